@@ -0,0 +1,203 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "allocations.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include <glog/logging.h>
+
+#ifdef __linux__
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#endif
+
+namespace allocations {
+namespace {
+
+/// Allocations of an active scope.
+struct Slot_ {
+  std::atomic<size_t> numAllocations;
+  std::atomic<size_t> bytes;
+  std::atomic<int64_t> peakBytes;
+};
+
+std::atomic<bool> enabled_(false);
+
+/// Can be negative, as blocks allocated before enable() are also freed.
+std::atomic<int64_t> liveBytes_(0);
+
+/// Depth of the innermost active scope, 0 if none. The slots are static, so
+/// threads that still see a scope that was destroyed don't touch freed
+/// memory.
+std::atomic<int> activeDepth_(0);
+std::array<Slot_, Scope::MaxDepth + 1> slots_;
+
+/// Size of the block in the heap, which may be bigger than the requested.
+size_t blockSize_(void *ptr) {
+#ifdef __linux__
+  return malloc_usable_size(ptr);
+#elif defined(__APPLE__)
+  return malloc_size(ptr);
+#else
+  (void)ptr;
+  return 0;
+#endif
+}
+
+void fetchMax_(std::atomic<int64_t> &value, int64_t other) {
+  int64_t current = value.load(std::memory_order_relaxed);
+  while (current < other &&
+         !value.compare_exchange_weak(current, other,
+                                      std::memory_order_relaxed)) {
+  }
+}
+
+void recordAllocation_(void *ptr, size_t size) {
+  const int64_t blockSize = blockSize_(ptr);
+  const int64_t live =
+      liveBytes_.fetch_add(blockSize, std::memory_order_relaxed) + blockSize;
+  const int depth = activeDepth_.load(std::memory_order_acquire);
+  if (depth) {
+    auto &slot = slots_[depth];
+    slot.numAllocations.fetch_add(1, std::memory_order_relaxed);
+    slot.bytes.fetch_add(size, std::memory_order_relaxed);
+    fetchMax_(slot.peakBytes, live);
+  }
+}
+
+void *allocate_(size_t size) {
+  void *ptr;
+  while (!(ptr = std::malloc(size ? size : 1))) {
+    const auto handler = std::get_new_handler();
+    if (!handler) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+
+  if (enabled_.load(std::memory_order_relaxed)) {
+    recordAllocation_(ptr, size);
+  }
+  return ptr;
+}
+
+void *allocateNoThrow_(size_t size) noexcept {
+  try {
+    return allocate_(size);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+void deallocate_(void *ptr) noexcept {
+  if (ptr && enabled_.load(std::memory_order_relaxed)) {
+    liveBytes_.fetch_sub(blockSize_(ptr), std::memory_order_relaxed);
+  }
+  std::free(ptr);
+}
+
+} // namespace
+
+Counts &Counts::operator+=(const Counts &other) {
+  numAllocations += other.numAllocations;
+  bytes += other.bytes;
+  peakBytes = std::max(peakBytes, other.peakBytes);
+  return *this;
+}
+
+void enable() { enabled_ = true; }
+
+bool enabled() { return enabled_; }
+
+size_t liveBytes() { return std::max<int64_t>(liveBytes_, 0); }
+
+Scope::Scope(Counts &counts) : counts_(counts), depth_(0) {
+  if (!enabled()) {
+    return;
+  }
+
+  depth_ = activeDepth_.load() + 1;
+  CHECK_LE(depth_, MaxDepth) << "Allocation scopes nested too deep";
+  auto &slot = slots_[depth_];
+  slot.numAllocations = 0;
+  slot.bytes = 0;
+  slot.peakBytes = liveBytes_.load();
+  activeDepth_.store(depth_, std::memory_order_release);
+}
+
+Scope::~Scope() {
+  if (!depth_) {
+    return;
+  }
+
+  activeDepth_.store(depth_ - 1, std::memory_order_release);
+  const auto &slot = slots_[depth_];
+  const int64_t peakBytes = slot.peakBytes;
+  Counts counts;
+  counts.numAllocations = slot.numAllocations;
+  counts.bytes = slot.bytes;
+  counts.peakBytes = std::max<int64_t>(peakBytes, 0);
+  counts_ += counts;
+
+  // The peak of the nested scope is also a peak of the enclosing one.
+  if (depth_ > 1) {
+    fetchMax_(slots_[depth_ - 1].peakBytes, peakBytes);
+  }
+}
+
+} // namespace allocations
+
+// Replacements of the global allocation functions. The aligned versions are
+// not replaced, so the blocks they allocate are consistently not counted.
+
+void *operator new(size_t size) { return allocations::allocate_(size); }
+
+void *operator new[](size_t size) { return allocations::allocate_(size); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return allocations::allocateNoThrow_(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return allocations::allocateNoThrow_(size);
+}
+
+void operator delete(void *ptr) noexcept { allocations::deallocate_(ptr); }
+
+void operator delete[](void *ptr) noexcept { allocations::deallocate_(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept {
+  allocations::deallocate_(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+  allocations::deallocate_(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  allocations::deallocate_(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  allocations::deallocate_(ptr);
+}
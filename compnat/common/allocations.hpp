@@ -0,0 +1,85 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPNAT_COMMON_ALLOCATIONS_HPP
+#define COMPNAT_COMMON_ALLOCATIONS_HPP
+
+#include <cstddef>
+
+/**
+ * Optional accounting of heap allocations, done by replacing the global
+ * operator new and operator delete. Allocations are attributed to the
+ * innermost active Scope, independently of the thread that made them, so the
+ * allocations of OpenMP parallel blocks go to the scope that started them.
+ * Nothing is counted until enable() is called. While disabled, the operators
+ * only add an atomic load to malloc() and free().
+ */
+namespace allocations {
+
+/// Allocations made while a scope was active.
+struct Counts {
+  /// Number of calls to operator new.
+  size_t numAllocations = 0;
+
+  /// Bytes requested from operator new.
+  size_t bytes = 0;
+
+  /// Maximum number of bytes allocated in the heap at the same time, see
+  /// liveBytes().
+  size_t peakBytes = 0;
+
+  /// Adds the allocations of other, keeping the biggest peak.
+  Counts &operator+=(const Counts &other);
+};
+
+/// Starts counting allocations.
+void enable();
+
+/// If allocations are being counted.
+bool enabled();
+
+/**
+ * Bytes allocated in the heap and not yet freed, as reported by the
+ * allocator. Only blocks allocated after enable() are known, but all frees
+ * are subtracted, so this is a lower bound. 0 on systems where the size of
+ * the blocks can't be queried.
+ */
+size_t liveBytes();
+
+/**
+ * Adds the allocations made during its lifetime to counts, except the ones
+ * made while a nested scope was active. Scopes must be nested in a single
+ * thread, and other threads must stop allocating on behalf of a scope before
+ * it is destroyed.
+ */
+class Scope {
+public:
+  /// Maximum nesting depth of scopes.
+  static constexpr int MaxDepth = 8;
+
+  explicit Scope(Counts &counts);
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+  ~Scope();
+
+private:
+  Counts &counts_;
+  int depth_;
+};
+
+} // namespace allocations
+
+#endif // !COMPNAT_COMMON_ALLOCATIONS_HPP
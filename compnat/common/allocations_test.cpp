@@ -0,0 +1,116 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "allocations.hpp"
+
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+TEST(AllocationsTest, CountsAllocations) {
+  allocations::enable();
+  allocations::Counts counts;
+  {
+    allocations::Scope scope(counts);
+    void *a = ::operator new(1000);
+    void *b = ::operator new[](3000);
+    ::operator delete(a);
+    ::operator delete[](b);
+  }
+  EXPECT_EQ((size_t)2, counts.numAllocations);
+  EXPECT_EQ((size_t)4000, counts.bytes);
+  EXPECT_LE((size_t)4000, counts.peakBytes);
+
+  // Allocations outside of scopes are not counted.
+  delete new int(0);
+  EXPECT_EQ((size_t)2, counts.numAllocations);
+}
+
+TEST(AllocationsTest, TracksLiveBytes) {
+  allocations::enable();
+  const size_t before = allocations::liveBytes();
+  void *ptr = ::operator new(1 << 20);
+  EXPECT_LE(before + (1 << 20), allocations::liveBytes());
+  ::operator delete(ptr);
+  EXPECT_EQ(before, allocations::liveBytes());
+}
+
+TEST(AllocationsTest, AttributesToInnermostScope) {
+  allocations::enable();
+  allocations::Counts outer, inner;
+  {
+    allocations::Scope outerScope(outer);
+    void *a = ::operator new(100);
+    {
+      allocations::Scope innerScope(inner);
+      void *b = ::operator new(1 << 20);
+      void *c = ::operator new(200);
+      ::operator delete(b);
+      ::operator delete(c);
+    }
+    ::operator delete(a);
+  }
+  EXPECT_EQ((size_t)1, outer.numAllocations);
+  EXPECT_EQ((size_t)100, outer.bytes);
+  EXPECT_EQ((size_t)2, inner.numAllocations);
+  EXPECT_EQ((size_t)(1 << 20) + 200, inner.bytes);
+
+  // The peak of the inner scope happened during the outer one.
+  EXPECT_LE((size_t)1 << 20, inner.peakBytes);
+  EXPECT_LE(inner.peakBytes, outer.peakBytes);
+}
+
+TEST(AllocationsTest, CountsOtherThreads) {
+  allocations::enable();
+  allocations::Counts counts;
+  {
+    allocations::Scope scope(counts);
+    std::vector<std::thread> threads;
+    threads.reserve(4);
+    for (int i = 0; i < 4; ++i) {
+      threads.emplace_back([]() {
+        for (int j = 0; j < 100; ++j) {
+          ::operator delete(::operator new(10));
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+  EXPECT_LE((size_t)400, counts.numAllocations);
+  EXPECT_LE((size_t)4000, counts.bytes);
+}
+
+TEST(AllocationsTest, AddsCounts) {
+  allocations::Counts a, b;
+  a.numAllocations = 1;
+  a.bytes = 10;
+  a.peakBytes = 100;
+  b.numAllocations = 2;
+  b.bytes = 20;
+  b.peakBytes = 50;
+  a += b;
+  EXPECT_EQ((size_t)3, a.numAllocations);
+  EXPECT_EQ((size_t)30, a.bytes);
+  EXPECT_EQ((size_t)100, a.peakBytes);
+}
+
+} // namespace
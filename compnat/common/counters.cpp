@@ -0,0 +1,274 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "counters.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#include <glog/logging.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace counters {
+namespace {
+
+std::atomic<bool> enabled_(false);
+
+std::mutex mutex_;
+std::map<std::string, Counts> regions_;
+
+/// Logs that the event is unavailable, only once for all threads.
+void warnUnavailable_(Event event, int error) {
+  static std::array<std::atomic<bool>, NumEvents> warned{};
+  if (!warned[event].exchange(true)) {
+    LOG(WARNING) << "Hardware counter " << eventName(event)
+                 << " unavailable: " << std::strerror(error);
+  }
+}
+
+/// Counters of the calling thread, all in the same group so they are read
+/// with a single system call.
+class ThreadCounters_ {
+public:
+  ThreadCounters_() {
+    index_.fill(-1);
+#ifdef __linux__
+    const std::array<uint64_t, NumEvents> configs = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES,
+        PERF_COUNT_HW_STALLED_CYCLES_BACKEND};
+    for (int event = 0; event < NumEvents; ++event) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = configs[event];
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                         PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+      // Counts the calling thread on any CPU.
+      const int fd = syscall(SYS_perf_event_open, &attr, 0, -1, leader_, 0);
+      if (fd < 0) {
+        warnUnavailable_((Event)event, errno);
+        continue;
+      }
+      if (leader_ < 0) {
+        leader_ = fd;
+      }
+      index_[event] = fds_.size();
+      fds_.push_back(fd);
+    }
+#else
+    for (int event = 0; event < NumEvents; ++event) {
+      warnUnavailable_((Event)event, ENOSYS);
+    }
+#endif
+  }
+
+  ThreadCounters_(const ThreadCounters_ &) = delete;
+  ThreadCounters_ &operator=(const ThreadCounters_ &) = delete;
+
+  ~ThreadCounters_() {
+#ifdef __linux__
+    for (const int fd : fds_) {
+      close(fd);
+    }
+#endif
+  }
+
+  /// If the event is being counted.
+  bool counted(Event event) const { return index_[event] >= 0; }
+
+  /// Reads all counters. Returns false if none are open.
+  bool read(Reading &reading) const {
+#ifdef __linux__
+    if (leader_ < 0) {
+      return false;
+    }
+
+    // Number of values, time enabled, time running and the values.
+    std::array<uint64_t, 3 + NumEvents> buf;
+    if (::read(leader_, buf.data(), sizeof(buf)) <= 0) {
+      return false;
+    }
+    reading.timeEnabled = buf[1];
+    reading.timeRunning = buf[2];
+    for (int event = 0; event < NumEvents; ++event) {
+      reading.values[event] =
+          counted((Event)event) ? buf[3 + index_[event]] : 0;
+    }
+    return true;
+#else
+    (void)reading;
+    return false;
+#endif
+  }
+
+private:
+  int leader_ = -1;
+  std::vector<int> fds_;
+
+  /// Index of each event in the group, -1 if not counted.
+  std::array<int, NumEvents> index_;
+};
+
+ThreadCounters_ &threadCounters_() {
+  thread_local ThreadCounters_ counters;
+  return counters;
+}
+
+/// Ratio as a string, or "n/a" if any of the counts is unavailable.
+std::string ratio_(double a, double b, double scale) {
+  if (a < 0 || b <= 0) {
+    return "n/a";
+  }
+  std::ostringstream ss;
+  ss << a / b * scale;
+  return ss.str();
+}
+
+} // namespace
+
+const char *eventName(Event event) {
+  switch (event) {
+  case Cycles:
+    return "cycles";
+  case Instructions:
+    return "instructions";
+  case CacheMisses:
+    return "cache-misses";
+  case BranchMisses:
+    return "branch-misses";
+  case StalledCycles:
+    return "stalled-cycles-backend";
+  default:
+    LOG(FATAL) << "Invalid event: " << (int)event;
+  }
+}
+
+void enable() { enabled_.store(true, std::memory_order_relaxed); }
+
+bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+void reset() {
+  enabled_.store(false, std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(mutex_);
+  regions_.clear();
+}
+
+std::vector<std::pair<std::string, Counts>> regions() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return {regions_.begin(), regions_.end()};
+}
+
+void logSummary() {
+  const auto &all = regions();
+  if (all.empty()) {
+    return;
+  }
+
+  LOG(INFO) << "";
+  LOG(INFO) << "Performance counters:";
+  bool counted = false;
+  for (const auto & [ name, counts ] : all) {
+    std::ostringstream ss;
+    ss << "  " << name << ": " << counts.numCalls << " calls, "
+       << counts.time << " ms";
+    for (int event = 0; event < NumEvents; ++event) {
+      if (counts.events[event] >= 0) {
+        ss << ", " << eventName((Event)event) << ": " << counts.events[event];
+        counted = true;
+      }
+    }
+    LOG(INFO) << ss.str();
+
+    const auto &events = counts.events;
+    if (events[Instructions] >= 0) {
+      LOG(INFO) << "    IPC: "
+                << ratio_(events[Instructions], events[Cycles], 1)
+                << " | cache misses/1k instructions: "
+                << ratio_(events[CacheMisses], events[Instructions], 1000)
+                << " | branch misses/1k instructions: "
+                << ratio_(events[BranchMisses], events[Instructions], 1000)
+                << " | stalled cycles (%): "
+                << ratio_(events[StalledCycles], events[Cycles], 100);
+    }
+  }
+  if (!counted) {
+    LOG(INFO) << "  Hardware counters unavailable, only times were measured.";
+  }
+}
+
+Region::Region(const char *name)
+    : span_(name), name_(name), active_(enabled()) {
+  if (active_) {
+    counted_ = threadCounters_().read(startReading_);
+    start_ = std::chrono::steady_clock::now();
+  }
+}
+
+Region::~Region() {
+  if (!active_) {
+    return;
+  }
+
+  const std::chrono::duration<double, std::milli> time =
+      std::chrono::steady_clock::now() - start_;
+  const auto &threadCounters = threadCounters_();
+  Reading end;
+  std::array<double, NumEvents> events;
+  events.fill(-1);
+
+  // Scales the counts by the fraction of the time they were running, in case
+  // they were multiplexed with other events.
+  if (counted_ && threadCounters.read(end) &&
+      end.timeRunning > startReading_.timeRunning) {
+    const double scale =
+        (double)(end.timeEnabled - startReading_.timeEnabled) /
+        (end.timeRunning - startReading_.timeRunning);
+    for (int event = 0; event < NumEvents; ++event) {
+      if (threadCounters.counted((Event)event)) {
+        events[event] =
+            (end.values[event] - startReading_.values[event]) * scale;
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto &counts = regions_[name_];
+  ++counts.numCalls;
+  counts.time += time.count();
+  for (int event = 0; event < NumEvents; ++event) {
+    if (events[event] >= 0) {
+      counts.events[event] =
+          std::max(counts.events[event], 0.0) + events[event];
+    }
+  }
+}
+
+} // namespace counters
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPNAT_COMMON_COUNTERS_HPP
+#define COMPNAT_COMMON_COUNTERS_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "trace.hpp"
+
+/**
+ * Optional hardware performance counters of named regions of code, read with
+ * Linux's perf_event_open. Each thread opens its own counters the first time
+ * it enters a region, so regions work inside OpenMP parallel blocks. When the
+ * counters can't be opened (other systems, containers or
+ * perf_event_paranoid), the regions only measure time.
+ * Regions do nothing until enable() is called. Independently of that, they
+ * are recorded as trace::Span if tracing is enabled.
+ */
+namespace counters {
+
+/// Events counted in each region.
+enum Event {
+  Cycles,
+  Instructions,
+  CacheMisses,
+  BranchMisses,
+  StalledCycles, // Backend stalls.
+  NumEvents
+};
+
+/// Name of the event, as used in the logs.
+const char *eventName(Event event);
+
+/// Totals of a region, for all threads.
+struct Counts {
+  /// Number of times the region was entered.
+  size_t numCalls = 0;
+
+  /// Time spent in the region, in milliseconds, summed for all threads.
+  double time = 0;
+
+  /// Count of each event, scaled if the counters were multiplexed. < 0 if
+  /// the event couldn't be counted in any of the calls.
+  std::array<double, NumEvents> events;
+
+  Counts() { events.fill(-1); }
+};
+
+/// Raw values of the counters of a thread.
+struct Reading {
+  uint64_t timeEnabled = 0;
+  uint64_t timeRunning = 0;
+  std::array<uint64_t, NumEvents> values{};
+};
+
+/// Enables the regions.
+void enable();
+
+/// If the regions are enabled.
+bool enabled();
+
+/// Disables the regions and discards the counts of all regions.
+void reset();
+
+/// Counts of all regions, sorted by name.
+std::vector<std::pair<std::string, Counts>> regions();
+
+/**
+ * Logs the counts of all regions, with the instructions per cycle and the
+ * cache and branch misses per thousand instructions.
+ */
+void logSummary();
+
+/**
+ * Counts the events and time of the current thread during its lifetime,
+ * adding them to the region with the given name.
+ */
+class Region {
+public:
+  /// name must outlive the region, usually it is a literal.
+  explicit Region(const char *name);
+  Region(const Region &) = delete;
+  Region &operator=(const Region &) = delete;
+  ~Region();
+
+private:
+  trace::Span span_;
+  const char *name_;
+  bool active_;
+  bool counted_ = false;
+  std::chrono::steady_clock::time_point start_;
+  Reading startReading_;
+};
+
+} // namespace counters
+
+#endif // !COMPNAT_COMMON_COUNTERS_HPP
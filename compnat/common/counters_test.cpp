@@ -0,0 +1,98 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "counters.hpp"
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/// Work that can't be optimized away.
+double work(size_t n) {
+  volatile double sum = 0;
+  for (size_t i = 0; i < n; ++i) {
+    sum = sum + i * 0.5;
+  }
+  return sum;
+}
+
+TEST(CountersTest, DisabledRegionsDoNothing) {
+  counters::reset();
+  { counters::Region region("disabled"); }
+  EXPECT_TRUE(counters::regions().empty());
+}
+
+TEST(CountersTest, CountsRegions) {
+  counters::reset();
+  counters::enable();
+  for (int i = 0; i < 3; ++i) {
+    counters::Region outer("outer");
+    work(100000);
+    counters::Region inner("inner");
+    work(100000);
+  }
+
+  const auto &regions = counters::regions();
+  ASSERT_EQ((size_t)2, regions.size());
+  const auto & [ innerName, inner ] = regions[0];
+  const auto & [ outerName, outer ] = regions[1];
+  EXPECT_EQ("inner", innerName);
+  EXPECT_EQ("outer", outerName);
+  EXPECT_EQ((size_t)3, inner.numCalls);
+  EXPECT_EQ((size_t)3, outer.numCalls);
+  EXPECT_LT(0, inner.time);
+  EXPECT_LE(inner.time, outer.time);
+
+  // The counters may be unavailable, but are counted in both or none.
+  for (int event = 0; event < counters::NumEvents; ++event) {
+    EXPECT_EQ(inner.events[event] < 0, outer.events[event] < 0)
+        << counters::eventName((counters::Event)event);
+  }
+  if (outer.events[counters::Instructions] >= 0) {
+    EXPECT_LT(200000, outer.events[counters::Instructions]);
+    EXPECT_LE(inner.events[counters::Instructions],
+              outer.events[counters::Instructions]);
+  }
+  counters::logSummary();
+  counters::reset();
+}
+
+TEST(CountersTest, CountsEachThread) {
+  counters::reset();
+  counters::enable();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([]() {
+      for (int j = 0; j < 10; ++j) {
+        counters::Region region("thread");
+        work(10000);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  const auto &regions = counters::regions();
+  ASSERT_EQ((size_t)1, regions.size());
+  EXPECT_EQ((size_t)40, regions[0].second.numCalls);
+  counters::reset();
+}
+
+} // namespace
@@ -0,0 +1,323 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "numa.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include <glog/logging.h>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace numa {
+namespace {
+
+/// Size of the transparent huge pages of x86-64 and of most ARM64 kernels.
+constexpr size_t HugePageSize_ = 2 << 20;
+
+/// Memory policies and flags of linux/mempolicy.h, which needs libnuma's
+/// numaif.h to be usable from C++.
+constexpr int MpolPreferred_ = 1;
+constexpr int MpolFNode_ = 1 << 0;
+constexpr int MpolFAddr_ = 1 << 1;
+
+std::atomic<uint64_t> localBytes_(0);
+std::atomic<uint64_t> remoteBytes_(0);
+
+size_t roundUp_(size_t value, size_t multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+/// Contents of the file, empty if it can't be read.
+std::string readFile_(const std::string &filename) {
+  std::ifstream in(filename);
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+/// Parses a sysfs list of ranges, like "0-3,8,10-11".
+std::vector<int> parseList_(const std::string &list) {
+  std::vector<int> values;
+  std::istringstream in(list.substr(0, list.find_last_not_of(" \n") + 1));
+  std::string range;
+  while (std::getline(in, range, ',')) {
+    if (range.empty()) {
+      continue;
+    }
+    const size_t dash = range.find('-');
+    const int first = std::atoi(range.c_str());
+    const int last =
+        dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+    for (int value = first; value <= last; ++value) {
+      values.push_back(value);
+    }
+  }
+  return values;
+}
+
+/// Index of the node with the given id, -1 if unknown.
+int nodeIndex_(const Topology &topology, int id) {
+  const auto &ids = topology.nodeIds;
+  const auto it = std::find(ids.begin(), ids.end(), id);
+  return it == ids.end() ? -1 : it - ids.begin();
+}
+
+/// Node of the thread when the threads are split among the nodes in
+/// proportion to their number of CPUs.
+int threadNode_(const Topology &topology, int thread, int numThreads) {
+  std::vector<size_t> firstCpus;
+  size_t numCpus = 0;
+  for (size_t node = 0; node < topology.numNodes(); ++node) {
+    firstCpus.push_back(numCpus);
+    numCpus += topology.cpus(node).size();
+  }
+
+  const size_t cpu = (size_t)thread * numCpus / numThreads;
+  const auto it = std::upper_bound(firstCpus.begin(), firstCpus.end(), cpu);
+  return it - firstCpus.begin() - 1;
+}
+
+/// Sets the preferred node of the pages, which are placed there when touched.
+void bind_(void *address, size_t bytes, int node) {
+#ifdef __linux__
+  const int id = topology().nodeIds[node];
+  const size_t bitsPerWord = 8 * sizeof(unsigned long);
+  std::vector<unsigned long> mask(id / bitsPerWord + 1, 0);
+  mask[id / bitsPerWord] |= 1ul << (id % bitsPerWord);
+  if (syscall(SYS_mbind, address, bytes, MpolPreferred_, mask.data(),
+              mask.size() * bitsPerWord, 0) == 0) {
+    return;
+  }
+  const int error = errno;
+#else
+  (void)address;
+  (void)bytes;
+  (void)node;
+  const int error = ENOSYS;
+#endif
+  static std::atomic<bool> warned(false);
+  if (!warned.exchange(true)) {
+    LOG(WARNING) << "Failed to bind memory to NUMA nodes, it is placed where "
+                    "it is first touched: "
+                 << std::strerror(error);
+  }
+}
+
+} // namespace
+
+Topology Topology::load(const std::string &dir) {
+  Topology topology;
+  for (int id : parseList_(readFile_(dir + "/online"))) {
+    const auto &cpus = parseList_(
+        readFile_(dir + "/node" + std::to_string(id) + "/cpulist"));
+    if (cpus.empty()) {
+      // Memory only nodes don't run threads.
+      continue;
+    }
+
+    for (int cpu : cpus) {
+      if ((size_t)cpu >= topology.cpuNodes.size()) {
+        topology.cpuNodes.resize(cpu + 1, -1);
+      }
+      topology.cpuNodes[cpu] = topology.nodeIds.size();
+    }
+    topology.nodeIds.push_back(id);
+  }
+
+  if (topology.nodeIds.empty()) {
+    topology.nodeIds.push_back(0);
+    topology.cpuNodes.clear();
+  }
+  return topology;
+}
+
+int Topology::cpuNode(int cpu) const {
+  return cpu >= 0 && (size_t)cpu < cpuNodes.size() && cpuNodes[cpu] >= 0
+             ? cpuNodes[cpu]
+             : 0;
+}
+
+std::vector<int> Topology::cpus(int node) const {
+  std::vector<int> cpus;
+  for (size_t cpu = 0; cpu < cpuNodes.size(); ++cpu) {
+    if (cpuNodes[cpu] == node) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+const Topology &topology() {
+  static const Topology topology = Topology::load();
+  return topology;
+}
+
+int currentNode() {
+  if (numNodes() == 1) {
+    return 0;
+  }
+#ifdef __linux__
+  return topology().cpuNode(sched_getcpu());
+#else
+  return 0;
+#endif
+}
+
+int addressNode(const void *address) {
+  if (numNodes() == 1) {
+    return 0;
+  }
+#ifdef __linux__
+  int id = -1;
+  if (syscall(SYS_get_mempolicy, &id, nullptr, 0, address,
+              MpolFNode_ | MpolFAddr_) == 0) {
+    return nodeIndex_(topology(), id);
+  }
+#else
+  (void)address;
+#endif
+  return -1;
+}
+
+std::shared_ptr<void> allocate(size_t bytes, int node) {
+  CHECK(node >= 0 && (size_t)node < numNodes()) << "Invalid node " << node;
+  bytes = std::max<size_t>(bytes, 1);
+#ifdef __linux__
+  const bool huge = bytes >= HugePageSize_;
+  const size_t size = huge ? roundUp_(bytes, HugePageSize_) : bytes;
+  const size_t length = huge ? size + HugePageSize_ : size;
+  void *map = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  PCHECK(map != MAP_FAILED) << "Failed to map " << bytes << " bytes";
+
+  char *begin = static_cast<char *>(map);
+  if (huge) {
+    // Trims the mapping to huge page boundaries. The advice is ignored when
+    // transparent huge pages are disabled.
+    char *aligned = reinterpret_cast<char *>(
+        roundUp_(reinterpret_cast<uintptr_t>(begin), HugePageSize_));
+    if (aligned != begin) {
+      munmap(begin, aligned - begin);
+    }
+    if (aligned + size != begin + length) {
+      munmap(aligned + size, begin + length - (aligned + size));
+    }
+    begin = aligned;
+    madvise(begin, size, MADV_HUGEPAGE);
+  }
+  if (numNodes() > 1) {
+    bind_(begin, size, node);
+  }
+  return std::shared_ptr<void>(begin,
+                               [size](void *data) { munmap(data, size); });
+#else
+  void *data = std::aligned_alloc(64, roundUp_(bytes, 64));
+  CHECK(data) << "Failed to allocate " << bytes << " bytes";
+  return std::shared_ptr<void>(data, std::free);
+#endif
+}
+
+bool pinToNode(int node) {
+#ifdef __linux__
+  const auto &cpus = topology().cpus(node);
+  if (cpus.empty()) {
+    return false;
+  }
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    CPU_SET(cpu, &set);
+  }
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  (void)node;
+  return false;
+#endif
+}
+
+void pinOpenMPThreads() {
+  const auto &topology = numa::topology();
+  if (topology.numNodes() == 1) {
+    return;
+  }
+
+  std::atomic<int> numPinned(0);
+  int numThreads = 1;
+#pragma omp parallel
+  {
+#ifdef _OPENMP
+    const int thread = omp_get_thread_num();
+#pragma omp single
+    numThreads = omp_get_num_threads();
+#else
+    const int thread = 0;
+#endif
+    if (pinToNode(threadNode_(topology, thread, numThreads))) {
+      ++numPinned;
+    }
+  }
+  LOG(INFO) << "Pinned " << numPinned.load() << " of " << numThreads
+            << " threads to " << topology.numNodes() << " NUMA nodes";
+}
+
+void recordAccess(int readerNode, int dataNode, uint64_t bytes) {
+  if (dataNode < 0 || dataNode == readerNode) {
+    localBytes_.fetch_add(bytes, std::memory_order_relaxed);
+  } else {
+    remoteBytes_.fetch_add(bytes, std::memory_order_relaxed);
+  }
+}
+
+Accesses accesses() {
+  Accesses accesses;
+  accesses.localBytes = localBytes_.load(std::memory_order_relaxed);
+  accesses.remoteBytes = remoteBytes_.load(std::memory_order_relaxed);
+  return accesses;
+}
+
+void resetAccesses() {
+  localBytes_ = 0;
+  remoteBytes_ = 0;
+}
+
+void logSummary() {
+  const auto &total = accesses();
+  const uint64_t bytes = total.localBytes + total.remoteBytes;
+  const double local = bytes ? 100.0 * total.localBytes / bytes : 100;
+  LOG(INFO) << "NUMA nodes: " << numNodes()
+            << " | local reads: " << (total.localBytes >> 20) << " MiB ("
+            << local << "%) | remote reads: " << (total.remoteBytes >> 20)
+            << " MiB (" << 100 - local << "%)";
+}
+
+} // namespace numa
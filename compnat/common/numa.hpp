@@ -0,0 +1,121 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPNAT_COMMON_NUMA_HPP
+#define COMPNAT_COMMON_NUMA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * NUMA placement of read-only data, read from Linux's sysfs and done with the
+ * mbind system call, without libnuma. Nodes are numbered from 0 to
+ * numNodes() - 1 in the order of their ids, which may have gaps. Machines
+ * where the topology can't be read are a single node with all the CPUs, and
+ * everything keeps working on them, only without binding memory.
+ */
+namespace numa {
+
+/// NUMA nodes and their CPUs.
+struct Topology {
+  /// Id of each node, as used by the kernel.
+  std::vector<int> nodeIds;
+
+  /// Node of each CPU, -1 for CPUs that aren't in any node.
+  std::vector<int> cpuNodes;
+
+  /**
+   * Reads the topology from the given sysfs directory. Gives a single node
+   * if the directory doesn't describe any node with CPUs.
+   */
+  static Topology load(const std::string &dir = "/sys/devices/system/node");
+
+  /// Number of nodes.
+  size_t numNodes() const { return nodeIds.size(); }
+
+  /// Node of the cpu, 0 if unknown.
+  int cpuNode(int cpu) const;
+
+  /// CPUs of the node.
+  std::vector<int> cpus(int node) const;
+};
+
+/// Topology of the machine, read once.
+const Topology &topology();
+
+/// Number of nodes of the machine.
+inline size_t numNodes() { return topology().numNodes(); }
+
+/// Node of the CPU the calling thread is running on.
+int currentNode();
+
+/**
+ * Node of the memory page containing address, which is faulted in if it wasn't
+ * touched yet. -1 if the kernel doesn't tell. Always 0 on single node
+ * machines.
+ */
+int addressNode(const void *address);
+
+/**
+ * Allocates at least bytes of memory on the given node, aligned to 64 bytes.
+ * Allocations of at least a huge page are aligned to huge pages and advised
+ * to use transparent huge pages. If the memory can't be bound to the node,
+ * logs a warning once and the pages are placed where they are first
+ * touched. The memory is freed with the last copy of the pointer.
+ */
+std::shared_ptr<void> allocate(size_t bytes, int node);
+
+/**
+ * Pins the calling thread to the CPUs of the node.
+ * @return If the thread was pinned.
+ */
+bool pinToNode(int node);
+
+/**
+ * Pins the threads of the OpenMP thread pool, giving each node a contiguous
+ * block of threads proportional to its number of CPUs. Later parallel blocks
+ * of the same size reuse the pinned threads. Does nothing on single node
+ * machines.
+ */
+void pinOpenMPThreads();
+
+/// Bytes read from memory of the reader's node and of other nodes.
+struct Accesses {
+  uint64_t localBytes = 0;
+  uint64_t remoteBytes = 0;
+};
+
+/**
+ * Adds bytes read by a thread on readerNode from memory of dataNode. Reads
+ * from memory of unknown nodes (-1) are counted as local.
+ */
+void recordAccess(int readerNode, int dataNode, uint64_t bytes);
+
+/// Total accesses recorded.
+Accesses accesses();
+
+/// Discards the recorded accesses.
+void resetAccesses();
+
+/// Logs the number of nodes and the local and remote accesses.
+void logSummary();
+
+} // namespace numa
+
+#endif // !COMPNAT_COMMON_NUMA_HPP
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "numa.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/// Writes a fake sysfs node directory with the given files.
+std::string writeNodeDir(
+    const std::string &name,
+    const std::vector<std::pair<std::string, std::string>> &files) {
+  const std::string dir = ::testing::TempDir() + name;
+  mkdir(dir.c_str(), 0755);
+  for (const auto & [ filename, contents ] : files) {
+    const size_t slash = filename.find('/');
+    if (slash != std::string::npos) {
+      mkdir((dir + "/" + filename.substr(0, slash)).c_str(), 0755);
+    }
+    std::ofstream(dir + "/" + filename) << contents;
+  }
+  return dir;
+}
+
+TEST(NumaTest, LoadsTopology) {
+  const auto &dir =
+      writeNodeDir("numa_two_nodes", {{"online", "0,2\n"},
+                                      {"node0/cpulist", "0-1,4\n"},
+                                      {"node2/cpulist", "2-3\n"}});
+  const auto &topology = numa::Topology::load(dir);
+  EXPECT_EQ((std::vector<int>{0, 2}), topology.nodeIds);
+  EXPECT_EQ((size_t)2, topology.numNodes());
+  EXPECT_EQ(0, topology.cpuNode(4));
+  EXPECT_EQ(1, topology.cpuNode(3));
+  EXPECT_EQ(0, topology.cpuNode(100));
+  EXPECT_EQ((std::vector<int>{0, 1, 4}), topology.cpus(0));
+  EXPECT_EQ((std::vector<int>{2, 3}), topology.cpus(1));
+}
+
+TEST(NumaTest, SkipsNodesWithoutCpus) {
+  const auto &dir =
+      writeNodeDir("numa_memory_node", {{"online", "0-1\n"},
+                                        {"node0/cpulist", "0-7\n"},
+                                        {"node1/cpulist", "\n"}});
+  const auto &topology = numa::Topology::load(dir);
+  EXPECT_EQ((std::vector<int>{0}), topology.nodeIds);
+  EXPECT_EQ((size_t)8, topology.cpus(0).size());
+}
+
+TEST(NumaTest, FallsBackToSingleNode) {
+  const auto &topology =
+      numa::Topology::load(::testing::TempDir() + "numa_missing");
+  EXPECT_EQ((std::vector<int>{0}), topology.nodeIds);
+  EXPECT_EQ(0, topology.cpuNode(5));
+  EXPECT_TRUE(topology.cpus(0).empty());
+}
+
+TEST(NumaTest, ReadsMachineTopology) {
+  ASSERT_LE((size_t)1, numa::numNodes());
+  const int node = numa::currentNode();
+  EXPECT_LE(0, node);
+  EXPECT_GT((int)numa::numNodes(), node);
+}
+
+TEST(NumaTest, AllocatesOnNodes) {
+  for (size_t node = 0; node < numa::numNodes(); ++node) {
+    for (size_t bytes : {(size_t)1, (size_t)1000, (size_t)5 << 20}) {
+      const auto &memory = numa::allocate(bytes, node);
+      ASSERT_TRUE(memory);
+      EXPECT_EQ((uintptr_t)0, (uintptr_t)memory.get() % 64);
+      std::memset(memory.get(), 0xab, bytes);
+      EXPECT_EQ(0xab, static_cast<unsigned char *>(memory.get())[bytes - 1]);
+
+      const int addressNode = numa::addressNode(memory.get());
+      if (numa::numNodes() == 1) {
+        EXPECT_EQ(0, addressNode);
+      } else {
+        EXPECT_GT((int)numa::numNodes(), addressNode);
+      }
+    }
+  }
+}
+
+TEST(NumaTest, CountsAccesses) {
+  numa::resetAccesses();
+  numa::recordAccess(0, 0, 10);
+  numa::recordAccess(0, 1, 5);
+  numa::recordAccess(1, -1, 3);
+  const auto &accesses = numa::accesses();
+  EXPECT_EQ((uint64_t)13, accesses.localBytes);
+  EXPECT_EQ((uint64_t)5, accesses.remoteBytes);
+
+  numa::resetAccesses();
+  EXPECT_EQ((uint64_t)0, numa::accesses().localBytes);
+}
+
+} // namespace
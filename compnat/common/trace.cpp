@@ -0,0 +1,147 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <glog/logging.h>
+#include <unistd.h>
+
+namespace trace {
+namespace {
+
+struct Event_ {
+  const char *name;
+  int64_t index;
+
+  /// Start and duration, in nanoseconds.
+  int64_t start;
+  int64_t duration;
+};
+
+/// Spans of a thread, only accessed by it until the trace is written.
+struct Buffer_ {
+  size_t tid;
+  std::vector<Event_> events;
+};
+
+std::atomic<bool> enabled_(false);
+std::chrono::steady_clock::time_point epoch_;
+
+/// Buffers of all threads that recorded spans. They outlive the threads, so
+/// the spans of finished threads are still written.
+std::mutex mutex_;
+std::vector<std::unique_ptr<Buffer_>> buffers_;
+
+/// Nanoseconds since enable().
+int64_t now_() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - epoch_)
+      .count();
+}
+
+/// Buffer of the calling thread, registered the first time it is used.
+Buffer_ &threadBuffer_() {
+  thread_local Buffer_ *buffer = nullptr;
+  if (!buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers_.push_back(std::make_unique<Buffer_>());
+    buffer = buffers_.back().get();
+    buffer->tid = buffers_.size();
+  }
+  return *buffer;
+}
+
+void writeEscaped_(std::ostream &out, const char *str) {
+  out << '"';
+  for (; *str; ++str) {
+    if (*str == '"' || *str == '\\') {
+      out << '\\';
+    }
+    out << *str;
+  }
+  out << '"';
+}
+
+} // namespace
+
+void enable() {
+  epoch_ = std::chrono::steady_clock::now();
+  enabled_.store(true, std::memory_order_release);
+}
+
+bool enabled() { return enabled_.load(std::memory_order_acquire); }
+
+void write(const std::string &filename) {
+  std::ofstream out(filename, std::ofstream::out | std::ofstream::trunc);
+  CHECK(out.is_open()) << "Failed to open " << filename;
+
+  const auto pid = getpid();
+  std::lock_guard<std::mutex> lock(mutex_);
+  out << std::fixed << std::setprecision(3);
+  out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  const char *separator = "\n";
+  for (const auto &buffer : buffers_) {
+    out << separator << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": "
+        << pid << ", \"tid\": " << buffer->tid
+        << ", \"args\": {\"name\": \"Thread " << buffer->tid << "\"}}";
+    separator = ",\n";
+
+    // Timestamps are in microseconds.
+    for (const auto &event : buffer->events) {
+      out << ",\n{\"name\": ";
+      writeEscaped_(out, event.name);
+      out << ", \"ph\": \"X\", \"pid\": " << pid
+          << ", \"tid\": " << buffer->tid << ", \"ts\": " << event.start / 1e3
+          << ", \"dur\": " << event.duration / 1e3;
+      if (event.index >= 0) {
+        out << ", \"args\": {\"index\": " << event.index << "}";
+      }
+      out << "}";
+    }
+  }
+  out << "\n]}\n";
+  CHECK(out.good()) << "Failed to write " << filename;
+  LOG(INFO) << "Trace written to " << filename;
+}
+
+void reset() {
+  enabled_.store(false, std::memory_order_release);
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto &buffer : buffers_) {
+    buffer->events.clear();
+  }
+}
+
+Span::Span(const char *name, int64_t index)
+    : name_(name), index_(index), active_(enabled()),
+      start_(active_ ? now_() : 0) {}
+
+Span::~Span() {
+  if (active_) {
+    const int64_t end = now_();
+    threadBuffer_().events.push_back({name_, index_, start_, end - start_});
+  }
+}
+
+} // namespace trace
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPNAT_COMMON_TRACE_HPP
+#define COMPNAT_COMMON_TRACE_HPP
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Records spans of code in the trace event format, loaded by chrome://tracing
+ * and Perfetto. Each thread appends its spans to its own buffer without
+ * locking, so spans can be recorded inside OpenMP parallel blocks.
+ * Spans do nothing until enable() is called.
+ */
+namespace trace {
+
+/// Enables recording spans. The timestamps are relative to this call.
+void enable();
+
+/// If spans are being recorded.
+bool enabled();
+
+/**
+ * Writes all spans recorded so far to a JSON file, with one track for each
+ * thread. Must not be called while spans are being recorded.
+ */
+void write(const std::string &filename);
+
+/// Disables recording and discards all spans. Not thread-safe.
+void reset();
+
+/**
+ * Records the current thread spending its lifetime in the given span.
+ */
+class Span {
+public:
+  /**
+   * @param name Name of the span. Must outlive the trace, usually it is a
+   *   literal.
+   * @param index Index of the span (generation, iteration, etc), or < 0 if
+   *   none.
+   */
+  explicit Span(const char *name, int64_t index = -1);
+  Span(const Span &) = delete;
+  Span &operator=(const Span &) = delete;
+  ~Span();
+
+private:
+  const char *name_;
+  int64_t index_;
+  bool active_;
+  int64_t start_;
+};
+
+} // namespace trace
+
+#endif // !COMPNAT_COMMON_TRACE_HPP
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+std::string writeTrace() {
+  const std::string filename = ::testing::TempDir() + "trace_test.json";
+  trace::write(filename);
+  std::ifstream in(filename);
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+size_t count(const std::string &str, const std::string &substr) {
+  size_t n = 0;
+  for (size_t i = str.find(substr); i != std::string::npos;
+       i = str.find(substr, i + 1)) {
+    ++n;
+  }
+  return n;
+}
+
+TEST(TraceTest, DisabledSpansDoNothing) {
+  trace::reset();
+  { trace::Span span("disabled"); }
+  const auto &json = writeTrace();
+  EXPECT_EQ((size_t)0, count(json, "\"ph\": \"X\""));
+  EXPECT_EQ((size_t)0, count(json, "disabled"));
+}
+
+TEST(TraceTest, RecordsSpans) {
+  trace::reset();
+  trace::enable();
+  {
+    trace::Span outer("outer", 3);
+    trace::Span inner("inner \"quoted\"");
+  }
+  trace::reset();
+  trace::enable();
+  { trace::Span span("generation", 7); }
+
+  const auto &json = writeTrace();
+  EXPECT_EQ(0u, json.find("{\"displayTimeUnit\": \"ms\", \"traceEvents\": ["));
+  EXPECT_EQ("\n]}\n", json.substr(json.size() - 4));
+  EXPECT_EQ((size_t)1, count(json, "\"ph\": \"X\""));
+  EXPECT_EQ((size_t)1, count(json, "\"name\": \"generation\""));
+  EXPECT_EQ((size_t)1, count(json, "\"args\": {\"index\": 7}"));
+  EXPECT_EQ((size_t)0, count(json, "outer"));
+  trace::reset();
+}
+
+TEST(TraceTest, RecordsEachThread) {
+  trace::reset();
+  trace::enable();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([i]() {
+      trace::Span task("task", i);
+      trace::Span inner("inner \"quoted\"");
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // The spans of the threads are kept after they finish.
+  const auto &json = writeTrace();
+  EXPECT_EQ((size_t)4, count(json, "\"name\": \"task\""));
+  EXPECT_EQ((size_t)4, count(json, "\"name\": \"inner \\\"quoted\\\"\""));
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ((size_t)1, count(json, "\"args\": {\"index\": " +
+                                         std::to_string(i) + "}"));
+  }
+  trace::reset();
+}
+
+} // namespace
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "baseline.hpp"
+
+#include <cmath>
+#include <sstream>
+
+#include "glog/logging.h"
+
+namespace baseline {
+namespace {
+
+const json::Value *findScenario_(const json::Value &scenarios,
+                                 const std::string &name) {
+  for (const auto &scenario : scenarios.array) {
+    if (scenario.at("name").string == name) {
+      return &scenario;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * Compares a metric, appending a regression if it changed more than the
+ * tolerance.
+ * @param onlyIncrease If only increases of the metric are regressions.
+ */
+void compareMetric_(const std::string &scenario, const std::string &metric,
+                    double current, double base, double tolerance,
+                    bool onlyIncrease, std::vector<std::string> &regressions) {
+  const double change = base ? (current - base) / std::abs(base) : 0;
+  const bool regressed = onlyIncrease ? change > tolerance
+                                      : std::abs(change) > tolerance ||
+                                            (!base && current != base);
+
+  std::ostringstream out;
+  out << scenario << " " << metric << ": " << base << " -> " << current << " ("
+      << (change >= 0 ? "+" : "") << 100 * change << "%)";
+  LOG(INFO) << out.str() << (regressed ? " REGRESSION" : "");
+  if (regressed) {
+    regressions.push_back(out.str());
+  }
+}
+
+} // namespace
+
+std::vector<std::string> compare(const json::Value &results,
+                                 const json::Value &baseline,
+                                 const Tolerances &tolerances) {
+  std::vector<std::string> regressions;
+  const auto &baseScenarios = baseline.at("scenarios");
+  for (const auto &scenario : results.at("scenarios").array) {
+    const auto &name = scenario.at("name").string;
+    const json::Value *base = findScenario_(baseScenarios, name);
+    if (!base) {
+      LOG(WARNING) << name << ": not in the baseline";
+      continue;
+    }
+
+    compareMetric_(name, "wallSeconds", scenario.at("wallSeconds").number,
+                   base->at("wallSeconds").number, tolerances.wallTime, true,
+                   regressions);
+    compareMetric_(name, "peakRssKb", scenario.at("peakRssKb").number,
+                   base->at("peakRssKb").number, tolerances.peakRss, true,
+                   regressions);
+    compareMetric_(name, "finalFitness", scenario.at("finalFitness").number,
+                   base->at("finalFitness").number, tolerances.fitness, false,
+                   regressions);
+  }
+  return regressions;
+}
+
+} // namespace baseline
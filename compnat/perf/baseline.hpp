@@ -0,0 +1,52 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPNAT_PERF_BASELINE_HPP
+#define COMPNAT_PERF_BASELINE_HPP
+
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+namespace baseline {
+
+/// Maximum relative change of each metric that isn't a regression.
+struct Tolerances {
+  /// Increase of the wall time.
+  double wallTime = 0.1;
+
+  /// Increase of the peak RSS.
+  double peakRss = 0.2;
+
+  /// Change of the final fitness, in any direction. Runs use fixed seeds, so
+  /// any change means the results aren't the same anymore.
+  double fitness = 1e-9;
+};
+
+/**
+ * Compares the scenarios of the results with the ones with the same name in
+ * the baseline, both in the format written by the perf harness. Scenarios
+ * missing from the baseline are ignored.
+ * @return Description of each regression, empty if there is none.
+ */
+std::vector<std::string> compare(const json::Value &results,
+                                 const json::Value &baseline,
+                                 const Tolerances &tolerances);
+
+} // namespace baseline
+
+#endif // !COMPNAT_PERF_BASELINE_HPP
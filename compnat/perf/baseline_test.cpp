@@ -0,0 +1,76 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "baseline.hpp"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+json::Value results(double wallSeconds, double peakRssKb, double fitness) {
+  auto scenario = json::Value::makeObject();
+  scenario.add("name", "tp1-house");
+  scenario.add("wallSeconds", wallSeconds);
+  scenario.add("peakRssKb", peakRssKb);
+  scenario.add("finalFitness", fitness);
+
+  auto scenarios = json::Value::makeArray();
+  scenarios.array.push_back(scenario);
+  auto value = json::Value::makeObject();
+  value.add("scenarios", scenarios);
+  return value;
+}
+
+TEST(BaselineTest, AcceptsChangesWithinTolerance) {
+  const auto &base = results(10, 1000, 0.5);
+  const baseline::Tolerances tolerances;
+  EXPECT_TRUE(baseline::compare(base, base, tolerances).empty());
+  EXPECT_TRUE(
+      baseline::compare(results(10.9, 1100, 0.5), base, tolerances).empty());
+
+  // Getting faster or smaller is never a regression.
+  EXPECT_TRUE(
+      baseline::compare(results(1, 10, 0.5), base, tolerances).empty());
+}
+
+TEST(BaselineTest, FindsRegressions) {
+  const auto &base = results(10, 1000, 0.5);
+  const baseline::Tolerances tolerances;
+  EXPECT_EQ((size_t)1,
+            baseline::compare(results(11.5, 1000, 0.5), base, tolerances)
+                .size());
+  EXPECT_EQ((size_t)1,
+            baseline::compare(results(10, 1300, 0.5), base, tolerances)
+                .size());
+
+  // Fixed seeds give the same fitness, so any change is a regression.
+  EXPECT_EQ((size_t)1,
+            baseline::compare(results(10, 1000, 0.4), base, tolerances)
+                .size());
+  EXPECT_EQ((size_t)3,
+            baseline::compare(results(20, 2000, 0.6), base, tolerances)
+                .size());
+}
+
+TEST(BaselineTest, IgnoresNewScenarios) {
+  auto base = json::Value::makeObject();
+  base.add("scenarios", json::Value::makeArray());
+  EXPECT_TRUE(baseline::compare(results(10, 1000, 0.5), base,
+                                baseline::Tolerances())
+                  .empty());
+}
+
+} // namespace
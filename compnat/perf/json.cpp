@@ -0,0 +1,284 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "json.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include "glog/logging.h"
+
+namespace json {
+namespace {
+
+/// Maximum nesting of parsed documents, to reject malformed data before
+/// running out of stack.
+const size_t MaxDepth_ = 256;
+
+/// Recursive descent parser of JSON documents.
+class Parser_ {
+public:
+  explicit Parser_(const std::string &text) : text_(text), pos_(0) {}
+
+  Value parse() {
+    auto value = value_(0);
+    skipSpaces_();
+    if (pos_ != text_.size()) {
+      fail_("expected end of document");
+    }
+    return value;
+  }
+
+private:
+  Value value_(size_t depth) {
+    if (depth > MaxDepth_) {
+      fail_("document is too deep");
+    }
+
+    skipSpaces_();
+    if (consume_("null")) {
+      return Value();
+    }
+    if (consume_("true")) {
+      return Value(true);
+    }
+    if (consume_("false")) {
+      return Value(false);
+    }
+    if (consume_("\"")) {
+      return Value(string_());
+    }
+
+    if (consume_("[")) {
+      auto array = Value::makeArray();
+      skipSpaces_();
+      if (consume_("]")) {
+        return array;
+      }
+      do {
+        array.array.push_back(value_(depth + 1));
+        skipSpaces_();
+      } while (consume_(","));
+      expect_(']');
+      return array;
+    }
+
+    if (consume_("{")) {
+      auto object = Value::makeObject();
+      skipSpaces_();
+      if (consume_("}")) {
+        return object;
+      }
+      do {
+        skipSpaces_();
+        expect_('"');
+        auto key = string_();
+        skipSpaces_();
+        expect_(':');
+        object.add(key, value_(depth + 1));
+        skipSpaces_();
+      } while (consume_(","));
+      expect_('}');
+      return object;
+    }
+
+    // strtod accepts more than JSON numbers, but never less.
+    const char *begin = text_.c_str() + pos_;
+    char *end;
+    const double number = std::strtod(begin, &end);
+    if (end == begin) {
+      fail_("expected value");
+    }
+    pos_ += end - begin;
+    return Value(number);
+  }
+
+  /// Parses the rest of a string, after the opening quote.
+  std::string string_() {
+    std::string out;
+    while (pos_ < text_.size() && text_[pos_] != '"') {
+      char c = text_[pos_++];
+      if (c == '\\') {
+        if (pos_ >= text_.size()) {
+          break;
+        }
+        switch (c = text_[pos_++]) {
+        case 'n':
+          c = '\n';
+          break;
+        case 't':
+          c = '\t';
+          break;
+        case '"':
+        case '\\':
+        case '/':
+          break;
+        default:
+          --pos_;
+          fail_("unsupported escape sequence");
+        }
+      }
+      out += c;
+    }
+    expect_('"');
+    return out;
+  }
+
+  /// Consumes the prefix if the remaining text starts with it.
+  bool consume_(const char *prefix) {
+    const size_t size = std::strlen(prefix);
+    if (text_.compare(pos_, size, prefix) != 0) {
+      return false;
+    }
+    pos_ += size;
+    return true;
+  }
+
+  void expect_(char c) {
+    if (pos_ >= text_.size() || text_[pos_] != c) {
+      fail_(std::string("expected '") + c + "'");
+    }
+    ++pos_;
+  }
+
+  void skipSpaces_() {
+    while (pos_ < text_.size() && std::strchr(" \t\r\n", text_[pos_])) {
+      ++pos_;
+    }
+  }
+
+  void fail_(const std::string &error) const {
+    LOG(FATAL) << "Invalid JSON at position " << pos_ << ": " << error;
+  }
+
+  const std::string &text_;
+  size_t pos_;
+};
+
+void appendString_(const std::string &string, std::string &out) {
+  out += '"';
+  for (const char c : string) {
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      out += c;
+    }
+  }
+  out += '"';
+}
+
+void append_(const Value &value, size_t indent, std::string &out) {
+  const std::string spaces(2 * (indent + 1), ' ');
+  switch (value.type) {
+  case Value::Type::Null:
+    out += "null";
+    break;
+  case Value::Type::Bool:
+    out += value.boolean ? "true" : "false";
+    break;
+  case Value::Type::Number: {
+    // JSON has no infinities or NaN.
+    CHECK(std::isfinite(value.number)) << "Non-finite JSON number";
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.*g",
+                  std::numeric_limits<double>::max_digits10, value.number);
+    out += buffer;
+    break;
+  }
+  case Value::Type::String:
+    appendString_(value.string, out);
+    break;
+  case Value::Type::Array:
+    out += '[';
+    for (size_t i = 0; i < value.array.size(); ++i) {
+      out += i ? ",\n" : "\n";
+      out += spaces;
+      append_(value.array[i], indent + 1, out);
+    }
+    out += value.array.empty() ? "]" : "\n" + spaces.substr(2) + "]";
+    break;
+  case Value::Type::Object:
+    out += '{';
+    for (size_t i = 0; i < value.object.size(); ++i) {
+      out += i ? ",\n" : "\n";
+      out += spaces;
+      appendString_(value.object[i].first, out);
+      out += ": ";
+      append_(value.object[i].second, indent + 1, out);
+    }
+    out += value.object.empty() ? "}" : "\n" + spaces.substr(2) + "}";
+    break;
+  }
+}
+
+} // namespace
+
+Value Value::makeArray() {
+  Value value;
+  value.type = Type::Array;
+  return value;
+}
+
+Value Value::makeObject() {
+  Value value;
+  value.type = Type::Object;
+  return value;
+}
+
+const Value *Value::find(const std::string &key) const {
+  for (const auto & [ name, member ] : object) {
+    if (name == key) {
+      return &member;
+    }
+  }
+  return nullptr;
+}
+
+const Value &Value::at(const std::string &key) const {
+  const Value *member = find(key);
+  CHECK(member) << "Missing JSON member: " << key;
+  return *member;
+}
+
+void Value::add(const std::string &key, Value value) {
+  CHECK(type == Type::Object) << "Adding member to a non-object";
+  object.emplace_back(key, std::move(value));
+}
+
+Value parse(const std::string &text) { return Parser_(text).parse(); }
+
+std::string str(const Value &value) {
+  std::string out;
+  append_(value, 0, out);
+  out += '\n';
+  return out;
+}
+
+} // namespace json
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPNAT_PERF_JSON_HPP
+#define COMPNAT_PERF_JSON_HPP
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Minimal JSON document model, enough for the perf results and baselines.
+namespace json {
+
+/// A JSON value. Only the member of its type is meaningful.
+struct Value {
+  enum class Type { Null, Bool, Number, String, Array, Object };
+
+  Type type = Type::Null;
+  bool boolean = false;
+  double number = 0;
+  std::string string;
+  std::vector<Value> array;
+
+  /// Members in the order they were added or parsed.
+  std::vector<std::pair<std::string, Value>> object;
+
+  Value() = default;
+  Value(bool value) : type(Type::Bool), boolean(value) {}
+  Value(double value) : type(Type::Number), number(value) {}
+  Value(const char *value) : type(Type::String), string(value) {}
+  Value(const std::string &value) : type(Type::String), string(value) {}
+
+  /// Empty array.
+  static Value makeArray();
+
+  /// Empty object.
+  static Value makeObject();
+
+  /// Returns the member with the given key, or nullptr if there is none.
+  const Value *find(const std::string &key) const;
+
+  /// Returns the member with the given key. Dies if there is none.
+  const Value &at(const std::string &key) const;
+
+  /// Adds a member to an object.
+  void add(const std::string &key, Value value);
+};
+
+/**
+ * Parses a JSON document.
+ * Aborts reporting the position if the document is malformed.
+ */
+Value parse(const std::string &text);
+
+/**
+ * Returns the JSON text of the value, with two spaces of indentation.
+ * Numbers are written with enough digits to be parsed back exactly.
+ */
+std::string str(const Value &value);
+
+} // namespace json
+
+#endif // !COMPNAT_PERF_JSON_HPP
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "json.hpp"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+TEST(JsonTest, ParsesDocuments) {
+  const auto &value = json::parse(
+      " {\"a\": [1, -2.5e3, true, false, null], \"b\": {\"c\": \"x\\\"y\"},"
+      "\"d\": []}\n");
+  ASSERT_EQ(json::Value::Type::Object, value.type);
+  const auto &a = value.at("a");
+  ASSERT_EQ((size_t)5, a.array.size());
+  EXPECT_EQ(1, a.array[0].number);
+  EXPECT_EQ(-2500, a.array[1].number);
+  EXPECT_TRUE(a.array[2].boolean);
+  EXPECT_EQ(json::Value::Type::Bool, a.array[3].type);
+  EXPECT_EQ(json::Value::Type::Null, a.array[4].type);
+  EXPECT_EQ("x\"y", value.at("b").at("c").string);
+  EXPECT_TRUE(value.at("d").array.empty());
+  EXPECT_EQ(nullptr, value.find("e"));
+}
+
+TEST(JsonTest, RoundTrips) {
+  auto value = json::Value::makeObject();
+  value.add("name", "tp1-house\n");
+  value.add("number", 0.1);
+  value.add("empty", json::Value::makeArray());
+  auto array = json::Value::makeArray();
+  array.array.push_back(json::Value(1.0 / 3));
+  array.array.push_back(json::Value());
+  value.add("array", array);
+
+  const auto &text = json::str(value);
+  EXPECT_EQ(text, json::str(json::parse(text)));
+  const auto &parsed = json::parse(text);
+  EXPECT_EQ("tp1-house\n", parsed.at("name").string);
+  EXPECT_EQ(0.1, parsed.at("number").number);
+  EXPECT_EQ(1.0 / 3, parsed.at("array").array[0].number);
+}
+
+TEST(JsonDeathTest, ReportsInvalidDocuments) {
+  EXPECT_DEATH(json::parse("{\"a\" 1}"), "position 5: expected ':'");
+  EXPECT_DEATH(json::parse("[1, 2"), "expected ']'");
+  EXPECT_DEATH(json::parse("[1] 2"), "expected end of document");
+  EXPECT_DEATH(json::parse("{}").at("a"), "Missing JSON member: a");
+}
+
+} // namespace
@@ -0,0 +1,220 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "baseline.hpp"
+#include "compnat/tp1/results/results_generated.h"
+#include "compnat/tp2/results/results_generated.h"
+#include "json.hpp"
+#include "runner.hpp"
+
+DEFINE_string(output_file, "",
+              "JSON file that receives the results (empty for stdout).");
+DEFINE_string(baseline_file, "",
+              "JSON results of a previous run to compare with (empty to skip "
+              "the comparison). Regressions make the harness exit with 1.");
+DEFINE_double(wall_time_tolerance, 0.1,
+              "Maximum relative increase of the wall time.");
+DEFINE_double(peak_rss_tolerance, 0.2,
+              "Maximum relative increase of the peak RSS.");
+DEFINE_double(fitness_tolerance, 1e-9,
+              "Maximum relative change of the final fitness.");
+DEFINE_int32(repetitions, 3,
+             "Runs of each scenario. The fastest one is reported.");
+DEFINE_string(filter, "", "Only run scenarios whose name contains this.");
+DEFINE_string(work_dir, "/tmp",
+              "Directory of the logs and result files of the runs.");
+DEFINE_string(tp1, "compnat/tp1/tp1", "Path of the tp1 binary.");
+DEFINE_string(tp2, "compnat/tp2/tp2", "Path of the tp2 binary.");
+DEFINE_string(tp1_datasets, "compnat/tp1/datasets",
+              "Directory of the tp1 datasets.");
+DEFINE_string(tp2_datasets, "compnat/tp2/datasets",
+              "Directory of the tp2 datasets.");
+
+namespace {
+
+enum class Program_ { Tp1, Tp2 };
+
+/// A run of tp1 or tp2 with a fixed seed and budget.
+struct Scenario_ {
+  std::string name;
+  Program_ program;
+  std::vector<std::string> args;
+
+  /// Number of generations (tp1) or iterations (tp2) of all the instances.
+  size_t numUnits;
+};
+
+Scenario_ tp1Scenario_(const std::string &dataset, size_t numInstances,
+                       size_t numGenerations, size_t populationSize) {
+  const auto &prefix = FLAGS_tp1_datasets + "/" + dataset;
+  return {"tp1-" + dataset,
+          Program_::Tp1,
+          {"--dataset_train=" + prefix + "-train.csv",
+           "--dataset_test=" + prefix + "-test.csv", "--seed=1",
+           "--num_instances=" + std::to_string(numInstances),
+           "--num_generations=" + std::to_string(numGenerations),
+           "--population_size=" + std::to_string(populationSize)},
+          numInstances * numGenerations};
+}
+
+Scenario_ tp2Scenario_(const std::string &dataset, size_t numExecutions,
+                       size_t numIterations) {
+  return {"tp2-" + dataset,
+          Program_::Tp2,
+          {"--dataset=" + FLAGS_tp2_datasets + "/" + dataset + ".dat",
+           "--seed=1", "--num_executions=" + std::to_string(numExecutions),
+           "--num_iterations=" + std::to_string(numIterations)},
+          numExecutions * numIterations};
+}
+
+std::vector<Scenario_> scenarios_() {
+  return {tp1Scenario_("keijzer-7", 4, 50, 500),
+          tp1Scenario_("keijzer-10", 4, 50, 500),
+          tp1Scenario_("house", 2, 20, 500), tp2Scenario_("SJC1", 4, 50),
+          tp2Scenario_("SJC2", 2, 20)};
+}
+
+std::string readFile_(const std::string &filename) {
+  std::ifstream in(filename, std::ifstream::binary);
+  CHECK(in.is_open()) << "Failed to open " << filename;
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+/// Mean test fitness of the best individual of each instance.
+double tp1Fitness_(const std::string &data) {
+  flatbuffers::Verifier verifier(
+      reinterpret_cast<const uint8_t *>(data.data()), data.size());
+  CHECK(stats::results::VerifyResultsBuffer(verifier))
+      << "Invalid tp1 results";
+  const auto *results = stats::results::GetResults(data.data());
+  CHECK(results && results->finalStats()) << "tp1 results without final stats";
+  return results->finalStats()->bestFitness()->mean();
+}
+
+/// Mean global best of the last iteration of each execution.
+double tp2Fitness_(const std::string &data) {
+  flatbuffers::Verifier verifier(
+      reinterpret_cast<const uint8_t *>(data.data()), data.size());
+  CHECK(tp2::results::VerifyResultsBuffer(verifier)) << "Invalid tp2 results";
+  const auto *results = tp2::results::GetResults(data.data());
+  CHECK(results && results->iterations() && results->iterations()->size())
+      << "tp2 results without iterations";
+
+  const auto *globalBests =
+      results->iterations()->Get(results->iterations()->size() - 1)
+          ->globalBests();
+  double sum = 0;
+  for (size_t i = 0; i < globalBests->size(); ++i) {
+    sum += globalBests->Get(i);
+  }
+  return sum / globalBests->size();
+}
+
+/// Runs the scenario FLAGS_repetitions times.
+json::Value runScenario_(const Scenario_ &scenario) {
+  const auto &prefix = FLAGS_work_dir + "/perf-" + scenario.name;
+  const auto &resultsFile = prefix + ".results";
+  const auto &logFile = prefix + ".log";
+
+  std::vector<std::string> args = scenario.args;
+  args.insert(args.begin(),
+              scenario.program == Program_::Tp1 ? FLAGS_tp1 : FLAGS_tp2);
+  args.push_back("--output_file=" + resultsFile);
+
+  double wallSeconds = 0;
+  size_t peakRssKb = 0;
+  for (int i = 0; i < FLAGS_repetitions; ++i) {
+    const auto &usage = runner::run(args, logFile);
+    CHECK_EQ(0, usage.exitStatus) << scenario.name << " failed, see "
+                                  << logFile;
+    wallSeconds = i ? std::min(wallSeconds, usage.wallSeconds)
+                    : usage.wallSeconds;
+    peakRssKb = std::max(peakRssKb, usage.peakRssKb);
+    LOG(INFO) << scenario.name << ": " << usage.wallSeconds << " s, "
+              << usage.peakRssKb << " KiB";
+  }
+
+  const auto &data = readFile_(resultsFile);
+  const double fitness = scenario.program == Program_::Tp1 ? tp1Fitness_(data)
+                                                           : tp2Fitness_(data);
+
+  auto result = json::Value::makeObject();
+  result.add("name", scenario.name);
+  result.add("unit", scenario.program == Program_::Tp1 ? "generations"
+                                                       : "iterations");
+  result.add("wallSeconds", wallSeconds);
+  result.add("unitsPerSecond", scenario.numUnits / wallSeconds);
+  result.add("peakRssKb", (double)peakRssKb);
+  result.add("finalFitness", fitness);
+  return result;
+}
+
+} // namespace
+
+/**
+ * End-to-end performance harness. Runs tp1 and tp2 on the bundled datasets
+ * with fixed seeds and budgets, and compares the results with a baseline.
+ */
+int main(int argc, char **argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  CHECK_GT(FLAGS_repetitions, 0);
+
+  auto scenarios = json::Value::makeArray();
+  for (const auto &scenario : scenarios_()) {
+    if (scenario.name.find(FLAGS_filter) != std::string::npos) {
+      scenarios.array.push_back(runScenario_(scenario));
+    }
+  }
+
+  auto results = json::Value::makeObject();
+  results.add("repetitions", (double)FLAGS_repetitions);
+  results.add("scenarios", std::move(scenarios));
+  if (FLAGS_output_file.empty()) {
+    std::cout << json::str(results);
+  } else {
+    std::ofstream out(FLAGS_output_file);
+    CHECK(out.is_open()) << "Failed to open " << FLAGS_output_file;
+    out << json::str(results);
+  }
+
+  if (FLAGS_baseline_file.empty()) {
+    return 0;
+  }
+
+  baseline::Tolerances tolerances;
+  tolerances.wallTime = FLAGS_wall_time_tolerance;
+  tolerances.peakRss = FLAGS_peak_rss_tolerance;
+  tolerances.fitness = FLAGS_fitness_tolerance;
+  const auto &regressions = baseline::compare(
+      results, json::parse(readFile_(FLAGS_baseline_file)), tolerances);
+  for (const auto &regression : regressions) {
+    LOG(ERROR) << "Regression: " << regression;
+  }
+  return regressions.empty() ? 0 : 1;
+}
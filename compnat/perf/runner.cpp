@@ -0,0 +1,77 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "runner.hpp"
+
+#include <chrono>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "glog/logging.h"
+
+namespace runner {
+
+Usage run(const std::vector<std::string> &args, const std::string &logFile) {
+  CHECK(!args.empty()) << "Empty command";
+
+  // Built before forking, as the child may only call async-signal-safe
+  // functions.
+  std::vector<char *> argv;
+  for (const auto &arg : args) {
+    argv.push_back(const_cast<char *>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+
+  int logFd = -1;
+  if (!logFile.empty()) {
+    logFd = open(logFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                 0644);
+    PCHECK(logFd >= 0) << "Failed to open " << logFile;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const pid_t pid = fork();
+  PCHECK(pid >= 0) << "Failed to fork";
+  if (!pid) {
+    if (logFd >= 0) {
+      dup2(logFd, STDOUT_FILENO);
+      dup2(logFd, STDERR_FILENO);
+    }
+    execv(argv[0], argv.data());
+    _exit(127);
+  }
+
+  int status;
+  rusage usage;
+  PCHECK(wait4(pid, &status, 0, &usage) == pid) << "Failed to wait " << pid;
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  if (logFd >= 0) {
+    close(logFd);
+  }
+
+  Usage result;
+  result.exitStatus =
+      WIFEXITED(status) ? WEXITSTATUS(status) : -WTERMSIG(status);
+  result.wallSeconds = elapsed.count();
+  result.peakRssKb = usage.ru_maxrss; // KiB on Linux.
+  return result;
+}
+
+} // namespace runner
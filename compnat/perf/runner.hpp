@@ -0,0 +1,47 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPNAT_PERF_RUNNER_HPP
+#define COMPNAT_PERF_RUNNER_HPP
+
+#include <string>
+#include <vector>
+
+namespace runner {
+
+/// Resources used by a finished command.
+struct Usage {
+  /// Exit code of the command, or minus the signal that killed it.
+  int exitStatus = 0;
+
+  /// Elapsed wall clock time.
+  double wallSeconds = 0;
+
+  /// Peak resident set size of the command, in KiB.
+  size_t peakRssKb = 0;
+};
+
+/**
+ * Runs the command and waits for it to finish.
+ * @param args Path of the executable followed by its arguments.
+ * @param logFile File that receives the standard output and error of the
+ *   command, or empty to inherit them.
+ */
+Usage run(const std::vector<std::string> &args, const std::string &logFile);
+
+} // namespace runner
+
+#endif // !COMPNAT_PERF_RUNNER_HPP
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "runner.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+TEST(RunnerTest, ReportsExitStatus) {
+  EXPECT_EQ(0, runner::run({"/bin/sh", "-c", "exit 0"}, "").exitStatus);
+  EXPECT_EQ(3, runner::run({"/bin/sh", "-c", "exit 3"}, "").exitStatus);
+  EXPECT_EQ(-9, runner::run({"/bin/sh", "-c", "kill -9 $$"}, "").exitStatus);
+  EXPECT_EQ(127, runner::run({"/nonexistent"}, "").exitStatus);
+}
+
+TEST(RunnerTest, MeasuresResources) {
+  const auto &usage = runner::run({"/bin/sh", "-c", "sleep 0.2"}, "");
+  EXPECT_LE(0.2, usage.wallSeconds);
+  EXPECT_LT((size_t)0, usage.peakRssKb);
+}
+
+TEST(RunnerTest, WritesLogFile) {
+  const std::string logFile = ::testing::TempDir() + "runner_test.log";
+  runner::run({"/bin/sh", "-c", "echo out; echo err >&2"}, logFile);
+  std::ifstream in(logFile);
+  EXPECT_EQ("out\nerr\n", std::string(std::istreambuf_iterator<char>(in),
+                                      std::istreambuf_iterator<char>()));
+}
+
+} // namespace
@@ -0,0 +1,333 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "generators.hpp"
+#include "operators.hpp"
+#include "parser.hpp"
+#include "primitives.hpp"
+#include "representation.hpp"
+#include "statistics.hpp"
+#include "vecmath.hpp"
+
+namespace {
+
+/// Bundled datasets, indexed by the first argument of the benchmarks.
+const char *const Datasets_[] = {"keijzer-7-train", "keijzer-10-train",
+                                 "house-train", "house-test"};
+
+/// Number of datasets used by the evaluation benchmarks.
+const int NumEvalDatasets_ = 3;
+
+const int PopulationSizes_[] = {120, 600};
+const int Heights_[] = {4, 7};
+
+std::string path_(int dataset) {
+  return std::string("compnat/tp1/datasets/") + Datasets_[dataset] + ".csv";
+}
+
+/// Loads each dataset only once.
+const repr::Dataset &dataset_(int dataset) {
+  static std::map<int, repr::Dataset> datasets;
+  auto it = datasets.find(dataset);
+  if (it == datasets.end()) {
+    it = datasets.emplace(dataset, parser::loadDataset(path_(dataset))).first;
+  }
+  return it->second;
+}
+
+/// Same functions and terminals as tp1 with default flags.
+repr::Params params_(size_t numInputs, size_t populationSize, size_t height) {
+  std::vector<repr::PrimitiveFn> terminals = {primitives::constTerm};
+  for (size_t i = 0; i < numInputs; ++i) {
+    terminals.push_back(primitives::makeVarTerm(i));
+  }
+  return repr::Params("", 0, 0, 0, populationSize, 7, height, 0.9, false,
+                      false, {primitives::sumFn, primitives::subFn,
+                              primitives::multFn, primitives::divFn},
+                      terminals);
+}
+
+size_t totalSize_(const std::vector<size_t> &sizes) {
+  return std::accumulate(sizes.begin(), sizes.end(), (size_t)0);
+}
+
+void setRate_(benchmark::State &state, const char *name, double count) {
+  state.counters[name] = benchmark::Counter(count, benchmark::Counter::kIsRate);
+}
+
+/// Args: {dataset, population size, height}.
+void evalArgs_(benchmark::internal::Benchmark *b) {
+  b->ArgNames({"dataset", "population", "height"});
+  for (int dataset = 0; dataset < NumEvalDatasets_; ++dataset) {
+    for (int populationSize : PopulationSizes_) {
+      for (int height : Heights_) {
+        b->Args({dataset, populationSize, height});
+      }
+    }
+  }
+}
+
+/// Args: {population size, height}.
+void populationArgs_(benchmark::internal::Benchmark *b) {
+  b->ArgNames({"population", "height"});
+  for (int populationSize : PopulationSizes_) {
+    for (int height : Heights_) {
+      b->Args({populationSize, height});
+    }
+  }
+}
+
+/// Population and dataset of the benchmarks that receive evalArgs_.
+struct EvalFixture_ {
+  explicit EvalFixture_(const benchmark::State &state)
+      : dataset(dataset_(state.range(0))),
+        params(params_(dataset.numInputs(), state.range(1), state.range(2))),
+        rng(params.seed),
+        population(generators::rampedHalfAndHalf(rng, params)),
+        sizes(stats::sizes(population)), totalSize(totalSize_(sizes)) {}
+
+  const repr::Dataset &dataset;
+  repr::Params params;
+  repr::RNG rng;
+  std::vector<repr::Node> population;
+  std::vector<size_t> sizes;
+  size_t totalSize;
+};
+
+void BM_NodeEval(benchmark::State &state) {
+  EvalFixture_ fixture(state);
+  const auto &dataset = fixture.dataset;
+  repr::EvalInput input(dataset.numInputs());
+  while (state.KeepRunning()) {
+    for (size_t i = 0; i < dataset.size(); ++i) {
+      dataset.row(i, input);
+      for (const auto &individual : fixture.population) {
+        benchmark::DoNotOptimize(individual.eval(input));
+      }
+    }
+  }
+  setRate_(state, "rows/s", (double)state.iterations() *
+                                fixture.population.size() * dataset.size());
+  setRate_(state, "nodes/s",
+           (double)state.iterations() * fixture.totalSize * dataset.size());
+}
+BENCHMARK(BM_NodeEval)->Apply(evalArgs_);
+
+void BM_FitnessSingle(benchmark::State &state) {
+  EvalFixture_ fixture(state);
+  while (state.KeepRunning()) {
+    for (const auto &individual : fixture.population) {
+      benchmark::DoNotOptimize(stats::fitness(individual, fixture.dataset));
+    }
+  }
+  setRate_(state, "rows/s", (double)state.iterations() *
+                                fixture.population.size() *
+                                fixture.dataset.size());
+  setRate_(state, "nodes/s", (double)state.iterations() * fixture.totalSize *
+                                 fixture.dataset.size());
+}
+BENCHMARK(BM_FitnessSingle)->Apply(evalArgs_);
+
+void BM_FitnessPopulation(benchmark::State &state) {
+  EvalFixture_ fixture(state);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(
+        stats::fitness(fixture.population, fixture.dataset));
+  }
+  setRate_(state, "rows/s", (double)state.iterations() *
+                                fixture.population.size() *
+                                fixture.dataset.size());
+  setRate_(state, "nodes/s", (double)state.iterations() * fixture.totalSize *
+                                 fixture.dataset.size());
+}
+BENCHMARK(BM_FitnessPopulation)->Apply(evalArgs_)->UseRealTime();
+
+void BM_NewGeneration(benchmark::State &state) {
+  EvalFixture_ fixture(state);
+  const auto &fitnesses = stats::fitness(fixture.population, fixture.dataset);
+  const stats::Statistics parentStats("train", fixture.population, fitnesses,
+                                      fixture.sizes);
+  size_t numNodes = 0;
+  while (state.KeepRunning()) {
+    const auto &newPopulation =
+        operators::newGeneration(fixture.rng, fixture.params,
+                                 fixture.population, fitnesses, fixture.sizes,
+                                 parentStats)
+            .first;
+    numNodes += totalSize_(stats::sizes(newPopulation));
+  }
+  setRate_(state, "nodes/s", numNodes);
+}
+BENCHMARK(BM_NewGeneration)->Apply(evalArgs_);
+
+void BM_RampedHalfAndHalf(benchmark::State &state) {
+  const auto &params = params_(1, state.range(0), state.range(1));
+  repr::RNG rng(params.seed);
+  size_t numNodes = 0;
+  while (state.KeepRunning()) {
+    const auto &population = generators::rampedHalfAndHalf(rng, params);
+    numNodes += totalSize_(stats::sizes(population));
+  }
+  setRate_(state, "nodes/s", numNodes);
+}
+BENCHMARK(BM_RampedHalfAndHalf)->Apply(populationArgs_);
+
+/// Population of the benchmarks that receive populationArgs_.
+struct PopulationFixture_ {
+  explicit PopulationFixture_(const benchmark::State &state)
+      : params(params_(1, state.range(0), state.range(1))), rng(params.seed),
+        population(generators::rampedHalfAndHalf(rng, params)),
+        sizes(stats::sizes(population)) {}
+
+  repr::Params params;
+  repr::RNG rng;
+  std::vector<repr::Node> population;
+  std::vector<size_t> sizes;
+};
+
+void BM_Crossover(benchmark::State &state) {
+  PopulationFixture_ fixture(state);
+  const size_t n = fixture.population.size();
+  size_t i = 0, numNodes = 0;
+  while (state.KeepRunning()) {
+    const size_t x = i++ % n, y = (x + n / 2) % n;
+    benchmark::DoNotOptimize(operators::crossover(
+        fixture.rng, fixture.params, fixture.population[x], fixture.sizes[x],
+        fixture.population[y], fixture.sizes[y]));
+    numNodes += fixture.sizes[x] + fixture.sizes[y];
+  }
+  setRate_(state, "nodes/s", numNodes);
+}
+BENCHMARK(BM_Crossover)->Apply(populationArgs_);
+
+void BM_Mutation(benchmark::State &state) {
+  PopulationFixture_ fixture(state);
+  size_t i = 0, numNodes = 0;
+  while (state.KeepRunning()) {
+    const size_t x = i++ % fixture.population.size();
+    benchmark::DoNotOptimize(operators::mutation(
+        fixture.rng, fixture.params, fixture.population[x], fixture.sizes[x]));
+    numNodes += fixture.sizes[x];
+  }
+  setRate_(state, "nodes/s", numNodes);
+}
+BENCHMARK(BM_Mutation)->Apply(populationArgs_);
+
+void BM_RandomTreePoint(benchmark::State &state) {
+  PopulationFixture_ fixture(state);
+  size_t i = 0, numNodes = 0;
+  while (state.KeepRunning()) {
+    const size_t x = i++ % fixture.population.size();
+    benchmark::DoNotOptimize(&std::get<0>(operators::randomTreePoint(
+        fixture.rng, fixture.population[x], fixture.sizes[x])));
+    numNodes += fixture.sizes[x];
+  }
+  setRate_(state, "nodes/s", numNodes);
+}
+BENCHMARK(BM_RandomTreePoint)->Apply(populationArgs_);
+
+void BM_LoadDataset(benchmark::State &state) {
+  const auto &path = path_(state.range(0));
+  size_t numRows = 0;
+  while (state.KeepRunning()) {
+    numRows += parser::loadDataset(path).size();
+  }
+  setRate_(state, "rows/s", numRows);
+}
+BENCHMARK(BM_LoadDataset)->ArgName("dataset")->DenseRange(0, 3);
+
+/**
+ * Applies fn to a block of values in [min, max]. The libm functions are called
+ * once per value, while vecmath ones are vectorized.
+ */
+template <typename Fn>
+void mathBenchmark_(benchmark::State &state, double min, double max, Fn fn) {
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<double> distr(min, max);
+  std::vector<double> input(4096), output(input.size());
+  for (auto &value : input) {
+    value = distr(rng);
+  }
+
+  while (state.KeepRunning()) {
+#pragma omp simd
+    for (size_t i = 0; i < input.size(); ++i) {
+      output[i] = fn(input[i]);
+    }
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+void BM_LibmExp(benchmark::State &state) {
+  mathBenchmark_(state, -50, 50, [](double x) { return std::exp(x); });
+}
+BENCHMARK(BM_LibmExp);
+
+void BM_VecmathExp(benchmark::State &state) {
+  mathBenchmark_(state, -50, 50, [](double x) { return vecmath::exp(x); });
+}
+BENCHMARK(BM_VecmathExp);
+
+void BM_LibmLog(benchmark::State &state) {
+  mathBenchmark_(state, 0, 50, [](double x) { return std::log(x); });
+}
+BENCHMARK(BM_LibmLog);
+
+void BM_VecmathLog(benchmark::State &state) {
+  mathBenchmark_(state, 0, 50, [](double x) { return vecmath::log(x); });
+}
+BENCHMARK(BM_VecmathLog);
+
+void BM_LibmSin(benchmark::State &state) {
+  mathBenchmark_(state, -50, 50, [](double x) { return std::sin(x); });
+}
+BENCHMARK(BM_LibmSin);
+
+void BM_VecmathSin(benchmark::State &state) {
+  mathBenchmark_(state, -50, 50, [](double x) { return vecmath::sin(x); });
+}
+BENCHMARK(BM_VecmathSin);
+
+void BM_LibmCos(benchmark::State &state) {
+  mathBenchmark_(state, -50, 50, [](double x) { return std::cos(x); });
+}
+BENCHMARK(BM_LibmCos);
+
+void BM_VecmathCos(benchmark::State &state) {
+  mathBenchmark_(state, -50, 50, [](double x) { return vecmath::cos(x); });
+}
+BENCHMARK(BM_VecmathCos);
+
+void BM_ProtectedPow(benchmark::State &state) {
+  mathBenchmark_(state, 0, 50, [](double x) {
+    return primitives::protectedPow(x, 1.5);
+  });
+}
+BENCHMARK(BM_ProtectedPow);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -41,30 +41,36 @@ def plot_charts(all_results, train, sizes, numRepeated, numCrossBetter,
             stats = result.TestStats
             size = result.TestStatsLength()
 
+        # Generations without statistics aren't saved and the improvement
+        # stats are only saved at full level, see --stats_level.
+        stats = [stats(i) for i in range(size)]
         if numRepeated:
             y = [
-                stats(i).NumRepeated().Mean() /
-                result.Params().PopulationSize() for i in range(size)
+                s.NumRepeated().Mean() / result.Params().PopulationSize()
+                for s in stats
             ]
         elif sizes:
-            y = [stats(i).BestSize().Mean() for i in range(size)]
+            y = [s.BestSize().Mean() for s in stats]
         elif numCrossBetter:
+            stats = [
+                s for s in stats if s.Generation() > 0 and s.NumCrossBetter()
+            ]
             y = [
-                stats(i).NumCrossBetter().Mean() /
-                result.Params().PopulationSize() for i in range(1, size)
+                s.NumCrossBetter().Mean() / result.Params().PopulationSize()
+                for s in stats
             ]
         elif numMutBetter:
+            stats = [
+                s for s in stats if s.Generation() > 0 and s.NumMutBetter()
+            ]
             y = [
-                stats(i).NumMutBetter().Mean() /
-                result.Params().PopulationSize() for i in range(1, size)
+                s.NumMutBetter().Mean() / result.Params().PopulationSize()
+                for s in stats
             ]
         else:
-            y = [stats(i).BestFitness().Mean() for i in range(size)]
+            y = [s.BestFitness().Mean() for s in stats]
 
-        if numCrossBetter or numMutBetter:
-            plt.plot(range(1, size), y, label=result_str(result))
-        else:
-            plt.plot(range(size), y, label=result_str(result))
+        plt.plot([s.Generation() for s in stats], y, label=result_str(result))
 
     plt.legend(loc='upper right')
     plt.xlabel('Generation')
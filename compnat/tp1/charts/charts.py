@@ -23,21 +23,87 @@ import matplotlib.pyplot as plt
 
 
 def plot_chart(stats, size):
-    best_y = [stats(i).BestFitness().Mean() for i in range(1, size)]
-    best_e = [stats(i).BestFitness().Stddev() for i in range(1, size)]
-    avg_y = [stats(i).AvgFitness().Mean() for i in range(1, size)]
-    avg_e = [stats(i).AvgFitness().Stddev() for i in range(1, size)]
-    worst_y = [stats(i).WorstFitness().Mean() for i in range(1, size)]
-    worst_e = [stats(i).WorstFitness().Stddev() for i in range(1, size)]
+    # Generations without statistics aren't saved, see --stats_level.
+    stats = [stats(i) for i in range(size) if stats(i).Generation() > 0]
+    x = [s.Generation() for s in stats]
+    best_y = [s.BestFitness().Mean() for s in stats]
+    best_e = [s.BestFitness().Stddev() for s in stats]
+    avg_y = [s.AvgFitness().Mean() for s in stats]
+    avg_e = [s.AvgFitness().Stddev() for s in stats]
+    worst_y = [s.WorstFitness().Mean() for s in stats]
+    worst_e = [s.WorstFitness().Stddev() for s in stats]
 
     plt.yscale('log')
-    plt.errorbar(range(1, size), best_y, best_e)
-    plt.plot(range(1, size), avg_y)
-    plt.plot(range(1, size), worst_y)
+    plt.errorbar(x, best_y, best_e)
+    plt.plot(x, avg_y)
+    plt.plot(x, worst_y)
     plt.xlabel('Generation')
     plt.ylabel('Fitness (log scale)')
     plt.title(
         'Best (and sddev), average and worst individuals for the test dataset')
+
+    # Instances that stopped early aren't aggregated in the generations after
+    # they stopped, so the number of instances of each generation is shown.
+    instances = [s.NumInstances() for s in stats]
+    if len(set(instances)) > 1:
+        instances_axis = plt.twinx()
+        instances_axis.step(x, instances, 'k--', where='post', alpha=0.5)
+        instances_axis.set_ylabel('Instances aggregated')
+        instances_axis.set_ylim(bottom=0)
+    plt.show()
+
+
+def plot_phase_times(results):
+    phases = [('Initialization', 'InitTime'), ('Selection', 'SelectionTime'),
+              ('Crossover', 'CrossoverTime'), ('Mutation', 'MutationTime'),
+              ('Train evaluation', 'TrainEvalTime'),
+              ('Test evaluation', 'TestEvalTime'), ('Statistics', 'StatsTime'),
+              ('Serialization', 'SerializationTime')]
+    size = results.PhaseTimesLength()
+    if not size:
+        return
+
+    generations = range(size)
+    bottom = [0] * size
+    for label, field in phases:
+        times = [
+            getattr(results.PhaseTimes(i), field)().Mean()
+            for i in generations
+        ]
+        plt.bar(generations, times, bottom=bottom, label=label)
+        bottom = [b + t for b, t in zip(bottom, times)]
+
+    plt.xlabel('Generation')
+    plt.ylabel('Time (ms)')
+    plt.title('Average time spent in each phase of the generations')
+    plt.legend()
+    plt.show()
+
+
+def plot_phase_allocations(results):
+    phases = [('Initialization', 'Initialization'), ('Selection', 'Selection'),
+              ('Crossover', 'Crossover'), ('Mutation', 'Mutation'),
+              ('Train evaluation', 'TrainEval'),
+              ('Test evaluation', 'TestEval'), ('Statistics', 'Stats'),
+              ('Serialization', 'Serialization')]
+    size = results.PhaseAllocationsLength()
+    if not size:
+        return
+
+    generations = range(size)
+    bottom = [0] * size
+    for label, field in phases:
+        allocations = [
+            getattr(results.PhaseAllocations(i), field)().NumAllocations()
+            .Mean() for i in generations
+        ]
+        plt.bar(generations, allocations, bottom=bottom, label=label)
+        bottom = [b + a for b, a in zip(bottom, allocations)]
+
+    plt.xlabel('Generation')
+    plt.ylabel('Allocations')
+    plt.title('Average heap allocations of each phase of the generations')
+    plt.legend()
     plt.show()
 
 
@@ -54,8 +120,22 @@ def main():
     print('  Fitness: {}'.format(results.FinalStats().BestIndividualFitness()))
     print('  Size: {}'.format(results.FinalStats().BestIndividualSize()))
     print('  Str: {}'.format(results.FinalStats().BestIndividualStr()))
+    if results.NumStoppedEarly():
+        print('Generations run: {} +/- {} ({} of {} instances stopped early)'.
+              format(results.GenerationsRun().Mean(),
+                     results.GenerationsRun().Stddev(),
+                     results.NumStoppedEarly(), results.NumInstancesRun()))
+    for i in range(results.FoldsLength()):
+        fold = results.Folds(i)
+        print('Fold {}: test fitness {} +/- {} ({} train, {} test rows)'.format(
+            i + 1,
+            fold.FinalStats().BestFitness().Mean(),
+            fold.FinalStats().BestFitness().Stddev(), fold.NumTrainRows(),
+            fold.NumTestRows()))
 
     plot_chart(results.TrainStats, results.TrainStatsLength())
+    plot_phase_times(results)
+    plot_phase_allocations(results)
 
 
 if __name__ == '__main__':
@@ -91,7 +91,7 @@ class AggregatedStats(object):
             return obj
         return None
 
-# /// Number of repeated individuals in the generation.
+# /// Number of structurally repeated individuals in the generation.
     # AggregatedStats
     def NumRepeated(self):
         o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(16))
@@ -105,6 +105,8 @@ class AggregatedStats(object):
 
 # /// Number of individuals generated by crossover better than their parents.
 # /// < 0 if the data is not available.
+# /// The improvement stats are absent if no instance computed them in the
+# /// generation, see Params.statsLevel.
     # AggregatedStats
     def NumCrossBetter(self):
         o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(18))
@@ -179,7 +181,123 @@ class AggregatedStats(object):
             return self._tab.Get(flatbuffers.number_types.Uint32Flags, o + self._tab.Pos)
         return 0
 
-def AggregatedStatsStart(builder): builder.StartObject(14)
+# /// Number of nodes of the population removed by simplification before
+# /// evaluation.
+    # AggregatedStats
+    def NumSimplifiedNodes(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(32))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+# /// Number of individuals with a provably constant output over the dataset,
+# /// which were scored in closed form.
+    # AggregatedStats
+    def NumConstant(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(34))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+# /// Number of individuals with a provably non-finite output over the
+# /// dataset, which were rejected without being evaluated.
+    # AggregatedStats
+    def NumNonFinite(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(36))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+# /// Total number of nodes of the generation.
+    # AggregatedStats
+    def TotalSize(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(38))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+# /// Time spent evaluating the generation, in milliseconds.
+    # AggregatedStats
+    def EvalTime(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(40))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+# /// Number of individuals that had their fitness copied from an equal
+# /// individual instead of being evaluated.
+    # AggregatedStats
+    def NumReused(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(42))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+# /// Best individual in the generation, across all instances, with constants
+# /// written with enough digits to be parsed back exactly.
+    # AggregatedStats
+    def BestIndividualExpr(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(44))
+        if o != 0:
+            return self._tab.String(o + self._tab.Pos)
+        return ""
+
+# /// Number of evaluations of individuals over the dataset in the
+# /// generation, including the ones done by constant tuning.
+    # AggregatedStats
+    def NumEvaluations(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(46))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+# /// Number of instances aggregated. Instances that stopped early aren't
+# /// aggregated in the generations after they stopped.
+    # AggregatedStats
+    def NumInstances(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(48))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Uint64Flags, o + self._tab.Pos)
+        return 0
+
+# /// Index of the generation. Generations whose statistics weren't computed
+# /// by any instance are left out, see Params.statsLevel. 0 in the final stats.
+    # AggregatedStats
+    def Generation(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(50))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Uint32Flags, o + self._tab.Pos)
+        return 0
+
+def AggregatedStatsStart(builder): builder.StartObject(24)
 def AggregatedStatsAddBestFitness(builder, bestFitness): builder.PrependStructSlot(0, flatbuffers.number_types.UOffsetTFlags.py_type(bestFitness), 0)
 def AggregatedStatsAddBestSize(builder, bestSize): builder.PrependStructSlot(1, flatbuffers.number_types.UOffsetTFlags.py_type(bestSize), 0)
 def AggregatedStatsAddWorstFitness(builder, worstFitness): builder.PrependStructSlot(2, flatbuffers.number_types.UOffsetTFlags.py_type(worstFitness), 0)
@@ -194,4 +312,14 @@ def AggregatedStatsAddNumMutWorse(builder, numMutWorse): builder.PrependStructSl
 def AggregatedStatsAddBestIndividualStr(builder, bestIndividualStr): builder.PrependUOffsetTRelativeSlot(11, flatbuffers.number_types.UOffsetTFlags.py_type(bestIndividualStr), 0)
 def AggregatedStatsAddBestIndividualFitness(builder, bestIndividualFitness): builder.PrependFloat64Slot(12, bestIndividualFitness, 0.0)
 def AggregatedStatsAddBestIndividualSize(builder, bestIndividualSize): builder.PrependUint32Slot(13, bestIndividualSize, 0)
+def AggregatedStatsAddNumSimplifiedNodes(builder, numSimplifiedNodes): builder.PrependStructSlot(14, flatbuffers.number_types.UOffsetTFlags.py_type(numSimplifiedNodes), 0)
+def AggregatedStatsAddNumConstant(builder, numConstant): builder.PrependStructSlot(15, flatbuffers.number_types.UOffsetTFlags.py_type(numConstant), 0)
+def AggregatedStatsAddNumNonFinite(builder, numNonFinite): builder.PrependStructSlot(16, flatbuffers.number_types.UOffsetTFlags.py_type(numNonFinite), 0)
+def AggregatedStatsAddTotalSize(builder, totalSize): builder.PrependStructSlot(17, flatbuffers.number_types.UOffsetTFlags.py_type(totalSize), 0)
+def AggregatedStatsAddEvalTime(builder, evalTime): builder.PrependStructSlot(18, flatbuffers.number_types.UOffsetTFlags.py_type(evalTime), 0)
+def AggregatedStatsAddNumReused(builder, numReused): builder.PrependStructSlot(19, flatbuffers.number_types.UOffsetTFlags.py_type(numReused), 0)
+def AggregatedStatsAddBestIndividualExpr(builder, bestIndividualExpr): builder.PrependUOffsetTRelativeSlot(20, flatbuffers.number_types.UOffsetTFlags.py_type(bestIndividualExpr), 0)
+def AggregatedStatsAddNumEvaluations(builder, numEvaluations): builder.PrependStructSlot(21, flatbuffers.number_types.UOffsetTFlags.py_type(numEvaluations), 0)
+def AggregatedStatsAddNumInstances(builder, numInstances): builder.PrependUint64Slot(22, numInstances, 0)
+def AggregatedStatsAddGeneration(builder, generation): builder.PrependUint32Slot(23, generation, 0)
 def AggregatedStatsEnd(builder): return builder.EndObject()
@@ -0,0 +1,62 @@
+# automatically generated by the FlatBuffers compiler, do not modify
+
+# namespace: results
+
+import flatbuffers
+
+# /// Heap allocations of a phase, aggregated for all instances.
+class AllocationCounts(object):
+    __slots__ = ['_tab']
+
+    @classmethod
+    def GetRootAsAllocationCounts(cls, buf, offset):
+        n = flatbuffers.encode.Get(flatbuffers.packer.uoffset, buf, offset)
+        x = AllocationCounts()
+        x.Init(buf, n + offset)
+        return x
+
+    # AllocationCounts
+    def Init(self, buf, pos):
+        self._tab = flatbuffers.table.Table(buf, pos)
+
+# /// Number of calls to operator new.
+    # AllocationCounts
+    def NumAllocations(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(4))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+# /// Bytes requested from operator new.
+    # AllocationCounts
+    def Bytes(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(6))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+# /// Maximum number of bytes allocated in the heap at the same time.
+    # AllocationCounts
+    def PeakBytes(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(8))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+def AllocationCountsStart(builder): builder.StartObject(3)
+def AllocationCountsAddNumAllocations(builder, numAllocations): builder.PrependStructSlot(0, flatbuffers.number_types.UOffsetTFlags.py_type(numAllocations), 0)
+def AllocationCountsAddBytes(builder, bytes): builder.PrependStructSlot(1, flatbuffers.number_types.UOffsetTFlags.py_type(bytes), 0)
+def AllocationCountsAddPeakBytes(builder, peakBytes): builder.PrependStructSlot(2, flatbuffers.number_types.UOffsetTFlags.py_type(peakBytes), 0)
+def AllocationCountsEnd(builder): return builder.EndObject()
@@ -0,0 +1,92 @@
+# automatically generated by the FlatBuffers compiler, do not modify
+
+# namespace: results
+
+import flatbuffers
+
+# /// Hardware performance counters of a named region of code, summed for all
+# /// threads and instances. The counts are < 0 if they were unavailable.
+class CounterRegion(object):
+    __slots__ = ['_tab']
+
+    @classmethod
+    def GetRootAsCounterRegion(cls, buf, offset):
+        n = flatbuffers.encode.Get(flatbuffers.packer.uoffset, buf, offset)
+        x = CounterRegion()
+        x.Init(buf, n + offset)
+        return x
+
+    # CounterRegion
+    def Init(self, buf, pos):
+        self._tab = flatbuffers.table.Table(buf, pos)
+
+# /// Name of the region.
+    # CounterRegion
+    def Name(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(4))
+        if o != 0:
+            return self._tab.String(o + self._tab.Pos)
+        return ""
+
+# /// Number of times the region was entered.
+    # CounterRegion
+    def NumCalls(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(6))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Uint64Flags, o + self._tab.Pos)
+        return 0
+
+# /// Time spent in the region, in milliseconds.
+    # CounterRegion
+    def Time(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(8))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Float64Flags, o + self._tab.Pos)
+        return 0.0
+
+    # CounterRegion
+    def Cycles(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(10))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Float64Flags, o + self._tab.Pos)
+        return 0.0
+
+    # CounterRegion
+    def Instructions(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(12))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Float64Flags, o + self._tab.Pos)
+        return 0.0
+
+    # CounterRegion
+    def CacheMisses(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(14))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Float64Flags, o + self._tab.Pos)
+        return 0.0
+
+    # CounterRegion
+    def BranchMisses(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(16))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Float64Flags, o + self._tab.Pos)
+        return 0.0
+
+# /// Cycles stalled in the backend of the CPU.
+    # CounterRegion
+    def StalledCycles(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(18))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Float64Flags, o + self._tab.Pos)
+        return 0.0
+
+def CounterRegionStart(builder): builder.StartObject(8)
+def CounterRegionAddName(builder, name): builder.PrependUOffsetTRelativeSlot(0, flatbuffers.number_types.UOffsetTFlags.py_type(name), 0)
+def CounterRegionAddNumCalls(builder, numCalls): builder.PrependUint64Slot(1, numCalls, 0)
+def CounterRegionAddTime(builder, time): builder.PrependFloat64Slot(2, time, 0.0)
+def CounterRegionAddCycles(builder, cycles): builder.PrependFloat64Slot(3, cycles, 0.0)
+def CounterRegionAddInstructions(builder, instructions): builder.PrependFloat64Slot(4, instructions, 0.0)
+def CounterRegionAddCacheMisses(builder, cacheMisses): builder.PrependFloat64Slot(5, cacheMisses, 0.0)
+def CounterRegionAddBranchMisses(builder, branchMisses): builder.PrependFloat64Slot(6, branchMisses, 0.0)
+def CounterRegionAddStalledCycles(builder, stalledCycles): builder.PrependFloat64Slot(7, stalledCycles, 0.0)
+def CounterRegionEnd(builder): return builder.EndObject()
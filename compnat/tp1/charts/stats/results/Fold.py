@@ -0,0 +1,77 @@
+# automatically generated by the FlatBuffers compiler, do not modify
+
+# namespace: results
+
+import flatbuffers
+
+# /// Statistics of one fold of k-fold cross-validation.
+class Fold(object):
+    __slots__ = ['_tab']
+
+    @classmethod
+    def GetRootAsFold(cls, buf, offset):
+        n = flatbuffers.encode.Get(flatbuffers.packer.uoffset, buf, offset)
+        x = Fold()
+        x.Init(buf, n + offset)
+        return x
+
+    # Fold
+    def Init(self, buf, pos):
+        self._tab = flatbuffers.table.Table(buf, pos)
+
+# /// Number of rows the fold was trained on.
+    # Fold
+    def NumTrainRows(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(4))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Uint64Flags, o + self._tab.Pos)
+        return 0
+
+# /// Number of rows held out of training, which the fold was tested on.
+    # Fold
+    def NumTestRows(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(6))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Uint64Flags, o + self._tab.Pos)
+        return 0
+
+# /// Aggregated results for each generation for the train rows.
+    # Fold
+    def TrainStats(self, j):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(8))
+        if o != 0:
+            x = self._tab.Vector(o)
+            x += flatbuffers.number_types.UOffsetTFlags.py_type(j) * 4
+            x = self._tab.Indirect(x)
+            from .AggregatedStats import AggregatedStats
+            obj = AggregatedStats()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+    # Fold
+    def TrainStatsLength(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(8))
+        if o != 0:
+            return self._tab.VectorLen(o)
+        return 0
+
+# /// Aggregated results for the final generation for the test rows.
+    # Fold
+    def FinalStats(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(10))
+        if o != 0:
+            x = self._tab.Indirect(o + self._tab.Pos)
+            from .AggregatedStats import AggregatedStats
+            obj = AggregatedStats()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+def FoldStart(builder): builder.StartObject(4)
+def FoldAddNumTrainRows(builder, numTrainRows): builder.PrependUint64Slot(0, numTrainRows, 0)
+def FoldAddNumTestRows(builder, numTestRows): builder.PrependUint64Slot(1, numTestRows, 0)
+def FoldAddTrainStats(builder, trainStats): builder.PrependUOffsetTRelativeSlot(2, flatbuffers.number_types.UOffsetTFlags.py_type(trainStats), 0)
+def FoldStartTrainStatsVector(builder, numElems): return builder.StartVector(4, numElems, 4)
+def FoldAddFinalStats(builder, finalStats): builder.PrependUOffsetTRelativeSlot(3, flatbuffers.number_types.UOffsetTFlags.py_type(finalStats), 0)
+def FoldEnd(builder): return builder.EndObject()
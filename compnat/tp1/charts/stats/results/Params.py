@@ -91,7 +91,97 @@ class Params(object):
             return self._tab.Get(flatbuffers.number_types.BoolFlags, o + self._tab.Pos)
         return 0
 
-def ParamsStart(builder): builder.StartObject(9)
+# /// Probability of Tarpeian rejection of children bigger than the average.
+    # Params
+    def TarpeianProb(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(22))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Float64Flags, o + self._tab.Pos)
+        return 0.0
+
+# /// Coefficient of the size penalty used for selection.
+    # Params
+    def ParsimonyCoefficient(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(24))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Float64Flags, o + self._tab.Pos)
+        return 0.0
+
+# /// Maximum total number of nodes of a generation, 0 if unlimited.
+    # Params
+    def NodeBudget(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(26))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Uint64Flags, o + self._tab.Pos)
+        return 0
+
+# /// Number of best individuals of each generation with tuned constants.
+    # Params
+    def TuneElites(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(28))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Uint64Flags, o + self._tab.Pos)
+        return 0
+
+# /// Levenberg-Marquardt steps for each tuned individual.
+    # Params
+    def TuneSteps(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(30))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Uint64Flags, o + self._tab.Pos)
+        return 0
+
+# /// Train fitness that counts as solving the problem, 0 if disabled.
+    # Params
+    def TargetFitness(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(32))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Float64Flags, o + self._tab.Pos)
+        return 0.0
+
+# /// Seconds all instances could run for, 0 if unlimited.
+    # Params
+    def TimeBudget(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(34))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Float64Flags, o + self._tab.Pos)
+        return 0.0
+
+# /// Seconds each instance could run for, 0 if unlimited.
+    # Params
+    def InstanceTimeBudget(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(36))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Float64Flags, o + self._tab.Pos)
+        return 0.0
+
+# /// Generations without improvement that stopped an instance, 0 if
+# /// disabled.
+    # Params
+    def StagnationGenerations(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(38))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Uint64Flags, o + self._tab.Pos)
+        return 0
+
+# /// Minimum decrease of the best fitness that counted as an improvement.
+    # Params
+    def StagnationEpsilon(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(40))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Float64Flags, o + self._tab.Pos)
+        return 0.0
+
+# /// Statistics computed for each generation, see repr::StatsLevel: 0 for
+# /// none, 1 for summary and 2 for full.
+    # Params
+    def StatsLevel(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(42))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Uint8Flags, o + self._tab.Pos)
+        return 2
+
+def ParamsStart(builder): builder.StartObject(20)
 def ParamsAddSeed(builder, seed): builder.PrependUint32Slot(0, seed, 0)
 def ParamsAddNumInstances(builder, numInstances): builder.PrependUint32Slot(1, numInstances, 0)
 def ParamsAddNumGenerations(builder, numGenerations): builder.PrependUint32Slot(2, numGenerations, 0)
@@ -101,4 +191,15 @@ def ParamsAddMaxHeight(builder, maxHeight): builder.PrependUint32Slot(5, maxHeig
 def ParamsAddCrossoverProb(builder, crossoverProb): builder.PrependFloat64Slot(6, crossoverProb, 0.0)
 def ParamsAddElitism(builder, elitism): builder.PrependBoolSlot(7, elitism, 0)
 def ParamsAddAlwaysTest(builder, alwaysTest): builder.PrependBoolSlot(8, alwaysTest, 0)
+def ParamsAddTarpeianProb(builder, tarpeianProb): builder.PrependFloat64Slot(9, tarpeianProb, 0.0)
+def ParamsAddParsimonyCoefficient(builder, parsimonyCoefficient): builder.PrependFloat64Slot(10, parsimonyCoefficient, 0.0)
+def ParamsAddNodeBudget(builder, nodeBudget): builder.PrependUint64Slot(11, nodeBudget, 0)
+def ParamsAddTuneElites(builder, tuneElites): builder.PrependUint64Slot(12, tuneElites, 0)
+def ParamsAddTuneSteps(builder, tuneSteps): builder.PrependUint64Slot(13, tuneSteps, 0)
+def ParamsAddTargetFitness(builder, targetFitness): builder.PrependFloat64Slot(14, targetFitness, 0.0)
+def ParamsAddTimeBudget(builder, timeBudget): builder.PrependFloat64Slot(15, timeBudget, 0.0)
+def ParamsAddInstanceTimeBudget(builder, instanceTimeBudget): builder.PrependFloat64Slot(16, instanceTimeBudget, 0.0)
+def ParamsAddStagnationGenerations(builder, stagnationGenerations): builder.PrependUint64Slot(17, stagnationGenerations, 0)
+def ParamsAddStagnationEpsilon(builder, stagnationEpsilon): builder.PrependFloat64Slot(18, stagnationEpsilon, 0.0)
+def ParamsAddStatsLevel(builder, statsLevel): builder.PrependUint8Slot(19, statsLevel, 2)
 def ParamsEnd(builder): return builder.EndObject()
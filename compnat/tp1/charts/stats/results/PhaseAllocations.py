@@ -0,0 +1,119 @@
+# automatically generated by the FlatBuffers compiler, do not modify
+
+# namespace: results
+
+import flatbuffers
+
+# /// Heap allocations of each phase of a generation, see PhaseTimes.
+class PhaseAllocations(object):
+    __slots__ = ['_tab']
+
+    @classmethod
+    def GetRootAsPhaseAllocations(cls, buf, offset):
+        n = flatbuffers.encode.Get(flatbuffers.packer.uoffset, buf, offset)
+        x = PhaseAllocations()
+        x.Init(buf, n + offset)
+        return x
+
+    # PhaseAllocations
+    def Init(self, buf, pos):
+        self._tab = flatbuffers.table.Table(buf, pos)
+
+    # PhaseAllocations
+    def Initialization(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(4))
+        if o != 0:
+            x = self._tab.Indirect(o + self._tab.Pos)
+            from .AllocationCounts import AllocationCounts
+            obj = AllocationCounts()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+    # PhaseAllocations
+    def Selection(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(6))
+        if o != 0:
+            x = self._tab.Indirect(o + self._tab.Pos)
+            from .AllocationCounts import AllocationCounts
+            obj = AllocationCounts()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+    # PhaseAllocations
+    def Crossover(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(8))
+        if o != 0:
+            x = self._tab.Indirect(o + self._tab.Pos)
+            from .AllocationCounts import AllocationCounts
+            obj = AllocationCounts()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+    # PhaseAllocations
+    def Mutation(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(10))
+        if o != 0:
+            x = self._tab.Indirect(o + self._tab.Pos)
+            from .AllocationCounts import AllocationCounts
+            obj = AllocationCounts()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+    # PhaseAllocations
+    def TrainEval(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(12))
+        if o != 0:
+            x = self._tab.Indirect(o + self._tab.Pos)
+            from .AllocationCounts import AllocationCounts
+            obj = AllocationCounts()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+    # PhaseAllocations
+    def TestEval(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(14))
+        if o != 0:
+            x = self._tab.Indirect(o + self._tab.Pos)
+            from .AllocationCounts import AllocationCounts
+            obj = AllocationCounts()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+    # PhaseAllocations
+    def Stats(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(16))
+        if o != 0:
+            x = self._tab.Indirect(o + self._tab.Pos)
+            from .AllocationCounts import AllocationCounts
+            obj = AllocationCounts()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+    # PhaseAllocations
+    def Serialization(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(18))
+        if o != 0:
+            x = self._tab.Indirect(o + self._tab.Pos)
+            from .AllocationCounts import AllocationCounts
+            obj = AllocationCounts()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+def PhaseAllocationsStart(builder): builder.StartObject(8)
+def PhaseAllocationsAddInitialization(builder, initialization): builder.PrependUOffsetTRelativeSlot(0, flatbuffers.number_types.UOffsetTFlags.py_type(initialization), 0)
+def PhaseAllocationsAddSelection(builder, selection): builder.PrependUOffsetTRelativeSlot(1, flatbuffers.number_types.UOffsetTFlags.py_type(selection), 0)
+def PhaseAllocationsAddCrossover(builder, crossover): builder.PrependUOffsetTRelativeSlot(2, flatbuffers.number_types.UOffsetTFlags.py_type(crossover), 0)
+def PhaseAllocationsAddMutation(builder, mutation): builder.PrependUOffsetTRelativeSlot(3, flatbuffers.number_types.UOffsetTFlags.py_type(mutation), 0)
+def PhaseAllocationsAddTrainEval(builder, trainEval): builder.PrependUOffsetTRelativeSlot(4, flatbuffers.number_types.UOffsetTFlags.py_type(trainEval), 0)
+def PhaseAllocationsAddTestEval(builder, testEval): builder.PrependUOffsetTRelativeSlot(5, flatbuffers.number_types.UOffsetTFlags.py_type(testEval), 0)
+def PhaseAllocationsAddStats(builder, stats): builder.PrependUOffsetTRelativeSlot(6, flatbuffers.number_types.UOffsetTFlags.py_type(stats), 0)
+def PhaseAllocationsAddSerialization(builder, serialization): builder.PrependUOffsetTRelativeSlot(7, flatbuffers.number_types.UOffsetTFlags.py_type(serialization), 0)
+def PhaseAllocationsEnd(builder): return builder.EndObject()
@@ -0,0 +1,129 @@
+# automatically generated by the FlatBuffers compiler, do not modify
+
+# namespace: results
+
+import flatbuffers
+
+# /// Time spent in each phase of a generation, in milliseconds, aggregated for
+# /// all instances.
+class PhaseTimes(object):
+    __slots__ = ['_tab']
+
+    @classmethod
+    def GetRootAsPhaseTimes(cls, buf, offset):
+        n = flatbuffers.encode.Get(flatbuffers.packer.uoffset, buf, offset)
+        x = PhaseTimes()
+        x.Init(buf, n + offset)
+        return x
+
+    # PhaseTimes
+    def Init(self, buf, pos):
+        self._tab = flatbuffers.table.Table(buf, pos)
+
+# /// Generation of the initial population, only in the first generation.
+    # PhaseTimes
+    def InitTime(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(4))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+# /// Tournament selection of the parents.
+    # PhaseTimes
+    def SelectionTime(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(6))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+# /// Crossover of the parents, including bloat control of the children.
+    # PhaseTimes
+    def CrossoverTime(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(8))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+# /// Mutation of the parents, including bloat control of the children.
+    # PhaseTimes
+    def MutationTime(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(10))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+# /// Evaluation on the train dataset, including simplification of the
+# /// genotype and constant tuning.
+    # PhaseTimes
+    def TrainEvalTime(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(12))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+# /// Evaluation on the test dataset.
+    # PhaseTimes
+    def TestEvalTime(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(14))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+# /// Calculation and aggregation of the statistics, except serialization.
+    # PhaseTimes
+    def StatsTime(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(16))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+# /// Serialization of the best individuals of the statistics to strings.
+    # PhaseTimes
+    def SerializationTime(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(18))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+def PhaseTimesStart(builder): builder.StartObject(8)
+def PhaseTimesAddInitTime(builder, initTime): builder.PrependStructSlot(0, flatbuffers.number_types.UOffsetTFlags.py_type(initTime), 0)
+def PhaseTimesAddSelectionTime(builder, selectionTime): builder.PrependStructSlot(1, flatbuffers.number_types.UOffsetTFlags.py_type(selectionTime), 0)
+def PhaseTimesAddCrossoverTime(builder, crossoverTime): builder.PrependStructSlot(2, flatbuffers.number_types.UOffsetTFlags.py_type(crossoverTime), 0)
+def PhaseTimesAddMutationTime(builder, mutationTime): builder.PrependStructSlot(3, flatbuffers.number_types.UOffsetTFlags.py_type(mutationTime), 0)
+def PhaseTimesAddTrainEvalTime(builder, trainEvalTime): builder.PrependStructSlot(4, flatbuffers.number_types.UOffsetTFlags.py_type(trainEvalTime), 0)
+def PhaseTimesAddTestEvalTime(builder, testEvalTime): builder.PrependStructSlot(5, flatbuffers.number_types.UOffsetTFlags.py_type(testEvalTime), 0)
+def PhaseTimesAddStatsTime(builder, statsTime): builder.PrependStructSlot(6, flatbuffers.number_types.UOffsetTFlags.py_type(statsTime), 0)
+def PhaseTimesAddSerializationTime(builder, serializationTime): builder.PrependStructSlot(7, flatbuffers.number_types.UOffsetTFlags.py_type(serializationTime), 0)
+def PhaseTimesEnd(builder): return builder.EndObject()
@@ -86,11 +86,160 @@ class Results(object):
             return obj
         return None
 
-def ResultsStart(builder): builder.StartObject(4)
+# /// Total evaluations needed to reach the target fitness on the train
+# /// dataset, for the instances that reached it.
+    # Results
+    def EvaluationsToTarget(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(12))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+# /// Number of instances that reached the target fitness.
+    # Results
+    def NumReachedTarget(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(14))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Uint64Flags, o + self._tab.Pos)
+        return 0
+
+# /// Time spent in each phase of each generation.
+    # Results
+    def PhaseTimes(self, j):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(16))
+        if o != 0:
+            x = self._tab.Vector(o)
+            x += flatbuffers.number_types.UOffsetTFlags.py_type(j) * 4
+            x = self._tab.Indirect(x)
+            from .PhaseTimes import PhaseTimes
+            obj = PhaseTimes()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+    # Results
+    def PhaseTimesLength(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(16))
+        if o != 0:
+            return self._tab.VectorLen(o)
+        return 0
+
+# /// Performance counters of each region, if enabled with --perf_counters.
+    # Results
+    def Counters(self, j):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(18))
+        if o != 0:
+            x = self._tab.Vector(o)
+            x += flatbuffers.number_types.UOffsetTFlags.py_type(j) * 4
+            x = self._tab.Indirect(x)
+            from .CounterRegion import CounterRegion
+            obj = CounterRegion()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+    # Results
+    def CountersLength(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(18))
+        if o != 0:
+            return self._tab.VectorLen(o)
+        return 0
+
+# /// Allocations of each phase of each generation, if enabled with
+# /// --count_allocations.
+    # Results
+    def PhaseAllocations(self, j):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(20))
+        if o != 0:
+            x = self._tab.Vector(o)
+            x += flatbuffers.number_types.UOffsetTFlags.py_type(j) * 4
+            x = self._tab.Indirect(x)
+            from .PhaseAllocations import PhaseAllocations
+            obj = PhaseAllocations()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+    # Results
+    def PhaseAllocationsLength(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(20))
+        if o != 0:
+            return self._tab.VectorLen(o)
+        return 0
+
+# /// Number of generations run by each instance, including the first.
+    # Results
+    def GenerationsRun(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(22))
+        if o != 0:
+            x = o + self._tab.Pos
+            from .meanStddev import meanStddev
+            obj = meanStddev()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+# /// Number of instances run, less than in params if the time budget ran out.
+    # Results
+    def NumInstancesRun(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(24))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Uint64Flags, o + self._tab.Pos)
+        return 0
+
+# /// Number of instances stopped before running all generations.
+    # Results
+    def NumStoppedEarly(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(26))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Uint64Flags, o + self._tab.Pos)
+        return 0
+
+# /// Statistics of each fold with --kfold. The other statistics aggregate
+# /// the instances of all folds, and the test dataset is the rows held out
+# /// of each fold.
+    # Results
+    def Folds(self, j):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(28))
+        if o != 0:
+            x = self._tab.Vector(o)
+            x += flatbuffers.number_types.UOffsetTFlags.py_type(j) * 4
+            x = self._tab.Indirect(x)
+            from .Fold import Fold
+            obj = Fold()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+    # Results
+    def FoldsLength(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(28))
+        if o != 0:
+            return self._tab.VectorLen(o)
+        return 0
+
+def ResultsStart(builder): builder.StartObject(13)
 def ResultsAddParams(builder, params): builder.PrependUOffsetTRelativeSlot(0, flatbuffers.number_types.UOffsetTFlags.py_type(params), 0)
 def ResultsAddTrainStats(builder, trainStats): builder.PrependUOffsetTRelativeSlot(1, flatbuffers.number_types.UOffsetTFlags.py_type(trainStats), 0)
 def ResultsStartTrainStatsVector(builder, numElems): return builder.StartVector(4, numElems, 4)
 def ResultsAddTestStats(builder, testStats): builder.PrependUOffsetTRelativeSlot(2, flatbuffers.number_types.UOffsetTFlags.py_type(testStats), 0)
 def ResultsStartTestStatsVector(builder, numElems): return builder.StartVector(4, numElems, 4)
 def ResultsAddFinalStats(builder, finalStats): builder.PrependUOffsetTRelativeSlot(3, flatbuffers.number_types.UOffsetTFlags.py_type(finalStats), 0)
+def ResultsAddEvaluationsToTarget(builder, evaluationsToTarget): builder.PrependStructSlot(4, flatbuffers.number_types.UOffsetTFlags.py_type(evaluationsToTarget), 0)
+def ResultsAddNumReachedTarget(builder, numReachedTarget): builder.PrependUint64Slot(5, numReachedTarget, 0)
+def ResultsAddPhaseTimes(builder, phaseTimes): builder.PrependUOffsetTRelativeSlot(6, flatbuffers.number_types.UOffsetTFlags.py_type(phaseTimes), 0)
+def ResultsStartPhaseTimesVector(builder, numElems): return builder.StartVector(4, numElems, 4)
+def ResultsAddCounters(builder, counters): builder.PrependUOffsetTRelativeSlot(7, flatbuffers.number_types.UOffsetTFlags.py_type(counters), 0)
+def ResultsStartCountersVector(builder, numElems): return builder.StartVector(4, numElems, 4)
+def ResultsAddPhaseAllocations(builder, phaseAllocations): builder.PrependUOffsetTRelativeSlot(8, flatbuffers.number_types.UOffsetTFlags.py_type(phaseAllocations), 0)
+def ResultsStartPhaseAllocationsVector(builder, numElems): return builder.StartVector(4, numElems, 4)
+def ResultsAddGenerationsRun(builder, generationsRun): builder.PrependStructSlot(9, flatbuffers.number_types.UOffsetTFlags.py_type(generationsRun), 0)
+def ResultsAddNumInstancesRun(builder, numInstancesRun): builder.PrependUint64Slot(10, numInstancesRun, 0)
+def ResultsAddNumStoppedEarly(builder, numStoppedEarly): builder.PrependUint64Slot(11, numStoppedEarly, 0)
+def ResultsAddFolds(builder, folds): builder.PrependUOffsetTRelativeSlot(12, flatbuffers.number_types.UOffsetTFlags.py_type(folds), 0)
+def ResultsStartFoldsVector(builder, numElems): return builder.StartVector(4, numElems, 4)
 def ResultsEnd(builder): return builder.EndObject()
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glog/logging.h"
+#include <gflags/gflags.h>
+
+#include "parser.hpp"
+
+DEFINE_string(input, "", "CSV dataset to convert.");
+DEFINE_string(output, "",
+              "Output file for the binary dataset. "
+              "Extension should be '.cnatds'.");
+
+int main(int argc, char **argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  CHECK(!FLAGS_input.empty()) << "--input is required.";
+  CHECK(!FLAGS_output.empty()) << "--output is required.";
+
+  const auto &dataset = parser::loadDataset(FLAGS_input);
+  parser::saveBinaryDataset(dataset, FLAGS_output);
+
+  LOG(INFO) << "Converted " << dataset.size() << " samples with "
+            << dataset.numInputs() << " inputs to " << FLAGS_output;
+
+  return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+#include "glog/logging.h"
+#include <gflags/gflags.h>
+
+#include "parser.hpp"
+#include "primitives.hpp"
+#include "synthetic.hpp"
+#include "utils.hpp"
+
+DEFINE_string(output, "",
+              "Output file for the dataset. Datasets with the '.cnatds' "
+              "extension are binary, others are CSV.");
+DEFINE_string(target, "keijzer-10",
+              "Ground-truth expression of the outputs: keijzer-7, keijzer-10, "
+              "random or an expression like '((x0 * x1) + 2)'.");
+DEFINE_uint64(num_rows, 1000000, "Number of rows to generate.");
+DEFINE_uint64(num_inputs, 0,
+              "Number of inputs of each row (0 for the inputs the target "
+              "uses). Extra inputs are unrelated to the outputs.");
+DEFINE_double(min_input, 0,
+              "Minimum value of the inputs. The target's own range is used "
+              "if it is equal to --max_input.");
+DEFINE_double(max_input, 0, "Maximum value of the inputs (exclusive).");
+DEFINE_double(noise, 0,
+              "Standard deviation of the Gaussian noise added to the "
+              "outputs.");
+DEFINE_int32(seed, 0, "Seed of the dataset and of random targets.");
+DEFINE_uint64(random_height, 5, "Maximum height of random targets.");
+DEFINE_string(random_functions, "sum,sub,mult,div",
+              "Comma-separated functions of random targets.");
+
+namespace {
+/// If the output file has the extension of binary datasets.
+bool binaryOutput_(const std::string &filename) {
+  const std::string extension = ".cnatds";
+  return filename.size() >= extension.size() &&
+         filename.compare(filename.size() - extension.size(),
+                          extension.size(), extension) == 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  CHECK(!FLAGS_output.empty()) << "--output is required.";
+
+  synthetic::Target target;
+  if (FLAGS_target == "random") {
+    std::vector<repr::PrimitiveFn> functions;
+    for (const auto &name : parser::splitLine(FLAGS_random_functions, ',')) {
+      functions.push_back(primitives::function(name));
+    }
+    repr::RNG rng(FLAGS_seed);
+    target = synthetic::randomTarget(rng, std::max<size_t>(FLAGS_num_inputs, 1),
+                                     FLAGS_random_height, functions);
+  } else {
+    target = synthetic::target(FLAGS_target);
+  }
+  if (FLAGS_min_input != FLAGS_max_input) {
+    target.minInput = FLAGS_min_input;
+    target.maxInput = FLAGS_max_input;
+  }
+
+  synthetic::Spec spec;
+  spec.numRows = FLAGS_num_rows;
+  spec.numInputs = FLAGS_num_inputs ? FLAGS_num_inputs : target.numInputs;
+  spec.noise = FLAGS_noise;
+  spec.seed = FLAGS_seed;
+  LOG(INFO) << "Target: " << target.expression.str() << ", inputs in ["
+            << target.minInput << ", " << target.maxInput << ")";
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto &dataset = synthetic::generate(target, spec);
+  LOG(INFO) << "Generated " << dataset.size() << " samples with "
+            << dataset.numInputs() << " inputs in " << utils::elapsedMs(start)
+            << " ms";
+
+  const auto saveStart = std::chrono::steady_clock::now();
+  if (binaryOutput_(FLAGS_output)) {
+    parser::saveBinaryDataset(dataset, FLAGS_output);
+  } else {
+    parser::saveCsvDataset(dataset, FLAGS_output);
+  }
+  LOG(INFO) << "Saved to " << FLAGS_output << " in "
+            << utils::elapsedMs(saveStart) << " ms";
+
+  return 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "kfold.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <random>
+
+#include "glog/logging.h"
+
+#include "pool.hpp"
+#include "simulation.hpp"
+
+namespace kfold {
+
+std::vector<Fold> split(const repr::Dataset &dataset, size_t k,
+                        unsigned seed) {
+  CHECK(k >= 2) << "K-fold cross-validation requires at least 2 folds";
+  CHECK(k <= dataset.size()) << "Can't split " << dataset.size()
+                             << " rows in " << k << " folds";
+  CHECK(dataset.summarized());
+
+  // The folds share one shuffled order of the rows, which stay in place.
+  CHECK(dataset.size() <= UINT32_MAX)
+      << "Can't shuffle " << dataset.size() << " rows";
+  auto order = std::make_shared<std::vector<uint32_t>>(dataset.size());
+  std::iota(order->begin(), order->end(), 0);
+  repr::RNG rng(seed);
+  std::shuffle(order->begin(), order->end(), rng);
+
+  std::vector<size_t> bounds(k + 1);
+  for (size_t i = 0; i <= k; ++i) {
+    bounds[i] = i * dataset.size() / k;
+  }
+
+  std::vector<Fold> folds;
+  for (size_t i = 0; i < k; ++i) {
+    repr::DatasetView test(dataset, order, {{bounds[i], bounds[i + 1]}});
+    repr::DatasetView train(
+        dataset, order, {{0, bounds[i]}, {bounds[i + 1], dataset.size()}});
+    folds.push_back({std::move(train), std::move(test)});
+  }
+  return folds;
+}
+
+std::vector<stats::FoldStats> run(const repr::Params &params,
+                                  const std::vector<Fold> &folds,
+                                  size_t numThreads, size_t threadsPerRun) {
+  std::vector<stats::FoldStats> foldStats(folds.size());
+  for (size_t i = 0; i < folds.size(); ++i) {
+    foldStats[i].numTrainRows = folds[i].train.size();
+    foldStats[i].numTestRows = folds[i].test.size();
+  }
+
+  // Instance-major, so the folds of the first instances finish first.
+  const size_t numRuns = params.numInstances * folds.size();
+  LOG(INFO) << "Cross-validating " << folds.size() << " folds in " << numRuns
+            << " runs";
+  pool::run(numRuns, numThreads, threadsPerRun, [&](size_t i) {
+    const size_t instance = i / folds.size(), fold = i % folds.size();
+    LOG(INFO) << "Fold " << fold + 1 << ", instance " << instance + 1;
+
+    std::seed_seq seed{params.seed, (unsigned)instance};
+    repr::RNG rng(seed);
+    simulation::simulateInstance(rng, params, folds[fold].train,
+                                 folds[fold].test, foldStats[fold].train,
+                                 foldStats[fold].test);
+  });
+  return foldStats;
+}
+
+} // namespace kfold
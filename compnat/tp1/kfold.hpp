@@ -0,0 +1,62 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPNAT_TP1_KFOLD_HPP
+#define COMPNAT_TP1_KFOLD_HPP
+
+#include <vector>
+
+#include "representation.hpp"
+#include "statistics.hpp"
+
+/**
+ * K-fold cross-validation: the dataset is split in k blocks of rows, and each
+ * fold trains on k - 1 of them and tests on the remaining one. The folds are
+ * views of a shuffled order of the rows, which stay in place in the dataset.
+ */
+namespace kfold {
+
+/// Train and test rows of a fold.
+struct Fold {
+  repr::DatasetView train;
+  repr::DatasetView test;
+};
+
+/**
+ * Splits the summarized dataset in k blocks of randomly chosen rows, so a
+ * dataset sorted by its inputs isn't tested only on the ends of its range.
+ * Fold i tests on block i and trains on the others. The sizes of the blocks
+ * differ by at most one row. The folds keep the storage of the dataset alive.
+ * @param seed Seed of the shuffle of the rows.
+ */
+std::vector<Fold> split(const repr::Dataset &dataset, size_t k,
+                        unsigned seed);
+
+/**
+ * Runs params.numInstances instances of each fold on a pool of threads. Each
+ * instance uses the same seed in all folds.
+ * @param numThreads Number of threads to use, 0 for one per core.
+ * @param threadsPerRun Minimum number of threads of each instance of a fold.
+ * @return The statistics of each fold.
+ */
+std::vector<stats::FoldStats> run(const repr::Params &params,
+                                  const std::vector<Fold> &folds,
+                                  size_t numThreads = 0,
+                                  size_t threadsPerRun = 1);
+
+} // namespace kfold
+
+#endif // !COMPNAT_TP1_KFOLD_HPP
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "kfold.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "parser.hpp"
+#include "primitives.hpp"
+
+namespace {
+
+/// Values of the first input of the rows of the view.
+std::vector<repr::T> firstInputs(const repr::DatasetView &view) {
+  std::vector<repr::T> values;
+  view.forEachChunk([&](const repr::Dataset &slice) {
+    values.insert(values.end(), slice.input(0), slice.input(0) + slice.size());
+  });
+  return values;
+}
+
+/// Rows of the view whose expected output isn't its first input.
+size_t mismatchedRows(const repr::DatasetView &view) {
+  size_t mismatched = 0;
+  view.forEachChunk([&](const repr::Dataset &slice) {
+    for (size_t i = 0; i < slice.size(); ++i) {
+      mismatched += slice.input(0)[i] != slice.expected()[i];
+    }
+  });
+  return mismatched;
+}
+
+TEST(KFoldTest, SplitsAllRowsInBlocks) {
+  const repr::Dataset dataset = {{{0}, 0}, {{1}, 1}, {{2}, 2}, {{3}, 3},
+                                 {{4}, 4}, {{5}, 5}, {{6}, 6}};
+  const auto &folds = kfold::split(dataset, 3, 1);
+  ASSERT_EQ((size_t)3, folds.size());
+
+  const size_t testSizes[] = {2, 2, 3};
+  std::vector<repr::T> testRows;
+  for (size_t i = 0; i < folds.size(); ++i) {
+    EXPECT_EQ(testSizes[i], folds[i].test.size());
+    EXPECT_EQ(dataset.size() - testSizes[i], folds[i].train.size());
+
+    // Each row is either trained or tested on, with its expected output.
+    auto rows = firstInputs(folds[i].train);
+    const auto &test = firstInputs(folds[i].test);
+    rows.insert(rows.end(), test.begin(), test.end());
+    std::sort(rows.begin(), rows.end());
+    EXPECT_EQ(firstInputs(repr::DatasetView(dataset, {{0, dataset.size()}})),
+              rows);
+    testRows.insert(testRows.end(), test.begin(), test.end());
+    EXPECT_EQ((size_t)0, mismatchedRows(folds[i].train));
+    EXPECT_EQ((size_t)0, mismatchedRows(folds[i].test));
+  }
+
+  // The test blocks are a partition of the rows.
+  std::sort(testRows.begin(), testRows.end());
+  EXPECT_EQ(firstInputs(repr::DatasetView(dataset, {{0, dataset.size()}})),
+            testRows);
+}
+
+TEST(KFoldTest, ReadsTheRowsOfTheDataset) {
+  const repr::Dataset dataset = {{{0}, 0}, {{1}, 1}, {{2}, 2}, {{3}, 3}};
+  for (const auto &fold : kfold::split(dataset, 2, 1)) {
+    // The folds read the storage of the dataset instead of copying it.
+    EXPECT_EQ(dataset.input(0), fold.train.dataset().input(0));
+    EXPECT_EQ(dataset.expected(), fold.train.dataset().expected());
+    EXPECT_EQ(dataset.input(0), fold.test.dataset().input(0));
+    EXPECT_EQ(dataset.expected(), fold.test.dataset().expected());
+  }
+}
+
+TEST(KFoldTest, GathersSummarizedBlocks) {
+  repr::Dataset dataset(2 * repr::DatasetView::GatherRows + 6, 1);
+  for (size_t i = 0; i < dataset.size(); ++i) {
+    dataset.mutableColumn(0)[i] = dataset.mutableColumn(1)[i] = i;
+  }
+  dataset.summarize();
+
+  const auto &folds = kfold::split(dataset, 2, 1);
+  auto rows = firstInputs(folds[0].train);
+  const auto &test = firstInputs(folds[0].test);
+  rows.insert(rows.end(), test.begin(), test.end());
+  std::sort(rows.begin(), rows.end());
+  EXPECT_EQ(firstInputs(repr::DatasetView(dataset, {{0, dataset.size()}})),
+            rows);
+
+  // The blocks of a fold are summarized like the chunks of a stream.
+  size_t numChunks = 0;
+  folds[1].train.forEachChunk([&](const repr::Dataset &chunk) {
+    ASSERT_TRUE(chunk.summarized());
+    EXPECT_GE(repr::DatasetView::GatherRows, chunk.size());
+    EXPECT_EQ(*std::min_element(chunk.input(0), chunk.input(0) + chunk.size()),
+              chunk.summary(0).min);
+    ++numChunks;
+  });
+  EXPECT_EQ((size_t)2, numChunks);
+}
+
+TEST(KFoldTest, ShufflesSortedRows) {
+  repr::Dataset dataset(100, 1);
+  for (size_t i = 0; i < dataset.size(); ++i) {
+    dataset.mutableColumn(0)[i] = dataset.mutableColumn(1)[i] = i;
+  }
+  dataset.summarize();
+
+  // Every fold tests on rows from the whole range of the input.
+  const auto &folds = kfold::split(dataset, 4, 1);
+  for (const auto &fold : folds) {
+    const auto &test = firstInputs(fold.test);
+    ASSERT_EQ((size_t)25, test.size());
+    EXPECT_GT(25, *std::min_element(test.begin(), test.end()));
+    EXPECT_LE(75, *std::max_element(test.begin(), test.end()));
+  }
+
+  // The same seed splits the same rows.
+  EXPECT_EQ(firstInputs(folds[0].test),
+            firstInputs(kfold::split(dataset, 4, 1)[0].test));
+  EXPECT_NE(firstInputs(folds[0].test),
+            firstInputs(kfold::split(dataset, 4, 2)[0].test));
+}
+
+TEST(KFoldTest, RunsAllInstancesOfAllFolds) {
+  const auto &dataset =
+      parser::loadDataset("compnat/tp1/datasets/keijzer-7-train.csv");
+  const auto &folds = kfold::split(dataset, 4, 1);
+
+  repr::Params params( // Keep formatting
+      "", 1, 2, 3, 60, 5, 7, 0.9, false, false,
+      {
+          primitives::sumFn,
+          primitives::subFn,
+          primitives::multFn,
+          primitives::divFn,
+      },
+      {
+          primitives::constTerm,
+          primitives::makeVarTerm(0),
+      });
+  params.statsLevel = repr::StatsLevel::None;
+
+  // Each instance has its own seed, so the results don't depend on the
+  // number of threads.
+  const auto &serial = kfold::run(params, folds, 1, 1);
+  const auto &parallel = kfold::run(params, folds, 4, 1);
+  ASSERT_EQ((size_t)4, serial.size());
+  ASSERT_EQ((size_t)4, parallel.size());
+
+  stats::Aggregator pooled;
+  size_t numTestRows = 0;
+  for (size_t i = 0; i < serial.size(); ++i) {
+    EXPECT_EQ(folds[i].train.size(), serial[i].numTrainRows);
+    EXPECT_EQ(folds[i].test.size(), serial[i].numTestRows);
+    EXPECT_EQ((size_t)2, serial[i].test.finalStats().count());
+    EXPECT_EQ((size_t)2, serial[i].train.generationsRun().count());
+    EXPECT_DOUBLE_EQ(serial[i].test.finalStats().bestFitness.mean(),
+                     parallel[i].test.finalStats().bestFitness.mean());
+    pooled.merge(serial[i].test);
+    numTestRows += serial[i].numTestRows;
+  }
+  EXPECT_EQ(dataset.size(), numTestRows);
+  EXPECT_EQ((size_t)8, pooled.finalStats().count());
+}
+
+} // namespace
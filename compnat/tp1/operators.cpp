@@ -20,12 +20,14 @@
 #include <random>
 #include <stack>
 
+#include "compnat/common/allocations.hpp"
 #include "generators.hpp"
+#include "utils.hpp"
 
 namespace operators {
 
 size_t tournamentSelection(repr::RNG &rng, size_t tournamentSize,
-                           const std::vector<repr::T> &fitnesses) {
+                           const std::vector<double> &fitnesses) {
   std::uniform_int_distribution<size_t> distr(0, fitnesses.size() - 1);
   size_t best = distr(rng);
 
@@ -121,54 +123,104 @@ newGeneration(repr::RNG &rng, const repr::Params &params,
               const std::vector<repr::Node> &parentPopulation,
               const std::vector<double> &parentFitnesses,
               const std::vector<size_t> &parentSizes,
-              const stats::Statistics &parentStats) {
+              const stats::Statistics &parentStats,
+              stats::PhaseTimes *times, stats::PhaseAllocations *allocs) {
   CHECK(params.crossoverProb >= 0.0 && params.crossoverProb < 1.0);
+  const auto &bloat = params.bloat;
+  stats::PhaseTimes unusedTimes;
+  auto &phaseTimes = times ? *times : unusedTimes;
+  stats::PhaseAllocations unusedAllocs;
+  auto &phaseAllocs = allocs ? *allocs : unusedAllocs;
+
+  // Parsimony pressure penalizes big individuals during selection.
+  std::vector<double> selectionFitnesses = parentFitnesses;
+  if (bloat.parsimonyCoefficient) {
+    for (size_t i = 0; i < selectionFitnesses.size(); ++i) {
+      selectionFitnesses[i] += bloat.parsimonyCoefficient * parentSizes[i];
+    }
+  }
 
-  size_t i = 0;
+  size_t numNodes = 0;
   std::vector<repr::Node> newPopulation;
+  newPopulation.reserve(parentPopulation.size());
   if (params.elitism) {
     // Make a copy.
     newPopulation.push_back(parentPopulation[parentStats.best]);
-    i++;
+    numNodes += parentSizes[parentStats.best];
   }
 
   std::uniform_real_distribution<double> distr(0.0, 1.0);
   stats::ImprovementMetadata metadata;
+
+  // The improvement stats are only computed with full statistics.
+  const bool trackParents = params.statsLevel == repr::StatsLevel::Full;
+
+  // Adds the child to the new population, unless it is full or the child is
+  // rejected by bloat control.
+  const auto addChild = [&](repr::Node &&child, double parentFitness,
+                            std::vector<std::pair<size_t, double>> &parents) {
+    if (newPopulation.size() == parentPopulation.size()) {
+      return;
+    }
+
+    if (bloat.tarpeianProb || bloat.nodeBudget) {
+      const size_t size = child.size();
+      if (bloat.tarpeianProb && size > parentStats.avgSize &&
+          distr(rng) < bloat.tarpeianProb) {
+        return;
+      }
+
+      // Leaves at least one node for each of the remaining individuals.
+      const size_t remaining =
+          parentPopulation.size() - newPopulation.size() - 1;
+      if (bloat.nodeBudget && numNodes + size + remaining > bloat.nodeBudget) {
+        newPopulation.emplace_back(
+            generators::randomPrimitive(rng, params.terminals));
+        ++numNodes;
+        return;
+      }
+      numNodes += size;
+    }
+
+    if (trackParents) {
+      parents.emplace_back(newPopulation.size(), parentFitness);
+    }
+    newPopulation.push_back(std::move(child));
+  };
+
   while (newPopulation.size() < parentPopulation.size()) {
-    const size_t p1 =
-        tournamentSelection(rng, params.tournamentSize, parentFitnesses);
+    size_t p1, p2;
+    {
+      utils::ScopedTimer timer(phaseTimes.selectionTime);
+      allocations::Scope scope(phaseAllocs.selection);
+      p1 = tournamentSelection(rng, params.tournamentSize, selectionFitnesses);
+      p2 = tournamentSelection(rng, params.tournamentSize, selectionFitnesses);
+    }
     const auto p1Fitness = parentFitnesses[p1];
-    const size_t p2 =
-        tournamentSelection(rng, params.tournamentSize, parentFitnesses);
     const auto p2Fitness = parentFitnesses[p2];
 
     if (distr(rng) <= params.crossoverProb) { // Crossover
+      utils::ScopedTimer timer(phaseTimes.crossoverTime);
+      allocations::Scope scope(phaseAllocs.crossover);
       auto[c1, c2] =
           crossover(rng, params, parentPopulation[p1], parentSizes[p1],
                     parentPopulation[p2], parentSizes[p2]);
-      newPopulation.push_back(std::move(c1));
-      newPopulation.push_back(std::move(c2));
 
       const auto avgParentFitness = (p1Fitness + p2Fitness) / 2.0;
-      metadata.crossoverAvgParentFitness.emplace_back(i++, avgParentFitness);
-      metadata.crossoverAvgParentFitness.emplace_back(i++, avgParentFitness);
+      addChild(std::move(c1), avgParentFitness,
+               metadata.crossoverAvgParentFitness);
+      addChild(std::move(c2), avgParentFitness,
+               metadata.crossoverAvgParentFitness);
     } else { // Mutation
-      newPopulation.push_back(
-          mutation(rng, params, parentPopulation[p1], parentSizes[p1]));
-      newPopulation.push_back(
-          mutation(rng, params, parentPopulation[p2], parentSizes[p2]));
-
-      metadata.mutationParentFitness.emplace_back(i++, p1Fitness);
-      metadata.mutationParentFitness.emplace_back(i++, p2Fitness);
+      utils::ScopedTimer timer(phaseTimes.mutationTime);
+      allocations::Scope scope(phaseAllocs.mutation);
+      addChild(mutation(rng, params, parentPopulation[p1], parentSizes[p1]),
+               p1Fitness, metadata.mutationParentFitness);
+      addChild(mutation(rng, params, parentPopulation[p2], parentSizes[p2]),
+               p2Fitness, metadata.mutationParentFitness);
     }
   }
 
-  // We added always two new individuals, so we may have exceeded the population
-  // size.
-  if (newPopulation.size() > parentPopulation.size()) {
-    CHECK(newPopulation.size() == parentPopulation.size() + 1);
-    newPopulation.pop_back();
-  }
   return {newPopulation, metadata};
 }
 
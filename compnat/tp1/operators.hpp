@@ -35,7 +35,7 @@ namespace operators {
  * @return The index of the individual with the best fitness in the tournament.
  */
 size_t tournamentSelection(repr::RNG &rng, size_t tournamentSize,
-                           const std::vector<repr::T> &fitnesses);
+                           const std::vector<double> &fitnesses);
 
 /**
  * Uses a traversal to select a random tree point.
@@ -88,6 +88,10 @@ repr::Node mutation(repr::RNG &rng, const repr::Params &params,
  * @param parentFitnesses Fitnesses of the parent population.
  * @param parnentSizes Sizes of the parent population.
  * @param parentStats Statistics of the parent generation.
+ * @param times If not null, the selection, crossover and mutation times are
+ *   added to it.
+ * @param allocs If not null, the selection, crossover and mutation
+ *   allocations are added to it, see allocations::enable().
  * @return Tuple containing the new population, the indices of crossover
  *   children and indices of mutation children.
  */
@@ -96,7 +100,9 @@ newGeneration(repr::RNG &rng, const repr::Params &params,
               const std::vector<repr::Node> &parentPopulation,
               const std::vector<double> &parentFitnesses,
               const std::vector<size_t> &parentSizes,
-              const stats::Statistics &parentStats);
+              const stats::Statistics &parentStats,
+              stats::PhaseTimes *times = nullptr,
+              stats::PhaseAllocations *allocs = nullptr);
 
 } // namespace operators
 
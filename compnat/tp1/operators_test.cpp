@@ -16,10 +16,12 @@
 
 #include "operators.hpp"
 
+#include <numeric>
 #include <random>
 
 #include <gtest/gtest.h>
 
+#include "compnat/common/allocations.hpp"
 #include "generators.hpp"
 #include "parser.hpp"
 #include "primitives.hpp"
@@ -150,4 +152,126 @@ TEST(NewGenerationTest, WorksCorrectly) {
   EXPECT_EQ(population[stats.best].str(), newPopulation[0].str());
 }
 
+TEST(NewGenerationTest, MeasuresPhaseTimes) {
+  repr::RNG rng;
+  const repr::Params params( // Keep formatting
+      "", 0, 0, 10, 60, 5, 7, 0.5, false, false,
+      {
+          primitives::sumFn,
+          primitives::subFn,
+          primitives::multFn,
+          primitives::divFn,
+      },
+      {
+          primitives::constTerm,
+          primitives::makeVarTerm(0),
+      });
+
+  const auto &dataset =
+      parser::loadDataset("compnat/tp1/datasets/keijzer-7-train.csv");
+  const auto &population = generators::rampedHalfAndHalf(rng, params);
+  const auto &fitnesses = stats::fitness(population, dataset);
+  const auto &sizes = stats::sizes(population);
+  const stats::Statistics stats("train", population, fitnesses, sizes);
+  EXPECT_LT(0, stats.serializationTime);
+
+  stats::PhaseTimes times;
+  newGeneration(rng, params, population, fitnesses, sizes, stats, &times);
+  EXPECT_LT(0, times.selectionTime);
+  EXPECT_LT(0, times.crossoverTime);
+  EXPECT_LT(0, times.mutationTime);
+  EXPECT_EQ(0, times.trainEvalTime);
+}
+
+TEST(NewGenerationTest, CountsPhaseAllocations) {
+  repr::RNG rng;
+  const repr::Params params( // Keep formatting
+      "", 0, 0, 10, 60, 5, 7, 0.5, false, false,
+      {
+          primitives::sumFn,
+          primitives::subFn,
+          primitives::multFn,
+          primitives::divFn,
+      },
+      {
+          primitives::constTerm,
+          primitives::makeVarTerm(0),
+      });
+
+  const auto &dataset =
+      parser::loadDataset("compnat/tp1/datasets/keijzer-7-train.csv");
+  const auto &population = generators::rampedHalfAndHalf(rng, params);
+  const auto &fitnesses = stats::fitness(population, dataset);
+  const auto &sizes = stats::sizes(population);
+
+  allocations::enable();
+  const stats::Statistics stats("train", population, fitnesses, sizes);
+  EXPECT_LT((size_t)0, stats.serializationAllocations.numAllocations);
+
+  stats::PhaseAllocations allocs;
+  newGeneration(rng, params, population, fitnesses, sizes, stats, nullptr,
+                &allocs);
+  EXPECT_LT((size_t)0, allocs.crossover.numAllocations);
+  EXPECT_LT((size_t)0, allocs.mutation.bytes);
+  EXPECT_LE(allocs.crossover.peakBytes, allocs.total().peakBytes);
+  EXPECT_EQ((size_t)0, allocs.trainEval.numAllocations);
+}
+
+/// Total number of nodes after running a few generations with the given bloat
+/// control params.
+size_t totalSizeWithBloatControl(const repr::BloatParams &bloat) {
+  repr::RNG rng;
+  const repr::Params params( // Keep formatting
+      "", 0, 0, 10, 60, 5, 7, 0.9, false, false,
+      {
+          primitives::sumFn,
+          primitives::subFn,
+          primitives::multFn,
+          primitives::divFn,
+      },
+      {
+          primitives::constTerm,
+          primitives::makeVarTerm(0),
+      },
+      false, bloat);
+
+  const auto &dataset =
+      parser::loadDataset("compnat/tp1/datasets/keijzer-7-train.csv");
+
+  auto population = generators::rampedHalfAndHalf(rng, params);
+  for (size_t i = 0; i < 20; ++i) {
+    const auto &fitnesses = stats::fitness(population, dataset);
+    const auto &sizes = stats::sizes(population);
+    const stats::Statistics stats("train", population, fitnesses, sizes);
+    auto[newPopulation, metadata] =
+        newGeneration(rng, params, population, fitnesses, sizes, stats);
+
+    EXPECT_EQ(population.size(), newPopulation.size());
+    for (const auto & [ index, parentFitness ] :
+         metadata.crossoverAvgParentFitness) {
+      EXPECT_LT(index, newPopulation.size());
+    }
+    population = std::move(newPopulation);
+  }
+
+  const auto &sizes = stats::sizes(population);
+  return std::accumulate(sizes.begin(), sizes.end(), (size_t)0);
+}
+
+TEST(NewGenerationTest, ControlsBloat) {
+  const size_t totalSize = totalSizeWithBloatControl({});
+
+  repr::BloatParams tarpeian;
+  tarpeian.tarpeianProb = 0.9;
+  EXPECT_GT(totalSize, totalSizeWithBloatControl(tarpeian));
+
+  repr::BloatParams parsimony;
+  parsimony.parsimonyCoefficient = 1;
+  EXPECT_GT(totalSize, totalSizeWithBloatControl(parsimony));
+
+  repr::BloatParams budget;
+  budget.nodeBudget = 200;
+  EXPECT_GE((size_t)200, totalSizeWithBloatControl(budget));
+}
+
 } // namespace
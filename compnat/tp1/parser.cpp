@@ -16,13 +16,322 @@
 
 #include "parser.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "glog/logging.h"
 
 #include "utils.hpp"
 
 namespace parser {
+namespace {
+
+/// Minimum size in bytes of the chunks parsed in parallel.
+const size_t MinChunkSize = 1 << 20;
+
+/// Number of rows formatted at a time by each thread when saving CSVs.
+const size_t CsvBlockRows = 1 << 14;
+
+/// Magic number at the start of binary datasets.
+const char BinaryMagic[8] = {'C', 'N', 'A', 'T', 'D', 'S', '\0', '\0'};
+
+/// Current version of the binary dataset format.
+const uint32_t BinaryVersion = 1;
+
+/// Type of the values stored in a binary dataset.
+enum class DType_ : uint32_t { Float32 = 1, Float64 = 2 };
+
+/// Header of binary datasets. See loadBinaryDataset() for the format.
+struct BinaryHeader_ {
+  char magic[8];
+  uint32_t version;
+  DType_ dtype;
+  uint64_t numRows;
+  uint64_t numColumns;
+  uint64_t columnStride;
+  uint64_t checksum;
+  uint8_t reserved[16];
+};
+static_assert(sizeof(BinaryHeader_) == repr::Dataset::ColumnAlignment,
+              "The columns must start aligned after the header.");
+
+/// Binary dataset value type of repr::T.
+const DType_ NativeDType =
+    std::is_same<repr::T, float>::value ? DType_::Float32 : DType_::Float64;
+
+/// Range of whole lines of the CSV data, parsed independently.
+struct Chunk_ {
+  const char *begin;
+  const char *end;
+
+  /// Number of lines and of non-blank lines (rows) in the chunk.
+  size_t numLines = 0;
+  size_t numRows = 0;
+
+  /// Line and row of the dataset where the chunk starts.
+  size_t firstLine = 0;
+  size_t firstRow = 0;
+
+  /// Error found while parsing the chunk, if any.
+  std::string error;
+
+  Chunk_(const char *begin, const char *end) : begin(begin), end(end) {}
+};
+
+/// Read-only memory mapping of a whole file.
+class MappedFile_ {
+public:
+  explicit MappedFile_(const std::string &filename) : data_(nullptr), size_(0) {
+    const int fd = open(filename.c_str(), O_RDONLY);
+    CHECK(fd >= 0) << "Failed to open " << filename;
+
+    struct stat st;
+    CHECK(fstat(fd, &st) == 0) << "Failed to stat " << filename;
+    size_ = st.st_size;
+    if (size_) {
+      data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      CHECK(data_ != MAP_FAILED) << "Failed to map " << filename;
+      madvise(data_, size_, MADV_WILLNEED);
+    }
+    close(fd);
+  }
+
+  ~MappedFile_() {
+    if (size_) {
+      munmap(data_, size_);
+    }
+  }
+
+  MappedFile_(const MappedFile_ &) = delete;
+  MappedFile_ &operator=(const MappedFile_ &) = delete;
+
+  const char *data() const { return static_cast<const char *>(data_); }
+  size_t size() const { return size_; }
+
+private:
+  void *data_;
+  size_t size_;
+};
+
+bool isBinary_(const MappedFile_ &file) {
+  return file.size() >= sizeof(BinaryHeader_) &&
+         !std::memcmp(file.data(), BinaryMagic, sizeof(BinaryMagic));
+}
+
+/// Copies a column stored with a different value type.
+template <typename U>
+void convertColumn_(const char *data, size_t numRows, repr::T *column) {
+  for (size_t i = 0; i < numRows; ++i) {
+    U value;
+    std::memcpy(&value, data + i * sizeof(U), sizeof(U));
+    column[i] = value;
+  }
+}
+
+BinaryDatasetInfo validateHeader_(const BinaryHeader_ &header, size_t fileSize,
+                                  const std::string &filename) {
+  CHECK(!std::memcmp(header.magic, BinaryMagic, sizeof(BinaryMagic)))
+      << filename << ": not a binary dataset";
+  CHECK(header.version == BinaryVersion)
+      << filename << ": unsupported binary dataset version " << header.version;
+  CHECK(header.dtype == DType_::Float32 || header.dtype == DType_::Float64)
+      << filename << ": unknown value type " << (uint32_t)header.dtype;
+  const size_t valueSize = header.dtype == DType_::Float32 ? 4 : 8;
+  CHECK(header.numColumns >= 2) << filename << ": samples need an input";
+  CHECK(header.numRows <= SIZE_MAX / valueSize)
+      << filename << ": invalid number of rows " << header.numRows;
+  CHECK(header.columnStride >= header.numRows * valueSize &&
+        header.columnStride % repr::Dataset::ColumnAlignment == 0)
+      << filename << ": invalid column stride " << header.columnStride;
+
+  // Checked by division, so a corrupted header can't wrap the product.
+  CHECK(fileSize >= sizeof(header) &&
+        (!header.columnStride ||
+         header.numColumns <=
+             (fileSize - sizeof(header)) / header.columnStride))
+      << filename << ": truncated binary dataset";
+
+  BinaryDatasetInfo info;
+  info.numRows = header.numRows;
+  info.numInputs = header.numColumns - 1;
+  info.valueSize = valueSize;
+  info.dataOffset = sizeof(header);
+  info.columnStride = header.columnStride;
+  info.checksum = header.checksum;
+  return info;
+}
+
+repr::Dataset loadBinary_(std::shared_ptr<MappedFile_> file,
+                          const std::string &filename, bool verifyChecksum) {
+  CHECK(isBinary_(*file)) << filename << ": not a binary dataset";
+  BinaryHeader_ header;
+  std::memcpy(&header, file->data(), sizeof(header));
+  validateHeader_(header, file->size(), filename);
+
+  const size_t dataSize = header.columnStride * header.numColumns;
+  const char *data = file->data() + sizeof(header);
+  if (verifyChecksum) {
+    CHECK(binaryChecksum(data, dataSize) == header.checksum)
+        << filename << ": checksum mismatch, the dataset is corrupted";
+  }
+
+  if (header.dtype == NativeDType) {
+    // The mapping is page aligned, so the columns are aligned too.
+    std::vector<repr::T *> columns;
+    for (size_t i = 0; i < header.numColumns; ++i) {
+      columns.push_back(reinterpret_cast<repr::T *>(
+          const_cast<char *>(data + i * header.columnStride)));
+    }
+    repr::Dataset dataset(header.numRows, std::move(columns), std::move(file));
+    dataset.summarize();
+    return dataset;
+  }
+
+  repr::Dataset dataset(header.numRows, header.numColumns - 1);
+  for (size_t i = 0; i < header.numColumns; ++i) {
+    const char *column = data + i * header.columnStride;
+    if (header.dtype == DType_::Float32) {
+      convertColumn_<float>(column, header.numRows, dataset.mutableColumn(i));
+    } else {
+      convertColumn_<double>(column, header.numRows, dataset.mutableColumn(i));
+    }
+  }
+  dataset.summarize();
+  return dataset;
+}
+
+bool isSpace_(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+bool isBlank_(const char *begin, const char *end) {
+  return std::all_of(begin, end, isSpace_);
+}
+
+/// Returns the end of the line starting at begin (the newline or end).
+const char *lineEnd_(const char *begin, const char *end) {
+  const void *newline = std::memchr(begin, '\n', end - begin);
+  return newline ? static_cast<const char *>(newline) : end;
+}
+
+/// Splits the data in chunks of whole lines.
+std::vector<Chunk_> splitChunks_(const char *data, size_t size) {
+  const size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+  const size_t numChunks = std::min(size / MinChunkSize + 1, 4 * numThreads);
+  const char *end = data + size;
+
+  std::vector<Chunk_> chunks;
+  const char *begin = data;
+  for (size_t i = 1; i <= numChunks && begin < end; ++i) {
+    const char *chunkEnd = end;
+    if (i < numChunks) {
+      chunkEnd = std::max(begin, data + i * size / numChunks);
+      chunkEnd = std::min(end, lineEnd_(chunkEnd, end) + 1);
+    }
+    chunks.emplace_back(begin, chunkEnd);
+    begin = chunkEnd;
+  }
+
+  return chunks;
+}
+
+void countRows_(Chunk_ &chunk) {
+  for (const char *line = chunk.begin; line < chunk.end;) {
+    const char *end = lineEnd_(line, chunk.end);
+    ++chunk.numLines;
+    if (!isBlank_(line, end)) {
+      ++chunk.numRows;
+    }
+    line = end + 1;
+  }
+}
+
+/// Number of values in the first non-blank line of the data.
+size_t countValues_(const char *data, size_t size) {
+  const char *end = data + size;
+  for (const char *line = data; line < end;) {
+    const char *lineEnd = lineEnd_(line, end);
+    if (!isBlank_(line, lineEnd)) {
+      return std::count(line, lineEnd, ',') + 1;
+    }
+    line = lineEnd + 1;
+  }
+  return 0;
+}
+
+/**
+ * Parses a value that ends at the next comma or at end.
+ * @return Pointer to after the value and its separator, or nullptr if the
+ *   value is invalid.
+ */
+const char *parseValue_(const char *begin, const char *end, repr::T &value) {
+  while (begin < end && isSpace_(*begin)) {
+    ++begin;
+  }
+  if (begin < end && *begin == '+') { // from_chars doesn't accept it.
+    ++begin;
+  }
+
+  const auto[ptr, ec] = std::from_chars(begin, end, value);
+  if (ec != std::errc() || ptr == begin) {
+    return nullptr;
+  }
+
+  const char *next = ptr;
+  while (next < end && isSpace_(*next)) {
+    ++next;
+  }
+  if (next < end && *next != ',') {
+    return nullptr;
+  }
+  return next + 1;
+}
+
+void parseChunk_(Chunk_ &chunk, const std::string &name,
+                 repr::Dataset &dataset) {
+  const size_t numValues = dataset.numInputs() + 1;
+  size_t lineNumber = chunk.firstLine;
+  size_t row = chunk.firstRow;
+  for (const char *line = chunk.begin; line < chunk.end;) {
+    const char *end = lineEnd_(line, chunk.end);
+    ++lineNumber;
+    if (isBlank_(line, end)) {
+      line = end + 1;
+      continue;
+    }
+
+    const size_t lineValues = std::count(line, end, ',') + 1;
+    if (lineValues != numValues) {
+      chunk.error = utils::strCat(name, ":", lineNumber, ": expected ",
+                                  numValues, " values, found ", lineValues);
+      return;
+    }
+
+    const char *value = line;
+    for (size_t i = 0; i < numValues; ++i) {
+      value = parseValue_(value, end, dataset.mutableColumn(i)[row]);
+      if (!value) {
+        chunk.error = utils::strCat(name, ":", lineNumber, ": value ", i + 1,
+                                    " is not a valid number");
+        return;
+      }
+    }
+
+    ++row;
+    line = end + 1;
+  }
+}
+
+} // namespace
 
 std::vector<std::string> splitLine(const std::string &text, char sep) {
   std::vector<std::string> tokens;
@@ -35,27 +344,161 @@ std::vector<std::string> splitLine(const std::string &text, char sep) {
   return tokens;
 }
 
-repr::Dataset loadDataset(const std::string &filename) {
-  repr::Dataset dataset;
+repr::Dataset loadDataset(const std::string &filename, bool verifyChecksum) {
+  auto file = std::make_shared<MappedFile_>(filename);
+  if (isBinary_(*file)) {
+    return loadBinary_(std::move(file), filename, verifyChecksum);
+  }
+  return parseDataset(file->data(), file->size(), filename);
+}
+
+repr::Dataset loadBinaryDataset(const std::string &filename,
+                                bool verifyChecksum) {
+  return loadBinary_(std::make_shared<MappedFile_>(filename), filename,
+                     verifyChecksum);
+}
+
+bool isBinaryDataset(const std::string &filename) {
+  std::ifstream in(filename, std::ifstream::binary);
+  CHECK(in.is_open()) << "Failed to open " << filename;
 
-  std::ifstream in(filename);
-  CHECK(in.is_open());
+  char magic[sizeof(BinaryMagic)];
+  return in.read(magic, sizeof(magic)) &&
+         !std::memcmp(magic, BinaryMagic, sizeof(BinaryMagic));
+}
+
+uint64_t binaryChecksum(const char *data, size_t size, uint64_t hash) {
+  for (size_t i = 0; i < size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, data + i, sizeof(word));
+    hash = (hash ^ word) * 1099511628211ull;
+  }
+  return hash;
+}
+
+BinaryDatasetInfo readBinaryDatasetInfo(const std::string &filename) {
+  std::ifstream in(filename, std::ifstream::binary | std::ifstream::ate);
+  CHECK(in.is_open()) << "Failed to open " << filename;
+  const size_t fileSize = in.tellg();
+  in.seekg(0);
+
+  BinaryHeader_ header;
+  CHECK(in.read((char *)&header, sizeof(header)))
+      << filename << ": not a binary dataset";
+  return validateHeader_(header, fileSize, filename);
+}
+
+void saveBinaryDataset(const repr::Dataset &dataset,
+                       const std::string &filename) {
+  std::ofstream out(filename, std::ofstream::out | std::ofstream::trunc |
+                                  std::ofstream::binary);
+  CHECK(out.is_open()) << "Failed to open " << filename;
 
-  std::string line;
-  while (std::getline(in, line)) {
-    const auto &tokens = splitLine(line, ',');
-    const size_t numInputs = tokens.size() - 1;
+  BinaryHeader_ header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, BinaryMagic, sizeof(BinaryMagic));
+  header.version = BinaryVersion;
+  header.dtype = NativeDType;
+  header.numRows = dataset.size();
+  header.numColumns = dataset.numInputs() + 1;
+  header.columnStride = repr::Dataset::columnStride(dataset.size());
+  header.checksum = EmptyBinaryChecksum;
 
-    repr::EvalInput input(numInputs);
-    for (size_t i = 0; i < numInputs; ++i) {
-      utils::strSplit(tokens[i], input[i]);
+  // The checksum is only known after the columns are written.
+  out.write((const char *)&header, sizeof(header));
+  std::vector<char> column(header.columnStride, 0);
+  for (size_t i = 0; i < header.numColumns; ++i) {
+    const repr::T *values =
+        i < dataset.numInputs() ? dataset.input(i) : dataset.expected();
+    std::memcpy(column.data(), values, dataset.size() * sizeof(repr::T));
+    header.checksum =
+        binaryChecksum(column.data(), column.size(), header.checksum);
+    out.write(column.data(), column.size());
+  }
+
+  out.seekp(0);
+  out.write((const char *)&header, sizeof(header));
+  CHECK(out.good()) << "Failed to write " << filename;
+}
+
+void saveCsvDataset(const repr::Dataset &dataset, const std::string &filename) {
+  std::ofstream out(filename, std::ofstream::out | std::ofstream::trunc |
+                                  std::ofstream::binary);
+  CHECK(out.is_open()) << "Failed to open " << filename;
+
+  // Formats a few blocks per thread at a time, writing them in order.
+  const size_t numBlocks = (dataset.size() + CsvBlockRows - 1) / CsvBlockRows;
+  const size_t numBuffered =
+      4 * std::max<size_t>(1, std::thread::hardware_concurrency());
+  std::vector<std::string> blocks(numBuffered);
+  for (size_t first = 0; first < numBlocks; first += numBuffered) {
+    const size_t last = std::min(numBlocks, first + numBuffered);
+
+#pragma omp parallel for schedule(dynamic)
+    for (size_t block = first; block < last; ++block) {
+      auto &text = blocks[block - first];
+      text.clear();
+      const size_t end = std::min(dataset.size(), (block + 1) * CsvBlockRows);
+      for (size_t row = block * CsvBlockRows; row < end; ++row) {
+        for (size_t column = 0; column <= dataset.numInputs(); ++column) {
+          const repr::T value = column < dataset.numInputs()
+                                    ? dataset.input(column)[row]
+                                    : dataset.expected()[row];
+          char buffer[32];
+          const auto[ptr, ec] =
+              std::to_chars(buffer, buffer + sizeof(buffer), value);
+          CHECK(ec == std::errc());
+          text.append(buffer, ptr);
+          text.push_back(column < dataset.numInputs() ? ',' : '\n');
+        }
+      }
     }
 
-    repr::T expectedValue;
-    utils::strSplit(tokens[tokens.size() - 1], expectedValue);
-    dataset.push_back({input, expectedValue});
+    for (size_t block = first; block < last; ++block) {
+      out.write(blocks[block - first].data(), blocks[block - first].size());
+    }
+  }
+  CHECK(out.good()) << "Failed to write " << filename;
+}
+
+repr::Dataset parseDataset(const char *data, size_t size,
+                           const std::string &name, size_t firstLine) {
+  auto chunks = splitChunks_(data, size);
+  const auto numChunks = chunks.size();
+
+#pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < numChunks; ++i) {
+    countRows_(chunks[i]);
+  }
+
+  size_t numRows = 0, numLines = firstLine;
+  for (auto &chunk : chunks) {
+    chunk.firstRow = numRows;
+    chunk.firstLine = numLines;
+    numRows += chunk.numRows;
+    numLines += chunk.numLines;
+  }
+  if (!numRows) {
+    return {};
   }
 
+  const size_t numValues = countValues_(data, size);
+  CHECK(numValues >= 2) << name << ": samples need at least one input";
+  repr::Dataset dataset(numRows, numValues - 1);
+
+#pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < numChunks; ++i) {
+    parseChunk_(chunks[i], name, dataset);
+  }
+
+  for (const auto &chunk : chunks) {
+    if (!chunk.error.empty()) {
+      LOG(FATAL) << "Malformed dataset: " << chunk.error;
+    }
+  }
+
+  dataset.summarize();
   return dataset;
 }
+
 } // namespace parser
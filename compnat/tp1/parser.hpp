@@ -17,6 +17,7 @@
 #ifndef COMPNAT_TP1_PARSER_HPP
 #define COMPNAT_TP1_PARSER_HPP
 
+#include <cstdint>
 #include <string>
 
 #include "representation.hpp"
@@ -27,9 +28,92 @@ namespace parser {
 std::vector<std::string> splitLine(const std::string &text, char sep);
 
 /**
- * Loads a dataset from a CSV file.
+ * Loads a dataset from a CSV or binary dataset file, detected by its contents.
+ * CSV files are memory mapped and parsed directly into the dataset columns, in
+ * parallel chunks if they're big enough. Aborts reporting the line if a row is
+ * malformed.
+ * @param filename Dataset file.
+ * @param verifyChecksum If the checksum of binary datasets should be verified.
  */
-repr::Dataset loadDataset(const std::string &filename);
+repr::Dataset loadDataset(const std::string &filename,
+                          bool verifyChecksum = true);
+
+/**
+ * Loads a dataset in the binary dataset format (.cnatds).
+ * The file is a 64 byte header (magic "CNATDS", version, value type, number of
+ * rows and columns, column stride and FNV-1a checksum of the column data)
+ * followed by each input column and then the expected output column. Columns
+ * are zero padded to a multiple of 64 bytes and stored in the host byte order.
+ *
+ * If the values have the type of repr::T, the dataset columns point directly
+ * to the memory mapped file, without any copy or parsing.
+ * @param filename Dataset file.
+ * @param verifyChecksum If the checksum of the column data should be verified.
+ */
+repr::Dataset loadBinaryDataset(const std::string &filename,
+                                bool verifyChecksum = true);
+
+/// Layout of a binary dataset file.
+struct BinaryDatasetInfo {
+  /// Number of samples.
+  size_t numRows;
+
+  /// Number of input variables of each sample.
+  size_t numInputs;
+
+  /// Size in bytes of each value (4 for float32 and 8 for float64).
+  size_t valueSize;
+
+  /// Offset in bytes of the first column in the file.
+  size_t dataOffset;
+
+  /// Distance in bytes between the start of consecutive columns.
+  size_t columnStride;
+
+  /// Checksum of the column data, see binaryChecksum().
+  uint64_t checksum;
+};
+
+/// Checksum of empty column data, where binaryChecksum() starts.
+constexpr uint64_t EmptyBinaryChecksum = 14695981039346656037ull;
+
+/**
+ * FNV-1a hash of the column data of a binary dataset, 8 bytes at a time.
+ * @param data Data to hash. Its size must be a multiple of 8.
+ * @param hash Hash of the previous data, to hash it in parts.
+ */
+uint64_t binaryChecksum(const char *data, size_t size,
+                        uint64_t hash = EmptyBinaryChecksum);
+
+/// If the file is a binary dataset, detected by its contents.
+bool isBinaryDataset(const std::string &filename);
+
+/// Reads and validates the header of a binary dataset.
+BinaryDatasetInfo readBinaryDatasetInfo(const std::string &filename);
+
+/**
+ * Saves a dataset in the binary dataset format (.cnatds).
+ */
+void saveBinaryDataset(const repr::Dataset &dataset,
+                       const std::string &filename);
+
+/**
+ * Saves a dataset as CSV, each value with the shortest text that parses back
+ * to it. Blocks of rows are formatted in parallel.
+ */
+void saveCsvDataset(const repr::Dataset &dataset, const std::string &filename);
+
+/**
+ * Parses a dataset from CSV data in memory.
+ * Each non-blank line is a sample: its inputs followed by the expected output,
+ * all separated by commas.
+ * @param data CSV data.
+ * @param size Size of the data in bytes.
+ * @param name Name of the data, used when reporting errors.
+ * @param firstLine Number of lines before the data, used when reporting errors.
+ */
+repr::Dataset parseDataset(const char *data, size_t size,
+                           const std::string &name, size_t firstLine = 0);
 
 } // namespace parser
 
@@ -16,11 +16,19 @@
 
 #include "parser.hpp"
 
+#include <cstdint>
+#include <fstream>
+#include <string>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 namespace {
+using parser::loadBinaryDataset;
 using parser::loadDataset;
+using parser::parseDataset;
+using parser::saveBinaryDataset;
+using parser::saveCsvDataset;
 using parser::splitLine;
 using testing::ElementsAreArray;
 using testing::Pair;
@@ -37,7 +45,7 @@ TEST(LoadDatasetTest, WorksCorrectly) {
   const auto &dataset = loadDataset("compnat/tp1/datasets/unit_test.csv");
   ASSERT_EQ((size_t)2, dataset.size());
 
-  auto & [ input0, expected0 ] = dataset[0];
+  const auto[input0, expected0] = dataset[0];
   ASSERT_EQ((size_t)4, input0.size());
   ASSERT_FLOAT_EQ(4, input0[0]);
   ASSERT_FLOAT_EQ(5, input0[1]);
@@ -45,7 +53,7 @@ TEST(LoadDatasetTest, WorksCorrectly) {
   ASSERT_FLOAT_EQ(7.8, input0[3]);
   ASSERT_FLOAT_EQ(900, expected0);
 
-  auto & [ input1, expected1 ] = dataset[1];
+  const auto[input1, expected1] = dataset[1];
   ASSERT_EQ((size_t)4, input1.size());
   ASSERT_FLOAT_EQ(6, input1[0]);
   ASSERT_FLOAT_EQ(3.3, input1[1]);
@@ -54,4 +62,151 @@ TEST(LoadDatasetTest, WorksCorrectly) {
   ASSERT_FLOAT_EQ(-800.15, expected1);
 }
 
+TEST(LoadDatasetTest, IsColumnar) {
+  const auto &dataset = loadDataset("compnat/tp1/datasets/unit_test.csv");
+  ASSERT_EQ((size_t)2, dataset.size());
+  ASSERT_EQ((size_t)4, dataset.numInputs());
+
+  for (size_t i = 0; i <= dataset.numInputs(); ++i) {
+    const auto *column = i < dataset.numInputs() ? dataset.input(i)
+                                                 : dataset.expected();
+    EXPECT_EQ((size_t)0, (uintptr_t)column % repr::Dataset::ColumnAlignment);
+  }
+  EXPECT_FLOAT_EQ(3.6, dataset.input(2)[0]);
+  EXPECT_FLOAT_EQ(-800.15, dataset.expected()[1]);
+}
+
+TEST(ParseDatasetTest, HandlesSpacesAndBlankLines) {
+  const std::string csv = "\n1, 2.5,+3\r\n  \n-4,5e-1 ,6\r\n";
+  const auto &dataset = parseDataset(csv.data(), csv.size(), "csv");
+  ASSERT_EQ((size_t)2, dataset.size());
+  ASSERT_EQ((size_t)2, dataset.numInputs());
+
+  EXPECT_FLOAT_EQ(1, dataset.input(0)[0]);
+  EXPECT_FLOAT_EQ(2.5, dataset.input(1)[0]);
+  EXPECT_FLOAT_EQ(3, dataset.expected()[0]);
+  EXPECT_FLOAT_EQ(-4, dataset.input(0)[1]);
+  EXPECT_FLOAT_EQ(0.5, dataset.input(1)[1]);
+  EXPECT_FLOAT_EQ(6, dataset.expected()[1]);
+}
+
+TEST(ParseDatasetTest, EmptyData) {
+  const std::string csv = "\n\n";
+  EXPECT_TRUE(parseDataset(csv.data(), csv.size(), "csv").empty());
+}
+
+TEST(ParseDatasetTest, ParsesBigDataInChunks) {
+  const size_t numRows = 200000; // Multiple MB, so it's split in chunks.
+  std::string csv;
+  for (size_t i = 0; i < numRows; ++i) {
+    csv += std::to_string(i) + ",0.25," + std::to_string(2 * i) + "\n";
+  }
+
+  const auto &dataset = parseDataset(csv.data(), csv.size(), "csv");
+  ASSERT_EQ(numRows, dataset.size());
+  for (size_t i = 0; i < numRows; ++i) {
+    ASSERT_EQ((repr::T)i, dataset.input(0)[i]);
+    ASSERT_EQ((repr::T)0.25, dataset.input(1)[i]);
+    ASSERT_EQ((repr::T)(2 * i), dataset.expected()[i]);
+  }
+}
+
+TEST(ParseDatasetDeathTest, ReportsMissingValues) {
+  const std::string csv = "1,2,3\n4,5\n";
+  EXPECT_DEATH(parseDataset(csv.data(), csv.size(), "csv"),
+               "csv:2: expected 3 values, found 2");
+}
+
+TEST(ParseDatasetDeathTest, ReportsInvalidValues) {
+  const std::string csv = "1,2,3\n\n4,abc,6\n";
+  EXPECT_DEATH(parseDataset(csv.data(), csv.size(), "csv"),
+               "csv:3: value 2 is not a valid number");
+}
+
+TEST(CsvDatasetTest, RoundTrip) {
+  repr::Dataset original(40000, 2);
+  for (size_t i = 0; i < original.size(); ++i) {
+    original.mutableColumn(0)[i] = i * 0.1;
+    original.mutableColumn(1)[i] = -1 / (i + 3.0);
+    original.mutableColumn(2)[i] = 1e20 * i;
+  }
+  const auto filename = testing::TempDir() + "/round_trip.csv";
+  saveCsvDataset(original, filename);
+
+  const auto &dataset = loadDataset(filename);
+  ASSERT_EQ(original.size(), dataset.size());
+  ASSERT_EQ(original.numInputs(), dataset.numInputs());
+  for (size_t i = 0; i < dataset.size(); ++i) {
+    ASSERT_EQ(original.input(0)[i], dataset.input(0)[i]);
+    ASSERT_EQ(original.input(1)[i], dataset.input(1)[i]);
+    ASSERT_EQ(original.expected()[i], dataset.expected()[i]);
+  }
+}
+
+TEST(BinaryDatasetTest, RoundTrip) {
+  const auto &csvDataset =
+      loadDataset("compnat/tp1/datasets/keijzer-10-train.csv");
+  const auto filename = testing::TempDir() + "/keijzer-10-train.cnatds";
+  saveBinaryDataset(csvDataset, filename);
+
+  const auto &dataset = loadBinaryDataset(filename);
+  ASSERT_EQ(csvDataset.size(), dataset.size());
+  ASSERT_EQ(csvDataset.numInputs(), dataset.numInputs());
+  for (size_t i = 0; i < dataset.numInputs(); ++i) {
+    EXPECT_EQ((size_t)0,
+              (uintptr_t)dataset.input(i) % repr::Dataset::ColumnAlignment);
+    for (size_t j = 0; j < dataset.size(); ++j) {
+      ASSERT_EQ(csvDataset.input(i)[j], dataset.input(i)[j]);
+    }
+  }
+  for (size_t j = 0; j < dataset.size(); ++j) {
+    ASSERT_EQ(csvDataset.expected()[j], dataset.expected()[j]);
+  }
+
+  // Detected by its contents.
+  EXPECT_EQ(dataset[42], loadDataset(filename)[42]);
+}
+
+TEST(BinaryDatasetDeathTest, DetectsCorruption) {
+  const auto filename = testing::TempDir() + "/corrupted.cnatds";
+  saveBinaryDataset(loadDataset("compnat/tp1/datasets/unit_test.csv"),
+                    filename);
+
+  {
+    std::fstream file(filename, std::fstream::in | std::fstream::out |
+                                    std::fstream::binary);
+    file.seekp(repr::Dataset::ColumnAlignment + 3);
+    file.put(42);
+  }
+
+  EXPECT_DEATH(loadBinaryDataset(filename), "checksum mismatch");
+  EXPECT_EQ((size_t)2, loadBinaryDataset(filename, false).size());
+}
+
+/// Saves a binary dataset with the 64-bit header field at offset replaced.
+std::string saveWithHeaderField(const std::string &name, size_t offset,
+                                uint64_t value) {
+  const auto filename = testing::TempDir() + "/" + name + ".cnatds";
+  saveBinaryDataset(loadDataset("compnat/tp1/datasets/unit_test.csv"),
+                    filename);
+  std::fstream file(filename, std::fstream::in | std::fstream::out |
+                                  std::fstream::binary);
+  file.seekp(offset);
+  file.write((const char *)&value, sizeof(value));
+  return filename;
+}
+
+TEST(BinaryDatasetDeathTest, RejectsHeadersThatOverflow) {
+  // numRows * 4 and numRows * 8 wrap to less than the column stride.
+  const auto &rows = saveWithHeaderField("rows", 16, (1ull << 62) + 4);
+  EXPECT_DEATH(loadBinaryDataset(rows), "invalid number of rows");
+  EXPECT_DEATH(parser::readBinaryDatasetInfo(rows), "invalid number of rows");
+
+  // numColumns * 64 wraps to the size of the columns in the file.
+  const auto &columns = saveWithHeaderField("columns", 24, (1ull << 58) + 3);
+  EXPECT_DEATH(loadBinaryDataset(columns), "truncated binary dataset");
+  EXPECT_DEATH(parser::readBinaryDatasetInfo(columns),
+               "truncated binary dataset");
+}
+
 } // namespace
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "glog/logging.h"
+
+namespace pool {
+
+void run(size_t numTasks, size_t numThreads, size_t threadsPerTask,
+         const std::function<void(size_t)> &fn) {
+  if (!numThreads) {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threadsPerTask = std::max((size_t)1, threadsPerTask);
+  const size_t numWorkers = std::max(
+      (size_t)1, std::min(numTasks, numThreads / threadsPerTask));
+  const size_t taskThreads = std::max(threadsPerTask, numThreads / numWorkers);
+  LOG(INFO) << "Running " << numTasks << " tasks, " << numWorkers
+            << " at a time with " << taskThreads << " threads each";
+
+  std::atomic<size_t> nextTask(0);
+  const auto &work = [&]() {
+#ifdef _OPENMP
+    omp_set_num_threads(taskThreads);
+#endif
+    for (size_t i = nextTask++; i < numTasks; i = nextTask++) {
+      fn(i);
+    }
+  };
+
+#ifdef _OPENMP
+  // The calling thread is one of the workers.
+  const int callerThreads = omp_get_max_threads();
+#endif
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < numWorkers; ++i) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+#ifdef _OPENMP
+  omp_set_num_threads(callerThreads);
+#endif
+}
+
+} // namespace pool
@@ -0,0 +1,38 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPNAT_TP1_POOL_HPP
+#define COMPNAT_TP1_POOL_HPP
+
+#include <functional>
+
+namespace pool {
+
+/**
+ * Calls fn(i) for each i in [0, numTasks) on a pool of threads, starting the
+ * tasks in order of i.
+ * The threads are divided evenly among the tasks that run at the same time:
+ * numThreads / threadsPerTask tasks run concurrently (at most numTasks), and
+ * the OpenMP parallel regions of each one use its share of the threads.
+ * @param numThreads Number of threads to use, 0 for one per core.
+ * @param threadsPerTask Minimum number of threads of each task.
+ */
+void run(size_t numTasks, size_t numThreads, size_t threadsPerTask,
+         const std::function<void(size_t)> &fn);
+
+} // namespace pool
+
+#endif // !COMPNAT_TP1_POOL_HPP
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pool.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+TEST(PoolTest, RunsEachTaskOnce) {
+  std::vector<std::atomic<int>> runs(100);
+  pool::run(runs.size(), 4, 1, [&](size_t i) { ++runs[i]; });
+  for (const auto &count : runs) {
+    EXPECT_EQ(1, count);
+  }
+
+  pool::run(0, 4, 1, [](size_t) { FAIL(); });
+}
+
+TEST(PoolTest, UsesTheGivenThreads) {
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  pool::run(16, 4, 2, [&](size_t) {
+    std::lock_guard<std::mutex> lock(mutex);
+    threads.insert(std::this_thread::get_id());
+#ifdef _OPENMP
+    EXPECT_EQ(2, omp_get_max_threads());
+#endif
+  });
+  EXPECT_GE((size_t)2, threads.size());
+}
+
+} // namespace
@@ -16,6 +16,7 @@
 
 #include "primitives.hpp"
 
+#include <map>
 #include <random>
 
 #include "utils.hpp"
@@ -31,7 +32,8 @@ repr::Primitive sumFn([[maybe_unused]] repr::RNG &rng) {
       [](const auto &children) {
         return utils::strCat('(', children[0].str(), " + ", children[1].str(),
                              ')');
-      });
+      },
+      repr::Op::Sum);
 }
 
 repr::Primitive subFn([[maybe_unused]] repr::RNG &rng) {
@@ -43,7 +45,8 @@ repr::Primitive subFn([[maybe_unused]] repr::RNG &rng) {
       [](const auto &children) {
         return utils::strCat('(', children[0].str(), " - ", children[1].str(),
                              ')');
-      });
+      },
+      repr::Op::Sub);
 }
 
 repr::Primitive multFn([[maybe_unused]] repr::RNG &rng) {
@@ -55,7 +58,8 @@ repr::Primitive multFn([[maybe_unused]] repr::RNG &rng) {
       [](const auto &children) {
         return utils::strCat('(', children[0].str(), " * ", children[1].str(),
                              ')');
-      });
+      },
+      repr::Op::Mult);
 }
 
 repr::Primitive divFn([[maybe_unused]] repr::RNG &rng) {
@@ -67,7 +71,8 @@ repr::Primitive divFn([[maybe_unused]] repr::RNG &rng) {
       [](const auto &children) {
         return utils::strCat('(', children[0].str(), " / ", children[1].str(),
                              ')');
-      });
+      },
+      repr::Op::Div);
 }
 
 repr::Primitive logFn([[maybe_unused]] repr::RNG &rng) {
@@ -78,32 +83,101 @@ repr::Primitive logFn([[maybe_unused]] repr::RNG &rng) {
       },
       [](const auto &children) {
         return utils::strCat("log2(", children[0].str(), ')');
-      });
+      },
+      repr::Op::Log);
 }
 
-repr::Primitive constTerm(repr::RNG &rng) {
-  std::uniform_real_distribution<repr::T> distr(-1, 1);
-  const repr::T value = distr(rng);
+repr::Primitive expFn([[maybe_unused]] repr::RNG &rng) {
+  return repr::Primitive( // Keep formatting
+      1,
+      [](const auto &input, const auto &children) {
+        return protectedExp(children[0].eval(input));
+      },
+      [](const auto &children) {
+        return utils::strCat("exp(", children[0].str(), ')');
+      },
+      repr::Op::Exp);
+}
+
+repr::Primitive sinFn([[maybe_unused]] repr::RNG &rng) {
+  return repr::Primitive( // Keep formatting
+      1,
+      [](const auto &input, const auto &children) {
+        return static_cast<repr::T>(vecmath::sin(children[0].eval(input)));
+      },
+      [](const auto &children) {
+        return utils::strCat("sin(", children[0].str(), ')');
+      },
+      repr::Op::Sin);
+}
+
+repr::Primitive cosFn([[maybe_unused]] repr::RNG &rng) {
+  return repr::Primitive( // Keep formatting
+      1,
+      [](const auto &input, const auto &children) {
+        return static_cast<repr::T>(vecmath::cos(children[0].eval(input)));
+      },
+      [](const auto &children) {
+        return utils::strCat("cos(", children[0].str(), ')');
+      },
+      repr::Op::Cos);
+}
+
+repr::Primitive sqrtFn([[maybe_unused]] repr::RNG &rng) {
+  return repr::Primitive( // Keep formatting
+      1,
+      [](const auto &input, const auto &children) {
+        return protectedSqrt(children[0].eval(input));
+      },
+      [](const auto &children) {
+        return utils::strCat("sqrt(", children[0].str(), ')');
+      },
+      repr::Op::Sqrt);
+}
+
+repr::Primitive powFn([[maybe_unused]] repr::RNG &rng) {
+  return repr::Primitive( // Keep formatting
+      2,
+      [](const auto &input, const auto &children) {
+        return protectedPow(children[0].eval(input), children[1].eval(input));
+      },
+      [](const auto &children) {
+        return utils::strCat("pow(", children[0].str(), ", ",
+                             children[1].str(), ')');
+      },
+      repr::Op::Pow);
+}
+
+repr::PrimitiveFn function(const std::string &name) {
+  static const std::map<std::string, repr::PrimitiveFn> functions = {
+      {"sum", sumFn}, {"sub", subFn}, {"mult", multFn}, {"div", divFn},
+      {"log", logFn}, {"exp", expFn}, {"sin", sinFn},   {"cos", cosFn},
+      {"sqrt", sqrtFn}, {"pow", powFn}};
 
+  const auto it = functions.find(name);
+  CHECK(it != functions.end()) << "Unknown function: " << name;
+  return it->second;
+}
+
+repr::Primitive constant(repr::T value) {
   return repr::Primitive( // Keep formatting
       0,
       [value]([[maybe_unused]] const auto &input,
               [[maybe_unused]] const auto &children) { return value; },
       [value]([[maybe_unused]] const auto &children) {
         return utils::strCat(value);
-      });
+      },
+      repr::Op::Const, value);
+}
+
+repr::Primitive constTerm(repr::RNG &rng) {
+  // Always draws a double, so the random sequence doesn't depend on repr::T.
+  std::uniform_real_distribution<double> distr(-1, 1);
+  return constant(distr(rng));
 }
 
 std::function<repr::Primitive(repr::RNG &)> literalTerm(repr::T value) {
-  return [value]([[maybe_unused]] auto &rng) {
-    return repr::Primitive( // Keep formatting
-        0,
-        [value]([[maybe_unused]] const auto &input,
-                [[maybe_unused]] const auto &children) { return value; },
-        [value]([[maybe_unused]] const auto &children) {
-          return utils::strCat(value);
-        });
-  };
+  return [value]([[maybe_unused]] auto &rng) { return constant(value); };
 }
 
 std::function<repr::Primitive(repr::RNG &)> makeVarTerm(size_t var) {
@@ -115,7 +189,8 @@ std::function<repr::Primitive(repr::RNG &)> makeVarTerm(size_t var) {
         },
         [var]([[maybe_unused]] const auto &children) {
           return utils::strCat("x", var);
-        });
+        },
+        repr::Op::Var, 0, var);
   };
 }
 
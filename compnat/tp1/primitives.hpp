@@ -17,12 +17,46 @@
 #ifndef COMPNAT_TP1_PRIMITIVES_HPP
 #define COMPNAT_TP1_PRIMITIVES_HPP
 
+#include <cmath>
+#include <limits>
 #include <string>
+#include <type_traits>
 
 #include "representation.hpp"
+#include "vecmath.hpp"
 
 namespace primitives {
 
+/// Largest argument of the exponential whose result is finite in repr::T.
+constexpr double MaxExpArg =
+    std::is_same_v<repr::T, float> ? 88 : vecmath::MaxExpArg;
+
+/// Clamps the argument of the exponential to [vecmath::MinExpArg, MaxExpArg].
+inline double clampExpArg(double a) {
+  a = a < vecmath::MinExpArg ? vecmath::MinExpArg : a;
+  return a > MaxExpArg ? MaxExpArg : a;
+}
+
+/// Exponential, with the argument clamped so the result is always finite.
+inline repr::T protectedExp(repr::T a) {
+  return static_cast<repr::T>(vecmath::exp(clampExpArg(a)));
+}
+
+/// Square root of |a|.
+inline repr::T protectedSqrt(repr::T a) { return std::sqrt(std::abs(a)); }
+
+/**
+ * |a|^b, computed as exp(b * log(|a|)) with the exponent clamped like in
+ * protectedExp(). Returns 0 if |a| is (almost) 0, like utils::safeDiv.
+ */
+inline repr::T protectedPow(repr::T a, repr::T b) {
+  const double abs = std::abs(a);
+  const double value = vecmath::exp(clampExpArg(b * vecmath::log(abs)));
+  return abs <= std::numeric_limits<repr::T>::epsilon()
+             ? 0
+             : static_cast<repr::T>(value);
+}
+
 /// Sum function.
 repr::Primitive sumFn([[maybe_unused]] repr::RNG &rng);
 
@@ -38,6 +72,30 @@ repr::Primitive divFn([[maybe_unused]] repr::RNG &rng);
 /// Logarithm function.
 repr::Primitive logFn([[maybe_unused]] repr::RNG &rng);
 
+/// Exponential function. See protectedExp().
+repr::Primitive expFn([[maybe_unused]] repr::RNG &rng);
+
+/// Sine function.
+repr::Primitive sinFn([[maybe_unused]] repr::RNG &rng);
+
+/// Cosine function.
+repr::Primitive cosFn([[maybe_unused]] repr::RNG &rng);
+
+/// Square root function. See protectedSqrt().
+repr::Primitive sqrtFn([[maybe_unused]] repr::RNG &rng);
+
+/// Power function. See protectedPow().
+repr::Primitive powFn([[maybe_unused]] repr::RNG &rng);
+
+/**
+ * Function with the given name: sum, sub, mult, div, log, exp, sin, cos, sqrt
+ * or pow. Dies if there is no such function.
+ */
+repr::PrimitiveFn function(const std::string &name);
+
+/// Constant terminal with the given value.
+repr::Primitive constant(repr::T value);
+
 /// Constant terminal. Returns a random value between -1 and 1.
 repr::Primitive constTerm(repr::RNG &rng);
 
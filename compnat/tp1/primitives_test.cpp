@@ -16,6 +16,7 @@
 
 #include "primitives.hpp"
 
+#include <cmath>
 #include <random>
 
 #include <gtest/gtest.h>
@@ -86,6 +87,59 @@ TEST(LogFnTest, WorksCorrectly) {
   EXPECT_FLOAT_EQ(1.5849625, node.eval({{3, 0}}));
 }
 
+TEST(ExpFnTest, WorksCorrectly) {
+  const auto &node = generateNode1(primitives::expFn);
+  EXPECT_FALSE(node.isTerminal());
+  EXPECT_EQ("exp(x0)", node.str());
+  EXPECT_FLOAT_EQ(20.085537, node.eval({{3, 0}}));
+  EXPECT_TRUE(std::isfinite(node.eval({{1e6, 0}})));
+  EXPECT_TRUE(std::isfinite(node.eval({{INFINITY, 0}})));
+}
+
+TEST(SinFnTest, WorksCorrectly) {
+  const auto &node = generateNode1(primitives::sinFn);
+  EXPECT_FALSE(node.isTerminal());
+  EXPECT_EQ("sin(x0)", node.str());
+  EXPECT_FLOAT_EQ(0.14112, node.eval({{3, 0}}));
+}
+
+TEST(CosFnTest, WorksCorrectly) {
+  const auto &node = generateNode1(primitives::cosFn);
+  EXPECT_FALSE(node.isTerminal());
+  EXPECT_EQ("cos(x0)", node.str());
+  EXPECT_FLOAT_EQ(-0.9899925, node.eval({{3, 0}}));
+}
+
+TEST(SqrtFnTest, WorksCorrectly) {
+  const auto &node = generateNode1(primitives::sqrtFn);
+  EXPECT_FALSE(node.isTerminal());
+  EXPECT_EQ("sqrt(x0)", node.str());
+  EXPECT_EQ(3, node.eval({{9, 0}}));
+  EXPECT_EQ(3, node.eval({{-9, 0}}));
+}
+
+TEST(PowFnTest, WorksCorrectly) {
+  const auto &node = generateNode2(primitives::powFn);
+  EXPECT_FALSE(node.isTerminal());
+  EXPECT_EQ("pow(x0, x1)", node.str());
+  EXPECT_FLOAT_EQ(9, node.eval({{3, 2}}));
+  EXPECT_FLOAT_EQ(9, node.eval({{-3, 2}}));
+  EXPECT_FLOAT_EQ(0.5, node.eval({{4, -0.5}}));
+  EXPECT_EQ(0, node.eval({{0, -2}}));
+  EXPECT_TRUE(std::isfinite(node.eval({{10, 1e6}})));
+}
+
+TEST(FunctionTest, FindsFunctionsByName) {
+  repr::RNG rng(0);
+  EXPECT_EQ(repr::Op::Sum, primitives::function("sum")(rng).op);
+  EXPECT_EQ(repr::Op::Log, primitives::function("log")(rng).op);
+  EXPECT_EQ(repr::Op::Pow, primitives::function("pow")(rng).op);
+}
+
+TEST(FunctionDeathTest, RejectsUnknownFunctions) {
+  EXPECT_DEATH(primitives::function("tan"), "Unknown function: tan");
+}
+
 TEST(ConstTermTest, WorksCorrectly) {
   const auto &node = generateNode0(primitives::constTerm);
   EXPECT_TRUE(node.isTerminal());
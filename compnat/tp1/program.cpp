@@ -0,0 +1,623 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "program.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <utility>
+
+#include "primitives.hpp"
+#include "utils.hpp"
+#include "vecmath.hpp"
+
+namespace program {
+namespace {
+
+/// Simplified expression tree, used before compiling an individual.
+struct Expr_ {
+  repr::Op op;
+  repr::T value;
+  size_t var;
+
+  /// Node the expression came from, or null if it was folded to a constant.
+  const repr::Node *node;
+
+  std::vector<Expr_> children;
+};
+
+Expr_ constant_(repr::T value) {
+  return Expr_{repr::Op::Const, value, 0, nullptr, {}};
+}
+
+bool isConstant_(const Expr_ &expr, repr::T value) {
+  return expr.op == repr::Op::Const && expr.value == value;
+}
+
+/// If the expression is always finite, assuming finite dataset values.
+bool isFinite_(const Expr_ &expr) {
+  return expr.op == repr::Op::Var ||
+         (expr.op == repr::Op::Const && std::isfinite(expr.value));
+}
+
+/// Applies op exactly like the corresponding primitive does.
+repr::T apply_(repr::Op op, repr::T a, repr::T b) {
+  switch (op) {
+  case repr::Op::Sum:
+    return a + b;
+  case repr::Op::Sub:
+    return a - b;
+  case repr::Op::Mult:
+    return a * b;
+  case repr::Op::Div:
+    return utils::safeDiv(a, b);
+  case repr::Op::Log:
+    return std::log2(a);
+  case repr::Op::Exp:
+    return primitives::protectedExp(a);
+  case repr::Op::Sin:
+    return vecmath::sin(a);
+  case repr::Op::Cos:
+    return vecmath::cos(a);
+  case repr::Op::Sqrt:
+    return primitives::protectedSqrt(a);
+  case repr::Op::Pow:
+    return primitives::protectedPow(a, b);
+  default:
+    LOG(FATAL) << "Operation can't be applied to constants";
+    return 0;
+  }
+}
+
+/// Total order of expressions, 0 if they are structurally equal.
+int compare_(const Expr_ &a, const Expr_ &b) {
+  if (a.op != b.op) {
+    return a.op < b.op ? -1 : 1;
+  }
+
+  switch (a.op) {
+  case repr::Op::Const:
+    return a.value == b.value ? 0 : (a.value < b.value ? -1 : 1);
+  case repr::Op::Var:
+    return a.var == b.var ? 0 : (a.var < b.var ? -1 : 1);
+  case repr::Op::Custom:
+    return a.node == b.node ? 0 : (std::less<>()(a.node, b.node) ? -1 : 1);
+  default:
+    for (size_t i = 0; i < a.children.size(); ++i) {
+      if (int result = compare_(a.children[i], b.children[i])) {
+        return result;
+      }
+    }
+    return 0;
+  }
+}
+
+/// Removes identities of binary operations and sorts commutative operands.
+Expr_ simplifyBinary_(Expr_ expr) {
+  auto &a = expr.children[0];
+  auto &b = expr.children[1];
+
+  switch (expr.op) {
+  case repr::Op::Sum:
+    if (isConstant_(a, 0)) {
+      return std::move(b);
+    }
+    if (isConstant_(b, 0)) {
+      return std::move(a);
+    }
+    break;
+  case repr::Op::Sub:
+    if (isConstant_(b, 0)) {
+      return std::move(a);
+    }
+    if (isFinite_(a) && compare_(a, b) == 0) {
+      return constant_(0);
+    }
+    break;
+  case repr::Op::Mult:
+    if (isConstant_(a, 1)) {
+      return std::move(b);
+    }
+    if (isConstant_(b, 1)) {
+      return std::move(a);
+    }
+    if ((isConstant_(a, 0) && isFinite_(b)) ||
+        (isConstant_(b, 0) && isFinite_(a))) {
+      return constant_(0);
+    }
+    break;
+  case repr::Op::Div:
+    if (isConstant_(b, 1)) {
+      return std::move(a);
+    }
+    // utils::safeDiv returns 0 when dividing by (almost) 0.
+    if (b.op == repr::Op::Const &&
+        std::abs(b.value) <= std::numeric_limits<repr::T>::epsilon()) {
+      return constant_(0);
+    }
+    if (isConstant_(a, 0) && isFinite_(b)) {
+      return constant_(0);
+    }
+    break;
+  default:
+    break;
+  }
+
+  const bool commutative =
+      expr.op == repr::Op::Sum || expr.op == repr::Op::Mult;
+  if (commutative && compare_(b, a) < 0) {
+    std::swap(a, b);
+  }
+  return expr;
+}
+
+Expr_ simplify_(const repr::Node &node) {
+  Expr_ expr{node.op(), node.value(), node.var(), &node, {}};
+  if (expr.op == repr::Op::Custom || node.isTerminal()) {
+    return expr;
+  }
+
+  bool foldable = true;
+  for (size_t i = 0; i < node.numChildren(); ++i) {
+    expr.children.push_back(simplify_(node.child(i)));
+    foldable = foldable && expr.children.back().op == repr::Op::Const;
+  }
+
+  if (foldable) {
+    const repr::T a = expr.children[0].value;
+    const repr::T b = expr.children.size() > 1 ? expr.children[1].value : 0;
+    return constant_(apply_(expr.op, a, b));
+  }
+  if (expr.children.size() == 2) {
+    return simplifyBinary_(std::move(expr));
+  }
+  return expr;
+}
+
+/// Number of nodes of the individual the expression represents.
+size_t size_(const Expr_ &expr) {
+  if (expr.op == repr::Op::Custom) {
+    return expr.node->size();
+  }
+
+  size_t size = 1;
+  for (const auto &child : expr.children) {
+    size += size_(child);
+  }
+  return size;
+}
+
+/// Appends the expression in postfix order. Returns the stack depth needed.
+size_t compile_(const Expr_ &expr, std::vector<Instruction> &code) {
+  size_t depth = 1;
+  for (size_t i = 0; i < expr.children.size(); ++i) {
+    depth = std::max(depth, i + compile_(expr.children[i], code));
+  }
+
+  const repr::Node *node = expr.op == repr::Op::Custom ? expr.node : nullptr;
+  code.push_back(Instruction{expr.op, expr.value, expr.var, node});
+  return depth;
+}
+
+repr::Node toNode_(const Expr_ &expr) {
+  if (!expr.node) {
+    return repr::Node(primitives::constant(expr.value));
+  }
+
+  repr::Node node = *expr.node;
+  for (size_t i = 0; i < expr.children.size(); ++i) {
+    node.setChild(i, toNode_(expr.children[i]));
+  }
+  return node;
+}
+
+Bounds interval_(repr::T min, repr::T max) {
+  Bounds bounds;
+  // Overflows can't be bounded.
+  bounds.bounded = std::isfinite(min) && std::isfinite(max);
+  bounds.min = min;
+  bounds.max = max;
+  return bounds;
+}
+
+Bounds nonFinite_() {
+  Bounds bounds;
+  bounds.nonFinite = true;
+  return bounds;
+}
+
+/// If the divisor is always (almost) 0, which utils::safeDiv turns into 0.
+bool divisorIsZero_(const Bounds &b) {
+  const repr::T epsilon = std::numeric_limits<repr::T>::epsilon();
+  return b.bounded && b.min >= -epsilon && b.max <= epsilon;
+}
+
+/// If the divisor is never (almost) 0, so utils::safeDiv always divides.
+bool divisorIsNonZero_(const Bounds &b) {
+  const repr::T epsilon = std::numeric_limits<repr::T>::epsilon();
+  return b.nonFinite || (b.bounded && (b.min > epsilon || b.max < -epsilon));
+}
+
+/// Interval with the min and max of fn applied to the corners of a and b.
+template <typename Fn>
+Bounds corners_(const Bounds &a, const Bounds &b, Fn fn) {
+  const repr::T values[] = {fn(a.min, b.min), fn(a.min, b.max),
+                            fn(a.max, b.min), fn(a.max, b.max)};
+  const auto & [ min, max ] = std::minmax_element(values, values + 4);
+  return interval_(*min, *max);
+}
+
+/**
+ * Bounds of applying a binary operation.
+ * Rounding is monotonic, so the bounds computed with the same floating point
+ * operations as the evaluation are never narrower than the evaluated values.
+ */
+Bounds binaryBounds_(repr::Op op, const Bounds &a, const Bounds &b) {
+  if (op == repr::Op::Pow) {
+    if (a.constant() && b.constant()) {
+      const repr::T value = primitives::protectedPow(a.min, b.min);
+      return interval_(value, value);
+    }
+    return Bounds();
+  }
+  if (op == repr::Op::Div) {
+    if (divisorIsZero_(b)) {
+      return interval_(0, 0);
+    }
+    if (a.nonFinite && divisorIsNonZero_(b)) {
+      return nonFinite_();
+    }
+    if (a.bounded && b.bounded && a.min == 0 && a.max == 0) {
+      return interval_(0, 0);
+    }
+    if (a.bounded && b.bounded && divisorIsNonZero_(b)) {
+      return corners_(a, b, std::divides<repr::T>());
+    }
+    return Bounds();
+  }
+
+  // Non-finite values always give non-finite sums, differences and products.
+  if (a.nonFinite || b.nonFinite) {
+    return nonFinite_();
+  }
+  if (!a.bounded || !b.bounded) {
+    return Bounds();
+  }
+
+  switch (op) {
+  case repr::Op::Sum:
+    return interval_(a.min + b.min, a.max + b.max);
+  case repr::Op::Sub:
+    return interval_(a.min - b.max, a.max - b.min);
+  case repr::Op::Mult:
+    return corners_(a, b, std::multiplies<repr::T>());
+  default:
+    LOG(FATAL) << "Invalid binary operation";
+    return Bounds();
+  }
+}
+
+Bounds logBounds_(const Bounds &a) {
+  if (a.nonFinite || (a.bounded && a.max <= 0)) {
+    // log2(0) is -inf and the log of negative values is NaN.
+    return nonFinite_();
+  }
+  if (a.bounded && a.min > 0) {
+    return interval_(std::log2(a.min), std::log2(a.max));
+  }
+  return Bounds();
+}
+
+/**
+ * Widens the interval by a few ulps, unless it is a single value.
+ * The polynomials of vecmath aren't guaranteed to be monotonic between ulps.
+ */
+Bounds widen_(repr::T min, repr::T max) {
+  if (min == max) {
+    return interval_(min, max);
+  }
+  const repr::T ulps = 4 * std::numeric_limits<repr::T>::epsilon();
+  return interval_(min - std::abs(min) * ulps, max + std::abs(max) * ulps);
+}
+
+/// Bounds of the unary operations other than Op::Log.
+Bounds unaryBounds_(repr::Op op, const Bounds &a) {
+  switch (op) {
+  case repr::Op::Exp:
+    // Infinite arguments are clamped, so only NaN gives NaN.
+    if (!a.bounded) {
+      return Bounds();
+    }
+    return widen_(primitives::protectedExp(a.min),
+                  primitives::protectedExp(a.max));
+  case repr::Op::Sin:
+  case repr::Op::Cos:
+    if (a.nonFinite) {
+      return nonFinite_();
+    }
+    if (!a.bounded || a.min < -vecmath::MaxTrigArg ||
+        a.max > vecmath::MaxTrigArg) {
+      return Bounds();
+    }
+    if (a.min == a.max) {
+      const repr::T value = apply_(op, a.min, 0);
+      return interval_(value, value);
+    }
+    return widen_(-1, 1);
+  case repr::Op::Sqrt: {
+    // sqrt(|NaN|) is NaN and sqrt(|inf|) is inf.
+    if (a.nonFinite) {
+      return nonFinite_();
+    }
+    if (!a.bounded) {
+      return Bounds();
+    }
+    const repr::T absMax = std::max(std::abs(a.min), std::abs(a.max));
+    const repr::T absMin = a.min <= 0 && a.max >= 0
+                               ? 0
+                               : std::min(std::abs(a.min), std::abs(a.max));
+    return interval_(std::sqrt(absMin), std::sqrt(absMax));
+  }
+  default:
+    LOG(FATAL) << "Invalid unary operation";
+    return Bounds();
+  }
+}
+
+template <typename Fn>
+void unary_(const repr::T *a, repr::T *out, size_t n, Fn fn) {
+#pragma omp simd
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = fn(a[i]);
+  }
+}
+
+template <typename Fn>
+void binary_(const repr::T *a, const repr::T *b, repr::T *out, size_t n,
+             Fn fn) {
+#pragma omp simd
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = fn(a[i], b[i]);
+  }
+}
+
+/**
+ * Evaluates a program one block of samples at a time.
+ * Each stack slot either points directly to a dataset column or to its own
+ * buffer of BlockSize values.
+ */
+class Evaluator_ {
+public:
+  Evaluator_(const std::vector<Instruction> &code, size_t maxDepth,
+             size_t numInputs)
+      : code_(code), buffers_(maxDepth * Program::BlockSize),
+        stack_(maxDepth), input_(numInputs) {}
+
+  /// Evaluates n <= BlockSize samples starting at begin.
+  const repr::T *block(const repr::Dataset &dataset, size_t begin, size_t n) {
+    size_t top = 0;
+    for (const auto &instr : code_) {
+      switch (instr.op) {
+      case repr::Op::Const:
+        std::fill_n(buffer_(top), n, instr.value);
+        stack_[top] = buffer_(top);
+        ++top;
+        break;
+      case repr::Op::Var:
+        stack_[top++] = dataset.input(instr.var) + begin;
+        break;
+      case repr::Op::Custom:
+        for (size_t i = 0; i < n; ++i) {
+          dataset.row(begin + i, input_);
+          buffer_(top)[i] = instr.node->eval(input_);
+        }
+        stack_[top] = buffer_(top);
+        ++top;
+        break;
+      case repr::Op::Log:
+      case repr::Op::Exp:
+      case repr::Op::Sin:
+      case repr::Op::Cos:
+      case repr::Op::Sqrt:
+        applyUnary_(instr.op, stack_[top - 1], buffer_(top - 1), n);
+        stack_[top - 1] = buffer_(top - 1);
+        break;
+      default:
+        applyBinary_(instr.op, stack_[top - 2], stack_[top - 1],
+                     buffer_(top - 2), n);
+        stack_[top - 2] = buffer_(top - 2);
+        --top;
+        break;
+      }
+    }
+
+    return stack_[0];
+  }
+
+private:
+  repr::T *buffer_(size_t slot) {
+    return &buffers_[slot * Program::BlockSize];
+  }
+
+  void applyUnary_(repr::Op op, const repr::T *a, repr::T *out, size_t n) {
+    switch (op) {
+    case repr::Op::Log:
+      return unary_(a, out, n, [](repr::T a) { return std::log2(a); });
+    case repr::Op::Exp:
+      return unary_(a, out, n,
+                    [](repr::T a) { return primitives::protectedExp(a); });
+    case repr::Op::Sin:
+      return unary_(a, out, n, [](repr::T a) {
+        return static_cast<repr::T>(vecmath::sin(a));
+      });
+    case repr::Op::Cos:
+      return unary_(a, out, n, [](repr::T a) {
+        return static_cast<repr::T>(vecmath::cos(a));
+      });
+    case repr::Op::Sqrt:
+      return unary_(a, out, n,
+                    [](repr::T a) { return primitives::protectedSqrt(a); });
+    default:
+      LOG(FATAL) << "Invalid unary operation";
+    }
+  }
+
+  void applyBinary_(repr::Op op, const repr::T *a, const repr::T *b,
+                    repr::T *out, size_t n) {
+    switch (op) {
+    case repr::Op::Sum:
+      return binary_(a, b, out, n, std::plus<repr::T>());
+    case repr::Op::Sub:
+      return binary_(a, b, out, n, std::minus<repr::T>());
+    case repr::Op::Mult:
+      return binary_(a, b, out, n, std::multiplies<repr::T>());
+    case repr::Op::Div:
+      return binary_(a, b, out, n, [](repr::T a, repr::T b) {
+        return utils::safeDiv(a, b);
+      });
+    case repr::Op::Pow:
+      return binary_(a, b, out, n, [](repr::T a, repr::T b) {
+        return primitives::protectedPow(a, b);
+      });
+    default:
+      LOG(FATAL) << "Invalid binary operation";
+    }
+  }
+
+  const std::vector<Instruction> &code_;
+  std::vector<repr::T> buffers_;
+  std::vector<const repr::T *> stack_;
+  repr::EvalInput input_;
+};
+
+} // namespace
+
+Program::Program(const repr::Node &individual) {
+  const auto &expr = simplify_(individual);
+  maxDepth_ = compile_(expr, code_);
+  numRemoved_ = individual.size() - size_(expr);
+
+  hash_ = code_.size();
+  for (const auto &instr : code_) {
+    utils::hashCombine(hash_, static_cast<size_t>(instr.op));
+    // Adding 0 turns -0 into 0, as they are equal.
+    utils::hashCombine(hash_, std::hash<repr::T>()(instr.value + repr::T(0)));
+    utils::hashCombine(hash_, instr.var);
+    utils::hashCombine(hash_, std::hash<const repr::Node *>()(instr.node));
+  }
+}
+
+bool Program::comparable() const {
+  return std::none_of(code_.begin(), code_.end(), [](const auto &instr) {
+    return instr.op == repr::Op::Custom;
+  });
+}
+
+bool Program::operator==(const Program &other) const {
+  return hash_ == other.hash_ &&
+         std::equal(code_.begin(), code_.end(), other.code_.begin(),
+                    other.code_.end(), [](const auto &a, const auto &b) {
+                      return a.op == b.op && a.value == b.value &&
+                             a.var == b.var && a.node == b.node;
+                    });
+}
+
+void Program::eval(const repr::Dataset &dataset, size_t begin, size_t end,
+                   repr::T *out) const {
+  Evaluator_ evaluator(code_, maxDepth_, dataset.numInputs());
+  for (size_t i = begin; i < end; i += BlockSize) {
+    const size_t n = std::min(BlockSize, end - i);
+    std::copy_n(evaluator.block(dataset, i, n), n, out + (i - begin));
+  }
+}
+
+Bounds Program::bounds(const repr::Dataset &dataset) const {
+  if (!dataset.summarized()) {
+    return Bounds();
+  }
+
+  std::vector<Bounds> stack;
+  for (const auto &instr : code_) {
+    switch (instr.op) {
+    case repr::Op::Const:
+      stack.push_back(std::isfinite(instr.value)
+                          ? interval_(instr.value, instr.value)
+                          : nonFinite_());
+      break;
+    case repr::Op::Var: {
+      const auto &summary = dataset.summary(instr.var);
+      stack.push_back(interval_(summary.min, summary.max));
+      break;
+    }
+    case repr::Op::Custom:
+      stack.push_back(Bounds());
+      break;
+    case repr::Op::Log:
+      stack.back() = logBounds_(stack.back());
+      break;
+    case repr::Op::Exp:
+    case repr::Op::Sin:
+    case repr::Op::Cos:
+    case repr::Op::Sqrt:
+      stack.back() = unaryBounds_(instr.op, stack.back());
+      break;
+    default: {
+      const Bounds b = stack.back();
+      stack.pop_back();
+      stack.back() = binaryBounds_(instr.op, stack.back(), b);
+      break;
+    }
+    }
+  }
+
+  return stack.back();
+}
+
+double Program::squaredError(const repr::Dataset &dataset,
+                             const Bounds &bounds) const {
+  if (bounds.nonFinite) {
+    return std::numeric_limits<double>::infinity();
+  }
+  if (bounds.constant()) {
+    // Sum of (c - y)^2 = n * (c - mean)^2 + sum of (y - mean)^2.
+    const auto &summary = dataset.summary(dataset.numInputs());
+    const double diff = (double)bounds.min - summary.mean;
+    return dataset.size() * diff * diff + summary.m2;
+  }
+
+  Evaluator_ evaluator(code_, maxDepth_, dataset.numInputs());
+  const repr::T *expected = dataset.expected();
+
+  double error = 0;
+  for (size_t i = 0; i < dataset.size(); i += BlockSize) {
+    const size_t n = std::min(BlockSize, dataset.size() - i);
+    const repr::T *values = evaluator.block(dataset, i, n);
+    for (size_t j = 0; j < n; ++j) {
+      const double diff = (double)values[j] - expected[i + j];
+      error += diff * diff;
+    }
+  }
+
+  return error;
+}
+
+repr::Node simplify(const repr::Node &individual) {
+  return toNode_(simplify_(individual));
+}
+
+} // namespace program
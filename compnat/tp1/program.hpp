@@ -0,0 +1,147 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPNAT_TP1_PROGRAM_HPP
+#define COMPNAT_TP1_PROGRAM_HPP
+
+#include <vector>
+
+#include "representation.hpp"
+
+namespace program {
+
+/// Instruction of a compiled individual.
+struct Instruction {
+  repr::Op op;
+
+  /// Value of Op::Const instructions.
+  repr::T value;
+
+  /// Variable of Op::Var instructions.
+  size_t var;
+
+  /// Node evaluated by Op::Custom instructions, including its children.
+  const repr::Node *node;
+};
+
+/**
+ * Bounds of the values of a program over all samples of a dataset, found by
+ * interval arithmetic over the column ranges.
+ */
+struct Bounds {
+  /// If all values are known to be within [min, max]. Otherwise, they may be
+  /// anything, including non-finite.
+  bool bounded = false;
+
+  /// If all values are known to be non-finite (NaN or infinite).
+  bool nonFinite = false;
+
+  repr::T min = 0;
+  repr::T max = 0;
+
+  /// If the program has the same value for all samples.
+  bool constant() const { return bounded && min == max; }
+};
+
+/**
+ * An individual compiled to postfix form, evaluated over blocks of samples
+ * directly from the dataset columns.
+ * The individual is simplified before being compiled: subtrees made only of
+ * constants are folded, identities like (e + 0), (e * 1) and (x0 - x0) are
+ * removed and the operands of commutative operations are sorted in a
+ * canonical order. The results are the same as evaluating the individual,
+ * which is never changed. Dataset values are assumed to be finite.
+ */
+class Program {
+public:
+  /// Number of samples evaluated at a time.
+  static constexpr size_t BlockSize = 256;
+
+  /**
+   * Compiles the individual.
+   * If it has Op::Custom nodes, the individual must outlive the program.
+   */
+  explicit Program(const repr::Node &individual);
+
+  /// Number of instructions of the program.
+  size_t size() const { return code_.size(); }
+
+  /// Number of nodes of the individual removed by the simplification.
+  size_t numRemoved() const { return numRemoved_; }
+
+  /// Instructions of the program, in postfix order.
+  const std::vector<Instruction> &code() const { return code_; }
+
+  /// Structural hash of the program. Equal programs have equal hashes.
+  size_t hash() const { return hash_; }
+
+  /**
+   * If the program may be compared with programs of other populations.
+   * Programs with Op::Custom instructions are compared by the address of their
+   * nodes, which may be reused by other individuals.
+   */
+  bool comparable() const;
+
+  /**
+   * If the programs are structurally equal, so they have the same values.
+   * Individuals that simplify to the same program are equal.
+   */
+  bool operator==(const Program &other) const;
+
+  /**
+   * Evaluates the samples in [begin, end) of the dataset.
+   * @param out Receives end - begin values.
+   */
+  void eval(const repr::Dataset &dataset, size_t begin, size_t end,
+            repr::T *out) const;
+
+  /**
+   * Bounds of the values of the program over the dataset.
+   * Nothing is known if the dataset wasn't summarized.
+   */
+  Bounds bounds(const repr::Dataset &dataset) const;
+
+  /**
+   * Sum of the squared errors of the program for all samples of the dataset.
+   * Programs with constant bounds are scored in closed form from the summary
+   * of the expected outputs and non-finite ones are rejected with an
+   * infinite error, without evaluating them.
+   * @param bounds Result of bounds(dataset).
+   */
+  double squaredError(const repr::Dataset &dataset,
+                      const Bounds &bounds) const;
+
+  /// Same as above, finding the bounds of the program.
+  double squaredError(const repr::Dataset &dataset) const {
+    return squaredError(dataset, bounds(dataset));
+  }
+
+private:
+  std::vector<Instruction> code_;
+  size_t maxDepth_;
+  size_t numRemoved_;
+  size_t hash_;
+};
+
+/**
+ * Returns the simplified version of the individual.
+ * The result evaluates to the same values, but may be smaller.
+ */
+repr::Node simplify(const repr::Node &individual);
+
+} // namespace program
+
+#endif // !COMPNAT_TP1_PROGRAM_HPP
@@ -0,0 +1,268 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "program.hpp"
+
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "generators.hpp"
+#include "parser.hpp"
+#include "primitives.hpp"
+
+namespace {
+using program::Program;
+using repr::Node;
+
+const char *KeijzerTrain = "compnat/tp1/datasets/keijzer-10-train.csv";
+
+Node var(size_t i) {
+  repr::RNG rng(0);
+  return Node(primitives::makeVarTerm(i)(rng));
+}
+
+Node constant(repr::T value) { return Node(primitives::constant(value)); }
+
+Node binary(const repr::PrimitiveFn &fn, Node a, Node b) {
+  repr::RNG rng(0);
+  Node node(fn(rng));
+  node.setChild(0, std::move(a));
+  node.setChild(1, std::move(b));
+  return node;
+}
+
+/// Checks the program evaluates to the same values as the individual.
+void expectSameValues(const Node &individual, const repr::Dataset &dataset) {
+  const Program program(individual);
+  std::vector<repr::T> values(dataset.size());
+  program.eval(dataset, 0, dataset.size(), values.data());
+
+  repr::EvalInput input(dataset.numInputs());
+  for (size_t i = 0; i < dataset.size(); ++i) {
+    dataset.row(i, input);
+    const repr::T expected = individual.eval(input);
+    if (std::isnan(expected)) {
+      ASSERT_TRUE(std::isnan(values[i])) << individual.str();
+    } else {
+      ASSERT_EQ(expected, values[i]) << individual.str();
+    }
+  }
+}
+
+TEST(ProgramTest, FoldsConstants) {
+  const auto &node =
+      binary(primitives::sumFn, var(0),
+             binary(primitives::multFn, constant(2), constant(3)));
+  const Program program(node);
+  EXPECT_EQ((size_t)3, program.size());
+  EXPECT_EQ((size_t)2, program.numRemoved());
+  EXPECT_EQ("(6 + x0)", program::simplify(node).str());
+}
+
+TEST(ProgramTest, RemovesIdentities) {
+  const auto &zero = binary(primitives::subFn, var(1), var(1));
+  const auto &node =
+      binary(primitives::divFn,
+             binary(primitives::sumFn, var(0), binary(primitives::multFn,
+                                                      var(1), zero)),
+             constant(1));
+  const Program program(node);
+  EXPECT_EQ((size_t)1, program.size());
+  EXPECT_EQ((size_t)8, program.numRemoved());
+  EXPECT_EQ("x0", program::simplify(node).str());
+
+  // Division by 0 is always 0.
+  EXPECT_EQ("0", program::simplify(binary(primitives::divFn, var(0), zero))
+                     .str());
+}
+
+TEST(ProgramTest, KeepsNonFiniteSubtrees) {
+  // log2(x0) may be -inf, so (log2(x0) * 0) isn't always 0.
+  repr::RNG rng(0);
+  Node log(primitives::logFn(rng));
+  log.setChild(0, var(0));
+  const auto &node = binary(primitives::multFn, log, constant(0));
+  EXPECT_EQ((size_t)0, Program(node).numRemoved());
+}
+
+TEST(ProgramTest, SortsCommutativeOperands) {
+  const auto &a = binary(primitives::sumFn, var(1), var(0));
+  const auto &b = binary(primitives::sumFn, var(0), var(1));
+  EXPECT_EQ(program::simplify(a).str(), program::simplify(b).str());
+
+  // Non commutative operands are kept in order.
+  const auto &c = binary(primitives::subFn, var(1), var(0));
+  EXPECT_EQ("(x1 - x0)", program::simplify(c).str());
+}
+
+TEST(ProgramTest, ComparesSimplifiedStructure) {
+  const Program a(binary(primitives::sumFn, var(1), var(0)));
+  const Program b(binary(primitives::sumFn, var(0),
+                         binary(primitives::sumFn, var(1), constant(0))));
+  EXPECT_TRUE(a == b);
+  EXPECT_EQ(a.hash(), b.hash());
+  EXPECT_TRUE(a.comparable());
+
+  EXPECT_FALSE(a == Program(binary(primitives::subFn, var(1), var(0))));
+  EXPECT_FALSE(a == Program(binary(primitives::sumFn, var(1), constant(0))));
+}
+
+TEST(ProgramTest, EvaluatesCustomPrimitives) {
+  const repr::Primitive square(
+      1,
+      [](const auto &input, const auto &children) {
+        const repr::T value = children[0].eval(input);
+        return value * value;
+      },
+      [](const auto &children) { return "sq" + children[0].str(); });
+  Node node(square);
+  node.setChild(0, binary(primitives::sumFn, var(0), constant(0)));
+
+  const auto &dataset = parser::loadDataset(KeijzerTrain);
+  expectSameValues(binary(primitives::sumFn, node, constant(1)), dataset);
+}
+
+TEST(BoundsTest, FindsConstantIndividuals) {
+  // x1 is always 2, so (x1 * x1) is always 4.
+  const repr::Dataset dataset = {{{1, 2}, 3}, {{5, 2}, 4}, {{-3, 2}, 8}};
+  const Program program(binary(primitives::multFn, var(1), var(1)));
+  const auto &bounds = program.bounds(dataset);
+  ASSERT_TRUE(bounds.constant());
+  EXPECT_EQ(4, bounds.min);
+
+  // 1 + 0 + 16 evaluated in closed form.
+  EXPECT_DOUBLE_EQ(17, program.squaredError(dataset));
+  EXPECT_FALSE(Program(var(0)).bounds(dataset).constant());
+}
+
+TEST(BoundsTest, RejectsNonFiniteIndividuals) {
+  const repr::Dataset dataset = {{{1, 2}, 3}, {{5, 2}, 4}};
+  repr::RNG rng(0);
+  Node log(primitives::logFn(rng));
+  log.setChild(0, binary(primitives::subFn, var(0), constant(5)));
+
+  // x0 - 5 is never positive.
+  const auto &node = binary(primitives::sumFn, var(1), log);
+  const Program program(node);
+  EXPECT_TRUE(program.bounds(dataset).nonFinite);
+  EXPECT_TRUE(std::isinf(program.squaredError(dataset)));
+
+  // Dividing by 0 turns it into 0.
+  const Program div(
+      binary(primitives::divFn, node, binary(primitives::subFn, var(1),
+                                             constant(2))));
+  EXPECT_TRUE(div.bounds(dataset).constant());
+}
+
+TEST(BoundsTest, BoundsAllValues) {
+  const auto &dataset = parser::loadDataset(KeijzerTrain);
+  const repr::Params params(
+      "", 0, 0, 0, 120, 0, 7, 0.8, false, false,
+      {primitives::sumFn, primitives::subFn, primitives::multFn,
+       primitives::divFn, primitives::logFn},
+      {primitives::constTerm, primitives::makeVarTerm(0),
+       primitives::makeVarTerm(1)});
+
+  repr::RNG rng(7);
+  std::vector<repr::T> values(dataset.size());
+  for (const auto &individual : generators::rampedHalfAndHalf(rng, params)) {
+    const Program program(individual);
+    const auto &bounds = program.bounds(dataset);
+    program.eval(dataset, 0, dataset.size(), values.data());
+    for (const auto &value : values) {
+      if (bounds.bounded) {
+        ASSERT_LE(bounds.min, value) << individual.str();
+        ASSERT_GE(bounds.max, value) << individual.str();
+      } else if (bounds.nonFinite) {
+        ASSERT_FALSE(std::isfinite(value)) << individual.str();
+      }
+    }
+  }
+}
+
+TEST(BoundsTest, BoundsTranscendentalValues) {
+  const auto &dataset = parser::loadDataset(KeijzerTrain);
+  const repr::Params params(
+      "", 0, 0, 0, 120, 0, 5, 0.8, false, false,
+      {primitives::sumFn, primitives::multFn, primitives::logFn,
+       primitives::expFn, primitives::sinFn, primitives::cosFn,
+       primitives::sqrtFn, primitives::powFn},
+      {primitives::constTerm, primitives::makeVarTerm(0),
+       primitives::literalTerm(1e4)});
+
+  repr::RNG rng(7);
+  std::vector<repr::T> values(dataset.size());
+  for (const auto &individual : generators::rampedHalfAndHalf(rng, params)) {
+    const Program program(individual);
+    const auto &bounds = program.bounds(dataset);
+    program.eval(dataset, 0, dataset.size(), values.data());
+    for (const auto &value : values) {
+      if (bounds.bounded) {
+        ASSERT_LE(bounds.min, value) << individual.str();
+        ASSERT_GE(bounds.max, value) << individual.str();
+      } else if (bounds.nonFinite) {
+        ASSERT_FALSE(std::isfinite(value)) << individual.str();
+      }
+    }
+  }
+}
+
+TEST(BoundsTest, RequiresSummarizedDatasets) {
+  repr::Dataset dataset(2, 1);
+  const Program program(constant(2));
+  EXPECT_FALSE(program.bounds(dataset).bounded);
+  dataset.summarize();
+  EXPECT_TRUE(program.bounds(dataset).constant());
+}
+
+TEST(ProgramTest, MatchesIndividuals) {
+  const auto &dataset = parser::loadDataset(KeijzerTrain);
+  const repr::Params params(
+      "", 0, 0, 0, 60, 0, 7, 0.8, false, false,
+      {primitives::sumFn, primitives::subFn, primitives::multFn,
+       primitives::divFn, primitives::logFn},
+      {primitives::constTerm, primitives::makeVarTerm(0),
+       primitives::makeVarTerm(1)});
+
+  repr::RNG rng(42);
+  for (const auto &individual : generators::rampedHalfAndHalf(rng, params)) {
+    expectSameValues(individual, dataset);
+    expectSameValues(program::simplify(individual), dataset);
+    EXPECT_EQ(individual.size() - Program(individual).numRemoved(),
+              program::simplify(individual).size());
+  }
+}
+
+TEST(ProgramTest, MatchesTranscendentalIndividuals) {
+  const auto &dataset = parser::loadDataset(KeijzerTrain);
+  const repr::Params params(
+      "", 0, 0, 0, 60, 0, 7, 0.8, false, false,
+      {primitives::subFn, primitives::divFn, primitives::expFn,
+       primitives::sinFn, primitives::cosFn, primitives::sqrtFn,
+       primitives::powFn},
+      {primitives::constTerm, primitives::makeVarTerm(0),
+       primitives::makeVarTerm(1)});
+
+  repr::RNG rng(42);
+  for (const auto &individual : generators::rampedHalfAndHalf(rng, params)) {
+    expectSameValues(individual, dataset);
+    expectSameValues(program::simplify(individual), dataset);
+  }
+}
+
+} // namespace
@@ -17,19 +17,36 @@
 #ifndef COMPNAT_TP1_REPRESENTATION_HPP
 #define COMPNAT_TP1_REPRESENTATION_HPP
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
 #include <functional>
+#include <initializer_list>
+#include <map>
+#include <memory>
 #include <random>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "glog/logging.h"
 
+#include "compnat/common/numa.hpp"
+
 namespace repr {
 class Node;
 struct Primitive;
 
-/// Type of the input data.
+/**
+ * Type of the input data.
+ * Built as float when COMPNAT_TP1_FLOAT32 is defined, which halves the memory
+ * and bandwidth used by the datasets. Errors are still accumulated as double.
+ */
+#ifdef COMPNAT_TP1_FLOAT32
+using T = float;
+#else
 using T = double;
+#endif
 
 /// Type of the random number generator.
 using RNG = std::mt19937;
@@ -55,8 +72,357 @@ using PrimitiveFn = std::function<Primitive(RNG &rng)>;
 /// Pair mapping inputs to output.
 using Sample = std::pair<EvalInput, T>;
 
-/// Dataset of samples.
-using Dataset = std::vector<Sample>;
+/// Range and moments of the values of a dataset column.
+struct ColumnSummary {
+  T min = 0;
+  T max = 0;
+  double mean = 0;
+
+  /// Sum of the squared deviations from the mean.
+  double m2 = 0;
+};
+
+/**
+ * Dataset of samples, stored by column.
+ * The first numInputs() columns are the values of the input variables and the
+ * last one is the expected output. Each column is contiguous and aligned to
+ * ColumnAlignment bytes, except in slices. Copies and slices share the same
+ * underlying storage.
+ */
+class Dataset {
+public:
+  /// Alignment of the start of each column, in bytes.
+  static constexpr size_t ColumnAlignment = 64;
+
+  /// Creates an empty dataset.
+  Dataset() : numRows_(0), numInputs_(0) {}
+
+  /// Allocates an uninitialized dataset with the given dimensions.
+  Dataset(size_t numRows, size_t numInputs)
+      : numRows_(numRows), numInputs_(numInputs) {
+    const size_t stride = columnStride(numRows);
+    const size_t bytes = std::max<size_t>(1, stride * (numInputs + 1));
+    T *data = static_cast<T *>(std::aligned_alloc(ColumnAlignment, bytes));
+    CHECK(data) << "Failed to allocate dataset with " << numRows << " rows";
+    storage_ = std::shared_ptr<void>(data, std::free);
+
+    for (size_t i = 0; i <= numInputs; ++i) {
+      columns_.push_back(data + i * stride / sizeof(T));
+    }
+  }
+
+  /// Creates a dataset from the given samples.
+  Dataset(std::initializer_list<Sample> samples)
+      : Dataset(samples.size(),
+                samples.size() ? samples.begin()->first.size() : 0) {
+    size_t row = 0;
+    for (const auto &sample : samples) {
+      CHECK(sample.first.size() == numInputs_);
+      for (size_t i = 0; i < numInputs_; ++i) {
+        columns_[i][row] = sample.first[i];
+      }
+      columns_[numInputs_][row++] = sample.second;
+    }
+    summarize();
+  }
+
+  /**
+   * Creates a dataset from columns stored somewhere else.
+   * @param numRows Number of rows of each column.
+   * @param columns Input columns followed by the expected output column.
+   * @param storage Keeps the memory of the columns alive.
+   */
+  Dataset(size_t numRows, std::vector<T *> columns,
+          std::shared_ptr<void> storage)
+      : numRows_(numRows), numInputs_(columns.size() - 1),
+        columns_(std::move(columns)), storage_(std::move(storage)) {
+    CHECK(!columns_.empty());
+  }
+
+  /// Size in bytes of a column with numRows rows, including alignment padding.
+  static size_t columnStride(size_t numRows) {
+    const size_t bytes = numRows * sizeof(T);
+    return (bytes + ColumnAlignment - 1) / ColumnAlignment * ColumnAlignment;
+  }
+
+  /**
+   * Rows [begin, end) of the dataset, without copying them. The slice is
+   * summarized if the dataset is.
+   */
+  Dataset slice(size_t begin, size_t end) const {
+    CHECK(begin <= end && end <= numRows_)
+        << "Invalid slice [" << begin << ", " << end << ") of " << numRows_
+        << " rows";
+    std::vector<T *> columns;
+    for (T *column : columns_) {
+      columns.push_back(column + begin);
+    }
+
+    Dataset slice(end - begin, std::move(columns), storage_);
+    if (summarized()) {
+      slice.summarize();
+    }
+    return slice;
+  }
+
+  /**
+   * Copy of the dataset with a replica of its columns in the memory of each
+   * NUMA node, read with replica(). The copy itself reads the replica of node
+   * 0. Slices of the copy aren't replicated.
+   */
+  Dataset replicate() const {
+    const size_t stride = columnStride(numRows_);
+    auto replicas = std::make_shared<std::vector<Dataset>>();
+    for (size_t node = 0; node < numa::numNodes(); ++node) {
+      auto storage = numa::allocate(stride * columns_.size(), node);
+      T *data = static_cast<T *>(storage.get());
+      std::vector<T *> columns;
+      for (size_t c = 0; c < columns_.size(); ++c) {
+        columns.push_back(data + c * stride / sizeof(T));
+        std::copy(columns_[c], columns_[c] + numRows_, columns.back());
+      }
+
+      replicas->emplace_back(numRows_, std::move(columns), std::move(storage));
+      replicas->back().summaries_ = summaries_;
+      replicas->back().node_ = node;
+    }
+
+    Dataset dataset = replicas->front();
+    dataset.replicas_ = std::move(replicas);
+    return dataset;
+  }
+
+  /// Replica of the dataset on the node, the dataset itself if it wasn't
+  /// replicated.
+  const Dataset &replica(int node) const {
+    return replicas_ ? (*replicas_)[node % replicas_->size()] : *this;
+  }
+
+  /// Number of replicas, 0 if the dataset wasn't replicated.
+  size_t numReplicas() const { return replicas_ ? replicas_->size() : 0; }
+
+  /// NUMA node of the memory of the columns, -1 if unknown.
+  int node() const {
+    return node_ >= 0 || columns_.empty() ? node_
+                                          : numa::addressNode(columns_[0]);
+  }
+
+  /// Number of samples in the dataset.
+  size_t size() const { return numRows_; }
+
+  /// Bytes of all columns, without padding.
+  size_t sizeInBytes() const { return numRows_ * columns_.size() * sizeof(T); }
+
+  /// If the dataset has no samples.
+  bool empty() const { return numRows_ == 0; }
+
+  /// Number of input variables of each sample.
+  size_t numInputs() const { return numInputs_; }
+
+  /// Values of the given input variable for all samples.
+  const T *input(size_t var) const { return columns_[var]; }
+
+  /// Expected outputs of all samples.
+  const T *expected() const { return columns_[numInputs_]; }
+
+  /// Mutable column, the expected output is column numInputs().
+  T *mutableColumn(size_t column) { return columns_[column]; }
+
+  /// Copies the inputs of the given row to input, which must be big enough.
+  void row(size_t i, EvalInput &input) const {
+    for (size_t var = 0; var < numInputs_; ++var) {
+      input[var] = columns_[var][i];
+    }
+  }
+
+  /// Returns a copy of the sample at the given row.
+  Sample operator[](size_t i) const {
+    EvalInput input(numInputs_);
+    row(i, input);
+    return {std::move(input), expected()[i]};
+  }
+
+  /**
+   * Computes the summary of all columns, done by the dataset loaders.
+   * Must be called again if the values are changed.
+   */
+  void summarize() {
+    summaries_.resize(columns_.size());
+#pragma omp parallel for
+    for (size_t c = 0; c < columns_.size(); ++c) {
+      summaries_[c] = summarize_(columns_[c], numRows_);
+    }
+  }
+
+  /// If summarize() was called.
+  bool summarized() const { return !summaries_.empty(); }
+
+  /// Summary of the given column, the expected output is column numInputs().
+  const ColumnSummary &summary(size_t column) const {
+    return summaries_[column];
+  }
+
+private:
+  static ColumnSummary summarize_(const T *column, size_t numRows) {
+    ColumnSummary summary;
+    if (!numRows) {
+      return summary;
+    }
+
+    summary.min = summary.max = column[0];
+    double sum = 0;
+    for (size_t i = 0; i < numRows; ++i) {
+      summary.min = std::min(summary.min, column[i]);
+      summary.max = std::max(summary.max, column[i]);
+      sum += column[i];
+    }
+
+    summary.mean = sum / numRows;
+    for (size_t i = 0; i < numRows; ++i) {
+      summary.m2 += ((double)column[i] - summary.mean) *
+                    ((double)column[i] - summary.mean);
+    }
+    return summary;
+  }
+
+  size_t numRows_;
+  size_t numInputs_;
+  std::vector<T *> columns_;
+  std::shared_ptr<void> storage_;
+  std::vector<ColumnSummary> summaries_;
+  int node_ = -1;
+  std::shared_ptr<const std::vector<Dataset>> replicas_;
+};
+
+/**
+ * Rows of a dataset selected by ranges of row indices, without copying them.
+ * Evaluated one slice at a time, like the chunks of a stream::DatasetStream.
+ */
+class DatasetView {
+public:
+  /// Range of rows [first, second).
+  using Range = std::pair<size_t, size_t>;
+
+  /// Permutation of the rows of a dataset, shared by the views that use it.
+  using RowOrder = std::shared_ptr<const std::vector<uint32_t>>;
+
+  /// Rows of each block gathered by the views of a RowOrder.
+  static constexpr size_t GatherRows = 1 << 14;
+
+  /// View of the given ranges of rows of the dataset, which is summarized.
+  DatasetView(const Dataset &dataset, const std::vector<Range> &ranges)
+      : dataset_(dataset), numRows_(0), numInputs_(dataset.numInputs()) {
+    CHECK(dataset.summarized());
+    for (const auto &range : ranges) {
+      if (range.first != range.second) {
+        slices_.push_back(dataset.slice(range.first, range.second));
+        numRows_ += slices_.back().size();
+      }
+    }
+  }
+
+  /**
+   * View of the rows of the dataset at the given ranges of positions of
+   * order. The rows aren't copied: each block of up to GatherRows rows is
+   * gathered into a buffer of the evaluating thread.
+   */
+  DatasetView(const Dataset &dataset, RowOrder order,
+              const std::vector<Range> &ranges)
+      : dataset_(dataset), order_(std::move(order)), numRows_(0),
+        numInputs_(dataset.numInputs()) {
+    CHECK(order_->size() == dataset.size());
+    for (const auto &range : ranges) {
+      CHECK(range.first <= range.second && range.second <= order_->size());
+      if (range.first != range.second) {
+        ranges_.push_back(range);
+        numRows_ += range.second - range.first;
+      }
+    }
+  }
+
+  /// Number of samples in the view.
+  size_t size() const { return numRows_; }
+
+  /// Number of input variables of each sample.
+  size_t numInputs() const { return numInputs_; }
+
+  /// Dataset the rows of the view are read from.
+  const Dataset &dataset() const { return dataset_; }
+
+  /// Contiguous slices of the dataset that form the view, empty for views of
+  /// a RowOrder.
+  const std::vector<Dataset> &slices() const { return slices_; }
+
+  /**
+   * Calls fn for each slice in order, or for each gathered block of the rows
+   * of a RowOrder. A block is only valid during its call.
+   * @return The number of samples in the view.
+   */
+  template <typename Fn> size_t forEachChunk(Fn fn) const {
+    for (const auto &slice : slices_) {
+      fn(slice);
+    }
+    for (const auto &range : ranges_) {
+      for (size_t begin = range.first; begin < range.second;
+           begin += GatherRows) {
+        fn(gather_(begin, std::min(range.second, begin + GatherRows)));
+      }
+    }
+    return numRows_;
+  }
+
+private:
+  /// Summarized copy of the rows at positions [begin, end) of the order, in
+  /// the buffer of the thread.
+  Dataset gather_(size_t begin, size_t end) const {
+    thread_local Dataset buffer;
+    if (buffer.numInputs() != numInputs_ || buffer.empty()) {
+      buffer = Dataset(GatherRows, numInputs_);
+    }
+
+    const auto &order = *order_;
+    for (size_t c = 0; c <= numInputs_; ++c) {
+      const T *column =
+          c < numInputs_ ? dataset_.input(c) : dataset_.expected();
+      T *gathered = buffer.mutableColumn(c);
+      for (size_t i = begin; i < end; ++i) {
+        gathered[i - begin] = column[order[i]];
+      }
+    }
+
+    auto block = buffer.slice(0, end - begin);
+    block.summarize();
+    return block;
+  }
+
+  Dataset dataset_;
+  RowOrder order_;
+  std::vector<Range> ranges_;
+  size_t numRows_;
+  size_t numInputs_;
+  std::vector<Dataset> slices_;
+};
+
+/**
+ * Operation performed by a primitive.
+ * Allows individuals to be compiled and simplified. Op::Custom primitives can
+ * only be evaluated through their EvalFn.
+ */
+enum class Op {
+  Custom,
+  Const,
+  Var,
+  Sum,
+  Sub,
+  Mult,
+  Div,
+  Log,
+  Exp,
+  Sin,
+  Cos,
+  Sqrt,
+  Pow
+};
 
 /// Represents an primitive.
 struct Primitive {
@@ -64,15 +430,117 @@ struct Primitive {
   EvalFn evalFn;
   StrFn strFn;
 
+  /// Operation performed by evalFn.
+  Op op;
+
+  /// Value of Op::Const primitives.
+  T value;
+
+  /// Variable of Op::Var primitives.
+  size_t var;
+
   operator bool() const { return evalFn && strFn; }
 
-  Primitive() : numRequiredChildren(0) {}
+  Primitive() : numRequiredChildren(0), op(Op::Custom), value(0), var(0) {}
 
-  Primitive(int numRequiredChildren, EvalFn evalFn, StrFn strFn)
-      : numRequiredChildren(numRequiredChildren), evalFn(evalFn), strFn(strFn) {
-  }
+  Primitive(int numRequiredChildren, EvalFn evalFn, StrFn strFn,
+            Op op = Op::Custom, T value = 0, size_t var = 0)
+      : numRequiredChildren(numRequiredChildren), evalFn(evalFn), strFn(strFn),
+        op(op), value(value), var(var) {}
+};
+
+/**
+ * Bloat control params, used when generating new populations. Each method is
+ * disabled when its param is 0 and they may be combined.
+ */
+struct BloatParams {
+  /// Probability of rejecting a child bigger than the average size of the
+  /// parent generation (Tarpeian method). Rejected children are replaced.
+  double tarpeianProb = 0;
+
+  /// Selection uses fitness + parsimonyCoefficient * size (parsimony
+  /// pressure).
+  double parsimonyCoefficient = 0;
+
+  /// Maximum total number of nodes of a generation. Children that don't fit
+  /// are replaced by a random terminal.
+  size_t nodeBudget = 0;
+};
+
+/// Params of the local optimization of the constants of the best individuals.
+struct TuningParams {
+  /// Number of best individuals of each generation that have their constants
+  /// tuned (0 to disable).
+  size_t numElites = 0;
+
+  /// Levenberg-Marquardt steps for each tuned individual.
+  size_t numSteps = 5;
+};
+
+/**
+ * Criteria that stop instances before numGenerations. Each criterion is
+ * disabled when its param is 0 and they may be combined. They are checked
+ * after the train statistics of each generation.
+ */
+struct StoppingParams {
+  /// Seconds all instances may run for. When it runs out, the running
+  /// instance stops and the remaining ones aren't run. The first instance
+  /// always runs at least its first generation.
+  double timeBudget = 0;
+
+  /// Seconds each instance may run for.
+  double instanceTimeBudget = 0;
+
+  /// Instances stop when their best train fitness didn't improve by more than
+  /// stagnationEpsilon in this many generations.
+  size_t stagnationGenerations = 0;
+
+  /// Minimum decrease of the best train fitness that counts as improving it.
+  double stagnationEpsilon = 0;
 };
 
+/// How much of the statistics of each generation is computed and reported.
+enum class StatsLevel {
+  /// Only the final statistics of each instance. The other generations only
+  /// compute what breeding and the stopping criteria need, and aren't logged
+  /// or aggregated.
+  None,
+
+  /// Fitness and size of the best, worst and average individuals, logged in a
+  /// single line. With alwaysTest, only the best train individual is scored
+  /// on the test dataset.
+  Summary,
+
+  /// Everything, including the best individual as a string, the repeated
+  /// individuals and the improvements over the parents.
+  Full
+};
+
+/// Name of the level, as used in the --stats_level flag.
+inline const char *statsLevelName(StatsLevel level) {
+  switch (level) {
+  case StatsLevel::None:
+    return "none";
+  case StatsLevel::Summary:
+    return "summary";
+  case StatsLevel::Full:
+    return "full";
+  }
+  return "";
+}
+
+/// Level named like in the --stats_level flag.
+inline StatsLevel parseStatsLevel(const std::string &name) {
+  static const std::map<std::string, StatsLevel> levels = {
+      {"none", StatsLevel::None},
+      {"summary", StatsLevel::Summary},
+      {"full", StatsLevel::Full}};
+
+  const auto it = levels.find(name);
+  CHECK(it != levels.end()) << "Unknown stats level: " << name;
+  return it->second;
+}
+
 /**
  * Represents the parameters used in the program.
  * TODO(renatoutsch): add accessors to always be sure populationSize is correct.
@@ -114,16 +582,45 @@ struct Params {
   /// Available terminal primitives.
   std::vector<PrimitiveFn> terminals;
 
+  /// If individuals are replaced by their simplified version after evaluation.
+  bool simplifyGenotype;
+
+  /// Bloat control params.
+  BloatParams bloat;
+
+  /// Constant tuning params.
+  TuningParams tuning;
+
+  /// Train fitness that counts as solving the problem. The number of
+  /// evaluations needed to reach it is reported (0 to disable).
+  double targetFitness;
+
+  /// Early stopping params.
+  StoppingParams stopping;
+
+  /// Statistics computed for each generation. The final statistics of each
+  /// instance are always full, except for the improvement stats.
+  StatsLevel statsLevel;
+
   Params(const std::string &outputFile_, unsigned seed_, size_t numInstances_,
          size_t numGenerations_, size_t populationSize_, size_t tournamentSize_,
          size_t maxHeight_, double crossoverProb_, bool elitism_,
          bool alwaysTest_, const std::vector<PrimitiveFn> &functions_,
-         const std::vector<PrimitiveFn> &terminals_)
+         const std::vector<PrimitiveFn> &terminals_,
+         bool simplifyGenotype_ = false,
+         const BloatParams &bloat_ = BloatParams(),
+         const TuningParams &tuning_ = TuningParams(),
+         double targetFitness_ = 0,
+         const StoppingParams &stopping_ = StoppingParams(),
+         StatsLevel statsLevel_ = StatsLevel::Full)
       : outputFile(outputFile_), seed(seed_), numInstances(numInstances_),
         numGenerations(numGenerations_), populationSize(populationSize_),
         tournamentSize(tournamentSize_), maxHeight(maxHeight_),
         crossoverProb(crossoverProb_), elitism(elitism_),
-        alwaysTest(alwaysTest_), functions(functions_), terminals(terminals_) {
+        alwaysTest(alwaysTest_), functions(functions_), terminals(terminals_),
+        simplifyGenotype(simplifyGenotype_), bloat(bloat_), tuning(tuning_),
+        targetFitness(targetFitness_), stopping(stopping_),
+        statsLevel(statsLevel_) {
     if (populationSize < maxHeight - 1) {
       LOG(WARNING) << "params: populationSize changed to maxHeight - 1";
       populationSize = maxHeight - 1;
@@ -143,6 +640,11 @@ struct Params {
       populationSize += maxHeight - 1;
     }
 
+    if (bloat.nodeBudget && bloat.nodeBudget < populationSize) {
+      LOG(WARNING) << "params: nodeBudget is smaller than the population, "
+                   << "generations will exceed it";
+    }
+
     LOG(INFO) << "Params:";
     LOG(INFO) << "outputFile: " << outputFile;
     LOG(INFO) << "seed: " << seed;
@@ -154,6 +656,18 @@ struct Params {
     LOG(INFO) << "crossoverProb: " << crossoverProb;
     LOG(INFO) << "elitism: " << elitism;
     LOG(INFO) << "alwaysTest: " << alwaysTest;
+    LOG(INFO) << "simplifyGenotype: " << simplifyGenotype;
+    LOG(INFO) << "tarpeianProb: " << bloat.tarpeianProb;
+    LOG(INFO) << "parsimonyCoefficient: " << bloat.parsimonyCoefficient;
+    LOG(INFO) << "nodeBudget: " << bloat.nodeBudget;
+    LOG(INFO) << "tuneElites: " << tuning.numElites;
+    LOG(INFO) << "tuneSteps: " << tuning.numSteps;
+    LOG(INFO) << "targetFitness: " << targetFitness;
+    LOG(INFO) << "timeBudget: " << stopping.timeBudget;
+    LOG(INFO) << "instanceTimeBudget: " << stopping.instanceTimeBudget;
+    LOG(INFO) << "stagnationGenerations: " << stopping.stagnationGenerations;
+    LOG(INFO) << "stagnationEpsilon: " << stopping.stagnationEpsilon;
+    LOG(INFO) << "statsLevel: " << statsLevelName(statsLevel);
   }
 };
 
@@ -170,7 +684,7 @@ public:
    */
   Node(const Primitive &op = Primitive())
       : numRequiredChildren_(op.numRequiredChildren), evalFn_(op.evalFn),
-        strFn_(op.strFn) {
+        strFn_(op.strFn), op_(op.op), value_(op.value), var_(op.var) {
     if (evalFn_) {
       CHECK(strFn_);
       children_.resize(numRequiredChildren_);
@@ -198,6 +712,15 @@ public:
   /// If the node is terminal.
   bool isTerminal() const { return evalFn_ && numRequiredChildren_ == 0; }
 
+  /// Operation performed by the node.
+  Op op() const { return op_; }
+
+  /// Value of the node if it is an Op::Const.
+  T value() const { return value_; }
+
+  /// Variable of the node if it is an Op::Var.
+  size_t var() const { return var_; }
+
   /**
    * Size of the tree, aka number of elements in this entire subtree.
    * If using this multiple times, best to pre-compute it once and reuse it.
@@ -214,6 +737,9 @@ private:
   int numRequiredChildren_;
   EvalFn evalFn_;
   StrFn strFn_;
+  Op op_;
+  T value_;
+  size_t var_;
   Children children_;
 };
 
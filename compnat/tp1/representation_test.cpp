@@ -20,6 +20,7 @@
 
 #include <gtest/gtest.h>
 
+#include "compnat/common/numa.hpp"
 #include "primitives.hpp"
 
 namespace {
@@ -53,6 +54,59 @@ TEST(ParamsTest, UpdatesPopulationSizeCorrectly) {
   EXPECT_EQ((size_t)28, params2.populationSize);
 }
 
+TEST(DatasetTest, SummarizesColumns) {
+  const repr::Dataset dataset = {{{1, -2}, 3}, {{5, 2}, 4}, {{3, 0}, 8}};
+  ASSERT_TRUE(dataset.summarized());
+  EXPECT_EQ(1, dataset.summary(0).min);
+  EXPECT_EQ(5, dataset.summary(0).max);
+  EXPECT_DOUBLE_EQ(3, dataset.summary(0).mean);
+  EXPECT_DOUBLE_EQ(8, dataset.summary(0).m2);
+  EXPECT_EQ(-2, dataset.summary(1).min);
+  EXPECT_EQ(2, dataset.summary(1).max);
+  EXPECT_DOUBLE_EQ(5, dataset.summary(2).mean);
+  EXPECT_DOUBLE_EQ(14, dataset.summary(2).m2);
+}
+
+TEST(DatasetTest, SlicesShareRows) {
+  const repr::Dataset dataset = {
+      {{1, -2}, 3}, {{5, 2}, 4}, {{3, 0}, 8}, {{2, 1}, 6}};
+  const auto &slice = dataset.slice(1, 3);
+  ASSERT_EQ((size_t)2, slice.size());
+  EXPECT_EQ(dataset.input(0) + 1, slice.input(0));
+  EXPECT_EQ(8, slice.expected()[1]);
+  ASSERT_TRUE(slice.summarized());
+  EXPECT_EQ(3, slice.summary(0).min);
+  EXPECT_DOUBLE_EQ(6, slice.summary(2).mean);
+
+  const repr::DatasetView view(dataset, {{0, 1}, {2, 2}, {3, 4}});
+  EXPECT_EQ((size_t)2, view.size());
+  EXPECT_EQ((size_t)2, view.numInputs());
+  ASSERT_EQ((size_t)2, view.slices().size());
+  EXPECT_EQ(2, view.slices()[1].input(0)[0]);
+}
+
+TEST(DatasetTest, ReplicatesPerNode) {
+  const repr::Dataset dataset = {{{1, -2}, 3}, {{5, 2}, 4}, {{3, 0}, 8}};
+  EXPECT_EQ((size_t)0, dataset.numReplicas());
+  EXPECT_EQ(&dataset, &dataset.replica(0));
+
+  const auto &replicated = dataset.replicate();
+  ASSERT_EQ(numa::numNodes(), replicated.numReplicas());
+  for (size_t node = 0; node < numa::numNodes(); ++node) {
+    const auto &replica = replicated.replica(node);
+    EXPECT_EQ((int)node, replica.node());
+    EXPECT_NE(dataset.input(0), replica.input(0));
+    ASSERT_EQ(dataset.size(), replica.size());
+    ASSERT_TRUE(replica.summarized());
+    EXPECT_EQ(-2, replica.summary(1).min);
+    for (size_t i = 0; i < dataset.size(); ++i) {
+      EXPECT_EQ(dataset[i], replica[i]);
+    }
+  }
+  EXPECT_EQ(replicated.replica(0).input(0), replicated.input(0));
+  EXPECT_EQ(&replicated.replica(0), &replicated.replica(numa::numNodes()));
+}
+
 TEST(NodeTest, AcceptsValidPrimitiveAndGivesCorrectResults) {
   RNG rng(0);
   Node node(primitives::sumFn(rng));
@@ -0,0 +1,474 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "serializer.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "glog/logging.h"
+
+#include "primitives.hpp"
+
+namespace serializer {
+namespace {
+using repr::Op;
+
+/// Maximum depth of parsed and decoded individuals, to reject malformed data
+/// before running out of stack.
+const size_t MaxDepth_ = 1024;
+
+/// Byte of each operation in the binary encoding. Never change the values.
+enum class Tag_ : uint8_t {
+  Const = 1,
+  Var = 2,
+  Sum = 3,
+  Sub = 4,
+  Mult = 5,
+  Div = 6,
+  Log = 7,
+  Exp = 8,
+  Sin = 9,
+  Cos = 10,
+  Sqrt = 11,
+  Pow = 12
+};
+
+/// Operations written as function calls, like "pow(a, b)".
+const Op FunctionOps_[] = {Op::Log, Op::Exp, Op::Sin,
+                           Op::Cos, Op::Sqrt, Op::Pow};
+
+/// Returns the primitive of an operation, except for Op::Const and Op::Var.
+repr::Primitive primitive_(Op op, repr::RNG &rng) {
+  switch (op) {
+  case Op::Sum:
+    return primitives::sumFn(rng);
+  case Op::Sub:
+    return primitives::subFn(rng);
+  case Op::Mult:
+    return primitives::multFn(rng);
+  case Op::Div:
+    return primitives::divFn(rng);
+  case Op::Log:
+    return primitives::logFn(rng);
+  case Op::Exp:
+    return primitives::expFn(rng);
+  case Op::Sin:
+    return primitives::sinFn(rng);
+  case Op::Cos:
+    return primitives::cosFn(rng);
+  case Op::Sqrt:
+    return primitives::sqrtFn(rng);
+  case Op::Pow:
+    return primitives::powFn(rng);
+  default:
+    LOG(FATAL) << "Invalid operation " << static_cast<int>(op);
+    return repr::Primitive();
+  }
+}
+
+/// Returns the variable terminal of the given index.
+repr::Node var_(size_t var, repr::RNG &rng) {
+  return repr::Node(primitives::makeVarTerm(var)(rng));
+}
+
+/// Returns the operator of binary operations, or nullptr.
+const char *binaryOperator_(Op op) {
+  switch (op) {
+  case Op::Sum:
+    return " + ";
+  case Op::Sub:
+    return " - ";
+  case Op::Mult:
+    return " * ";
+  case Op::Div:
+    return " / ";
+  default:
+    return nullptr;
+  }
+}
+
+/// Returns the name of operations written as function calls, or nullptr.
+const char *functionName_(Op op) {
+  switch (op) {
+  case Op::Log:
+    return "log2";
+  case Op::Exp:
+    return "exp";
+  case Op::Sin:
+    return "sin";
+  case Op::Cos:
+    return "cos";
+  case Op::Sqrt:
+    return "sqrt";
+  case Op::Pow:
+    return "pow";
+  default:
+    return nullptr;
+  }
+}
+
+void appendStr_(const repr::Node &node, std::string &out, int precision) {
+  char buffer[32];
+  switch (node.op()) {
+  case Op::Const: {
+    // Same format of std::ostream, used by Node::str().
+    const int n = std::snprintf(buffer, sizeof(buffer), "%.*g", precision,
+                                static_cast<double>(node.value()));
+    out.append(buffer, n);
+    return;
+  }
+  case Op::Var: {
+    out += 'x';
+    const auto[end, ec] = std::to_chars(buffer, buffer + sizeof(buffer),
+                                        node.var());
+    out.append(buffer, end);
+    return;
+  }
+  case Op::Custom:
+    out.append(node.str());
+    return;
+  default:
+    break;
+  }
+
+  if (const char *name = functionName_(node.op())) {
+    out.append(name);
+    out += '(';
+    for (size_t i = 0; i < node.numChildren(); ++i) {
+      if (i) {
+        out.append(", ");
+      }
+      appendStr_(node.child(i), out, precision);
+    }
+    out += ')';
+  } else {
+    out += '(';
+    appendStr_(node.child(0), out, precision);
+    out.append(binaryOperator_(node.op()));
+    appendStr_(node.child(1), out, precision);
+    out += ')';
+  }
+}
+
+/// Recursive descent parser of expressions.
+class Parser_ {
+public:
+  explicit Parser_(const std::string &text) : text_(text), pos_(0) {}
+
+  repr::Node parse() {
+    auto node = expr_(0);
+    skipSpaces_();
+    if (pos_ != text_.size()) {
+      fail_("expected end of expression");
+    }
+    return node;
+  }
+
+private:
+  repr::Node expr_(size_t depth) {
+    if (depth > MaxDepth_) {
+      fail_("expression is too deep");
+    }
+
+    skipSpaces_();
+    for (const Op op : FunctionOps_) {
+      const std::string &call = std::string(functionName_(op)) + '(';
+      if (consume_(call.c_str())) {
+        repr::Node node(primitive_(op, rng_));
+        for (size_t i = 0; i < node.numChildren(); ++i) {
+          if (i) {
+            expect_(',');
+          }
+          node.setChild(i, expr_(depth + 1));
+        }
+        expect_(')');
+        return node;
+      }
+    }
+
+    if (consume_("(")) {
+      auto left = expr_(depth + 1);
+      skipSpaces_();
+      const Op op = binaryOp_();
+      auto right = expr_(depth + 1);
+      expect_(')');
+
+      repr::Node node(primitive_(op, rng_));
+      node.setChild(0, std::move(left));
+      node.setChild(1, std::move(right));
+      return node;
+    }
+
+    const char *begin = text_.data() + pos_;
+    const char *end = text_.data() + text_.size();
+    if (consume_("x")) {
+      size_t var;
+      const auto[ptr, ec] = std::from_chars(begin + 1, end, var);
+      if (ec != std::errc()) {
+        fail_("expected variable index");
+      }
+      pos_ = ptr - text_.data();
+      return var_(var, rng_);
+    }
+
+    repr::T value;
+    const auto[ptr, ec] = std::from_chars(begin, end, value);
+    if (ec != std::errc()) {
+      fail_("expected expression");
+    }
+    pos_ = ptr - text_.data();
+    return repr::Node(primitives::constant(value));
+  }
+
+  /// Consumes the operator of a binary operation.
+  Op binaryOp_() {
+    for (const Op op : {Op::Sum, Op::Sub, Op::Mult, Op::Div}) {
+      if (pos_ < text_.size() && text_[pos_] == binaryOperator_(op)[1]) {
+        ++pos_;
+        return op;
+      }
+    }
+    fail_("expected binary operator");
+    return Op::Custom;
+  }
+
+  /// Consumes the prefix if the remaining text starts with it.
+  bool consume_(const char *prefix) {
+    const size_t size = std::strlen(prefix);
+    if (text_.compare(pos_, size, prefix) != 0) {
+      return false;
+    }
+    pos_ += size;
+    return true;
+  }
+
+  void expect_(char c) {
+    skipSpaces_();
+    if (pos_ >= text_.size() || text_[pos_] != c) {
+      fail_(std::string("expected '") + c + "'");
+    }
+    ++pos_;
+  }
+
+  void skipSpaces_() {
+    while (pos_ < text_.size() && text_[pos_] == ' ') {
+      ++pos_;
+    }
+  }
+
+  void fail_(const std::string &error) const {
+    LOG(FATAL) << "Invalid expression at position " << pos_ << ": " << error
+               << ": " << text_;
+  }
+
+  const std::string &text_;
+  size_t pos_;
+
+  /// Unused by the primitives, but required to create them.
+  repr::RNG rng_;
+};
+
+void appendBinary_(const repr::Node &node, std::string &out) {
+  switch (node.op()) {
+  case Op::Const: {
+    out += static_cast<char>(Tag_::Const);
+    const double value = node.value();
+    char buffer[sizeof(value)];
+    std::memcpy(buffer, &value, sizeof(value));
+    out.append(buffer, sizeof(buffer));
+    return;
+  }
+  case Op::Var: {
+    out += static_cast<char>(Tag_::Var);
+    size_t var = node.var();
+    do {
+      const uint8_t byte = var & 0x7f;
+      var >>= 7;
+      out += static_cast<char>(var ? byte | 0x80 : byte);
+    } while (var);
+    return;
+  }
+  case Op::Sum:
+    out += static_cast<char>(Tag_::Sum);
+    break;
+  case Op::Sub:
+    out += static_cast<char>(Tag_::Sub);
+    break;
+  case Op::Mult:
+    out += static_cast<char>(Tag_::Mult);
+    break;
+  case Op::Div:
+    out += static_cast<char>(Tag_::Div);
+    break;
+  case Op::Log:
+    out += static_cast<char>(Tag_::Log);
+    break;
+  case Op::Exp:
+    out += static_cast<char>(Tag_::Exp);
+    break;
+  case Op::Sin:
+    out += static_cast<char>(Tag_::Sin);
+    break;
+  case Op::Cos:
+    out += static_cast<char>(Tag_::Cos);
+    break;
+  case Op::Sqrt:
+    out += static_cast<char>(Tag_::Sqrt);
+    break;
+  case Op::Pow:
+    out += static_cast<char>(Tag_::Pow);
+    break;
+  case Op::Custom:
+    LOG(FATAL) << "Custom primitives can't be encoded: " << node.str();
+  }
+
+  for (size_t i = 0; i < node.numChildren(); ++i) {
+    appendBinary_(node.child(i), out);
+  }
+}
+
+/// Decoder of the binary encoding.
+class Decoder_ {
+public:
+  Decoder_(const char *data, size_t size) : data_(data), size_(size), pos_(0) {}
+
+  repr::Node decode(size_t depth = 0) {
+    CHECK(depth <= MaxDepth_) << "Encoded individual is too deep";
+    CHECK(pos_ < size_) << "Truncated individual";
+    const auto tag = static_cast<Tag_>(data_[pos_++]);
+
+    Op op;
+    switch (tag) {
+    case Tag_::Const: {
+      CHECK(size_ - pos_ >= sizeof(double)) << "Truncated individual";
+      double value;
+      std::memcpy(&value, data_ + pos_, sizeof(value));
+      pos_ += sizeof(value);
+      return repr::Node(primitives::constant(value));
+    }
+    case Tag_::Var: {
+      size_t var = 0;
+      for (size_t shift = 0;; shift += 7) {
+        CHECK(pos_ < size_) << "Truncated individual";
+        CHECK(shift < 64) << "Invalid variable index";
+        const auto byte = static_cast<uint8_t>(data_[pos_++]);
+        var |= static_cast<size_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+          break;
+        }
+      }
+      return var_(var, rng_);
+    }
+    case Tag_::Sum:
+      op = Op::Sum;
+      break;
+    case Tag_::Sub:
+      op = Op::Sub;
+      break;
+    case Tag_::Mult:
+      op = Op::Mult;
+      break;
+    case Tag_::Div:
+      op = Op::Div;
+      break;
+    case Tag_::Log:
+      op = Op::Log;
+      break;
+    case Tag_::Exp:
+      op = Op::Exp;
+      break;
+    case Tag_::Sin:
+      op = Op::Sin;
+      break;
+    case Tag_::Cos:
+      op = Op::Cos;
+      break;
+    case Tag_::Sqrt:
+      op = Op::Sqrt;
+      break;
+    case Tag_::Pow:
+      op = Op::Pow;
+      break;
+    default:
+      LOG(FATAL) << "Invalid operation " << static_cast<int>(tag)
+                 << " at byte " << pos_ - 1;
+      return repr::Node();
+    }
+
+    repr::Node node(primitive_(op, rng_));
+    for (size_t i = 0; i < node.numChildren(); ++i) {
+      node.setChild(i, decode(depth + 1));
+    }
+    return node;
+  }
+
+  size_t pos() const { return pos_; }
+
+private:
+  const char *data_;
+  size_t size_;
+  size_t pos_;
+
+  /// Unused by the primitives, but required to create them.
+  repr::RNG rng_;
+};
+
+} // namespace
+
+void appendStr(const repr::Node &individual, std::string &out,
+               int precision) {
+  appendStr_(individual, out, precision);
+}
+
+std::string str(const repr::Node &individual, int precision) {
+  std::string out;
+  out.reserve(8 * individual.size());
+  appendStr_(individual, out, precision);
+  return out;
+}
+
+repr::Node parse(const std::string &text) { return Parser_(text).parse(); }
+
+void appendBinary(const repr::Node &individual, std::string &out) {
+  appendBinary_(individual, out);
+}
+
+std::string encode(const repr::Node &individual) {
+  std::string out;
+  appendBinary_(individual, out);
+  return out;
+}
+
+repr::Node decode(const char *data, size_t size, size_t *consumed) {
+  Decoder_ decoder(data, size);
+  auto individual = decoder.decode();
+  if (consumed) {
+    *consumed = decoder.pos();
+  }
+  return individual;
+}
+
+repr::Node decode(const std::string &data) {
+  size_t consumed;
+  auto individual = decode(data.data(), data.size(), &consumed);
+  CHECK(consumed == data.size()) << "Trailing data after individual";
+  return individual;
+}
+
+} // namespace serializer
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPNAT_TP1_SERIALIZER_HPP
+#define COMPNAT_TP1_SERIALIZER_HPP
+
+#include <limits>
+#include <string>
+
+#include "representation.hpp"
+
+namespace serializer {
+
+/// Number of significant digits of constants in Node::str().
+constexpr int DefaultPrecision = 6;
+
+/// Number of significant digits needed to parse back the exact constants.
+constexpr int ExactPrecision = std::numeric_limits<repr::T>::max_digits10;
+
+/**
+ * Appends the expression of the individual to out, in the same format of
+ * Node::str() when using the default precision. Nothing is allocated if out
+ * has enough capacity, except for Op::Custom nodes, which use Node::str().
+ * @param precision Number of significant digits of the constants.
+ */
+void appendStr(const repr::Node &individual, std::string &out,
+               int precision = DefaultPrecision);
+
+/// Returns the expression of the individual. Same as appendStr().
+std::string str(const repr::Node &individual,
+                int precision = DefaultPrecision);
+
+/**
+ * Parses an expression in the format of str() back into an individual.
+ * Constants are only exact if they were written with ExactPrecision.
+ * Aborts reporting the position if the expression is malformed.
+ */
+repr::Node parse(const std::string &text);
+
+/**
+ * Appends the binary encoding of the individual to out.
+ * Each node is stored in prefix order as a byte with its operation, followed
+ * by the value as a float64 in the host byte order for constants and the index
+ * as a LEB128 varint for variables. Individuals with Op::Custom nodes can't be
+ * encoded. Nothing is allocated if out has enough capacity.
+ */
+void appendBinary(const repr::Node &individual, std::string &out);
+
+/// Returns the binary encoding of the individual. Same as appendBinary().
+std::string encode(const repr::Node &individual);
+
+/**
+ * Decodes an individual encoded by appendBinary().
+ * Aborts if the data is malformed.
+ * @param size Size in bytes of the data.
+ * @param consumed If not null, receives the number of bytes decoded, so
+ *   consecutive individuals can be decoded from the same buffer.
+ */
+repr::Node decode(const char *data, size_t size, size_t *consumed = nullptr);
+
+/// Same as above, but the whole data must be a single individual.
+repr::Node decode(const std::string &data);
+
+} // namespace serializer
+
+#endif // !COMPNAT_TP1_SERIALIZER_HPP
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "serializer.hpp"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "generators.hpp"
+#include "primitives.hpp"
+
+namespace {
+using repr::Node;
+
+std::vector<Node> generatePopulation() {
+  const repr::Params params(
+      "", 0, 0, 0, 100, 0, 7, 0.8, false, false,
+      {primitives::sumFn, primitives::subFn, primitives::multFn,
+       primitives::divFn, primitives::logFn, primitives::expFn,
+       primitives::sinFn, primitives::cosFn, primitives::sqrtFn,
+       primitives::powFn},
+      {primitives::constTerm, primitives::makeVarTerm(0),
+       primitives::makeVarTerm(11), primitives::literalTerm(-1e30),
+       primitives::literalTerm(0)});
+
+  repr::RNG rng(3);
+  return generators::rampedHalfAndHalf(rng, params);
+}
+
+TEST(SerializerTest, MatchesNodeStr) {
+  for (const auto &individual : generatePopulation()) {
+    EXPECT_EQ(individual.str(), serializer::str(individual));
+  }
+}
+
+TEST(SerializerTest, ReusesBuffer) {
+  const auto &population = generatePopulation();
+  std::string out;
+  out.reserve(1 << 16);
+  const char *data = out.data();
+  for (const auto &individual : population) {
+    out.clear();
+    serializer::appendStr(individual, out);
+    serializer::appendBinary(individual, out);
+  }
+  EXPECT_EQ(data, out.data());
+}
+
+TEST(SerializerTest, ParsesExpressions) {
+  const auto &node = serializer::parse(" ( x0 +log2(  (x12 * -0.5))) ");
+  EXPECT_EQ("(x0 + log2((x12 * -0.5)))", node.str());
+  EXPECT_FLOAT_EQ(3, node.eval(repr::EvalInput{2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                               0, 0, -4}));
+  EXPECT_EQ("(inf / -inf)", serializer::parse("(inf / -inf)").str());
+  EXPECT_EQ("pow(sqrt(x0), cos(-2))",
+            serializer::parse("pow(sqrt(x0),cos( -2 ))").str());
+}
+
+TEST(SerializerTest, RoundTripsText) {
+  for (const auto &individual : generatePopulation()) {
+    const auto &text =
+        serializer::str(individual, serializer::ExactPrecision);
+    const auto &parsed = serializer::parse(text);
+    EXPECT_EQ(text, serializer::str(parsed, serializer::ExactPrecision));
+    EXPECT_EQ(individual.str(), parsed.str());
+  }
+}
+
+TEST(SerializerTest, RoundTripsBinary) {
+  const auto &population = generatePopulation();
+  std::string data;
+  for (const auto &individual : population) {
+    const auto &decoded = serializer::decode(serializer::encode(individual));
+    EXPECT_EQ(serializer::str(individual, serializer::ExactPrecision),
+              serializer::str(decoded, serializer::ExactPrecision));
+    serializer::appendBinary(individual, data);
+  }
+
+  // Individuals can be decoded one after the other.
+  size_t pos = 0;
+  for (const auto &individual : population) {
+    size_t consumed;
+    const auto &decoded =
+        serializer::decode(data.data() + pos, data.size() - pos, &consumed);
+    EXPECT_EQ(individual.str(), decoded.str());
+    pos += consumed;
+  }
+  EXPECT_EQ(data.size(), pos);
+}
+
+TEST(SerializerDeathTest, ReportsInvalidExpressions) {
+  EXPECT_DEATH(serializer::parse("(x0 ^ 1)"),
+               "position 4: expected binary operator");
+  EXPECT_DEATH(serializer::parse("log2(x0"), "position 7: expected '\\)'");
+  EXPECT_DEATH(serializer::parse("pow(x0)"), "position 6: expected ','");
+  EXPECT_DEATH(serializer::parse("x0 x1"), "expected end of expression");
+  EXPECT_DEATH(serializer::parse("y"), "position 0: expected expression");
+}
+
+TEST(SerializerDeathTest, ReportsInvalidData) {
+  const auto &data = serializer::encode(generatePopulation()[42]);
+  EXPECT_DEATH(serializer::decode(data.substr(0, data.size() - 1)),
+               "Truncated individual");
+  EXPECT_DEATH(serializer::decode(data + data), "Trailing data");
+  EXPECT_DEATH(serializer::decode(std::string(1, 42)), "Invalid operation");
+}
+
+} // namespace
@@ -0,0 +1,536 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "serve.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "glog/logging.h"
+
+#include "compnat/tp1/results/results_generated.h"
+#include "parser.hpp"
+#include "serializer.hpp"
+
+namespace {
+/// Rows of a batch evaluated by each parallel task.
+const size_t ChunkRows_ = 1 << 14;
+
+std::string readFile_(const std::string &filename) {
+  std::ifstream in(filename, std::ifstream::binary);
+  CHECK(in.is_open()) << "Failed to open " << filename;
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+bool isResultsFile_(const std::string &filename) {
+  const std::string extension = ".cnat";
+  return filename.size() >= extension.size() &&
+         filename.compare(filename.size() - extension.size(),
+                          extension.size(), extension) == 0;
+}
+
+/// Number of inputs used by the individual.
+size_t numInputs_(const repr::Node &individual) {
+  size_t numInputs = 0;
+  if (individual.op() == repr::Op::Var) {
+    numInputs = individual.var() + 1;
+  }
+  for (size_t i = 0; i < individual.numChildren(); ++i) {
+    numInputs = std::max(numInputs, numInputs_(individual.child(i)));
+  }
+  return numInputs;
+}
+
+serve::Model makeModel_(const std::string &name, const std::string &expr) {
+  serve::Model model;
+  model.name = name;
+  model.individual = serializer::parse(expr);
+  model.numInputs = numInputs_(model.individual);
+  return model;
+}
+
+/// Reads exactly size bytes. False if the connection was closed.
+bool readAll_(int fd, void *data, size_t size) {
+  char *bytes = static_cast<char *>(data);
+  while (size) {
+    const ssize_t n = recv(fd, bytes, size, 0);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    bytes += n;
+    size -= n;
+  }
+  return true;
+}
+
+/// Writes exactly size bytes. False if the connection was closed.
+bool writeAll_(int fd, const void *data, size_t size) {
+  const char *bytes = static_cast<const char *>(data);
+  while (size) {
+    const ssize_t n = send(fd, bytes, size, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    bytes += n;
+    size -= n;
+  }
+  return true;
+}
+
+sockaddr_un address_(const std::string &socketPath) {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  CHECK(socketPath.size() < sizeof(address.sun_path))
+      << "Socket path too long: " << socketPath;
+  std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+  return address;
+}
+
+} // namespace
+
+namespace serve {
+
+const char *statusName(Status status) {
+  switch (status) {
+  case Status::Ok:
+    return "ok";
+  case Status::UnknownModel:
+    return "unknown model";
+  case Status::TooFewInputs:
+    return "too few inputs";
+  case Status::TooBig:
+    return "request too big";
+  }
+  return "unknown status";
+}
+
+bool tooBig(size_t numRows, size_t numInputs) {
+  return numRows > MaxRequestRows || numInputs > MaxRequestInputs ||
+         (uint64_t)numRows * numInputs > MaxRequestValues;
+}
+
+std::vector<Model> loadModels(const std::vector<std::string> &filenames) {
+  std::vector<Model> models;
+  for (const auto &filename : filenames) {
+    const auto &data = readFile_(filename);
+    if (isResultsFile_(filename)) {
+      flatbuffers::Verifier verifier(
+          reinterpret_cast<const uint8_t *>(data.data()), data.size());
+      CHECK(stats::results::VerifyResultsBuffer(verifier))
+          << filename << ": invalid tp1 results";
+      const auto *results = stats::results::GetResults(data.data());
+      CHECK(results && results->finalStats() &&
+            results->finalStats()->bestIndividualExpr())
+          << filename << ": results without the best individual";
+      models.push_back(makeModel_(
+          filename, results->finalStats()->bestIndividualExpr()->str()));
+      continue;
+    }
+
+    size_t lineNumber = 0;
+    for (const auto &line : parser::splitLine(data, '\n')) {
+      ++lineNumber;
+      if (line.find_first_not_of(" \t\r") != std::string::npos) {
+        models.push_back(makeModel_(
+            filename + ":" + std::to_string(lineNumber), line));
+      }
+    }
+  }
+  return models;
+}
+
+LatencyHistogram::LatencyHistogram() {
+  for (auto &bucket : buckets_) {
+    bucket = 0;
+  }
+}
+
+void LatencyHistogram::add(double micros) {
+  size_t bucket = 0;
+  if (micros >= 1) {
+    int exponent;
+    const double fraction = std::frexp(micros, &exponent);
+    bucket = (exponent - 1) * SubBuckets +
+             static_cast<size_t>((2 * fraction - 1) * SubBuckets);
+  }
+  buckets_[std::min(bucket, NumBuckets - 1)].fetch_add(
+      1, std::memory_order_relaxed);
+}
+
+size_t LatencyHistogram::count() const {
+  size_t count = 0;
+  for (const auto &bucket : buckets_) {
+    count += bucket.load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+double LatencyHistogram::percentile(double p) const {
+  const size_t total = count();
+  if (!total) {
+    return 0;
+  }
+
+  const double rank = std::max(1.0, std::ceil(p * total));
+  size_t seen = 0, bucket = 0;
+  for (; bucket < NumBuckets - 1; ++bucket) {
+    seen += buckets_[bucket].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      break;
+    }
+  }
+  const size_t exponent = bucket / SubBuckets, sub = bucket % SubBuckets;
+  return std::ldexp(1 + (sub + 1.0) / SubBuckets, exponent);
+}
+
+/// Request waiting for its batch.
+struct Batcher::Request_ {
+  uint32_t model;
+  size_t numRows;
+  size_t numInputs;
+  const double *inputs;
+  double *outputs;
+  std::chrono::steady_clock::time_point arrival;
+  bool done;
+};
+
+Batcher::Batcher(const std::vector<Model> &models,
+                 std::chrono::microseconds window, size_t maxBatchRows)
+    : models_(models), window_(window), maxBatchRows_(maxBatchRows) {
+  CHECK(maxBatchRows_) << "Batches need at least one row";
+  for (const auto &model : models_) {
+    programs_.emplace_back(model.individual);
+  }
+  thread_ = std::thread([this]() { run_(); });
+}
+
+Batcher::~Batcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  pending_.notify_one();
+  thread_.join();
+}
+
+Status Batcher::evaluate(uint32_t model, size_t numRows, size_t numInputs,
+                         const double *inputs, double *outputs) {
+  ++numRequests_;
+  Status status = Status::Ok;
+  if (tooBig(numRows, numInputs)) {
+    status = Status::TooBig;
+  } else if (model >= models_.size()) {
+    status = Status::UnknownModel;
+  } else if (numInputs < models_[model].numInputs) {
+    status = Status::TooFewInputs;
+  }
+  if (status != Status::Ok) {
+    ++numErrors_;
+    return status;
+  }
+  numRows_ += numRows;
+  if (!numRows) {
+    return status;
+  }
+
+  Request_ request = {model,   numRows, numInputs,
+                      inputs,  outputs, std::chrono::steady_clock::now(),
+                      false};
+  std::unique_lock<std::mutex> lock(mutex_);
+  queue_.push_back(&request);
+  queuedRows_ += numRows;
+  pending_.notify_one();
+  done_.wait(lock, [&]() { return request.done; });
+  return status;
+}
+
+BatcherCounters Batcher::counters() const {
+  BatcherCounters counters;
+  counters.numRequests = numRequests_;
+  counters.numRows = numRows_;
+  counters.numBatches = numBatches_;
+  counters.numErrors = numErrors_;
+  counters.p50Micros = latencies_.percentile(0.5);
+  counters.p99Micros = latencies_.percentile(0.99);
+  return counters;
+}
+
+void Batcher::run_() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    pending_.wait(lock, [&]() { return stopping_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+
+    // Waits for more requests until the window of the oldest one closes.
+    const auto deadline = queue_.front()->arrival + window_;
+    pending_.wait_until(lock, deadline, [&]() {
+      return stopping_ || queuedRows_ >= maxBatchRows_;
+    });
+
+    std::vector<Request_ *> batch;
+    size_t numRows = 0;
+    while (!queue_.empty() &&
+           (batch.empty() ||
+            numRows + queue_.front()->numRows <= maxBatchRows_)) {
+      batch.push_back(queue_.front());
+      numRows += queue_.front()->numRows;
+      queue_.pop_front();
+    }
+    queuedRows_ -= numRows;
+
+    lock.unlock();
+    evaluateBatch_(batch);
+    lock.lock();
+    for (auto *request : batch) {
+      request->done = true;
+    }
+    done_.notify_all();
+  }
+}
+
+void Batcher::evaluateBatch_(const std::vector<Request_ *> &batch) {
+  std::map<uint32_t, std::vector<Request_ *>> byModel;
+  for (auto *request : batch) {
+    byModel[request->model].push_back(request);
+  }
+
+  for (const auto & [ model, requests ] : byModel) {
+    size_t numRows = 0;
+    for (const auto *request : requests) {
+      numRows += request->numRows;
+    }
+
+    // Individuals without inputs are evaluated over a column of zeros.
+    const size_t numInputs = models_[model].numInputs;
+    repr::Dataset dataset(numRows, std::max<size_t>(numInputs, 1));
+    size_t row = 0;
+    for (const auto *request : requests) {
+      for (size_t i = 0; i < request->numRows; ++i, ++row) {
+        const double *inputs = request->inputs + i * request->numInputs;
+        for (size_t var = 0; var < dataset.numInputs(); ++var) {
+          dataset.mutableColumn(var)[row] = var < numInputs ? inputs[var] : 0;
+        }
+      }
+    }
+
+    std::vector<repr::T> outputs(numRows);
+    const auto &program = programs_[model];
+    const size_t numChunks = (numRows + ChunkRows_ - 1) / ChunkRows_;
+#pragma omp parallel for schedule(dynamic) if (numChunks > 1)
+    for (size_t chunk = 0; chunk < numChunks; ++chunk) {
+      const size_t begin = chunk * ChunkRows_;
+      const size_t end = std::min(numRows, begin + ChunkRows_);
+      program.eval(dataset, begin, end, outputs.data() + begin);
+    }
+
+    row = 0;
+    const auto now = std::chrono::steady_clock::now();
+    for (auto *request : requests) {
+      std::copy_n(outputs.begin() + row, request->numRows, request->outputs);
+      row += request->numRows;
+      const std::chrono::duration<double, std::micro> latency =
+          now - request->arrival;
+      latencies_.add(latency.count());
+    }
+  }
+  ++numBatches_;
+}
+
+Server::Server(const std::string &socketPath, Batcher &batcher)
+    : socketPath_(socketPath), batcher_(batcher) {
+  const auto &address = address_(socketPath_);
+  listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  PCHECK(listenFd_ >= 0) << "Failed to create socket";
+  unlink(socketPath_.c_str());
+  PCHECK(bind(listenFd_, (const sockaddr *)&address, sizeof(address)) == 0)
+      << "Failed to bind " << socketPath_;
+  PCHECK(listen(listenFd_, SOMAXCONN) == 0) << "Failed to listen on "
+                                             << socketPath_;
+  PCHECK(pipe2(wakeFds_, O_CLOEXEC) == 0) << "Failed to create pipe";
+}
+
+Server::~Server() {
+  close(listenFd_);
+  close(wakeFds_[0]);
+  close(wakeFds_[1]);
+  unlink(socketPath_.c_str());
+}
+
+void Server::run() {
+  LOG(INFO) << "Serving " << batcher_.models().size() << " models on "
+            << socketPath_;
+  while (!stopping_) {
+    pollfd fds[] = {{listenFd_, POLLIN, 0}, {wakeFds_[0], POLLIN, 0}};
+    if (poll(fds, 2, -1) < 0) {
+      PCHECK(errno == EINTR) << "Failed to poll " << socketPath_;
+      continue;
+    }
+    if (fds[1].revents) {
+      break;
+    }
+
+    const int fd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+      PLOG(WARNING) << "Failed to accept a connection";
+      continue;
+    }
+    joinClosed_();
+    std::lock_guard<std::mutex> lock(mutex_);
+    connections_.push_back(fd);
+    threads_.emplace_back([this, fd]() { serveConnection_(fd); });
+  }
+
+  std::vector<std::thread> threads;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int fd : connections_) {
+      shutdown(fd, SHUT_RDWR);
+    }
+    threads.swap(threads_);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  closed_.clear();
+}
+
+size_t Server::numThreads() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return threads_.size();
+}
+
+void Server::joinClosed_() {
+  std::vector<std::thread> closed;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &id : closed_) {
+      const auto &thread =
+          std::find_if(threads_.begin(), threads_.end(),
+                       [&](const std::thread &t) { return t.get_id() == id; });
+      closed.push_back(std::move(*thread));
+      threads_.erase(thread);
+    }
+    closed_.clear();
+  }
+
+  // Only the end of serveConnection_() is left to run.
+  for (auto &thread : closed) {
+    thread.join();
+  }
+}
+
+void Server::stop() {
+  stopping_ = true;
+  const char byte = 0;
+  PCHECK(write(wakeFds_[1], &byte, 1) == 1) << "Failed to stop the server";
+}
+
+void Server::serveConnection_(int fd) {
+  std::vector<double> inputs, outputs;
+  RequestHeader request;
+  while (readAll_(fd, &request, sizeof(request))) {
+    ResponseHeader response = {Status::Ok, request.numRows};
+    const size_t numRows = request.numRows, numInputs = request.numInputs;
+    if (tooBig(numRows, numInputs)) {
+      // The inputs aren't read, so the connection can't be used anymore.
+      response.status = batcher_.evaluate(request.model, numRows, numInputs,
+                                          nullptr, nullptr);
+      response.numRows = 0;
+      writeAll_(fd, &response, sizeof(response));
+      break;
+    }
+
+    inputs.resize(numRows * numInputs);
+    outputs.resize(numRows);
+    if (!readAll_(fd, inputs.data(), inputs.size() * sizeof(double))) {
+      break;
+    }
+    response.status = batcher_.evaluate(request.model, numRows, numInputs,
+                                        inputs.data(), outputs.data());
+    if (response.status != Status::Ok) {
+      response.numRows = 0;
+    }
+    if (!writeAll_(fd, &response, sizeof(response)) ||
+        !writeAll_(fd, outputs.data(),
+                   response.numRows * sizeof(double))) {
+      break;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  connections_.erase(
+      std::find(connections_.begin(), connections_.end(), fd));
+  closed_.push_back(std::this_thread::get_id());
+  close(fd);
+}
+
+Client::Client(const std::string &socketPath) {
+  const auto &address = address_(socketPath);
+  fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  PCHECK(fd_ >= 0) << "Failed to create socket";
+  PCHECK(connect(fd_, (const sockaddr *)&address, sizeof(address)) == 0)
+      << "Failed to connect to " << socketPath;
+}
+
+Client::~Client() { close(fd_); }
+
+Status Client::predict(uint32_t model, size_t numInputs,
+                       const std::vector<double> &inputs,
+                       std::vector<double> &outputs) {
+  CHECK(numInputs && inputs.size() % numInputs == 0)
+      << inputs.size() << " values aren't rows of " << numInputs << " inputs";
+  if (tooBig(inputs.size() / numInputs, numInputs)) {
+    outputs.clear();
+    return Status::TooBig;
+  }
+
+  const RequestHeader request = {model, (uint32_t)(inputs.size() / numInputs),
+                                 (uint32_t)numInputs, 0};
+  ResponseHeader response;
+  CHECK(writeAll_(fd_, &request, sizeof(request)) &&
+        writeAll_(fd_, inputs.data(), inputs.size() * sizeof(double)) &&
+        readAll_(fd_, &response, sizeof(response)))
+      << "Connection to the server lost";
+
+  outputs.resize(response.numRows);
+  CHECK(readAll_(fd_, outputs.data(), outputs.size() * sizeof(double)))
+      << "Connection to the server lost";
+  return response.status;
+}
+
+} // namespace serve
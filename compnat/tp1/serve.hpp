@@ -0,0 +1,269 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPNAT_TP1_SERVE_HPP
+#define COMPNAT_TP1_SERVE_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "program.hpp"
+#include "representation.hpp"
+
+/**
+ * Serving of evolved individuals to other processes of the same host, over a
+ * Unix domain socket.
+ *
+ * Each request is a RequestHeader followed by numRows * numInputs doubles, the
+ * inputs of each row in order. Each response is a ResponseHeader followed by
+ * numRows doubles if the status is Status::Ok. Values are in the host byte
+ * order. Connections may send any number of requests, one at a time.
+ */
+namespace serve {
+
+/// Maximum number of rows of a request.
+constexpr uint32_t MaxRequestRows = 1 << 20;
+
+/// Maximum number of inputs of each row of a request.
+constexpr uint32_t MaxRequestInputs = 1 << 12;
+
+/// Maximum number of input values of a request, numRows * numInputs.
+constexpr uint64_t MaxRequestValues = 1 << 24;
+
+/// If a request with the given dimensions is over any of the limits above.
+bool tooBig(size_t numRows, size_t numInputs);
+
+struct RequestHeader {
+  /// Index of the model, in the order they were loaded.
+  uint32_t model;
+  uint32_t numRows;
+  uint32_t numInputs;
+  uint32_t reserved;
+};
+
+enum class Status : uint32_t {
+  Ok = 0,
+  UnknownModel = 1,
+
+  /// The rows have fewer inputs than the model uses.
+  TooFewInputs = 2,
+
+  /// More than MaxRequestRows rows, MaxRequestInputs inputs or
+  /// MaxRequestValues values. The connection is closed after the response.
+  TooBig = 3
+};
+
+/// Name of the status.
+const char *statusName(Status status);
+
+struct ResponseHeader {
+  Status status;
+  uint32_t numRows;
+};
+
+/// Individual that is served.
+struct Model {
+  /// File it was loaded from, and the line of text files.
+  std::string name;
+
+  repr::Node individual;
+
+  /// Number of inputs the individual uses.
+  size_t numInputs = 0;
+};
+
+/**
+ * Loads the models of the files, in order. Results files ('.cnat') give the
+ * best individual of their final generation. Other files are text, with one
+ * expression per non-blank line, like "((x0 * x1) + 2)".
+ */
+std::vector<Model> loadModels(const std::vector<std::string> &filenames);
+
+/**
+ * Histogram of latencies, with 8 buckets per power of 2 of microseconds.
+ * Percentiles are the upper bound of their bucket, so they are up to 9% too
+ * big. Thread-safe.
+ */
+class LatencyHistogram {
+public:
+  LatencyHistogram();
+
+  /// Adds a latency in microseconds.
+  void add(double micros);
+
+  /// Number of latencies added.
+  size_t count() const;
+
+  /// Latency in microseconds that p (in [0, 1]) of the latencies are below.
+  double percentile(double p) const;
+
+private:
+  static constexpr size_t SubBuckets = 8;
+  static constexpr size_t NumBuckets = 40 * SubBuckets;
+
+  std::array<std::atomic<uint64_t>, NumBuckets> buckets_;
+};
+
+/// Counters of a Batcher since it was created.
+struct BatcherCounters {
+  size_t numRequests = 0;
+  size_t numRows = 0;
+  size_t numBatches = 0;
+
+  /// Requests rejected with a status other than Status::Ok.
+  size_t numErrors = 0;
+
+  /// Latencies of the requests, from their arrival to their evaluation.
+  double p50Micros = 0;
+  double p99Micros = 0;
+};
+
+/**
+ * Coalesces concurrent requests into micro-batches. A batch starts with the
+ * first pending request and closes after the batch window, or earlier if it
+ * reaches the maximum number of rows. The rows of all requests of a model are
+ * evaluated together, directly from columns, by its compiled program.
+ */
+class Batcher {
+public:
+  /**
+   * Starts the thread that evaluates the batches.
+   * @param window How long a batch waits for more requests.
+   * @param maxBatchRows Rows that close a batch before the window.
+   */
+  Batcher(const std::vector<Model> &models, std::chrono::microseconds window,
+          size_t maxBatchRows);
+  Batcher(const Batcher &) = delete;
+  Batcher &operator=(const Batcher &) = delete;
+  ~Batcher();
+
+  const std::vector<Model> &models() const { return models_; }
+
+  /**
+   * Evaluates the rows of a request, blocking until its batch is done.
+   * Thread-safe.
+   * @param inputs numRows * numInputs values, row by row.
+   * @param outputs Receives numRows values if the status is Status::Ok.
+   */
+  Status evaluate(uint32_t model, size_t numRows, size_t numInputs,
+                  const double *inputs, double *outputs);
+
+  BatcherCounters counters() const;
+
+private:
+  struct Request_;
+
+  void run_();
+  void evaluateBatch_(const std::vector<Request_ *> &batch);
+
+  std::vector<Model> models_;
+  std::vector<program::Program> programs_;
+  std::chrono::microseconds window_;
+  size_t maxBatchRows_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable pending_;
+  std::condition_variable done_;
+  std::deque<Request_ *> queue_;
+  size_t queuedRows_ = 0;
+  bool stopping_ = false;
+
+  std::atomic<size_t> numRequests_{0};
+  std::atomic<size_t> numRows_{0};
+  std::atomic<size_t> numBatches_{0};
+  std::atomic<size_t> numErrors_{0};
+  LatencyHistogram latencies_;
+
+  std::thread thread_;
+};
+
+/// Serves the models of a batcher on a Unix domain socket.
+class Server {
+public:
+  /// Listens on the socket, replacing any socket file left in its path.
+  Server(const std::string &socketPath, Batcher &batcher);
+  Server(const Server &) = delete;
+  Server &operator=(const Server &) = delete;
+
+  /// Removes the socket file.
+  ~Server();
+
+  /**
+   * Accepts connections, each served by its own thread, until stop(). The
+   * threads of closed connections are joined on the next accept.
+   */
+  void run();
+
+  /// Stops accepting connections and closes the open ones. Thread-safe.
+  void stop();
+
+  /// Number of connection threads that weren't joined yet. Thread-safe.
+  size_t numThreads() const;
+
+private:
+  void serveConnection_(int fd);
+
+  /// Joins the threads of the connections that were closed.
+  void joinClosed_();
+
+  std::string socketPath_;
+  Batcher &batcher_;
+  int listenFd_;
+
+  /// Pipe written by stop() to wake run().
+  int wakeFds_[2];
+
+  mutable std::mutex mutex_;
+  std::vector<int> connections_;
+  std::vector<std::thread> threads_;
+
+  /// Threads of the connections that were closed, not joined yet.
+  std::vector<std::thread::id> closed_;
+  std::atomic<bool> stopping_{false};
+};
+
+/// Connection to a Server.
+class Client {
+public:
+  explicit Client(const std::string &socketPath);
+  Client(const Client &) = delete;
+  Client &operator=(const Client &) = delete;
+  ~Client();
+
+  /**
+   * Evaluates inputs.size() / numInputs rows with the model. Requests that
+   * are too big aren't sent.
+   * @param outputs Receives a value per row if the status is Status::Ok.
+   */
+  Status predict(uint32_t model, size_t numInputs,
+                 const std::vector<double> &inputs,
+                 std::vector<double> &outputs);
+
+private:
+  int fd_;
+};
+
+} // namespace serve
+
+#endif // !COMPNAT_TP1_SERVE_HPP
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "serve.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+namespace {
+using serve::Status;
+
+std::vector<serve::Model> writeModels(const std::string &filename) {
+  std::ofstream out(filename);
+  out << "((x0 * x1) + 2)\n\n(x0 - 0.5)\n3\n";
+  out.close();
+  return serve::loadModels({filename});
+}
+
+TEST(LoadModelsTest, LoadsAnExpressionPerLine) {
+  const auto filename = testing::TempDir() + "/models.txt";
+  const auto &models = writeModels(filename);
+  ASSERT_EQ((size_t)3, models.size());
+  EXPECT_EQ("((x0 * x1) + 2)", models[0].individual.str());
+  EXPECT_EQ((size_t)2, models[0].numInputs);
+  EXPECT_EQ(filename + ":3", models[1].name);
+  EXPECT_EQ((size_t)1, models[1].numInputs);
+  EXPECT_EQ((size_t)0, models[2].numInputs);
+}
+
+TEST(LatencyHistogramTest, ComputesPercentiles) {
+  serve::LatencyHistogram histogram;
+  EXPECT_EQ(0, histogram.percentile(0.5));
+  for (int i = 1; i <= 1000; ++i) {
+    histogram.add(i);
+  }
+  histogram.add(0.1);
+
+  EXPECT_EQ((size_t)1001, histogram.count());
+  EXPECT_LE(500, histogram.percentile(0.5));
+  EXPECT_GE(500 * 1.13, histogram.percentile(0.5));
+  EXPECT_LE(990, histogram.percentile(0.99));
+  EXPECT_GE(990 * 1.13, histogram.percentile(0.99));
+  EXPECT_GE(1.125, histogram.percentile(0));
+}
+
+TEST(BatcherTest, CoalescesConcurrentRequests) {
+  const auto &models = writeModels(testing::TempDir() + "/batcher.txt");
+  serve::Batcher batcher(models, std::chrono::milliseconds(20), 1000);
+
+  // Rows of 3 inputs, more than the models use.
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < 8; ++i) {
+    threads.emplace_back([&, i]() {
+      const std::vector<double> inputs = {1.0 * i, 2, 9, 0.5, 4, 9};
+      std::vector<double> outputs(2);
+      const uint32_t model = i % 3;
+      ASSERT_EQ(Status::Ok, batcher.evaluate(model, 2, 3, inputs.data(),
+                                             outputs.data()));
+      for (size_t row = 0; row < 2; ++row) {
+        const repr::EvalInput input(&inputs[row * 3], &inputs[row * 3 + 3]);
+        EXPECT_DOUBLE_EQ(models[model].individual.eval(input), outputs[row]);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  const auto &counters = batcher.counters();
+  EXPECT_EQ((size_t)8, counters.numRequests);
+  EXPECT_EQ((size_t)16, counters.numRows);
+  EXPECT_LT(counters.numBatches, counters.numRequests);
+  EXPECT_LT(0, counters.p99Micros);
+
+  std::vector<double> outputs(1);
+  const std::vector<double> inputs = {1};
+  EXPECT_EQ(Status::UnknownModel,
+            batcher.evaluate(3, 1, 1, inputs.data(), outputs.data()));
+  EXPECT_EQ(Status::TooFewInputs,
+            batcher.evaluate(0, 1, 1, inputs.data(), outputs.data()));
+  EXPECT_EQ(Status::TooBig, batcher.evaluate(0, serve::MaxRequestRows + 1, 2,
+                                             nullptr, nullptr));
+  EXPECT_EQ(Status::TooBig,
+            batcher.evaluate(0, serve::MaxRequestRows, serve::MaxRequestInputs,
+                             nullptr, nullptr));
+  EXPECT_EQ((size_t)4, batcher.counters().numErrors);
+}
+
+TEST(ServerTest, ServesPredictions) {
+  const auto &models = writeModels(testing::TempDir() + "/server.txt");
+  serve::Batcher batcher(models, std::chrono::microseconds(100), 1000);
+  const auto socketPath = testing::TempDir() + "/serve_test.sock";
+  serve::Server server(socketPath, batcher);
+  std::thread thread([&]() { server.run(); });
+
+  {
+    serve::Client client(socketPath);
+    std::vector<double> outputs;
+    EXPECT_EQ(Status::Ok, client.predict(0, 2, {3, 4, 0.5, 2}, outputs));
+    EXPECT_EQ(std::vector<double>({14, 3}), outputs);
+    EXPECT_EQ(Status::Ok, client.predict(2, 1, {7}, outputs));
+    EXPECT_EQ(std::vector<double>({3}), outputs);
+    EXPECT_EQ(Status::TooFewInputs, client.predict(0, 1, {3, 4}, outputs));
+    EXPECT_TRUE(outputs.empty());
+
+    // The connection is still usable after an error.
+    EXPECT_EQ(Status::Ok, client.predict(1, 1, {2}, outputs));
+    EXPECT_EQ(std::vector<double>({1.5}), outputs);
+  }
+
+  // Open connections don't keep the server running.
+  serve::Client idle(socketPath);
+  server.stop();
+  thread.join();
+  EXPECT_EQ((size_t)4, batcher.counters().numRequests);
+}
+
+TEST(ServerTest, RejectsTooManyValues) {
+  const auto &models = writeModels(testing::TempDir() + "/server.txt");
+  serve::Batcher batcher(models, std::chrono::microseconds(100), 1000);
+  const auto socketPath = testing::TempDir() + "/serve_test.sock";
+  serve::Server server(socketPath, batcher);
+  std::thread thread([&]() { server.run(); });
+
+  // Rows and inputs within their limits, but 32 GiB of values. The client
+  // doesn't send it, so the header is written to the socket directly.
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  std::strcpy(address.sun_path, socketPath.c_str());
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_EQ(0, connect(fd, (const sockaddr *)&address, sizeof(address)));
+  const serve::RequestHeader request = {0, serve::MaxRequestRows,
+                                        serve::MaxRequestInputs, 0};
+  ASSERT_EQ((ssize_t)sizeof(request), send(fd, &request, sizeof(request), 0));
+
+  serve::ResponseHeader response;
+  ASSERT_EQ((ssize_t)sizeof(response),
+            recv(fd, &response, sizeof(response), MSG_WAITALL));
+  EXPECT_EQ(Status::TooBig, response.status);
+  EXPECT_EQ((uint32_t)0, response.numRows);
+  EXPECT_EQ(0, recv(fd, &response, sizeof(response), 0));
+  close(fd);
+
+  // The server still serves other connections.
+  serve::Client client(socketPath);
+  std::vector<double> outputs;
+  EXPECT_EQ(Status::Ok, client.predict(2, 1, {7}, outputs));
+  server.stop();
+  thread.join();
+}
+
+TEST(ServerTest, JoinsTheThreadsOfClosedConnections) {
+  const auto &models = writeModels(testing::TempDir() + "/server.txt");
+  serve::Batcher batcher(models, std::chrono::microseconds(100), 1000);
+  const auto socketPath = testing::TempDir() + "/serve_test.sock";
+  serve::Server server(socketPath, batcher);
+  std::thread thread([&]() { server.run(); });
+
+  const auto &connect = [&]() {
+    serve::Client client(socketPath);
+    std::vector<double> outputs;
+    EXPECT_EQ(Status::Ok, client.predict(2, 1, {7}, outputs));
+  };
+  for (int i = 0; i < 20; ++i) {
+    connect();
+  }
+
+  // Each accept joins the threads of the connections that finished closing.
+  for (int i = 0; i < 100 && server.numThreads() > 2; ++i) {
+    connect();
+  }
+  EXPECT_GE((size_t)2, server.numThreads());
+  server.stop();
+  thread.join();
+  EXPECT_EQ((size_t)0, server.numThreads());
+}
+
+} // namespace
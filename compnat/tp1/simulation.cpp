@@ -16,81 +16,382 @@
 
 #include "simulation.hpp"
 
+#include <chrono>
+#include <limits>
+#include <optional>
 #include <utility>
 #include <vector>
 
 #include "glog/logging.h"
 
+#include "compnat/common/allocations.hpp"
+#include "compnat/common/counters.hpp"
+#include "compnat/common/trace.hpp"
 #include "generators.hpp"
 #include "operators.hpp"
+#include "program.hpp"
 #include "statistics.hpp"
+#include "tuning.hpp"
+#include "utils.hpp"
 
 namespace {
-std::pair<std::vector<stats::Statistics>, std::vector<stats::Statistics>>
-simulateGeneration_(repr::RNG &rng, const repr::Params &params,
-                    const repr::Dataset &trainDataset,
-                    const repr::Dataset &testDataset) {
-  std::vector<stats::Statistics> trainStats;
-  std::vector<stats::Statistics> testStats;
-
-  LOG(INFO) << "Generation 0";
-  auto population = generators::rampedHalfAndHalf(rng, params);
-
-  auto fitnesses = stats::fitness(population, trainDataset);
-  auto sizes = stats::sizes(population);
-
-  trainStats.emplace_back("Train", population, fitnesses, sizes);
-  if (params.alwaysTest) {
-    testStats.emplace_back("Test", population,
-                           stats::fitness(population, testDataset), sizes);
+/// Replaces the individuals by their simplified version, if requested.
+void simplifyGenotype_(const repr::Params &params,
+                       std::vector<repr::Node> &population) {
+  if (params.simplifyGenotype) {
+    for (auto &individual : population) {
+      individual = program::simplify(individual);
+    }
   }
+}
 
-  stats::ImprovementMetadata metadata;
-  for (size_t i = 1; i <= params.numGenerations; ++i) {
-    LOG(INFO) << "Generation " << i;
-    std::tie(population, metadata) = operators::newGeneration(
-        rng, params, population, fitnesses, sizes, trainStats[i - 1]);
+/// Tunes the constants of the best individuals, if requested.
+void tuneElites_(const repr::Params &params,
+                 std::vector<repr::Node> &population,
+                 std::vector<double> &fitnesses, const repr::Dataset &dataset,
+                 stats::EvaluationMetadata &metadata) {
+  metadata.numEvaluations +=
+      tuning::tuneElites(params, population, fitnesses, dataset);
+}
 
-    fitnesses = stats::fitness(population, trainDataset);
-    sizes = stats::sizes(population);
+void tuneElites_(const repr::Params &params,
+                 [[maybe_unused]] std::vector<repr::Node> &population,
+                 [[maybe_unused]] std::vector<double> &fitnesses,
+                 [[maybe_unused]] stream::DatasetStream &stream,
+                 [[maybe_unused]] stats::EvaluationMetadata &metadata) {
+  CHECK(!params.tuning.numElites)
+      << "Constant tuning requires the datasets in memory";
+}
+
+void tuneElites_(const repr::Params &params,
+                 [[maybe_unused]] std::vector<repr::Node> &population,
+                 [[maybe_unused]] std::vector<double> &fitnesses,
+                 [[maybe_unused]] const repr::DatasetView &view,
+                 [[maybe_unused]] stats::EvaluationMetadata &metadata) {
+  CHECK(!params.tuning.numElites)
+      << "Constant tuning requires whole datasets, not views of their rows";
+}
+
+using Clock_ = std::chrono::steady_clock;
+
+/// Time point the given seconds after start, or never if seconds is 0.
+Clock_::time_point deadlineAfter_(Clock_::time_point start, double seconds) {
+  if (!seconds) {
+    return Clock_::time_point::max();
+  }
+  return start + std::chrono::duration_cast<Clock_::duration>(
+                     std::chrono::duration<double>(seconds));
+}
+
+/// Decides when an instance stops, see repr::StoppingParams.
+class StoppingCriteria_ {
+public:
+  /// @param deadline When the time budget of all instances runs out.
+  StoppingCriteria_(const repr::Params &params, Clock_::time_point deadline)
+      : params_(params), deadline_(deadline),
+        instanceDeadline_(deadlineAfter_(
+            Clock_::now(), params.stopping.instanceTimeBudget)) {}
+
+  /**
+   * Checks the criteria after the train statistics of a generation.
+   * @param generation Index of the generation.
+   * @param bestFitness Best train fitness of the generation.
+   * @return If the instance stops after this generation.
+   */
+  bool stop(size_t generation, double bestFitness) {
+    const auto &stopping = params_.stopping;
+    if (bestFitness < bestFitness_ - stopping.stagnationEpsilon) {
+      bestFitness_ = bestFitness;
+      lastImprovement_ = generation;
+    }
+    if (generation >= params_.numGenerations) {
+      return true;
+    }
 
-    trainStats.emplace_back("Train", population, fitnesses, sizes, metadata);
-    if (params.alwaysTest || i == params.numGenerations) {
-      // Always save test stats for the last generation.
-      testStats.emplace_back("Test", population,
-                             stats::fitness(population, testDataset), sizes);
+    const char *reason = nullptr;
+    const auto now = Clock_::now();
+    if (now >= deadline_) {
+      reason = "time budget exhausted";
+    } else if (now >= instanceDeadline_) {
+      reason = "instance time budget exhausted";
+    } else if (stopping.stagnationGenerations &&
+               generation - lastImprovement_ >=
+                   stopping.stagnationGenerations) {
+      reason = "best fitness stagnated";
     }
+
+    if (reason) {
+      LOG(INFO) << "Stopping after generation " << generation << ": "
+                << reason;
+      stoppedEarly_ = true;
+    }
+    return stoppedEarly_;
   }
 
-  return {trainStats, testStats};
-}
+  /// If stop() stopped the instance before params.numGenerations.
+  bool stoppedEarly() const { return stoppedEarly_; }
 
-} // namespace
+private:
+  const repr::Params &params_;
+  Clock_::time_point deadline_;
+  Clock_::time_point instanceDeadline_;
+  double bestFitness_ = std::numeric_limits<double>::infinity();
+  size_t lastImprovement_ = 0;
+  bool stoppedEarly_ = false;
+};
 
-namespace simulation {
+/**
+ * Runs an instance until params.numGenerations or until it is stopped by
+ * params.stopping.
+ * Dataset is a const repr::Dataset, a const repr::DatasetView or a
+ * stream::DatasetStream.
+ * @param deadline When the time budget of all instances runs out.
+ */
+template <typename Dataset>
+void simulateGeneration_(repr::RNG &rng, const repr::Params &params,
+                         Dataset &trainDataset, Dataset &testDataset,
+                         stats::Aggregator &trainAggregator,
+                         stats::Aggregator &testAggregator,
+                         Clock_::time_point deadline) {
+  StoppingCriteria_ stopping(params, deadline);
+  const auto level = params.statsLevel;
+  if (level != repr::StatsLevel::None) {
+    LOG(INFO) << "Generation 0";
+  }
+  std::optional<trace::Span> firstGenerationSpan(std::in_place, "generation",
+                                                 0);
+  stats::PhaseTimes times;
+  stats::PhaseAllocations allocs;
+  std::vector<repr::Node> population;
+  {
+    utils::ScopedTimer timer(times.initTime);
+    allocations::Scope scope(allocs.init);
+    counters::Region region("initialization");
+    population = generators::rampedHalfAndHalf(rng, params);
+  }
 
-std::pair<std::vector<std::vector<stats::Statistics>>,
-          std::vector<std::vector<stats::Statistics>>>
-simulate(const repr::Params &params, const repr::Dataset &trainDataset,
-         const repr::Dataset &testDataset) {
+  // Individuals that survive unchanged keep the fitness they already had.
+  stats::FitnessCache trainCache, testCache;
+  stats::EvaluationMetadata evalMetadata;
+  std::vector<double> fitnesses;
+  std::vector<size_t> sizes;
+  const auto &evaluateTrain = [&]() {
+    utils::ScopedTimer timer(times.trainEvalTime);
+    allocations::Scope scope(allocs.trainEval);
+    trace::Span span("trainEvaluation");
+    fitnesses =
+        stats::fitness(population, trainDataset, &evalMetadata, &trainCache);
+    simplifyGenotype_(params, population);
+    tuneElites_(params, population, fitnesses, trainDataset, evalMetadata);
+    sizes = stats::sizes(population);
+  };
+  const auto &evaluateTest = [&](const std::vector<repr::Node> &individuals,
+                                 stats::EvaluationMetadata *metadata,
+                                 stats::FitnessCache *cache) {
+    utils::ScopedTimer timer(times.testEvalTime);
+    allocations::Scope scope(allocs.testEval);
+    trace::Span span("testEvaluation");
+    return stats::fitness(individuals, testDataset, metadata, cache);
+  };
+
+  // Calculates the statistics, timing the serialization of the best
+  // individual separately.
+  const auto &calcStats = [&](const auto &makeStats) {
+    const auto start = std::chrono::steady_clock::now();
+    counters::Region region("statistics");
+    allocations::Scope scope(allocs.stats);
+    stats::Statistics stats = makeStats();
+    times.serializationTime += stats.serializationTime;
+    allocs.serialization += stats.serializationAllocations;
+    times.statsTime += utils::elapsedMs(start) - stats.serializationTime;
+    return stats;
+  };
+
+  // The strings of the statistics of a generation are reused by the next one,
+  // so the best individual is serialized without allocating.
+  stats::SerializationBuffers trainBuffers, testBuffers;
+  const auto &makeTrainStats = [&](const stats::ImprovementMetadata &metadata,
+                                   repr::StatsLevel statsLevel) {
+    return calcStats([&]() {
+      return stats::Statistics("Train", population, fitnesses, sizes, metadata,
+                               evalMetadata, statsLevel, &trainBuffers);
+    });
+  };
+
+  // Reports the evaluations needed to reach the target fitness, once.
+  size_t totalEvaluations = 0;
+  bool reachedTarget = false;
+  const auto &checkTarget = [&](const stats::Statistics &stats) {
+    totalEvaluations += stats.numEvaluations;
+    if (params.targetFitness && !reachedTarget &&
+        stats.bestFitness <= params.targetFitness) {
+      reachedTarget = true;
+      LOG(INFO) << "Target fitness reached after " << totalEvaluations
+                << " evaluations";
+      trainAggregator.addEvaluationsToTarget(totalEvaluations);
+    }
+  };
+
+  // Aggregates the times and allocations of the phases of the generation.
+  const auto &addPhases = [&](size_t generation) {
+    trainAggregator.add(generation, times);
+    if (allocations::enabled()) {
+      stats::logAllocations(allocs);
+      trainAggregator.add(generation, allocs);
+    }
+  };
+
+  // Aggregates the train stats of the generation once it is known if it is
+  // the last one, whose stats are always full.
+  const auto &addTrainStats = [&](size_t generation, bool last,
+                                  const stats::ImprovementMetadata &metadata,
+                                  stats::Statistics &trainStats) {
+    if (last && level != repr::StatsLevel::Full) {
+      trainBuffers.reuse(trainStats);
+      trainStats = makeTrainStats(metadata, repr::StatsLevel::Full);
+    }
+    if (last || level != repr::StatsLevel::None) {
+      trainAggregator.add(generation, trainStats);
+    }
+  };
+
+  // Always saves full test stats for the last generation of the instance,
+  // which are its final stats. Summary stats only score the best train
+  // individual.
+  const auto &addTestStats = [&](size_t generation, bool last,
+                                 const stats::Statistics &trainStats) {
+    if (last || (params.alwaysTest && level == repr::StatsLevel::Full)) {
+      stats::EvaluationMetadata testMetadata;
+      const auto &testFitnesses =
+          evaluateTest(population, &testMetadata, &testCache);
+      auto stats = calcStats([&]() {
+        return stats::Statistics("Test", population, testFitnesses, sizes, {},
+                                 testMetadata, repr::StatsLevel::Full,
+                                 &testBuffers);
+      });
+      testAggregator.add(generation, stats);
+      if (last) {
+        testAggregator.addFinal(stats);
+      }
+      testBuffers.reuse(stats);
+    } else if (params.alwaysTest && level == repr::StatsLevel::Summary) {
+      const std::vector<repr::Node> best = {population[trainStats.best]};
+      const auto &testFitnesses = evaluateTest(best, nullptr, nullptr);
+      const auto &stats = calcStats([&]() {
+        return stats::Statistics("Test", best, testFitnesses,
+                                 {trainStats.bestSize}, {}, {}, level);
+      });
+      testAggregator.add(generation, stats);
+    }
+  };
+
+  // Only the statistics of the previous generation are needed to generate the
+  // next one, the rest is pushed to the aggregators.
+  stats::ImprovementMetadata metadata;
+  evaluateTrain();
+  stats::Statistics trainStats = makeTrainStats(metadata, level);
+  checkTarget(trainStats);
+  bool last = stopping.stop(0, trainStats.bestFitness);
+  addTrainStats(0, last, metadata, trainStats);
+  addTestStats(0, last, trainStats);
+  addPhases(0);
+  firstGenerationSpan.reset();
+
+  size_t i = 0;
+  while (!last) {
+    ++i;
+    if (level != repr::StatsLevel::None) {
+      LOG(INFO) << "Generation " << i;
+    }
+    trace::Span generationSpan("generation", i);
+    times = stats::PhaseTimes();
+    allocs = stats::PhaseAllocations();
+    {
+      counters::Region region("newGeneration");
+      std::tie(population, metadata) =
+          operators::newGeneration(rng, params, population, fitnesses, sizes,
+                                   trainStats, &times, &allocs);
+    }
+
+    evaluateTrain();
+    trainBuffers.reuse(trainStats);
+    trainStats = makeTrainStats(metadata, level);
+    checkTarget(trainStats);
+    last = stopping.stop(i, trainStats.bestFitness);
+    addTrainStats(i, last, metadata, trainStats);
+    addTestStats(i, last, trainStats);
+    addPhases(i);
+  }
+  trainAggregator.addInstance(i + 1, stopping.stoppedEarly());
+}
+
+template <typename Dataset>
+std::pair<stats::Aggregator, stats::Aggregator>
+simulate_(const repr::Params &params, Dataset &trainDataset,
+          Dataset &testDataset) {
   repr::RNG rng(params.seed);
 
-  std::vector<std::vector<stats::Statistics>> allTrainStats;
-  std::vector<std::vector<stats::Statistics>> allTestStats;
+  stats::Aggregator trainAggregator;
+  stats::Aggregator testAggregator;
+  const auto deadline =
+      deadlineAfter_(Clock_::now(), params.stopping.timeBudget);
   for (size_t i = 1; i <= params.numInstances; ++i) {
+    if (i > 1 && Clock_::now() >= deadline) {
+      LOG(INFO) << "Time budget exhausted, skipping the remaining "
+                << params.numInstances - i + 1 << " instances";
+      break;
+    }
+
     LOG(INFO) << "";
     LOG(INFO) << "";
     LOG(INFO) << "INSTANCE " << i;
     LOG(INFO) << "";
     LOG(INFO) << "";
 
-    auto[trainStats, testStats] =
-        simulateGeneration_(rng, params, trainDataset, testDataset);
-    allTrainStats.push_back(std::move(trainStats));
-    allTestStats.push_back(std::move(testStats));
+    trace::Span span("instance", i);
+    simulateGeneration_(rng, params, trainDataset, testDataset, trainAggregator,
+                        testAggregator, deadline);
   }
 
-  return {allTrainStats, allTestStats};
+  return {std::move(trainAggregator), std::move(testAggregator)};
+}
+
+} // namespace
+
+namespace simulation {
+
+void simulateInstance(repr::RNG &rng, const repr::Params &params,
+                      const repr::Dataset &trainDataset,
+                      const repr::Dataset &testDataset,
+                      stats::Aggregator &trainAggregator,
+                      stats::Aggregator &testAggregator) {
+  const auto deadline =
+      deadlineAfter_(Clock_::now(), params.stopping.timeBudget);
+  simulateGeneration_(rng, params, trainDataset, testDataset, trainAggregator,
+                      testAggregator, deadline);
+}
+
+void simulateInstance(repr::RNG &rng, const repr::Params &params,
+                      const repr::DatasetView &trainView,
+                      const repr::DatasetView &testView,
+                      stats::Aggregator &trainAggregator,
+                      stats::Aggregator &testAggregator) {
+  const auto deadline =
+      deadlineAfter_(Clock_::now(), params.stopping.timeBudget);
+  simulateGeneration_(rng, params, trainView, testView, trainAggregator,
+                      testAggregator, deadline);
+}
+
+std::pair<stats::Aggregator, stats::Aggregator>
+simulate(const repr::Params &params, const repr::Dataset &trainDataset,
+         const repr::Dataset &testDataset) {
+  return simulate_(params, trainDataset, testDataset);
+}
+
+std::pair<stats::Aggregator, stats::Aggregator>
+simulate(const repr::Params &params, stream::DatasetStream &trainStream,
+         stream::DatasetStream &testStream) {
+  return simulate_(params, trainStream, testStream);
 }
 
 } // namespace simulation
@@ -18,21 +18,49 @@
 #define COMPNAT_TP1_SIMULATION_HPP
 
 #include <utility>
-#include <vector>
 
 #include "representation.hpp"
 #include "statistics.hpp"
+#include "stream.hpp"
 
 namespace simulation {
 
 /**
  * Runs the entire GA simulation for the given params and datasets.
+ * @return Pair with the aggregated train and test statistics of all instances.
  */
-std::pair<std::vector<std::vector<stats::Statistics>>,
-          std::vector<std::vector<stats::Statistics>>>
+std::pair<stats::Aggregator, stats::Aggregator>
 simulate(const repr::Params &params, const repr::Dataset &trainDataset,
          const repr::Dataset &testDataset);
 
+/**
+ * Runs the entire GA simulation streaming the datasets from disk.
+ * @return Pair with the aggregated train and test statistics of all instances.
+ */
+std::pair<stats::Aggregator, stats::Aggregator>
+simulate(const repr::Params &params, stream::DatasetStream &trainStream,
+         stream::DatasetStream &testStream);
+
+/**
+ * Runs a single instance with the given RNG, adding its statistics to the
+ * aggregators. Instances may run concurrently on the same aggregators, as
+ * long as each one has its own RNG.
+ * params.numInstances is ignored, and params.stopping.timeBudget limits only
+ * this instance.
+ */
+void simulateInstance(repr::RNG &rng, const repr::Params &params,
+                      const repr::Dataset &trainDataset,
+                      const repr::Dataset &testDataset,
+                      stats::Aggregator &trainAggregator,
+                      stats::Aggregator &testAggregator);
+
+/// Same as above, with the rows of views of the datasets.
+void simulateInstance(repr::RNG &rng, const repr::Params &params,
+                      const repr::DatasetView &trainView,
+                      const repr::DatasetView &testView,
+                      stats::Aggregator &trainAggregator,
+                      stats::Aggregator &testAggregator);
+
 } // namespace simulation
 
 #endif // !COMPNAT_TP1_SIMULATION_HPP
@@ -52,4 +52,156 @@ TEST(NewGenerationTest, WorksCorrectly) {
   simulate(params, trainDataset, testDataset);
 }
 
+TEST(SimulateTest, StopsOnStagnation) {
+  // No improvement is big enough, so instances stop after 3 generations.
+  repr::Params params( // Keep formatting
+      "", 1, 2, 50, 60, 5, 7, 0.9, false, false,
+      {
+          primitives::sumFn,
+          primitives::subFn,
+          primitives::multFn,
+          primitives::divFn,
+      },
+      {
+          primitives::constTerm,
+          primitives::makeVarTerm(0),
+      });
+  params.stopping.stagnationGenerations = 3;
+  params.stopping.stagnationEpsilon = 1e300;
+
+  const auto &trainDataset =
+      parser::loadDataset("compnat/tp1/datasets/keijzer-7-train.csv");
+  const auto &testDataset =
+      parser::loadDataset("compnat/tp1/datasets/keijzer-7-test.csv");
+  const auto & [ train, test ] = simulate(params, trainDataset, testDataset);
+  EXPECT_EQ((size_t)4, train.numGenerations());
+  EXPECT_EQ((size_t)2, train.generation(3).count());
+  EXPECT_EQ((size_t)2, train.numStoppedEarly());
+  EXPECT_DOUBLE_EQ(4, train.generationsRun().mean());
+  EXPECT_EQ((size_t)2, test.finalStats().count());
+}
+
+TEST(SimulateTest, StopsOnTimeBudget) {
+  // The budget runs out during the first generation, so only the first
+  // instance runs, and only its first generation.
+  repr::Params params( // Keep formatting
+      "", 1, 3, 50, 60, 5, 7, 0.9, false, false,
+      {
+          primitives::sumFn,
+          primitives::subFn,
+          primitives::multFn,
+          primitives::divFn,
+      },
+      {
+          primitives::constTerm,
+          primitives::makeVarTerm(0),
+      });
+  params.stopping.timeBudget = 1e-9;
+
+  const auto &trainDataset =
+      parser::loadDataset("compnat/tp1/datasets/keijzer-7-train.csv");
+  const auto &testDataset =
+      parser::loadDataset("compnat/tp1/datasets/keijzer-7-test.csv");
+  const auto & [ train, test ] = simulate(params, trainDataset, testDataset);
+  EXPECT_EQ((size_t)1, train.numGenerations());
+  EXPECT_EQ((size_t)1, train.generationsRun().count());
+  EXPECT_EQ((size_t)1, train.numStoppedEarly());
+  EXPECT_EQ((size_t)1, test.finalStats().count());
+}
+
+TEST(SimulateTest, FinalStatsOfEachInstance) {
+  repr::Params params( // Keep formatting
+      "", 1, 2, 3, 60, 5, 7, 0.9, false, false,
+      {
+          primitives::sumFn,
+          primitives::subFn,
+          primitives::multFn,
+          primitives::divFn,
+      },
+      {
+          primitives::constTerm,
+          primitives::makeVarTerm(0),
+      });
+  const auto &trainDataset =
+      parser::loadDataset("compnat/tp1/datasets/keijzer-7-train.csv");
+  const auto &testDataset =
+      parser::loadDataset("compnat/tp1/datasets/keijzer-7-test.csv");
+  const auto & [ train, test ] = simulate(params, trainDataset, testDataset);
+  EXPECT_EQ((size_t)4, train.numGenerations());
+  EXPECT_EQ((size_t)0, train.numStoppedEarly());
+  EXPECT_DOUBLE_EQ(4, train.generationsRun().mean());
+  ASSERT_EQ((size_t)2, test.finalStats().count());
+  EXPECT_DOUBLE_EQ(test.generation(3).bestFitness.mean(),
+                   test.finalStats().bestFitness.mean());
+}
+
+TEST(SimulateTest, NoStatsOnlyAggregatesTheLastGeneration) {
+  const auto &trainDataset =
+      parser::loadDataset("compnat/tp1/datasets/keijzer-7-train.csv");
+  const auto &testDataset =
+      parser::loadDataset("compnat/tp1/datasets/keijzer-7-test.csv");
+  repr::Params params( // Keep formatting
+      "", 1, 2, 3, 60, 5, 7, 0.9, false, false,
+      {
+          primitives::sumFn,
+          primitives::subFn,
+          primitives::multFn,
+          primitives::divFn,
+      },
+      {
+          primitives::constTerm,
+          primitives::makeVarTerm(0),
+      });
+  const auto & [ fullTrain, fullTest ] =
+      simulate(params, trainDataset, testDataset);
+
+  params.alwaysTest = true;
+  params.statsLevel = repr::StatsLevel::None;
+  const auto & [ train, test ] = simulate(params, trainDataset, testDataset);
+
+  EXPECT_EQ((size_t)0, train.generation(1).count());
+  EXPECT_EQ((size_t)0, test.generation(1).count());
+  ASSERT_EQ((size_t)2, train.generation(3).count());
+  EXPECT_FALSE(train.generation(3).bestIndividualStr.empty());
+  EXPECT_DOUBLE_EQ(fullTrain.generation(3).bestFitness.mean(),
+                   train.generation(3).bestFitness.mean());
+  ASSERT_EQ((size_t)2, test.finalStats().count());
+  EXPECT_DOUBLE_EQ(fullTest.finalStats().bestFitness.mean(),
+                   test.finalStats().bestFitness.mean());
+}
+
+TEST(SimulateTest, SummaryStatsOnlyTestTheBestIndividual) {
+  const auto &trainDataset =
+      parser::loadDataset("compnat/tp1/datasets/keijzer-7-train.csv");
+  const auto &testDataset =
+      parser::loadDataset("compnat/tp1/datasets/keijzer-7-test.csv");
+  repr::Params params( // Keep formatting
+      "", 1, 2, 3, 60, 5, 7, 0.9, false, false,
+      {
+          primitives::sumFn,
+          primitives::subFn,
+          primitives::multFn,
+          primitives::divFn,
+      },
+      {
+          primitives::constTerm,
+          primitives::makeVarTerm(0),
+      });
+  params.alwaysTest = true;
+  params.statsLevel = repr::StatsLevel::Summary;
+  const auto & [ train, test ] = simulate(params, trainDataset, testDataset);
+
+  ASSERT_EQ((size_t)2, train.generation(1).count());
+  EXPECT_EQ((size_t)2, train.generation(1).numRepeated.count());
+  EXPECT_EQ((size_t)0, train.generation(1).numCrossBetter.count());
+  ASSERT_EQ((size_t)2, test.generation(1).count());
+  EXPECT_DOUBLE_EQ(train.generation(1).bestSize.mean(),
+                   test.generation(1).avgSize.mean());
+  EXPECT_DOUBLE_EQ(test.generation(1).bestFitness.mean(),
+                   test.generation(1).worstFitness.mean());
+  EXPECT_EQ((size_t)2, test.finalStats().count());
+  EXPECT_FALSE(train.generation(3).bestIndividualStr.empty());
+  EXPECT_EQ((size_t)2, train.generation(3).numCrossBetter.count());
+}
+
 } // namespace
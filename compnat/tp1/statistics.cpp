@@ -16,13 +16,19 @@
 
 #include "statistics.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <fstream>
-#include <unordered_set>
+#include <unordered_map>
 
 #include "glog/logging.h"
 
+#include "compnat/common/allocations.hpp"
+#include "compnat/common/counters.hpp"
+#include "compnat/common/numa.hpp"
 #include "compnat/tp1/results/results_generated.h"
+#include "serializer.hpp"
 #include "utils.hpp"
 
 namespace stats {
@@ -41,81 +47,48 @@ buildParams_(flatbuffers::FlatBufferBuilder &builder,
   paramsBuilder.add_crossoverProb(params.crossoverProb);
   paramsBuilder.add_elitism(params.elitism);
   paramsBuilder.add_alwaysTest(params.alwaysTest);
+  paramsBuilder.add_tarpeianProb(params.bloat.tarpeianProb);
+  paramsBuilder.add_parsimonyCoefficient(params.bloat.parsimonyCoefficient);
+  paramsBuilder.add_nodeBudget(params.bloat.nodeBudget);
+  paramsBuilder.add_tuneElites(params.tuning.numElites);
+  paramsBuilder.add_tuneSteps(params.tuning.numSteps);
+  paramsBuilder.add_targetFitness(params.targetFitness);
+  paramsBuilder.add_timeBudget(params.stopping.timeBudget);
+  paramsBuilder.add_instanceTimeBudget(params.stopping.instanceTimeBudget);
+  paramsBuilder.add_stagnationGenerations(
+      params.stopping.stagnationGenerations);
+  paramsBuilder.add_stagnationEpsilon(params.stopping.stagnationEpsilon);
+  paramsBuilder.add_statsLevel((uint8_t)params.statsLevel);
   return paramsBuilder.Finish();
 }
-std::pair<double, double>
-aggregateParamPair_(const std::vector<std::vector<Statistics>> &allStats,
-                    size_t generation,
-                    std::function<double(const Statistics &)> &&accessor) {
-  double mean = 0;
-  for (size_t i = 0; i < allStats.size(); ++i) {
-    mean += accessor(allStats[i][generation]);
-  }
-  mean /= allStats.size();
-
-  double stddev = 0;
-  for (size_t i = 0; i < allStats.size(); ++i) {
-    stddev += std::pow(accessor(allStats[i][generation]) - mean, 2);
-  }
-  stddev = std::sqrt(stddev / allStats.size());
-
-  return {mean, stddev};
-}
-
-results::meanStddev
-aggregateParam_(const std::vector<std::vector<Statistics>> &allStats,
-                size_t generation,
-                std::function<double(const Statistics &)> &&accessor) {
-  auto[mean, stddev] = aggregateParamPair_(
-      allStats, generation, std::forward<decltype(accessor)>(accessor));
-  return results::meanStddev(mean, stddev);
-}
-
-std::tuple<flatbuffers::Offset<flatbuffers::String>, double, size_t>
-bestIndividual_(flatbuffers::FlatBufferBuilder &builder,
-                const std::vector<std::vector<Statistics>> &allStats,
-                size_t generation) {
-  size_t best = 0;
-  for (size_t i = 0; i < allStats.size(); ++i) {
-    if (allStats[i][generation].bestFitness <
-        allStats[best][generation].bestFitness) {
-      best = i;
-    }
-  }
-
-  return {builder.CreateString(allStats[best][generation].bestStr),
-          allStats[best][generation].bestFitness,
-          allStats[best][generation].bestSize};
+results::meanStddev meanStddev_(const RunningMeanStddev &value) {
+  return results::meanStddev(value.mean(), value.stddev());
 }
 
 flatbuffers::Offset<results::AggregatedStats>
 buildAggregatedStats_(flatbuffers::FlatBufferBuilder &builder,
-                      const std::vector<std::vector<Statistics>> &allStats,
-                      size_t generation) {
-  auto bestFitness = aggregateParam_(
-      allStats, generation, [](const auto &s) { return s.bestFitness; });
-  auto bestSize = aggregateParam_(allStats, generation,
-                                  [](const auto &s) { return s.bestSize; });
-  auto worstFitness = aggregateParam_(
-      allStats, generation, [](const auto &s) { return s.worstFitness; });
-  auto worstSize = aggregateParam_(allStats, generation,
-                                   [](const auto &s) { return s.worstSize; });
-  auto avgFitness = aggregateParam_(allStats, generation,
-                                    [](const auto &s) { return s.avgFitness; });
-  auto avgSize = aggregateParam_(allStats, generation,
-                                 [](const auto &s) { return s.avgSize; });
-  auto numRepeated = aggregateParam_(
-      allStats, generation, [](const auto &s) { return s.numRepeated; });
-  auto numCrossBetter = aggregateParam_(
-      allStats, generation, [](const auto &s) { return s.numCrossBetter; });
-  auto numCrossWorse = aggregateParam_(
-      allStats, generation, [](const auto &s) { return s.numCrossWorse; });
-  auto numMutBetter = aggregateParam_(
-      allStats, generation, [](const auto &s) { return s.numMutBetter; });
-  auto numMutWorse = aggregateParam_(
-      allStats, generation, [](const auto &s) { return s.numMutWorse; });
-  auto[bestIndividualStr, bestIndividualFitness, bestIndividualSize] =
-      bestIndividual_(builder, allStats, generation);
+                      const GenerationAggregate &aggregate,
+                      size_t generation = 0) {
+  auto bestFitness = meanStddev_(aggregate.bestFitness);
+  auto bestSize = meanStddev_(aggregate.bestSize);
+  auto worstFitness = meanStddev_(aggregate.worstFitness);
+  auto worstSize = meanStddev_(aggregate.worstSize);
+  auto avgFitness = meanStddev_(aggregate.avgFitness);
+  auto avgSize = meanStddev_(aggregate.avgSize);
+  auto numRepeated = meanStddev_(aggregate.numRepeated);
+  auto numCrossBetter = meanStddev_(aggregate.numCrossBetter);
+  auto numCrossWorse = meanStddev_(aggregate.numCrossWorse);
+  auto numMutBetter = meanStddev_(aggregate.numMutBetter);
+  auto numMutWorse = meanStddev_(aggregate.numMutWorse);
+  auto numSimplifiedNodes = meanStddev_(aggregate.numSimplifiedNodes);
+  auto numConstant = meanStddev_(aggregate.numConstant);
+  auto numNonFinite = meanStddev_(aggregate.numNonFinite);
+  auto totalSize = meanStddev_(aggregate.totalSize);
+  auto evalTime = meanStddev_(aggregate.evalTime);
+  auto numReused = meanStddev_(aggregate.numReused);
+  auto numEvaluations = meanStddev_(aggregate.numEvaluations);
+  auto bestIndividualStr = builder.CreateString(aggregate.bestIndividualStr);
+  auto bestIndividualExpr = builder.CreateString(aggregate.bestIndividualExpr);
 
   results::AggregatedStatsBuilder statsBuilder(builder);
   statsBuilder.add_bestFitness(&bestFitness);
@@ -125,28 +98,181 @@ buildAggregatedStats_(flatbuffers::FlatBufferBuilder &builder,
   statsBuilder.add_avgFitness(&avgFitness);
   statsBuilder.add_avgSize(&avgSize);
   statsBuilder.add_numRepeated(&numRepeated);
-  statsBuilder.add_numCrossBetter(&numCrossBetter);
-  statsBuilder.add_numCrossWorse(&numCrossWorse);
-  statsBuilder.add_numMutBetter(&numMutBetter);
-  statsBuilder.add_numMutWorse(&numMutWorse);
+  // Only computed by the instances with full stats in the generation.
+  if (aggregate.numCrossBetter.count()) {
+    statsBuilder.add_numCrossBetter(&numCrossBetter);
+    statsBuilder.add_numCrossWorse(&numCrossWorse);
+    statsBuilder.add_numMutBetter(&numMutBetter);
+    statsBuilder.add_numMutWorse(&numMutWorse);
+  }
   statsBuilder.add_bestIndividualStr(bestIndividualStr);
-  statsBuilder.add_bestIndividualFitness(bestIndividualFitness);
-  statsBuilder.add_bestIndividualSize(bestIndividualSize);
+  statsBuilder.add_bestIndividualExpr(bestIndividualExpr);
+  statsBuilder.add_bestIndividualFitness(aggregate.bestIndividualFitness);
+  statsBuilder.add_bestIndividualSize(aggregate.bestIndividualSize);
+  statsBuilder.add_numSimplifiedNodes(&numSimplifiedNodes);
+  statsBuilder.add_numConstant(&numConstant);
+  statsBuilder.add_numNonFinite(&numNonFinite);
+  statsBuilder.add_totalSize(&totalSize);
+  statsBuilder.add_evalTime(&evalTime);
+  statsBuilder.add_numReused(&numReused);
+  statsBuilder.add_numEvaluations(&numEvaluations);
+  statsBuilder.add_numInstances(aggregate.count());
+  statsBuilder.add_generation(generation);
   return statsBuilder.Finish();
 }
 
 flatbuffers::Offset<
     flatbuffers::Vector<flatbuffers::Offset<results::AggregatedStats>>>
 buildAllStats_(flatbuffers::FlatBufferBuilder &builder,
-               const std::vector<std::vector<Statistics>> &allStats) {
+               const Aggregator &aggregator) {
   std::vector<flatbuffers::Offset<results::AggregatedStats>> aggregatedStats;
-  for (size_t i = 0; i < allStats[0].size(); ++i) {
-    aggregatedStats.push_back(buildAggregatedStats_(builder, allStats, i));
+  for (size_t i = 0; i < aggregator.numGenerations(); ++i) {
+    // Generations with only phases weren't aggregated, see repr::StatsLevel.
+    const auto &aggregate = aggregator.generation(i);
+    if (aggregate.count()) {
+      aggregatedStats.push_back(buildAggregatedStats_(builder, aggregate, i));
+    }
   }
 
   return builder.CreateVector(aggregatedStats);
 }
 
+flatbuffers::Offset<results::PhaseTimes>
+buildPhaseTimes_(flatbuffers::FlatBufferBuilder &builder,
+                 const GenerationAggregate &aggregate) {
+  auto initTime = meanStddev_(aggregate.initTime);
+  auto selectionTime = meanStddev_(aggregate.selectionTime);
+  auto crossoverTime = meanStddev_(aggregate.crossoverTime);
+  auto mutationTime = meanStddev_(aggregate.mutationTime);
+  auto trainEvalTime = meanStddev_(aggregate.trainEvalTime);
+  auto testEvalTime = meanStddev_(aggregate.testEvalTime);
+  auto statsTime = meanStddev_(aggregate.statsTime);
+  auto serializationTime = meanStddev_(aggregate.serializationTime);
+
+  results::PhaseTimesBuilder timesBuilder(builder);
+  timesBuilder.add_initTime(&initTime);
+  timesBuilder.add_selectionTime(&selectionTime);
+  timesBuilder.add_crossoverTime(&crossoverTime);
+  timesBuilder.add_mutationTime(&mutationTime);
+  timesBuilder.add_trainEvalTime(&trainEvalTime);
+  timesBuilder.add_testEvalTime(&testEvalTime);
+  timesBuilder.add_statsTime(&statsTime);
+  timesBuilder.add_serializationTime(&serializationTime);
+  return timesBuilder.Finish();
+}
+
+flatbuffers::Offset<
+    flatbuffers::Vector<flatbuffers::Offset<results::PhaseTimes>>>
+buildAllPhaseTimes_(flatbuffers::FlatBufferBuilder &builder,
+                    const Aggregator &aggregator) {
+  std::vector<flatbuffers::Offset<results::PhaseTimes>> phaseTimes;
+  for (size_t i = 0; i < aggregator.numGenerations(); ++i) {
+    phaseTimes.push_back(buildPhaseTimes_(builder, aggregator.generation(i)));
+  }
+
+  return builder.CreateVector(phaseTimes);
+}
+
+flatbuffers::Offset<results::AllocationCounts>
+buildAllocationCounts_(flatbuffers::FlatBufferBuilder &builder,
+                       const AllocationsAggregate &aggregate) {
+  auto numAllocations = meanStddev_(aggregate.numAllocations);
+  auto bytes = meanStddev_(aggregate.bytes);
+  auto peakBytes = meanStddev_(aggregate.peakBytes);
+
+  results::AllocationCountsBuilder countsBuilder(builder);
+  countsBuilder.add_numAllocations(&numAllocations);
+  countsBuilder.add_bytes(&bytes);
+  countsBuilder.add_peakBytes(&peakBytes);
+  return countsBuilder.Finish();
+}
+
+flatbuffers::Offset<results::PhaseAllocations>
+buildPhaseAllocations_(flatbuffers::FlatBufferBuilder &builder,
+                       const GenerationAggregate &aggregate) {
+  auto init = buildAllocationCounts_(builder, aggregate.initAllocations);
+  auto selection =
+      buildAllocationCounts_(builder, aggregate.selectionAllocations);
+  auto crossover =
+      buildAllocationCounts_(builder, aggregate.crossoverAllocations);
+  auto mutation =
+      buildAllocationCounts_(builder, aggregate.mutationAllocations);
+  auto trainEval =
+      buildAllocationCounts_(builder, aggregate.trainEvalAllocations);
+  auto testEval =
+      buildAllocationCounts_(builder, aggregate.testEvalAllocations);
+  auto stats = buildAllocationCounts_(builder, aggregate.statsAllocations);
+  auto serialization =
+      buildAllocationCounts_(builder, aggregate.serializationAllocations);
+
+  results::PhaseAllocationsBuilder allocsBuilder(builder);
+  allocsBuilder.add_initialization(init);
+  allocsBuilder.add_selection(selection);
+  allocsBuilder.add_crossover(crossover);
+  allocsBuilder.add_mutation(mutation);
+  allocsBuilder.add_trainEval(trainEval);
+  allocsBuilder.add_testEval(testEval);
+  allocsBuilder.add_stats(stats);
+  allocsBuilder.add_serialization(serialization);
+  return allocsBuilder.Finish();
+}
+
+/// Empty if allocations weren't counted.
+flatbuffers::Offset<
+    flatbuffers::Vector<flatbuffers::Offset<results::PhaseAllocations>>>
+buildAllPhaseAllocations_(flatbuffers::FlatBufferBuilder &builder,
+                          const Aggregator &aggregator) {
+  std::vector<flatbuffers::Offset<results::PhaseAllocations>> phaseAllocs;
+  for (size_t i = 0;
+       allocations::enabled() && i < aggregator.numGenerations(); ++i) {
+    phaseAllocs.push_back(
+        buildPhaseAllocations_(builder, aggregator.generation(i)));
+  }
+
+  return builder.CreateVector(phaseAllocs);
+}
+
+flatbuffers::Offset<
+    flatbuffers::Vector<flatbuffers::Offset<results::CounterRegion>>>
+buildCounters_(flatbuffers::FlatBufferBuilder &builder) {
+  std::vector<flatbuffers::Offset<results::CounterRegion>> regions;
+  for (const auto & [ name, counts ] : counters::regions()) {
+    auto regionName = builder.CreateString(name);
+
+    results::CounterRegionBuilder regionBuilder(builder);
+    regionBuilder.add_name(regionName);
+    regionBuilder.add_numCalls(counts.numCalls);
+    regionBuilder.add_time(counts.time);
+    regionBuilder.add_cycles(counts.events[counters::Cycles]);
+    regionBuilder.add_instructions(counts.events[counters::Instructions]);
+    regionBuilder.add_cacheMisses(counts.events[counters::CacheMisses]);
+    regionBuilder.add_branchMisses(counts.events[counters::BranchMisses]);
+    regionBuilder.add_stalledCycles(counts.events[counters::StalledCycles]);
+    regions.push_back(regionBuilder.Finish());
+  }
+
+  return builder.CreateVector(regions);
+}
+
+flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<results::Fold>>>
+buildFolds_(flatbuffers::FlatBufferBuilder &builder,
+            const std::vector<FoldStats> &folds) {
+  std::vector<flatbuffers::Offset<results::Fold>> resultsFolds;
+  for (const auto &fold : folds) {
+    auto trainStats = buildAllStats_(builder, fold.train);
+    auto finalStats = buildAggregatedStats_(builder, fold.test.finalStats());
+
+    results::FoldBuilder foldBuilder(builder);
+    foldBuilder.add_numTrainRows(fold.numTrainRows);
+    foldBuilder.add_numTestRows(fold.numTestRows);
+    foldBuilder.add_trainStats(trainStats);
+    foldBuilder.add_finalStats(finalStats);
+    resultsFolds.push_back(foldBuilder.Finish());
+  }
+
+  return builder.CreateVector(resultsFolds);
+}
+
 void saveToFile_(const std::string &outputFile, const uint8_t *buf,
                  size_t size) {
   std::ofstream out(outputFile, std::ofstream::out | std::ofstream::trunc |
@@ -156,29 +282,252 @@ void saveToFile_(const std::string &outputFile, const uint8_t *buf,
   out.write((const char *)buf, size);
 }
 
+/**
+ * Population compiled to programs. Individuals equal to another one of the
+ * population or to one in the cache aren't evaluated again.
+ */
+struct CompiledPopulation_ {
+  std::vector<program::Program> programs;
+
+  /// Indices of the individuals that need to be evaluated.
+  std::vector<size_t> evaluate;
+
+  /// Index of the individual each one copies the fitness from, or its own
+  /// index if it doesn't.
+  std::vector<size_t> source;
+
+  /// Fitness of the individuals, already set for the cached ones.
+  std::vector<double> fitnesses;
+
+  /// If the output of each individual is provably constant or non-finite,
+  /// already set for the cached ones.
+  std::vector<char> constant;
+  std::vector<char> nonFinite;
+};
+
+/// Compiles all the population, adding the compilation stats to metadata.
+CompiledPopulation_ compile_(const std::vector<repr::Node> &population,
+                             const FitnessCache *cache,
+                             EvaluationMetadata *metadata) {
+  CompiledPopulation_ compiled;
+  compiled.programs.reserve(population.size());
+  compiled.source.resize(population.size());
+  compiled.fitnesses.resize(population.size());
+  compiled.constant.resize(population.size());
+  compiled.nonFinite.resize(population.size());
+
+  size_t numSimplifiedNodes = 0, numReused = 0, numRepeated = 0;
+  std::unordered_multimap<size_t, size_t> unique;
+  for (size_t i = 0; i < population.size(); ++i) {
+    compiled.programs.emplace_back(population[i]);
+    const auto &program = compiled.programs.back();
+    numSimplifiedNodes += program.numRemoved();
+
+    compiled.source[i] = i;
+    const auto & [ begin, end ] = unique.equal_range(program.hash());
+    for (auto it = begin; it != end; ++it) {
+      if (compiled.programs[it->second] == program) {
+        compiled.source[i] = it->second;
+        break;
+      }
+    }
+    if (compiled.source[i] != i) {
+      ++numReused;
+      ++numRepeated;
+      continue;
+    }
+
+    unique.emplace(program.hash(), i);
+    if (const auto *entry = cache ? cache->find(program) : nullptr) {
+      compiled.fitnesses[i] = entry->fitness;
+      compiled.constant[i] = entry->constant;
+      compiled.nonFinite[i] = entry->nonFinite;
+      ++numReused;
+      continue;
+    }
+    compiled.evaluate.push_back(i);
+  }
+
+  if (metadata) {
+    metadata->numSimplifiedNodes = numSimplifiedNodes;
+    metadata->numReused = numReused;
+    metadata->numRepeated = numRepeated;
+  }
+  return compiled;
+}
+
+/**
+ * Copies the fitness of repeated individuals, updates the cache and adds the
+ * number of constant and non-finite individuals and the time since start to
+ * metadata.
+ */
+std::vector<double> finish_(CompiledPopulation_ &compiled,
+                            std::chrono::steady_clock::time_point start,
+                            EvaluationMetadata *metadata,
+                            FitnessCache *cache) {
+  auto &fitnesses = compiled.fitnesses;
+  std::vector<program::Program> uniquePrograms;
+  std::vector<FitnessCache::Entry> uniqueEntries;
+  for (size_t i = 0; i < fitnesses.size(); ++i) {
+    const size_t source = compiled.source[i];
+    if (source != i) {
+      fitnesses[i] = fitnesses[source];
+      compiled.constant[i] = compiled.constant[source];
+      compiled.nonFinite[i] = compiled.nonFinite[source];
+    } else if (cache) {
+      uniquePrograms.push_back(std::move(compiled.programs[i]));
+      uniqueEntries.push_back({fitnesses[i], (bool)compiled.constant[i],
+                               (bool)compiled.nonFinite[i]});
+    }
+  }
+
+  if (cache) {
+    cache->assign(std::move(uniquePrograms), std::move(uniqueEntries));
+  }
+  if (metadata) {
+    const auto &constant = compiled.constant;
+    const auto &nonFinite = compiled.nonFinite;
+    metadata->numConstant = std::count(constant.begin(), constant.end(), 1);
+    metadata->numNonFinite = std::count(nonFinite.begin(), nonFinite.end(), 1);
+    metadata->numEvaluations = compiled.evaluate.size();
+    metadata->evalTime = utils::elapsedMs(start);
+  }
+  return std::move(fitnesses);
+}
+
+/**
+ * Fitness of the population on a dataset made of chunks, in a single pass
+ * over them. Chunked is a stream::DatasetStream or a repr::DatasetView.
+ */
+template <typename Chunked>
+std::vector<double> chunkedFitness_(const std::vector<repr::Node> &population,
+                                    Chunked &chunked,
+                                    EvaluationMetadata *metadata,
+                                    FitnessCache *cache) {
+  const auto start = std::chrono::steady_clock::now();
+  auto compiled = compile_(population, cache, metadata);
+  const auto &evaluate = compiled.evaluate;
+  std::vector<double> errors(evaluate.size(), 0);
+
+  // Individuals are constant if they have the same constant value in all
+  // chunks, and are rejected as soon as they are non-finite in a chunk.
+  std::vector<char> constant(evaluate.size(), 1);
+  std::vector<char> nonFinite(evaluate.size(), 0);
+  std::vector<repr::T> constantValues(evaluate.size());
+  bool firstChunk = true;
+  if (!evaluate.empty()) {
+    const size_t numRows = chunked.forEachChunk([&](const auto &chunk) {
+#pragma omp parallel
+      {
+        counters::Region region("fitness");
+#pragma omp for
+        for (size_t k = 0; k < evaluate.size(); ++k) {
+          if (nonFinite[k]) {
+            continue;
+          }
+
+          const auto &program = compiled.programs[evaluate[k]];
+          const auto &bounds = program.bounds(chunk);
+          constant[k] = constant[k] && bounds.constant() &&
+                        (firstChunk || bounds.min == constantValues[k]);
+          constantValues[k] = bounds.min;
+          nonFinite[k] = bounds.nonFinite;
+          errors[k] += program.squaredError(chunk, bounds);
+        }
+      }
+      firstChunk = false;
+    });
+
+    for (size_t k = 0; k < evaluate.size(); ++k) {
+      compiled.fitnesses[evaluate[k]] = std::sqrt(errors[k] / numRows);
+      compiled.constant[evaluate[k]] = constant[k];
+      compiled.nonFinite[evaluate[k]] = nonFinite[k];
+    }
+  }
+
+  return finish_(compiled, start, metadata, cache);
+}
+
 } // namespace
 
-double fitness(const repr::Node &individual, const repr::Dataset &dataset) {
-  double error = 0;
-  for (const auto &sample : dataset) {
-    // Unpack outside the loop because clang on MacOS can't compile it in the
-    // loop.
-    const auto & [ input, expected ] = sample;
-    error += std::pow(individual.eval(input) - expected, 2);
+void SerializationBuffers::reuse(Statistics &stats) {
+  bestStr.swap(stats.bestStr);
+  bestExpr.swap(stats.bestExpr);
+}
+
+const FitnessCache::Entry *
+FitnessCache::find(const program::Program &program) const {
+  const auto & [ begin, end ] = index_.equal_range(program.hash());
+  for (auto it = begin; it != end; ++it) {
+    if (programs_[it->second] == program) {
+      return &entries_[it->second];
+    }
   }
+  return nullptr;
+}
 
-  return std::sqrt(error / dataset.size());
+void FitnessCache::assign(std::vector<program::Program> programs,
+                          std::vector<Entry> entries) {
+  CHECK(programs.size() == entries.size());
+  programs_.clear();
+  entries_.clear();
+  index_.clear();
+  for (size_t i = 0; i < programs.size(); ++i) {
+    if (programs[i].comparable()) {
+      index_.emplace(programs[i].hash(), programs_.size());
+      programs_.push_back(std::move(programs[i]));
+      entries_.push_back(entries[i]);
+    }
+  }
+}
+
+double fitness(const repr::Node &individual, const repr::Dataset &dataset) {
+  const program::Program program(individual);
+  return std::sqrt(program.squaredError(dataset) / dataset.size());
 }
 
 std::vector<double> fitness(const std::vector<repr::Node> &population,
-                            const repr::Dataset &dataset) {
-  std::vector<double> results(population.size());
-#pragma omp parallel for
-  for (size_t i = 0; i < population.size(); ++i) {
-    results[i] = fitness(population[i], dataset);
+                            const repr::Dataset &dataset,
+                            EvaluationMetadata *metadata,
+                            FitnessCache *cache) {
+  const auto start = std::chrono::steady_clock::now();
+  auto compiled = compile_(population, cache, metadata);
+  const auto &evaluate = compiled.evaluate;
+
+#pragma omp parallel
+  {
+    counters::Region region("fitness");
+    const int node = numa::currentNode();
+    const auto &local = dataset.replica(node);
+    size_t numEvaluated = 0;
+#pragma omp for
+    for (size_t k = 0; k < evaluate.size(); ++k) {
+      const auto &program = compiled.programs[evaluate[k]];
+      const auto &bounds = program.bounds(local);
+      compiled.constant[evaluate[k]] = bounds.constant();
+      compiled.nonFinite[evaluate[k]] = bounds.nonFinite;
+      compiled.fitnesses[evaluate[k]] =
+          std::sqrt(program.squaredError(local, bounds) / local.size());
+      ++numEvaluated;
+    }
+    numa::recordAccess(node, local.node(), numEvaluated * local.sizeInBytes());
   }
 
-  return results;
+  return finish_(compiled, start, metadata, cache);
+}
+
+std::vector<double> fitness(const std::vector<repr::Node> &population,
+                            stream::DatasetStream &stream,
+                            EvaluationMetadata *metadata,
+                            FitnessCache *cache) {
+  return chunkedFitness_(population, stream, metadata, cache);
+}
+
+std::vector<double> fitness(const std::vector<repr::Node> &population,
+                            const repr::DatasetView &view,
+                            EvaluationMetadata *metadata,
+                            FitnessCache *cache) {
+  return chunkedFitness_(population, view, metadata, cache);
 }
 
 std::vector<size_t> sizes(const std::vector<repr::Node> &population) {
@@ -194,21 +543,32 @@ Statistics::Statistics(const std::string &statsName,
                        const std::vector<repr::Node> &population,
                        const std::vector<double> &fitnesses,
                        const std::vector<size_t> &sizes,
-                       const ImprovementMetadata &metadata)
+                       const ImprovementMetadata &metadata,
+                       const EvaluationMetadata &evalMetadata,
+                       repr::StatsLevel level, SerializationBuffers *buffers)
     : best(0), bestFitness(0), bestSize(0), worst(0), worstFitness(0),
-      worstSize(0), avgFitness(0), avgSize(0), numRepeated(0),
-      numCrossBetter(-1), numCrossWorse(-1), numMutBetter(-1), numMutWorse(-1) {
-
-  calcFitnessAndSizeStats_(population, fitnesses, sizes);
-  calcRepeatedIndividuals_(fitnesses);
-  calcImprovementStats_(fitnesses, metadata);
-
-  printStats_(statsName);
+      worstSize(0), avgFitness(0), avgSize(0), totalSize(0),
+      numRepeated(evalMetadata.numRepeated),
+      numCrossBetter(-1), numCrossWorse(-1), numMutBetter(-1), numMutWorse(-1),
+      numSimplifiedNodes(evalMetadata.numSimplifiedNodes),
+      numConstant(evalMetadata.numConstant),
+      numNonFinite(evalMetadata.numNonFinite),
+      evalTime(evalMetadata.evalTime), numReused(evalMetadata.numReused),
+      numEvaluations(evalMetadata.numEvaluations), serializationTime(0),
+      level(level) {
+
+  calcFitnessAndSizeStats_(fitnesses, sizes);
+  if (level == repr::StatsLevel::Full) {
+    serializeBest_(population, buffers);
+    calcImprovementStats_(fitnesses, metadata);
+    printStats_(statsName);
+  } else if (level == repr::StatsLevel::Summary) {
+    printSummary_(statsName);
+  }
 }
 
-void Statistics::calcFitnessAndSizeStats_(
-    const std::vector<repr::Node> &population,
-    const std::vector<double> &fitnesses, const std::vector<size_t> &sizes) {
+void Statistics::calcFitnessAndSizeStats_(const std::vector<double> &fitnesses,
+                                          const std::vector<size_t> &sizes) {
   for (size_t i = 0; i < fitnesses.size(); ++i) {
     if (fitnesses[best] > fitnesses[i]) {
       best = i;
@@ -217,28 +577,29 @@ void Statistics::calcFitnessAndSizeStats_(
       worst = i;
     }
     avgFitness += fitnesses[i];
-    avgSize += sizes[i];
+    totalSize += sizes[i];
   }
   avgFitness /= fitnesses.size();
-  avgSize /= sizes.size();
+  avgSize = totalSize / sizes.size();
 
   bestFitness = fitnesses[best];
   bestSize = sizes[best];
-  bestStr = population[best].str();
   worstFitness = fitnesses[worst];
   worstSize = sizes[worst];
 }
 
-void Statistics::calcRepeatedIndividuals_(
-    const std::vector<double> &fitnesses) {
-  std::unordered_set<double> set;
-  for (const auto &fit : fitnesses) {
-    if (set.count(fit)) {
-      ++numRepeated;
-    } else {
-      set.insert(fit);
-    }
+void Statistics::serializeBest_(const std::vector<repr::Node> &population,
+                                SerializationBuffers *buffers) {
+  utils::ScopedTimer timer(serializationTime);
+  allocations::Scope scope(serializationAllocations);
+  if (buffers) {
+    bestStr.swap(buffers->bestStr);
+    bestExpr.swap(buffers->bestExpr);
+    bestStr.clear();
+    bestExpr.clear();
   }
+  serializer::appendStr(population[best], bestStr);
+  serializer::appendStr(population[best], bestExpr, serializer::ExactPrecision);
 }
 
 void Statistics::calcImprovementStats_(const std::vector<double> &fitnesses,
@@ -267,6 +628,14 @@ void Statistics::calcFitnessImprovement_(
   }
 }
 
+void Statistics::printSummary_(const std::string &statsName) {
+  LOG(INFO) << utils::strCat("  ", statsName, ": best fitness: ", bestFitness,
+                             " | best size: ", bestSize,
+                             " | worst fitness: ", worstFitness,
+                             " | avgFitness: ", avgFitness,
+                             " | avgSize: ", avgSize);
+}
+
 void Statistics::printStats_(const std::string &statsName) {
   using utils::paddedStrCat;
   using utils::strCat;
@@ -279,7 +648,14 @@ void Statistics::printStats_(const std::string &statsName) {
             << paddedStrCat(w, "| worst size: ", worstSize);
   LOG(INFO) << paddedStrCat(w, "    avgFitness: ", avgFitness)
             << paddedStrCat(w, "| avgSize: ", avgSize)
-            << paddedStrCat(w, "| numRepeated: ", numRepeated);
+            << paddedStrCat(w, "| numRepeated: ", numRepeated)
+            << paddedStrCat(w, "| numSimplifiedNodes: ", numSimplifiedNodes)
+            << paddedStrCat(w, "| numEvaluations: ", numEvaluations);
+  LOG(INFO) << paddedStrCat(w, "    numConstant: ", numConstant)
+            << paddedStrCat(w, "| numNonFinite: ", numNonFinite)
+            << paddedStrCat(w, "| totalSize: ", totalSize)
+            << paddedStrCat(w, "| evalTime (ms): ", evalTime)
+            << paddedStrCat(w, "| numReused: ", numReused);
 
   if (numCrossBetter != -1) {
     LOG(INFO) << paddedStrCat(w, "    numCrossBetter: ", numCrossBetter)
@@ -289,39 +665,320 @@ void Statistics::printStats_(const std::string &statsName) {
   }
 }
 
-void saveResults(const repr::Params &params,
-                 const std::vector<std::vector<Statistics>> &allTrainStats,
-                 const std::vector<std::vector<Statistics>> &allTestStats) {
+allocations::Counts PhaseAllocations::total() const {
+  allocations::Counts counts = init;
+  for (const auto &phase : {selection, crossover, mutation, trainEval,
+                            testEval, stats, serialization}) {
+    counts += phase;
+  }
+  return counts;
+}
+
+void logAllocations(const PhaseAllocations &allocs) {
+  using utils::paddedStrCat;
+  const size_t w = 30; // Width of each padded string, as in printStats_.
+  const auto &total = allocs.total();
+
+  LOG(INFO) << "  Allocations:";
+  LOG(INFO) << paddedStrCat(w, "    numAllocations: ", total.numAllocations)
+            << paddedStrCat(w, "| bytes: ", total.bytes)
+            << paddedStrCat(w, "| peakBytes: ", total.peakBytes);
+  LOG(INFO) << paddedStrCat(w, "    init: ", allocs.init.numAllocations)
+            << paddedStrCat(w, "| selection: ", allocs.selection.numAllocations)
+            << paddedStrCat(w, "| crossover: ", allocs.crossover.numAllocations)
+            << paddedStrCat(w, "| mutation: ", allocs.mutation.numAllocations);
+  LOG(INFO) << paddedStrCat(w, "    trainEval: ",
+                            allocs.trainEval.numAllocations)
+            << paddedStrCat(w, "| testEval: ", allocs.testEval.numAllocations)
+            << paddedStrCat(w, "| stats: ", allocs.stats.numAllocations)
+            << paddedStrCat(w, "| serialization: ",
+                            allocs.serialization.numAllocations);
+}
+
+void RunningMeanStddev::push(double value) {
+  ++count_;
+  const double delta = value - mean_;
+  mean_ += delta / count_;
+  m2_ += delta * (value - mean_);
+}
+
+void RunningMeanStddev::merge(const RunningMeanStddev &other) {
+  if (!other.count_) {
+    return;
+  }
+
+  // Chan et al.'s combination of the moments of two sets of values.
+  const double count = count_, otherCount = other.count_;
+  const double delta = other.mean_ - mean_;
+  mean_ += delta * otherCount / (count + otherCount);
+  m2_ += other.m2_ + delta * delta * count * otherCount / (count + otherCount);
+  count_ += other.count_;
+}
+
+double RunningMeanStddev::stddev() const {
+  return count_ ? std::sqrt(m2_ / count_) : 0;
+}
+
+void AllocationsAggregate::push(const allocations::Counts &counts) {
+  numAllocations.push(counts.numAllocations);
+  bytes.push(counts.bytes);
+  peakBytes.push(counts.peakBytes);
+}
+
+void AllocationsAggregate::merge(const AllocationsAggregate &other) {
+  numAllocations.merge(other.numAllocations);
+  bytes.merge(other.bytes);
+  peakBytes.merge(other.peakBytes);
+}
+
+void GenerationAggregate::push(const Statistics &stats) {
+  // Individuals that weren't serialized, see repr::StatsLevel, aren't kept.
+  if (!stats.bestStr.empty() && (bestIndividualStr.empty() ||
+                                 stats.bestFitness < bestIndividualFitness)) {
+    bestIndividualStr = stats.bestStr;
+    bestIndividualExpr = stats.bestExpr;
+    bestIndividualFitness = stats.bestFitness;
+    bestIndividualSize = stats.bestSize;
+  }
+
+  bestFitness.push(stats.bestFitness);
+  bestSize.push(stats.bestSize);
+  worstFitness.push(stats.worstFitness);
+  worstSize.push(stats.worstSize);
+  avgFitness.push(stats.avgFitness);
+  avgSize.push(stats.avgSize);
+  numRepeated.push(stats.numRepeated);
+  if (stats.level == repr::StatsLevel::Full) {
+    numCrossBetter.push(stats.numCrossBetter);
+    numCrossWorse.push(stats.numCrossWorse);
+    numMutBetter.push(stats.numMutBetter);
+    numMutWorse.push(stats.numMutWorse);
+  }
+  numSimplifiedNodes.push(stats.numSimplifiedNodes);
+  numConstant.push(stats.numConstant);
+  numNonFinite.push(stats.numNonFinite);
+  totalSize.push(stats.totalSize);
+  evalTime.push(stats.evalTime);
+  numReused.push(stats.numReused);
+  numEvaluations.push(stats.numEvaluations);
+}
+
+void GenerationAggregate::push(const PhaseTimes &times) {
+  initTime.push(times.initTime);
+  selectionTime.push(times.selectionTime);
+  crossoverTime.push(times.crossoverTime);
+  mutationTime.push(times.mutationTime);
+  trainEvalTime.push(times.trainEvalTime);
+  testEvalTime.push(times.testEvalTime);
+  statsTime.push(times.statsTime);
+  serializationTime.push(times.serializationTime);
+}
+
+void GenerationAggregate::push(const PhaseAllocations &allocs) {
+  initAllocations.push(allocs.init);
+  selectionAllocations.push(allocs.selection);
+  crossoverAllocations.push(allocs.crossover);
+  mutationAllocations.push(allocs.mutation);
+  trainEvalAllocations.push(allocs.trainEval);
+  testEvalAllocations.push(allocs.testEval);
+  statsAllocations.push(allocs.stats);
+  serializationAllocations.push(allocs.serialization);
+}
+
+void GenerationAggregate::merge(const GenerationAggregate &other) {
+  if (!other.bestIndividualStr.empty() &&
+      (bestIndividualStr.empty() ||
+       other.bestIndividualFitness < bestIndividualFitness)) {
+    bestIndividualStr = other.bestIndividualStr;
+    bestIndividualExpr = other.bestIndividualExpr;
+    bestIndividualFitness = other.bestIndividualFitness;
+    bestIndividualSize = other.bestIndividualSize;
+  }
+
+  bestFitness.merge(other.bestFitness);
+  bestSize.merge(other.bestSize);
+  worstFitness.merge(other.worstFitness);
+  worstSize.merge(other.worstSize);
+  avgFitness.merge(other.avgFitness);
+  avgSize.merge(other.avgSize);
+  numRepeated.merge(other.numRepeated);
+  numCrossBetter.merge(other.numCrossBetter);
+  numCrossWorse.merge(other.numCrossWorse);
+  numMutBetter.merge(other.numMutBetter);
+  numMutWorse.merge(other.numMutWorse);
+  numSimplifiedNodes.merge(other.numSimplifiedNodes);
+  numConstant.merge(other.numConstant);
+  numNonFinite.merge(other.numNonFinite);
+  totalSize.merge(other.totalSize);
+  evalTime.merge(other.evalTime);
+  numReused.merge(other.numReused);
+  numEvaluations.merge(other.numEvaluations);
+
+  initTime.merge(other.initTime);
+  selectionTime.merge(other.selectionTime);
+  crossoverTime.merge(other.crossoverTime);
+  mutationTime.merge(other.mutationTime);
+  trainEvalTime.merge(other.trainEvalTime);
+  testEvalTime.merge(other.testEvalTime);
+  statsTime.merge(other.statsTime);
+  serializationTime.merge(other.serializationTime);
+
+  initAllocations.merge(other.initAllocations);
+  selectionAllocations.merge(other.selectionAllocations);
+  crossoverAllocations.merge(other.crossoverAllocations);
+  mutationAllocations.merge(other.mutationAllocations);
+  trainEvalAllocations.merge(other.trainEvalAllocations);
+  testEvalAllocations.merge(other.testEvalAllocations);
+  statsAllocations.merge(other.statsAllocations);
+  serializationAllocations.merge(other.serializationAllocations);
+}
+
+Aggregator::Aggregator(Aggregator &&other) {
+  std::lock_guard<std::mutex> lock(other.mutex_);
+  generations_ = std::move(other.generations_);
+  finalStats_ = std::move(other.finalStats_);
+  evaluationsToTarget_ = other.evaluationsToTarget_;
+  generationsRun_ = other.generationsRun_;
+  numStoppedEarly_ = other.numStoppedEarly_;
+}
+
+Aggregator &Aggregator::operator=(Aggregator &&other) {
+  if (this != &other) {
+    std::scoped_lock lock(mutex_, other.mutex_);
+    generations_ = std::move(other.generations_);
+    finalStats_ = std::move(other.finalStats_);
+    evaluationsToTarget_ = other.evaluationsToTarget_;
+    generationsRun_ = other.generationsRun_;
+    numStoppedEarly_ = other.numStoppedEarly_;
+  }
+  return *this;
+}
+
+template <typename T>
+void Aggregator::push_(size_t generation, const T &value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (generations_.size() <= generation) {
+    generations_.resize(generation + 1);
+  }
+  generations_[generation].push(value);
+}
+
+void Aggregator::add(size_t generation, const Statistics &stats) {
+  push_(generation, stats);
+}
+
+void Aggregator::add(size_t generation, const PhaseTimes &times) {
+  push_(generation, times);
+}
+
+void Aggregator::add(size_t generation, const PhaseAllocations &allocs) {
+  push_(generation, allocs);
+}
+
+size_t Aggregator::numGenerations() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return generations_.size();
+}
+
+void Aggregator::merge(const Aggregator &other) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (generations_.size() < other.generations_.size()) {
+    generations_.resize(other.generations_.size());
+  }
+  for (size_t i = 0; i < other.generations_.size(); ++i) {
+    generations_[i].merge(other.generations_[i]);
+  }
+  finalStats_.merge(other.finalStats_);
+  evaluationsToTarget_.merge(other.evaluationsToTarget_);
+  generationsRun_.merge(other.generationsRun_);
+  numStoppedEarly_ += other.numStoppedEarly_;
+}
+
+void Aggregator::addFinal(const Statistics &stats) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  finalStats_.push(stats);
+}
+
+void Aggregator::addInstance(size_t numGenerations, bool stoppedEarly) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  generationsRun_.push(numGenerations);
+  numStoppedEarly_ += stoppedEarly;
+}
+
+void Aggregator::addEvaluationsToTarget(size_t numEvaluations) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  evaluationsToTarget_.push(numEvaluations);
+}
+
+void saveResults(const repr::Params &params, const Aggregator &trainAggregator,
+                 const Aggregator &testAggregator,
+                 const std::vector<FoldStats> &folds) {
   flatbuffers::FlatBufferBuilder builder;
+  const auto &finalStats = testAggregator.finalStats();
 
   auto resultsParams = buildParams_(builder, params);
-  auto resultsTrainStats = buildAllStats_(builder, allTrainStats);
+  auto resultsTrainStats = buildAllStats_(builder, trainAggregator);
   auto resultsTestStats = params.alwaysTest
-                              ? buildAllStats_(builder, allTestStats)
-                              : buildAllStats_(builder, {{}});
-  auto resultsFinalStats =
-      buildAggregatedStats_(builder, allTestStats, allTestStats[0].size() - 1);
+                              ? buildAllStats_(builder, testAggregator)
+                              : buildAllStats_(builder, Aggregator());
+  auto resultsFinalStats = buildAggregatedStats_(builder, finalStats);
+  auto resultsPhaseTimes = buildAllPhaseTimes_(builder, trainAggregator);
+  auto resultsPhaseAllocs = buildAllPhaseAllocations_(builder, trainAggregator);
+  auto resultsCounters = buildCounters_(builder);
+  auto resultsFolds = buildFolds_(builder, folds);
+  auto evaluationsToTarget =
+      meanStddev_(trainAggregator.evaluationsToTarget());
+  auto meanGenerationsRun = meanStddev_(trainAggregator.generationsRun());
 
   results::ResultsBuilder resultsBuilder(builder);
   resultsBuilder.add_params(resultsParams);
   resultsBuilder.add_trainStats(resultsTrainStats);
   resultsBuilder.add_testStats(resultsTestStats);
   resultsBuilder.add_finalStats(resultsFinalStats);
+  resultsBuilder.add_evaluationsToTarget(&evaluationsToTarget);
+  resultsBuilder.add_numReachedTarget(
+      trainAggregator.evaluationsToTarget().count());
+  resultsBuilder.add_phaseTimes(resultsPhaseTimes);
+  resultsBuilder.add_phaseAllocations(resultsPhaseAllocs);
+  resultsBuilder.add_generationsRun(&meanGenerationsRun);
+  resultsBuilder.add_numInstancesRun(trainAggregator.generationsRun().count());
+  resultsBuilder.add_numStoppedEarly(trainAggregator.numStoppedEarly());
+  resultsBuilder.add_counters(resultsCounters);
+  resultsBuilder.add_folds(resultsFolds);
   builder.Finish(resultsBuilder.Finish());
 
   saveToFile_(params.outputFile, builder.GetBufferPointer(), builder.GetSize());
 
-  auto[finalMeanFitness, finalFitnessError] =
-      aggregateParamPair_(allTestStats, allTestStats[0].size() - 1,
-                          [](const auto &s) { return s.bestFitness; });
-  auto[finalMeanSize, finalSizeError] =
-      aggregateParamPair_(allTestStats, allTestStats[0].size() - 1,
-                          [](const auto &s) { return s.bestSize; });
   LOG(INFO) << "";
   LOG(INFO) << "Final results: ";
-  LOG(INFO) << "  best fitness: " << finalMeanFitness << " +/- "
-            << finalFitnessError;
-  LOG(INFO) << "  best size: " << finalMeanSize << " +/- " << finalSizeError;
+  LOG(INFO) << "  best fitness: " << finalStats.bestFitness.mean() << " +/- "
+            << finalStats.bestFitness.stddev();
+  LOG(INFO) << "  best size: " << finalStats.bestSize.mean() << " +/- "
+            << finalStats.bestSize.stddev();
+  if (params.targetFitness) {
+    const auto &evaluationsToTarget = trainAggregator.evaluationsToTarget();
+    LOG(INFO) << "  evaluations to target: " << evaluationsToTarget.mean()
+              << " +/- " << evaluationsToTarget.stddev() << " ("
+              << evaluationsToTarget.count() << " of " << params.numInstances
+              << " instances reached it)";
+  }
+  const auto &generationsRun = trainAggregator.generationsRun();
+  if (generationsRun.count() < params.numInstances ||
+      trainAggregator.numStoppedEarly()) {
+    LOG(INFO) << "  generations run: " << generationsRun.mean() << " +/- "
+              << generationsRun.stddev() << " ("
+              << trainAggregator.numStoppedEarly() << " of "
+              << generationsRun.count() << " instances stopped early, "
+              << generationsRun.count() << " of " << params.numInstances
+              << " instances run)";
+  }
+  for (size_t i = 0; i < folds.size(); ++i) {
+    const auto &foldStats = folds[i].test.finalStats();
+    LOG(INFO) << "  fold " << i + 1 << " best fitness: "
+              << foldStats.bestFitness.mean() << " +/- "
+              << foldStats.bestFitness.stddev() << " ("
+              << folds[i].numTestRows << " test rows)";
+  }
 }
 
 } // namespace stats
@@ -17,13 +17,79 @@
 #ifndef COMPNAT_TP1_STATISTICS_HPP
 #define COMPNAT_TP1_STATISTICS_HPP
 
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "compnat/common/allocations.hpp"
+#include "program.hpp"
 #include "representation.hpp"
+#include "stream.hpp"
 
 namespace stats {
 
+/// Per-generation evaluation stats.
+struct EvaluationMetadata {
+  /// Number of nodes of the population removed by simplification before
+  /// evaluation (see program::Program).
+  size_t numSimplifiedNodes = 0;
+
+  /// Number of individuals with a provably constant output, which were scored
+  /// in closed form. Includes the ones whose fitness was copied.
+  size_t numConstant = 0;
+
+  /// Number of individuals with a provably non-finite output, which were
+  /// rejected with an infinite fitness without being evaluated. Includes the
+  /// ones whose fitness was copied.
+  size_t numNonFinite = 0;
+
+  /// Time spent evaluating the population, in milliseconds.
+  double evalTime = 0;
+
+  /// Number of individuals that had their fitness copied from an equal
+  /// individual instead of being evaluated.
+  size_t numReused = 0;
+
+  /// Number of individuals equal to a previous one of the population, after
+  /// simplification (see program::Program).
+  size_t numRepeated = 0;
+
+  /// Number of evaluations of individuals over the dataset, including the
+  /// ones done by constant tuning.
+  size_t numEvaluations = 0;
+};
+
+/**
+ * Fitness of the individuals of the previous population evaluated on a
+ * dataset, by the structural hash of their programs. Lets individuals that
+ * survived unchanged have their fitness copied instead of evaluated again.
+ */
+class FitnessCache {
+public:
+  /// Fitness of a program and what is known about its output.
+  struct Entry {
+    double fitness = 0;
+    bool constant = false;
+    bool nonFinite = false;
+  };
+
+  /// Returns the entry of a program equal to the given one, or null.
+  const Entry *find(const program::Program &program) const;
+
+  /// Replaces the contents of the cache.
+  void assign(std::vector<program::Program> programs,
+              std::vector<Entry> entries);
+
+  /// Number of programs in the cache.
+  size_t size() const { return programs_.size(); }
+
+private:
+  std::vector<program::Program> programs_;
+  std::vector<Entry> entries_;
+  std::unordered_multimap<size_t, size_t> index_;
+};
+
 /**
  * Calculates the fitness of an individual given a set of input data.
  * This is implemented as the Root-mean-square deviation.
@@ -36,15 +102,50 @@ double fitness(const repr::Node &individual, const repr::Dataset &dataset);
 
 /**
  * Calculates the fitness for all population and returns it in a vector.
- * This is implemented as the Root-mean-square deviation.
+ * This is implemented as the Root-mean-square deviation. Individuals that are
+ * structurally equal (after simplification) are evaluated only once.
  * @param pool Thread pool.
  * @param population The population used when calculating the fitness.
  * @param sizes The size of each individual in the population.
  * @param dataset The dataset used to calculate the fitness.
+ * @param metadata If not null, receives the evaluation stats.
+ * @param cache If not null, the fitness of individuals in the cache is copied
+ *   and the cache is replaced by this population.
+ * @return Vector of fitness.
+ */
+std::vector<double> fitness(const std::vector<repr::Node> &population,
+                            const repr::Dataset &dataset,
+                            EvaluationMetadata *metadata = nullptr,
+                            FitnessCache *cache = nullptr);
+
+/**
+ * Calculates the fitness for all population streaming the dataset from disk.
+ * A single pass is made over the dataset: the whole population is evaluated
+ * against each chunk, accumulating the squared errors of each individual.
+ * @param population The population used when calculating the fitness.
+ * @param stream The dataset used to calculate the fitness.
+ * @param metadata If not null, receives the evaluation stats.
+ * @param cache Same as above.
+ * @return Vector of fitness.
+ */
+std::vector<double> fitness(const std::vector<repr::Node> &population,
+                            stream::DatasetStream &stream,
+                            EvaluationMetadata *metadata = nullptr,
+                            FitnessCache *cache = nullptr);
+
+/**
+ * Calculates the fitness for all population on the rows of a view, evaluating
+ * its slices like the chunks of a stream.
+ * @param population The population used when calculating the fitness.
+ * @param view The rows used to calculate the fitness.
+ * @param metadata If not null, receives the evaluation stats.
+ * @param cache Same as above.
  * @return Vector of fitness.
  */
 std::vector<double> fitness(const std::vector<repr::Node> &population,
-                            const repr::Dataset &dataset);
+                            const repr::DatasetView &view,
+                            EvaluationMetadata *metadata = nullptr,
+                            FitnessCache *cache = nullptr);
 
 /**
  * Calculates the size for all the population.
@@ -62,6 +163,69 @@ struct ImprovementMetadata {
   std::vector<std::pair<size_t, double>> mutationParentFitness;
 };
 
+/// Per-generation time spent in each phase of an instance, in milliseconds.
+struct PhaseTimes {
+  /// Generation of the initial population, only in the first generation.
+  double initTime = 0;
+
+  /// Tournament selection of the parents.
+  double selectionTime = 0;
+
+  /// Crossover of the parents, including bloat control of the children.
+  double crossoverTime = 0;
+
+  /// Mutation of the parents, including bloat control of the children.
+  double mutationTime = 0;
+
+  /// Evaluation on the train dataset, including simplification of the
+  /// genotype and constant tuning.
+  double trainEvalTime = 0;
+
+  /// Evaluation on the test dataset.
+  double testEvalTime = 0;
+
+  /// Calculation and aggregation of the statistics, except serialization.
+  double statsTime = 0;
+
+  /// Serialization of the best individuals of the statistics to strings.
+  double serializationTime = 0;
+};
+
+/**
+ * Per-generation heap allocations of each phase of an instance, see
+ * PhaseTimes. Only counted if allocations::enable() was called.
+ */
+struct PhaseAllocations {
+  allocations::Counts init;
+  allocations::Counts selection;
+  allocations::Counts crossover;
+  allocations::Counts mutation;
+  allocations::Counts trainEval;
+  allocations::Counts testEval;
+  allocations::Counts stats;
+  allocations::Counts serialization;
+
+  /// Allocations of all phases, with the biggest peak.
+  allocations::Counts total() const;
+};
+
+/// Logs the allocations of a generation after its statistics.
+void logAllocations(const PhaseAllocations &allocs);
+
+struct Statistics;
+
+/**
+ * Strings that Statistics serialize the best individual into, so an instance
+ * can serialize the best individual of each generation without allocating.
+ */
+struct SerializationBuffers {
+  std::string bestStr;
+  std::string bestExpr;
+
+  /// Takes the strings of stats, which won't be read anymore.
+  void reuse(Statistics &stats);
+};
+
 /**
  * Stores the statistics of each generation.
  */
@@ -78,6 +242,9 @@ struct Statistics {
   /// String representation of the best individual.
   std::string bestStr;
 
+  /// Best individual with exact constants, see serializer::parse().
+  std::string bestExpr;
+
   /// Index of the worst individual in the generation.
   size_t worst;
 
@@ -93,7 +260,11 @@ struct Statistics {
   /// Average individual size.
   size_t avgSize;
 
-  /// Number of repeated individuals in the generation.
+  /// Total number of nodes of the generation.
+  size_t totalSize;
+
+  /// Number of individuals equal to a previous one of the generation, see
+  /// EvaluationMetadata::numRepeated.
   size_t numRepeated;
 
   /// Number of individuals generated by crossover better than their parents.
@@ -108,20 +279,57 @@ struct Statistics {
   /// Number of individuals generated by mutation worse than their parent.
   int numMutWorse;
 
+  /// Number of nodes removed by simplification before evaluation.
+  size_t numSimplifiedNodes;
+
+  /// Number of individuals with a provably constant output.
+  size_t numConstant;
+
+  /// Number of individuals with a provably non-finite output.
+  size_t numNonFinite;
+
+  /// Time spent evaluating the generation, in milliseconds.
+  double evalTime;
+
+  /// Number of individuals that had their fitness copied.
+  size_t numReused;
+
+  /// Number of evaluations of individuals, including constant tuning.
+  size_t numEvaluations;
+
+  /// Time spent serializing the best individual, in milliseconds.
+  double serializationTime;
+
+  /// Allocations made serializing the best individual.
+  allocations::Counts serializationAllocations;
+
+  /// Level the statistics were computed at.
+  repr::StatsLevel level;
+
+  /**
+   * Computes the statistics of the generation and logs them under statsName.
+   * Below StatsLevel::Full, bestStr, bestExpr and the improvement stats
+   * aren't computed, and the stats are logged in a single line (Summary) or
+   * not at all (None).
+   * @param buffers If given, bestStr and bestExpr take their strings.
+   */
   Statistics(const std::string &statsName,
              const std::vector<repr::Node> &population,
              const std::vector<double> &fitnesses,
              const std::vector<size_t> &sizes,
-             const ImprovementMetadata &metadata = {});
+             const ImprovementMetadata &metadata = {},
+             const EvaluationMetadata &evalMetadata = {},
+             repr::StatsLevel level = repr::StatsLevel::Full,
+             SerializationBuffers *buffers = nullptr);
 
 private:
   /// best, worst, avg.
-  void calcFitnessAndSizeStats_(const std::vector<repr::Node> &population,
-                                const std::vector<double> &fitnesses,
+  void calcFitnessAndSizeStats_(const std::vector<double> &fitnesses,
                                 const std::vector<size_t> &sizes);
 
-  /// numRepeated.
-  void calcRepeatedIndividuals_(const std::vector<double> &fitnesses);
+  /// bestStr, bestExpr.
+  void serializeBest_(const std::vector<repr::Node> &population,
+                      SerializationBuffers *buffers);
 
   // num[Crossover/Mutation]Better, num[Crossover/Mutation]Worse.
   void calcImprovementStats_(const std::vector<double> &fitnesses,
@@ -132,14 +340,235 @@ private:
       const std::vector<double> &fitnesses, int &better, int &worse);
 
   void printStats_(const std::string &statsName);
+
+  void printSummary_(const std::string &statsName);
+};
+
+/**
+ * Online mean and standard deviation, computed with Welford's algorithm.
+ * The standard deviation is the population one, as the values pushed are all
+ * the instances that were executed.
+ */
+class RunningMeanStddev {
+public:
+  /// Adds a new value.
+  void push(double value);
+
+  /// Number of values pushed.
+  size_t count() const { return count_; }
+
+  /// Mean of the values pushed.
+  double mean() const { return mean_; }
+
+  /// Standard deviation of the values pushed.
+  double stddev() const;
+
+  /// Adds all the values pushed to other.
+  void merge(const RunningMeanStddev &other);
+
+private:
+  size_t count_ = 0;
+  double mean_ = 0;
+  double m2_ = 0;
+};
+
+/// Allocations of a phase, aggregated for all instances.
+struct AllocationsAggregate {
+  RunningMeanStddev numAllocations;
+  RunningMeanStddev bytes;
+  RunningMeanStddev peakBytes;
+
+  /// Aggregates the allocations of one more instance.
+  void push(const allocations::Counts &counts);
+
+  /// Aggregates all the instances of other.
+  void merge(const AllocationsAggregate &other);
+};
+
+/**
+ * Statistics of a single generation, aggregated for all instances.
+ */
+struct GenerationAggregate {
+  RunningMeanStddev bestFitness;
+  RunningMeanStddev bestSize;
+  RunningMeanStddev worstFitness;
+  RunningMeanStddev worstSize;
+  RunningMeanStddev avgFitness;
+  RunningMeanStddev avgSize;
+  RunningMeanStddev numRepeated;
+  RunningMeanStddev numCrossBetter;
+  RunningMeanStddev numCrossWorse;
+  RunningMeanStddev numMutBetter;
+  RunningMeanStddev numMutWorse;
+  RunningMeanStddev numSimplifiedNodes;
+  RunningMeanStddev numConstant;
+  RunningMeanStddev numNonFinite;
+  RunningMeanStddev totalSize;
+  RunningMeanStddev evalTime;
+  RunningMeanStddev numReused;
+  RunningMeanStddev numEvaluations;
+
+  /// Time spent in each phase, see PhaseTimes.
+  RunningMeanStddev initTime;
+  RunningMeanStddev selectionTime;
+  RunningMeanStddev crossoverTime;
+  RunningMeanStddev mutationTime;
+  RunningMeanStddev trainEvalTime;
+  RunningMeanStddev testEvalTime;
+  RunningMeanStddev statsTime;
+  RunningMeanStddev serializationTime;
+
+  /// Allocations of each phase, see PhaseAllocations.
+  AllocationsAggregate initAllocations;
+  AllocationsAggregate selectionAllocations;
+  AllocationsAggregate crossoverAllocations;
+  AllocationsAggregate mutationAllocations;
+  AllocationsAggregate trainEvalAllocations;
+  AllocationsAggregate testEvalAllocations;
+  AllocationsAggregate statsAllocations;
+  AllocationsAggregate serializationAllocations;
+
+  /// String representation of the best individual across all instances.
+  std::string bestIndividualStr;
+
+  /// Best individual across all instances with exact constants.
+  std::string bestIndividualExpr;
+
+  /// Fitness of the best individual across all instances.
+  double bestIndividualFitness = 0;
+
+  /// Size of the best individual across all instances.
+  size_t bestIndividualSize = 0;
+
+  /// Number of instances aggregated.
+  size_t count() const { return bestFitness.count(); }
+
+  /// Aggregates the statistics of one more instance.
+  void push(const Statistics &stats);
+
+  /// Aggregates the phase times of one more instance.
+  void push(const PhaseTimes &times);
+
+  /// Aggregates the phase allocations of one more instance.
+  void push(const PhaseAllocations &allocs);
+
+  /// Aggregates all the instances of other.
+  void merge(const GenerationAggregate &other);
+};
+
+/**
+ * Aggregates the statistics of all instances as each generation finishes, so
+ * the per-instance history doesn't need to be kept until the end of the
+ * execution. Instances may add their statistics concurrently.
+ */
+class Aggregator {
+public:
+  Aggregator() = default;
+  Aggregator(Aggregator &&other);
+  Aggregator &operator=(Aggregator &&other);
+
+  /**
+   * Adds the statistics of a generation of one of the instances.
+   * @param generation Index of the generation.
+   * @param stats Statistics of the generation.
+   */
+  void add(size_t generation, const Statistics &stats);
+
+  /// Adds the phase times of a generation of one of the instances.
+  void add(size_t generation, const PhaseTimes &times);
+
+  /// Adds the phase allocations of a generation of one of the instances.
+  void add(size_t generation, const PhaseAllocations &allocs);
+
+  /// Number of generations that were added (including any gaps).
+  size_t numGenerations() const;
+
+  /**
+   * Adds all the instances of other, which must not be changing. Used to
+   * pool instances run on different data, like the folds of k-fold
+   * cross-validation.
+   */
+  void merge(const Aggregator &other);
+
+  /**
+   * Adds the statistics of the last generation of one of the instances,
+   * which may differ between instances if they stopped early.
+   */
+  void addFinal(const Statistics &stats);
+
+  /// Statistics of the last generation of each instance. Not thread-safe.
+  const GenerationAggregate &finalStats() const { return finalStats_; }
+
+  /**
+   * Adds an instance that finished.
+   * @param numGenerations Number of generations it ran, including the first.
+   * @param stoppedEarly If it stopped before params.numGenerations.
+   */
+  void addInstance(size_t numGenerations, bool stoppedEarly);
+
+  /// Generations run by each instance added. Not thread-safe.
+  const RunningMeanStddev &generationsRun() const { return generationsRun_; }
+
+  /// Number of instances added that stopped early. Not thread-safe.
+  size_t numStoppedEarly() const { return numStoppedEarly_; }
+
+  /**
+   * Adds the number of evaluations an instance needed to reach the target
+   * fitness.
+   */
+  void addEvaluationsToTarget(size_t numEvaluations);
+
+  /// Evaluations needed to reach the target fitness, for the instances that
+  /// reached it. Not thread-safe.
+  const RunningMeanStddev &evaluationsToTarget() const {
+    return evaluationsToTarget_;
+  }
+
+  /// Returns the aggregate of the given generation. Not thread-safe.
+  const GenerationAggregate &generation(size_t i) const {
+    return generations_[i];
+  }
+
+private:
+  /// Pushes value to the aggregate of the generation.
+  template <typename T> void push_(size_t generation, const T &value);
+
+  mutable std::mutex mutex_;
+  std::vector<GenerationAggregate> generations_;
+  GenerationAggregate finalStats_;
+  RunningMeanStddev evaluationsToTarget_;
+  RunningMeanStddev generationsRun_;
+  size_t numStoppedEarly_ = 0;
+};
+
+/// Aggregated statistics of one fold of k-fold cross-validation.
+struct FoldStats {
+  Aggregator train;
+
+  /// Statistics on the rows held out of the fold.
+  Aggregator test;
+
+  /// Number of rows the fold was trained on.
+  size_t numTrainRows = 0;
+
+  /// Number of rows the fold was tested on.
+  size_t numTestRows = 0;
 };
 
 /**
  * Salves the execution results to the file specified in params.
+ * @param params Genetic programming params.
+ * @param trainAggregator Aggregated train statistics of all generations.
+ * @param testAggregator Aggregated test statistics. Only the final statistics
+ *   are required if params.alwaysTest is not set.
+ * @param folds Statistics of each fold with k-fold cross-validation, which
+ *   the aggregators merge.
+ * The phase times and allocations are saved from the train aggregator, and
+ * the performance counters from counters::regions().
  */
-void saveResults(const repr::Params &params,
-                 const std::vector<std::vector<Statistics>> &allTrainStats,
-                 const std::vector<std::vector<Statistics>> &allTestStats);
+void saveResults(const repr::Params &params, const Aggregator &trainAggregator,
+                 const Aggregator &testAggregator,
+                 const std::vector<FoldStats> &folds = {});
 
 } // namespace stats
 
@@ -17,16 +17,22 @@
 #include "statistics.hpp"
 
 #include <random>
+#include <thread>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include "compnat/common/allocations.hpp"
+#include "compnat/common/numa.hpp"
 #include "generators.hpp"
 #include "parser.hpp"
 #include "primitives.hpp"
 #include "representation.hpp"
+#include "serializer.hpp"
 
 namespace {
+using stats::Aggregator;
+using stats::RunningMeanStddev;
 using stats::Statistics;
 using testing::ElementsAre;
 
@@ -69,6 +75,89 @@ TEST(FitnessTest, WorksCorrectly) {
   EXPECT_FLOAT_EQ(4.7434163, fitness[2]);
 }
 
+TEST(FitnessTest, ViewsScoreTheirRows) {
+  const auto &population = generatePopulation();
+  const repr::Dataset dataset = {
+      {{12, 2}, 15}, {{15, 4}, 21}, {{3, 1}, 2}, {{7, 5}, 10}};
+  const repr::Dataset rows = {{{12, 2}, 15}, {{7, 5}, 10}};
+
+  const repr::DatasetView view(dataset, {{0, 1}, {3, 4}});
+  const auto &fitness = stats::fitness(population, view);
+  const auto &expected = stats::fitness(population, rows);
+  ASSERT_EQ(expected.size(), fitness.size());
+  for (size_t i = 0; i < fitness.size(); ++i) {
+    EXPECT_DOUBLE_EQ(expected[i], fitness[i]);
+  }
+}
+
+TEST(FitnessTest, ViewsAreConstantWithTheSameValueInAllSlices) {
+  const std::vector<repr::Node> population = {serializer::parse("x0"),
+                                              serializer::parse("(x1 * 2)")};
+  const repr::Dataset dataset = {
+      {{1, 3}, 2}, {{1, 3}, 4}, {{2, 3}, 6}, {{2, 3}, 8}};
+
+  // x0 is constant in each slice, but with different values.
+  const repr::DatasetView view(dataset, {{0, 2}, {2, 4}});
+  stats::EvaluationMetadata metadata;
+  stats::fitness(population, view, &metadata);
+  EXPECT_EQ((size_t)1, metadata.numConstant);
+}
+
+TEST(FitnessTest, CountsConstantIndividualsOfThePopulation) {
+  std::vector<repr::Node> population = {serializer::parse("(1 + 2)"),
+                                        serializer::parse("3"),
+                                        serializer::parse("x0")};
+  const repr::Dataset dataset = {{{1}, 2}, {{2}, 4}};
+
+  // Repeated and cached individuals count too.
+  stats::FitnessCache cache;
+  stats::EvaluationMetadata metadata;
+  stats::fitness(population, dataset, &metadata, &cache);
+  EXPECT_EQ((size_t)1, metadata.numReused);
+  EXPECT_EQ((size_t)2, metadata.numConstant);
+  stats::fitness(population, dataset, &metadata, &cache);
+  EXPECT_EQ((size_t)3, metadata.numReused);
+  EXPECT_EQ((size_t)2, metadata.numConstant);
+}
+
+TEST(FitnessTest, CountsRepeatedSimplifiedIndividuals) {
+  const std::vector<repr::Node> population = {
+      serializer::parse("(x0 + x1)"), serializer::parse("(x1 + x0)"),
+      serializer::parse("((x1 + 0) + x0)"), serializer::parse("(x0 * x1)")};
+  const repr::Dataset dataset = {{{1, 2}, 3}, {{2, 3}, 5}};
+
+  // Individuals repeated in the cache aren't repeated in the population.
+  stats::FitnessCache cache;
+  stats::EvaluationMetadata metadata;
+  const auto &fitnesses = stats::fitness(population, dataset, &metadata);
+  stats::fitness(population, dataset, &metadata, &cache);
+  stats::fitness(population, dataset, &metadata, &cache);
+  EXPECT_EQ((size_t)2, metadata.numRepeated);
+  EXPECT_EQ((size_t)4, metadata.numReused);
+
+  const Statistics statistics("Test", population, fitnesses,
+                              stats::sizes(population), {}, metadata);
+  EXPECT_EQ((size_t)2, statistics.numRepeated);
+}
+
+TEST(FitnessTest, ReadsLocalReplicas) {
+  const auto &population = generatePopulation();
+  const repr::Dataset dataset = {
+      {{12, 2}, 15}, {{15, 4}, 21}, {{3, 1}, 2}, {{7, 5}, 10}};
+  const auto &expected = stats::fitness(population, dataset);
+
+  numa::resetAccesses();
+  const auto &fitness = stats::fitness(population, dataset.replicate());
+  ASSERT_EQ(expected.size(), fitness.size());
+  for (size_t i = 0; i < fitness.size(); ++i) {
+    EXPECT_DOUBLE_EQ(expected[i], fitness[i]);
+  }
+
+  const auto &accesses = numa::accesses();
+  EXPECT_EQ(population.size() * dataset.sizeInBytes(), accesses.localBytes);
+  EXPECT_EQ((uint64_t)0, accesses.remoteBytes);
+}
+
 TEST(FitnessTest, GeneratesExpectedValue) {
   repr::RNG rng;
 
@@ -80,6 +169,84 @@ TEST(FitnessTest, GeneratesExpectedValue) {
   EXPECT_FLOAT_EQ(0.089933448, fitness);
 }
 
+TEST(FitnessTest, AgreesWithDoublePrecision) {
+  // Fitnesses computed with double as repr::T. Builds with float (see
+  // COMPNAT_TP1_FLOAT32) must agree with them.
+  const std::vector<std::pair<std::string, std::vector<double>>> expected = {
+      {"keijzer-7-train", {0.0983508111, 3.042899827, 2.991997438}},
+      {"keijzer-7-test", {1.540121919, 1.385903795, 1.977992788}},
+      {"keijzer-10-train", {0.4431372473, 0.6159318152, 0.08791997858}},
+      {"keijzer-10-test", {0.442036419, 0.6156668593, 0.08993344571}},
+  };
+
+  repr::RNG rng;
+  // ln(x0 + 1) = log2(x0 + 1) * ln(2).
+  repr::Node ln(primitives::multFn(rng));
+  ln.setChild(0, repr::Node(primitives::logFn(rng)));
+  ln.mutableChild(0).setChild(0, repr::Node(primitives::sumFn(rng)));
+  ln.mutableChild(0).mutableChild(0).setChild(
+      0, primitives::makeVarTerm(0)(rng));
+  ln.mutableChild(0).mutableChild(0).setChild(
+      1, primitives::literalTerm(1)(rng));
+  ln.setChild(1, primitives::literalTerm(0.69314718)(rng));
+
+  // (x0 / (x0 + 0.5)) - 0.25.
+  repr::Node ratio(primitives::subFn(rng));
+  ratio.setChild(0, repr::Node(primitives::divFn(rng)));
+  ratio.mutableChild(0).setChild(0, primitives::makeVarTerm(0)(rng));
+  ratio.mutableChild(0).setChild(1, repr::Node(primitives::sumFn(rng)));
+  ratio.mutableChild(0).mutableChild(1).setChild(
+      0, primitives::makeVarTerm(0)(rng));
+  ratio.mutableChild(0).mutableChild(1).setChild(
+      1, primitives::literalTerm(0.5)(rng));
+  ratio.setChild(1, primitives::literalTerm(0.25)(rng));
+
+  const std::vector<repr::Node> population = {
+      ln, ratio, repr::Node(primitives::literalTerm(0.791453)(rng))};
+
+  for (const auto & [ name, fitnesses ] : expected) {
+    const auto &dataset =
+        parser::loadDataset("compnat/tp1/datasets/" + name + ".csv");
+    const auto &fitness = stats::fitness(population, dataset);
+    ASSERT_EQ(fitnesses.size(), fitness.size());
+    for (size_t i = 0; i < fitness.size(); ++i) {
+      EXPECT_NEAR(fitnesses[i], fitness[i], 1e-5 * (1 + fitnesses[i]))
+          << name << ", individual " << i;
+    }
+  }
+}
+
+TEST(FitnessTest, ReusesFitnessOfEqualIndividuals) {
+  auto population = generatePopulation();
+  population.push_back(population[0]);
+  population.push_back(population[2]);
+  const repr::Dataset dataset = {
+      {{12, 2}, 15},
+      {{15, 4}, 21},
+  };
+
+  stats::FitnessCache cache;
+  stats::EvaluationMetadata metadata;
+  const auto fitness = stats::fitness(population, dataset, &metadata, &cache);
+  ASSERT_EQ((size_t)5, fitness.size());
+  EXPECT_EQ(fitness[0], fitness[3]);
+  EXPECT_EQ(fitness[2], fitness[4]);
+  EXPECT_FLOAT_EQ(1.5811388, fitness[3]);
+  EXPECT_EQ((size_t)2, metadata.numReused);
+  EXPECT_EQ((size_t)3, cache.size());
+
+  // Individuals of the previous population are copied from the cache.
+  repr::RNG rng(0);
+  population[1] = repr::Node(primitives::makeVarTerm(1)(rng));
+  const auto next = stats::fitness(population, dataset, &metadata, &cache);
+  EXPECT_EQ(fitness[0], next[0]);
+  EXPECT_FLOAT_EQ(15.132746, next[1]);
+  EXPECT_EQ((size_t)4, metadata.numReused);
+  EXPECT_EQ(stats::fitness(population, dataset), next);
+
+  EXPECT_EQ((size_t)2, metadata.numRepeated);
+}
+
 TEST(SizesTest, WorksCorrectly) {
   const auto &population = generatePopulation();
 
@@ -120,4 +287,230 @@ TEST(StatisticsTest, SingleGenerationPerformanceBenchmark) {
   EXPECT_EQ((size_t)600, sizes.size());
 }
 
+TEST(StatisticsTest, ReusesTheSerializationBuffers) {
+  const std::vector<repr::Node> population = {
+      serializer::parse("((x0 + 1.25) * (x1 - 0.5))"),
+      serializer::parse("(x0 * x1)")};
+  const std::vector<double> fitnesses = {1, 2};
+  const auto &sizes = stats::sizes(population);
+  stats::SerializationBuffers buffers;
+  Statistics first("first", population, fitnesses, sizes, {}, {},
+                   repr::StatsLevel::Full, &buffers);
+  const std::string bestStr = first.bestStr;
+  buffers.reuse(first);
+
+  allocations::enable();
+  const Statistics second("second", population, fitnesses, sizes, {}, {},
+                          repr::StatsLevel::Full, &buffers);
+  EXPECT_EQ((size_t)0, second.serializationAllocations.numAllocations);
+  EXPECT_EQ(bestStr, second.bestStr);
+  EXPECT_EQ(bestStr, serializer::str(serializer::parse(second.bestExpr)));
+}
+
+TEST(StatisticsTest, LevelsSkipTheFullStats) {
+  const auto &population = generatePopulation();
+  const std::vector<double> fitnesses = {2, 3, 1};
+  const std::vector<size_t> sizes = {3, 2, 1};
+  stats::ImprovementMetadata metadata;
+  metadata.mutationParentFitness = {{0, 1.5}};
+
+  for (const auto level : {repr::StatsLevel::None, repr::StatsLevel::Summary,
+                           repr::StatsLevel::Full}) {
+    const Statistics stats("train", population, fitnesses, sizes, metadata, {},
+                           level);
+    EXPECT_EQ((size_t)2, stats.best);
+    EXPECT_DOUBLE_EQ(1, stats.bestFitness);
+    EXPECT_EQ((size_t)1, stats.bestSize);
+    EXPECT_EQ((size_t)1, stats.worst);
+    EXPECT_DOUBLE_EQ(3, stats.worstFitness);
+    EXPECT_DOUBLE_EQ(2, stats.avgFitness);
+    EXPECT_EQ((size_t)6, stats.totalSize);
+
+    const bool full = level == repr::StatsLevel::Full;
+    EXPECT_EQ(full, !stats.bestStr.empty());
+    EXPECT_EQ(full, !stats.bestExpr.empty());
+    EXPECT_EQ(full ? 1 : -1, stats.numMutWorse);
+  }
+}
+
+TEST(RunningMeanStddevTest, WorksCorrectly) {
+  RunningMeanStddev value;
+  for (double x : {2, 4, 4, 4, 5, 5, 7, 9}) {
+    value.push(x);
+  }
+
+  EXPECT_EQ((size_t)8, value.count());
+  EXPECT_DOUBLE_EQ(5, value.mean());
+  EXPECT_DOUBLE_EQ(2, value.stddev());
+}
+
+TEST(RunningMeanStddevTest, EmptyIsZero) {
+  RunningMeanStddev value;
+  EXPECT_EQ((size_t)0, value.count());
+  EXPECT_DOUBLE_EQ(0, value.mean());
+  EXPECT_DOUBLE_EQ(0, value.stddev());
+}
+
+TEST(RunningMeanStddevTest, MergesLikePushes) {
+  RunningMeanStddev first, second, all;
+  for (double x : {2, 4, 4}) {
+    first.push(x);
+    all.push(x);
+  }
+  for (double x : {4, 5, 5, 7, 9}) {
+    second.push(x);
+    all.push(x);
+  }
+
+  first.merge(second);
+  EXPECT_EQ(all.count(), first.count());
+  EXPECT_DOUBLE_EQ(all.mean(), first.mean());
+  EXPECT_DOUBLE_EQ(all.stddev(), first.stddev());
+
+  first.merge(RunningMeanStddev());
+  EXPECT_DOUBLE_EQ(5, first.mean());
+}
+
+TEST(AggregatorTest, AggregatesInstances) {
+  const auto &population = generatePopulation();
+  const auto &sizes = stats::sizes(population);
+  const Statistics first("train", population, {3, 2, 5}, sizes);
+  const Statistics second("train", population, {4, 1, 1}, sizes);
+
+  Aggregator aggregator;
+  aggregator.add(0, first);
+  aggregator.add(0, second);
+  aggregator.add(2, first);
+  ASSERT_EQ((size_t)3, aggregator.numGenerations());
+  EXPECT_EQ((size_t)0, aggregator.generation(1).count());
+  EXPECT_EQ((size_t)1, aggregator.generation(2).count());
+
+  const auto &generation = aggregator.generation(0);
+  EXPECT_EQ((size_t)2, generation.count());
+  EXPECT_DOUBLE_EQ(1.5, generation.bestFitness.mean());
+  EXPECT_DOUBLE_EQ(0.5, generation.bestFitness.stddev());
+  EXPECT_DOUBLE_EQ(4.5, generation.worstFitness.mean());
+  EXPECT_DOUBLE_EQ(2, generation.bestSize.mean());
+  EXPECT_DOUBLE_EQ(1, generation.bestIndividualFitness);
+  EXPECT_EQ((size_t)2, generation.bestIndividualSize);
+  EXPECT_EQ(population[1].str(), generation.bestIndividualStr);
+}
+
+TEST(AggregatorTest, OnlyAggregatesTheStatsOfTheLevel) {
+  const auto &population = generatePopulation();
+  const auto &sizes = stats::sizes(population);
+  const Statistics summary("train", population, {3, 2, 5}, sizes, {}, {},
+                           repr::StatsLevel::Summary);
+  const Statistics full("train", population, {4, 1, 1}, sizes);
+
+  Aggregator aggregator;
+  aggregator.add(0, summary);
+  aggregator.add(0, full);
+  const auto &generation = aggregator.generation(0);
+  EXPECT_EQ((size_t)2, generation.count());
+  EXPECT_EQ((size_t)2, generation.numRepeated.count());
+  EXPECT_EQ((size_t)1, generation.numCrossBetter.count());
+  EXPECT_DOUBLE_EQ(-1, generation.numMutBetter.mean());
+}
+
+TEST(AggregatorTest, AggregatesPhaseTimes) {
+  stats::PhaseTimes first, second;
+  first.initTime = 4;
+  first.trainEvalTime = 10;
+  second.trainEvalTime = 20;
+  second.serializationTime = 1;
+
+  Aggregator aggregator;
+  aggregator.add(1, first);
+  aggregator.add(1, second);
+  ASSERT_EQ((size_t)2, aggregator.numGenerations());
+
+  const auto &generation = aggregator.generation(1);
+  EXPECT_DOUBLE_EQ(2, generation.initTime.mean());
+  EXPECT_DOUBLE_EQ(15, generation.trainEvalTime.mean());
+  EXPECT_DOUBLE_EQ(5, generation.trainEvalTime.stddev());
+  EXPECT_DOUBLE_EQ(0.5, generation.serializationTime.mean());
+  EXPECT_DOUBLE_EQ(0, generation.selectionTime.mean());
+  EXPECT_EQ((size_t)2, generation.statsTime.count());
+}
+
+TEST(AggregatorTest, AggregatesPhaseAllocations) {
+  stats::PhaseAllocations first, second;
+  first.crossover.numAllocations = 10;
+  first.crossover.bytes = 1000;
+  first.trainEval.peakBytes = 500;
+  second.crossover.numAllocations = 30;
+  second.crossover.bytes = 3000;
+  second.mutation.peakBytes = 700;
+
+  const auto &total = first.total();
+  EXPECT_EQ((size_t)10, total.numAllocations);
+  EXPECT_EQ((size_t)1000, total.bytes);
+  EXPECT_EQ((size_t)500, total.peakBytes);
+
+  Aggregator aggregator;
+  aggregator.add(0, first);
+  aggregator.add(0, second);
+  ASSERT_EQ((size_t)1, aggregator.numGenerations());
+
+  const auto &generation = aggregator.generation(0);
+  EXPECT_DOUBLE_EQ(20, generation.crossoverAllocations.numAllocations.mean());
+  EXPECT_DOUBLE_EQ(10,
+                   generation.crossoverAllocations.numAllocations.stddev());
+  EXPECT_DOUBLE_EQ(2000, generation.crossoverAllocations.bytes.mean());
+  EXPECT_DOUBLE_EQ(250, generation.trainEvalAllocations.peakBytes.mean());
+  EXPECT_DOUBLE_EQ(350, generation.mutationAllocations.peakBytes.mean());
+  EXPECT_EQ((size_t)2, generation.initAllocations.bytes.count());
+}
+
+TEST(AggregatorTest, MergesAggregators) {
+  const auto &population = generatePopulation();
+  const auto &sizes = stats::sizes(population);
+  const Statistics first("train", population, {3, 2, 5}, sizes);
+  const Statistics second("train", population, {4, 1, 1}, sizes);
+
+  Aggregator aggregator, other;
+  aggregator.add(0, first);
+  other.add(0, second);
+  other.add(1, first);
+  aggregator.addInstance(1, false);
+  other.addInstance(2, true);
+  aggregator.merge(other);
+
+  ASSERT_EQ((size_t)2, aggregator.numGenerations());
+  EXPECT_EQ((size_t)2, aggregator.generation(0).count());
+  EXPECT_DOUBLE_EQ(1.5, aggregator.generation(0).bestFitness.mean());
+  EXPECT_DOUBLE_EQ(1, aggregator.generation(0).bestIndividualFitness);
+  EXPECT_EQ(population[1].str(), aggregator.generation(0).bestIndividualStr);
+  EXPECT_EQ((size_t)1, aggregator.generation(1).count());
+  EXPECT_DOUBLE_EQ(1.5, aggregator.generationsRun().mean());
+  EXPECT_EQ((size_t)1, aggregator.numStoppedEarly());
+}
+
+TEST(AggregatorTest, ConcurrentInstances) {
+  const auto &population = generatePopulation();
+  const auto &sizes = stats::sizes(population);
+  const Statistics stats("train", population, {3, 2, 5}, sizes);
+
+  Aggregator aggregator;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < 4; ++i) {
+    threads.emplace_back([&]() {
+      for (size_t generation = 0; generation < 100; ++generation) {
+        aggregator.add(generation, stats);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ((size_t)100, aggregator.numGenerations());
+  for (size_t i = 0; i < aggregator.numGenerations(); ++i) {
+    EXPECT_EQ((size_t)4, aggregator.generation(i).count());
+    EXPECT_DOUBLE_EQ(2, aggregator.generation(i).bestFitness.mean());
+    EXPECT_DOUBLE_EQ(0, aggregator.generation(i).bestFitness.stddev());
+  }
+}
+
 } // namespace
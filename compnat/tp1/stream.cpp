@@ -0,0 +1,245 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stream.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "glog/logging.h"
+
+namespace stream {
+namespace {
+
+/// Size of each read from CSV files.
+const size_t CsvBlockSize = 1 << 20;
+
+bool isBlank_(const char *begin, const char *end) {
+  return std::all_of(begin, end,
+                     [](char c) { return c == ' ' || c == '\t' || c == '\r'; });
+}
+
+/// Number of values of each sample of a CSV dataset, from its first line.
+size_t csvNumValues_(const std::string &filename) {
+  std::ifstream in(filename);
+  CHECK(in.is_open()) << "Failed to open " << filename;
+
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!isBlank_(line.data(), line.data() + line.size())) {
+      return std::count(line.begin(), line.end(), ',') + 1;
+    }
+  }
+  return 0;
+}
+
+void readAt_(int fd, char *buffer, size_t size, size_t offset,
+             const std::string &filename) {
+  while (size) {
+    const ssize_t numRead = pread(fd, buffer, size, offset);
+    CHECK(numRead > 0) << "Failed to read " << filename;
+    buffer += numRead;
+    offset += numRead;
+    size -= numRead;
+  }
+}
+
+} // namespace
+
+DatasetStream::DatasetStream(const std::string &filename, size_t maxMemory,
+                             bool verifyChecksum)
+    : filename_(filename), fd_(open(filename.c_str(), O_RDONLY)),
+      binary_(false), numInputs_(0), chunkRows_(0), nextRow_(0),
+      maxPending_(0), numLinesRead_(0), eof_(false) {
+  CHECK(fd_ >= 0) << "Failed to open " << filename;
+
+  // Two chunks are kept in memory, and CSV files also need their text.
+  size_t rowBytes = 0;
+  binary_ = parser::isBinaryDataset(filename);
+  if (binary_) {
+    info_ = parser::readBinaryDatasetInfo(filename);
+    numInputs_ = info_.numInputs;
+    rowBytes = 2 * (numInputs_ + 1) * sizeof(repr::T);
+  } else {
+    const size_t numValues = csvNumValues_(filename);
+    CHECK(numValues >= 2) << filename << ": samples need at least one input";
+    numInputs_ = numValues - 1;
+    rowBytes = 3 * numValues * sizeof(repr::T);
+    maxMemory = maxMemory > CsvBlockSize ? maxMemory - CsvBlockSize : 0;
+  }
+
+  chunkRows_ = std::max<size_t>(1, maxMemory / rowBytes);
+  if (binary_ && verifyChecksum) {
+    verifyChecksum_();
+  } else if (!binary_) {
+    // The text of a chunk gets the memory of one of its values per value,
+    // plus the read buffer.
+    maxPending_ =
+        chunkRows_ * (numInputs_ + 1) * sizeof(repr::T) + CsvBlockSize;
+    pending_.reserve(maxPending_);
+  }
+  LOG(INFO) << "Streaming " << filename << " in chunks of " << chunkRows_
+            << " rows";
+}
+
+DatasetStream::~DatasetStream() { close(fd_); }
+
+size_t DatasetStream::forEachChunk(
+    const std::function<void(const repr::Dataset &)> &fn) {
+  rewind_();
+
+  size_t numRows = 0;
+  auto next = std::async(std::launch::async, [this] { return readChunk_(); });
+  while (true) {
+    const auto chunk = next.get();
+    if (chunk.empty()) {
+      break;
+    }
+
+    next = std::async(std::launch::async, [this] { return readChunk_(); });
+    fn(chunk);
+    numRows += chunk.size();
+  }
+
+  return numRows;
+}
+
+void DatasetStream::rewind_() {
+  CHECK(lseek(fd_, 0, SEEK_SET) == 0) << "Failed to rewind " << filename_;
+  nextRow_ = 0;
+  pending_.clear();
+  numLinesRead_ = 0;
+  eof_ = false;
+}
+
+void DatasetStream::verifyChecksum_() {
+  const size_t dataSize = info_.columnStride * (numInputs_ + 1);
+  std::vector<char> block(std::min(dataSize, CsvBlockSize));
+  uint64_t checksum = parser::EmptyBinaryChecksum;
+  for (size_t offset = 0; offset < dataSize; offset += block.size()) {
+    const size_t size = std::min(block.size(), dataSize - offset);
+    readAt_(fd_, block.data(), size, info_.dataOffset + offset, filename_);
+    checksum = parser::binaryChecksum(block.data(), size, checksum);
+  }
+  CHECK(checksum == info_.checksum)
+      << filename_ << ": checksum mismatch, the dataset is corrupted";
+}
+
+repr::Dataset DatasetStream::readChunk_() {
+  return binary_ ? readBinaryChunk_() : readCsvChunk_();
+}
+
+repr::Dataset DatasetStream::readBinaryChunk_() {
+  const size_t numRows = std::min(chunkRows_, info_.numRows - nextRow_);
+  if (!numRows) {
+    return {};
+  }
+
+  repr::Dataset chunk(numRows, numInputs_);
+  std::vector<char> buffer;
+  for (size_t i = 0; i <= numInputs_; ++i) {
+    const size_t offset = info_.dataOffset + i * info_.columnStride +
+                          nextRow_ * info_.valueSize;
+    repr::T *column = chunk.mutableColumn(i);
+    if (info_.valueSize == sizeof(repr::T)) {
+      readAt_(fd_, (char *)column, numRows * sizeof(repr::T), offset,
+              filename_);
+      continue;
+    }
+
+    buffer.resize(numRows * info_.valueSize);
+    readAt_(fd_, buffer.data(), buffer.size(), offset, filename_);
+    for (size_t j = 0; j < numRows; ++j) {
+      if (info_.valueSize == sizeof(float)) {
+        float value;
+        std::memcpy(&value, buffer.data() + j * sizeof(value), sizeof(value));
+        column[j] = value;
+      } else {
+        double value;
+        std::memcpy(&value, buffer.data() + j * sizeof(value), sizeof(value));
+        column[j] = value;
+      }
+    }
+  }
+
+  nextRow_ += numRows;
+  chunk.summarize();
+  return chunk;
+}
+
+repr::Dataset DatasetStream::readCsvChunk_() {
+  // Finds where the chunkRows_-th sample ends, reading more data as needed.
+  size_t numRows = 0, numLines = 0, end = 0;
+  while (numRows < chunkRows_) {
+    const size_t newline = pending_.find('\n', end);
+    if (newline == std::string::npos) {
+      if (eof_) {
+        if (end < pending_.size()) {
+          numRows += !isBlank_(pending_.data() + end, pending_.data() +
+                                                          pending_.size());
+          ++numLines;
+          end = pending_.size();
+        }
+        break;
+      }
+
+      if (pending_.size() == maxPending_) {
+        if (numRows) {
+          // The rest of the chunk doesn't fit, it goes to the next one.
+          break;
+        }
+        CHECK(end) << filename_ << ": line " << numLinesRead_ + 1
+                   << " is longer than the " << maxPending_
+                   << " bytes of text the stream memory allows";
+
+        // Only blank lines were found, they can be dropped.
+        pending_.erase(0, end);
+        numLinesRead_ += numLines;
+        numLines = end = 0;
+      }
+
+      const size_t size = pending_.size();
+      const size_t blockSize = std::min(CsvBlockSize, maxPending_ - size);
+      pending_.resize(size + blockSize);
+      const ssize_t numRead = read(fd_, &pending_[size], blockSize);
+      CHECK(numRead >= 0) << "Failed to read " << filename_;
+      pending_.resize(size + numRead);
+      eof_ = numRead == 0;
+      continue;
+    }
+
+    numRows += !isBlank_(pending_.data() + end, pending_.data() + newline);
+    ++numLines;
+    end = newline + 1;
+  }
+
+  auto chunk =
+      parser::parseDataset(pending_.data(), end, filename_, numLinesRead_);
+  CHECK(chunk.empty() || chunk.numInputs() == numInputs_)
+      << filename_ << ": samples after line " << numLinesRead_
+      << " have a different number of values";
+  pending_.erase(0, end);
+  numLinesRead_ += numLines;
+  return chunk;
+}
+
+} // namespace stream
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPNAT_TP1_STREAM_HPP
+#define COMPNAT_TP1_STREAM_HPP
+
+#include <functional>
+#include <string>
+
+#include "parser.hpp"
+#include "representation.hpp"
+
+namespace stream {
+
+/**
+ * Reads a CSV or binary dataset from disk in chunks of rows, so datasets
+ * bigger than the memory can be used.
+ * While a chunk is being used, the next one is read asynchronously (double
+ * buffering), so at most two chunks are in memory at any time. Not
+ * thread-safe, each pass over the dataset must finish before the next one.
+ */
+class DatasetStream {
+public:
+  /**
+   * Opens the dataset for streaming.
+   * @param filename CSV or binary (.cnatds) dataset.
+   * @param maxMemory Maximum memory in bytes used by the chunks being read
+   *   and, for CSV files, by their text.
+   * @param verifyChecksum If the checksum of binary datasets should be
+   *   verified, with a pass over the file when it is opened.
+   */
+  DatasetStream(const std::string &filename, size_t maxMemory,
+                bool verifyChecksum = true);
+  ~DatasetStream();
+
+  DatasetStream(const DatasetStream &) = delete;
+  DatasetStream &operator=(const DatasetStream &) = delete;
+
+  /// Number of input variables of each sample.
+  size_t numInputs() const { return numInputs_; }
+
+  /**
+   * Maximum number of rows of each chunk. The last chunk may be smaller, and
+   * so may CSV chunks whose text doesn't fit in the memory given to it.
+   */
+  size_t chunkRows() const { return chunkRows_; }
+
+  /**
+   * Passes through the whole dataset, calling fn for each chunk in order.
+   * @return The number of samples in the dataset.
+   */
+  size_t forEachChunk(const std::function<void(const repr::Dataset &)> &fn);
+
+private:
+  /// Starts a new pass from the beginning of the file.
+  void rewind_();
+
+  /// Reads the whole binary dataset in blocks, checking its checksum.
+  void verifyChecksum_();
+
+  /// Reads the next chunk. Empty if the end of the file was reached.
+  repr::Dataset readChunk_();
+  repr::Dataset readBinaryChunk_();
+  repr::Dataset readCsvChunk_();
+
+  std::string filename_;
+  int fd_;
+  bool binary_;
+  parser::BinaryDatasetInfo info_;
+  size_t numInputs_;
+  size_t chunkRows_;
+
+  /// Next row to be read from binary datasets.
+  size_t nextRow_;
+
+  /// CSV data read but not parsed yet and number of lines already parsed.
+  /// pending_ never grows past maxPending_ bytes.
+  std::string pending_;
+  size_t maxPending_;
+  size_t numLinesRead_;
+  bool eof_;
+};
+
+} // namespace stream
+
+#endif // !COMPNAT_TP1_STREAM_HPP
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stream.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "parser.hpp"
+#include "primitives.hpp"
+#include "statistics.hpp"
+
+namespace {
+using stream::DatasetStream;
+
+const char *KeijzerTrain = "compnat/tp1/datasets/keijzer-10-train.csv";
+
+/// Streams the whole dataset and checks it matches the one in memory.
+void expectStreamsDataset(DatasetStream &stream, const repr::Dataset &dataset,
+                          size_t expectedChunks) {
+  size_t row = 0, numChunks = 0;
+  const size_t numRows = stream.forEachChunk([&](const auto &chunk) {
+    ASSERT_EQ(dataset.numInputs(), chunk.numInputs());
+    ASSERT_LE(chunk.size(), stream.chunkRows());
+    for (size_t i = 0; i < chunk.size(); ++i, ++row) {
+      EXPECT_EQ(dataset[row], chunk[i]);
+    }
+    ++numChunks;
+  });
+
+  EXPECT_EQ(dataset.size(), numRows);
+  EXPECT_EQ(dataset.size(), row);
+  EXPECT_EQ(expectedChunks, numChunks);
+}
+
+TEST(DatasetStreamTest, StreamsCsv) {
+  const auto &dataset = parser::loadDataset(KeijzerTrain);
+
+  // The CSV read buffer plus 8 rows of 3 values for 2 chunks and the text.
+  DatasetStream stream(KeijzerTrain, (1 << 20) + 8 * 3 * 3 * sizeof(repr::T));
+  EXPECT_EQ((size_t)2, stream.numInputs());
+  EXPECT_EQ((size_t)8, stream.chunkRows());
+
+  expectStreamsDataset(stream, dataset, 13);
+  // The stream can be used again.
+  expectStreamsDataset(stream, dataset, 13);
+}
+
+TEST(DatasetStreamTest, StreamsBinary) {
+  const auto &dataset = parser::loadDataset(KeijzerTrain);
+  const auto filename = testing::TempDir() + "/stream.cnatds";
+  parser::saveBinaryDataset(dataset, filename);
+
+  DatasetStream stream(filename, 30 * 2 * 3 * sizeof(repr::T));
+  EXPECT_EQ((size_t)2, stream.numInputs());
+  EXPECT_EQ((size_t)30, stream.chunkRows());
+
+  expectStreamsDataset(stream, dataset, 4);
+}
+
+TEST(DatasetStreamTest, SplitsChunksWithLongLines) {
+  // Each line has 300 KiB of text, so only 3 rows fit in the text memory of
+  // a chunk of 4 rows, which is 4 rows of 2 values plus the read buffer.
+  const auto filename = testing::TempDir() + "/long_lines.csv";
+  {
+    std::ofstream out(filename);
+    for (int i = 0; i < 10; ++i) {
+      out << std::string(300 << 10, ' ') << i << "," << i * 2 << "\n";
+    }
+  }
+  const auto &dataset = parser::loadDataset(filename);
+
+  DatasetStream stream(filename, (1 << 20) + 4 * 2 * 3 * sizeof(repr::T));
+  EXPECT_EQ((size_t)4, stream.chunkRows());
+  expectStreamsDataset(stream, dataset, 4);
+}
+
+TEST(DatasetStreamDeathTest, RejectsLinesBiggerThanTheMemory) {
+  const auto filename = testing::TempDir() + "/huge_line.csv";
+  {
+    std::ofstream out(filename);
+    out << "1,2\n" << std::string(2 << 20, '1') << ",2\n";
+  }
+
+  DatasetStream stream(filename, (1 << 20) + 4 * 2 * 3 * sizeof(repr::T));
+  EXPECT_DEATH(stream.forEachChunk([](const auto &) {}),
+               "line 2 is longer than");
+}
+
+TEST(DatasetStreamDeathTest, VerifiesBinaryChecksum) {
+  const auto filename = testing::TempDir() + "/stream_corrupted.cnatds";
+  parser::saveBinaryDataset(parser::loadDataset(KeijzerTrain), filename);
+  {
+    std::fstream file(filename, std::fstream::in | std::fstream::out |
+                                    std::fstream::binary);
+    file.seekp(repr::Dataset::ColumnAlignment + 3);
+    file.put(42);
+  }
+
+  EXPECT_DEATH(DatasetStream(filename, 1 << 20), "checksum mismatch");
+  DatasetStream stream(filename, 1 << 20, false);
+  EXPECT_EQ((size_t)2, stream.numInputs());
+}
+
+TEST(DatasetStreamTest, FitnessMatchesInMemory) {
+  repr::RNG rng;
+  repr::Node node(primitives::sumFn(rng));
+  node.setChild(0, repr::Node(primitives::makeVarTerm(0)(rng)));
+  node.setChild(1, repr::Node(primitives::makeVarTerm(1)(rng)));
+  const std::vector<repr::Node> population = {
+      node, repr::Node(primitives::literalTerm(0.791453)(rng))};
+
+  const auto &dataset = parser::loadDataset(KeijzerTrain);
+  DatasetStream stream(KeijzerTrain, (1 << 20) + 1);
+
+  const auto &expected = stats::fitness(population, dataset);
+  const auto &fitness = stats::fitness(population, stream);
+  ASSERT_EQ(expected.size(), fitness.size());
+  for (size_t i = 0; i < fitness.size(); ++i) {
+    EXPECT_DOUBLE_EQ(expected[i], fitness[i]);
+  }
+}
+
+} // namespace
@@ -0,0 +1,313 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sweep.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <utility>
+
+#include "glog/logging.h"
+
+#include "parser.hpp"
+#include "pool.hpp"
+#include "simulation.hpp"
+#include "utils.hpp"
+
+namespace {
+/// Hyperparameter that can be swept.
+struct Param_ {
+  /// If it only takes integer values.
+  bool integer;
+
+  /// Sets the value in the params.
+  void (*set)(repr::Params &params, double value);
+};
+
+const Param_ &param_(const std::string &name) {
+  static const std::map<std::string, Param_> params = {
+      {"population_size",
+       {true, [](repr::Params &p, double v) { p.populationSize = v; }}},
+      {"tournament_size",
+       {true, [](repr::Params &p, double v) { p.tournamentSize = v; }}},
+      {"max_height",
+       {true, [](repr::Params &p, double v) { p.maxHeight = v; }}},
+      {"crossover_prob",
+       {false, [](repr::Params &p, double v) { p.crossoverProb = v; }}},
+      {"elitism",
+       {true, [](repr::Params &p, double v) { p.elitism = v != 0; }}},
+      {"num_generations",
+       {true, [](repr::Params &p, double v) { p.numGenerations = v; }}},
+      {"tarpeian_prob",
+       {false, [](repr::Params &p, double v) { p.bloat.tarpeianProb = v; }}},
+      {"parsimony_coefficient",
+       {false,
+        [](repr::Params &p, double v) { p.bloat.parsimonyCoefficient = v; }}},
+  };
+
+  const auto it = params.find(name);
+  CHECK(it != params.end()) << "Unknown sweep hyperparameter: " << name;
+  return it->second;
+}
+
+std::string trim_(const std::string &text) {
+  const auto begin = text.find_first_not_of(" \t\r");
+  if (begin == std::string::npos) {
+    return "";
+  }
+  const auto end = text.find_last_not_of(" \t\r");
+  return text.substr(begin, end - begin + 1);
+}
+
+double parseValue_(const std::string &text) {
+  const auto &value = trim_(text);
+  if (value == "true") {
+    return 1;
+  }
+  if (value == "false") {
+    return 0;
+  }
+
+  char *end = nullptr;
+  const double result = std::strtod(value.c_str(), &end);
+  CHECK(!value.empty() && *end == '\0') << "Invalid sweep value: " << text;
+  return result;
+}
+
+sweep::Dimension parseDimension_(const std::string &entry) {
+  const auto equals = entry.find('=');
+  CHECK(equals != std::string::npos) << "Invalid sweep entry: " << entry;
+
+  sweep::Dimension dimension;
+  dimension.name = trim_(entry.substr(0, equals));
+  param_(dimension.name); // Checks the name.
+
+  const auto &values = entry.substr(equals + 1);
+  const auto colon = values.find(':');
+  if (colon != std::string::npos) {
+    dimension.values.min = parseValue_(values.substr(0, colon));
+    dimension.values.max = parseValue_(values.substr(colon + 1));
+    CHECK(dimension.values.min <= dimension.values.max)
+        << "Empty sweep range: " << entry;
+  } else {
+    for (const auto &value : parser::splitLine(values, ',')) {
+      dimension.values.choices.push_back(parseValue_(value));
+    }
+  }
+  return dimension;
+}
+
+double sample_(repr::RNG &rng, const sweep::Dimension &dimension) {
+  const auto &values = dimension.values;
+  if (!values.choices.empty()) {
+    std::uniform_int_distribution<size_t> distr(0, values.choices.size() - 1);
+    return values.choices[distr(rng)];
+  }
+
+  if (param_(dimension.name).integer) {
+    const auto min = (long long)std::ceil(values.min);
+    const auto max = (long long)std::floor(values.max);
+    CHECK(min <= max) << "No integers in the sweep range of "
+                      << dimension.name;
+    std::uniform_int_distribution<long long> distr(min, max);
+    return distr(rng);
+  }
+  std::uniform_real_distribution<double> distr(values.min, values.max);
+  return distr(rng);
+}
+
+/// Runs in the order they are scheduled: (config, instance).
+std::vector<std::pair<size_t, size_t>>
+schedule_(const std::vector<repr::Params> &params) {
+  size_t maxInstances = 0;
+  for (const auto &configParams : params) {
+    maxInstances = std::max(maxInstances, configParams.numInstances);
+  }
+
+  std::vector<std::pair<size_t, size_t>> runs;
+  for (size_t instance = 0; instance < maxInstances; ++instance) {
+    for (size_t config = 0; config < params.size(); ++config) {
+      if (instance < params[config].numInstances) {
+        runs.emplace_back(config, instance);
+      }
+    }
+  }
+  return runs;
+}
+
+} // namespace
+
+namespace sweep {
+
+Spec parseSpec(const std::string &text) {
+  Spec spec;
+  for (const auto &line : parser::splitLine(text, '\n')) {
+    for (const auto &entry : parser::splitLine(line, ';')) {
+      if (trim_(entry).empty()) {
+        continue;
+      }
+
+      auto dimension = parseDimension_(entry);
+      for (const auto &other : spec) {
+        CHECK(other.name != dimension.name)
+            << "Repeated sweep hyperparameter: " << dimension.name;
+      }
+      spec.push_back(std::move(dimension));
+    }
+  }
+  return spec;
+}
+
+std::vector<Config> grid(const Spec &spec) {
+  std::vector<Config> configs = {{}};
+  for (const auto &dimension : spec) {
+    CHECK(!dimension.values.choices.empty())
+        << "Grid search can't sweep the range of " << dimension.name;
+
+    std::vector<Config> extended;
+    for (const auto &config : configs) {
+      for (const auto value : dimension.values.choices) {
+        extended.push_back(config);
+        extended.back().push_back(value);
+      }
+    }
+    configs = std::move(extended);
+  }
+  return configs;
+}
+
+std::vector<Config> randomSearch(const Spec &spec, size_t numConfigs,
+                                 repr::RNG &rng) {
+  std::vector<Config> configs(numConfigs);
+  for (auto &config : configs) {
+    for (const auto &dimension : spec) {
+      config.push_back(sample_(rng, dimension));
+    }
+  }
+  return configs;
+}
+
+std::string str(const Spec &spec, const Config &config) {
+  std::string result;
+  for (size_t i = 0; i < spec.size(); ++i) {
+    result += utils::strCat(i ? " " : "", spec[i].name, "=", config[i]);
+  }
+  return result;
+}
+
+repr::Params configParams(const repr::Params &base, const Spec &spec,
+                          const Config &config,
+                          const std::string &outputFile) {
+  CHECK(config.size() == spec.size());
+  repr::Params p = base;
+  for (size_t i = 0; i < spec.size(); ++i) {
+    param_(spec[i].name).set(p, config[i]);
+  }
+
+  // Goes through the constructor again to adjust the population size.
+  return repr::Params(outputFile, p.seed, p.numInstances, p.numGenerations,
+                      p.populationSize, p.tournamentSize, p.maxHeight,
+                      p.crossoverProb, p.elitism, p.alwaysTest, p.functions,
+                      p.terminals, p.simplifyGenotype, p.bloat, p.tuning,
+                      p.targetFitness, p.stopping, p.statsLevel);
+}
+
+std::vector<Result> run(const std::vector<repr::Params> &params,
+                        const repr::Dataset &trainDataset,
+                        const repr::Dataset &testDataset, size_t numThreads,
+                        size_t threadsPerRun) {
+  const auto &runs = schedule_(params);
+  LOG(INFO) << "Sweeping " << params.size() << " configs in " << runs.size()
+            << " runs";
+
+  std::vector<Result> results(params.size());
+  std::vector<double> runSeconds(runs.size());
+  pool::run(runs.size(), numThreads, threadsPerRun, [&](size_t i) {
+    const auto & [ config, instance ] = runs[i];
+    LOG(INFO) << "Config " << config << ", instance " << instance + 1;
+
+    const auto start = std::chrono::steady_clock::now();
+    std::seed_seq seed{params[config].seed, (unsigned)instance};
+    repr::RNG rng(seed);
+    simulation::simulateInstance(rng, params[config], trainDataset,
+                                 testDataset, results[config].train,
+                                 results[config].test);
+    runSeconds[i] = utils::elapsedMs(start) / 1000;
+  });
+
+  for (size_t i = 0; i < runs.size(); ++i) {
+    results[runs[i].first].runSeconds += runSeconds[i];
+  }
+  return results;
+}
+
+void summarize(const Spec &spec, const std::vector<Config> &configs,
+               const std::vector<std::string> &outputFiles,
+               const std::vector<Result> &results,
+               const std::string &filename) {
+  CHECK(configs.size() == results.size());
+  CHECK(outputFiles.size() == results.size());
+  std::vector<size_t> ranking(results.size());
+  std::iota(ranking.begin(), ranking.end(), 0);
+  std::stable_sort(ranking.begin(), ranking.end(), [&](size_t a, size_t b) {
+    return results[a].test.finalStats().bestFitness.mean() <
+           results[b].test.finalStats().bestFitness.mean();
+  });
+
+  std::ofstream out;
+  if (!filename.empty()) {
+    out.open(filename, std::ofstream::out | std::ofstream::trunc);
+    CHECK(out) << "Failed to open " << filename;
+    out << "rank,config";
+    for (const auto &dimension : spec) {
+      out << "," << dimension.name;
+    }
+    out << ",testFitness,testFitnessStddev,testSize,generationsRun,"
+           "runSeconds,outputFile\n";
+  }
+
+  LOG(INFO) << "";
+  LOG(INFO) << "Sweep results (best first):";
+  for (size_t rank = 1; rank <= ranking.size(); ++rank) {
+    const size_t i = ranking[rank - 1];
+    const auto &finalStats = results[i].test.finalStats();
+    const double generationsRun = results[i].train.generationsRun().mean();
+    LOG(INFO) << "  " << rank << ". config " << i << " ("
+              << str(spec, configs[i])
+              << "): test fitness: " << finalStats.bestFitness.mean()
+              << " +/- " << finalStats.bestFitness.stddev()
+              << ", size: " << finalStats.bestSize.mean()
+              << ", run time: " << results[i].runSeconds << " s";
+
+    if (out.is_open()) {
+      out << rank << "," << i;
+      for (const auto value : configs[i]) {
+        out << "," << value;
+      }
+      out << "," << finalStats.bestFitness.mean() << ","
+          << finalStats.bestFitness.stddev() << ","
+          << finalStats.bestSize.mean() << "," << generationsRun << ","
+          << results[i].runSeconds << "," << outputFiles[i] << "\n";
+    }
+  }
+}
+
+} // namespace sweep
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPNAT_TP1_SWEEP_HPP
+#define COMPNAT_TP1_SWEEP_HPP
+
+#include <string>
+#include <vector>
+
+#include "representation.hpp"
+#include "statistics.hpp"
+
+/**
+ * Hyperparameter sweeps: many configs of tp1, each with several instances,
+ * run on a single pool of threads over the same datasets.
+ */
+namespace sweep {
+
+/// Values of a swept hyperparameter.
+struct Values {
+  /// Values of the grid, or to choose from in random search.
+  std::vector<double> choices;
+
+  /// Range of random search, [min, max], used if there are no choices.
+  double min = 0;
+  double max = 0;
+};
+
+/// Swept hyperparameter, named like the tp1 flag that sets it.
+struct Dimension {
+  std::string name;
+  Values values;
+};
+
+/// Search space of a sweep.
+using Spec = std::vector<Dimension>;
+
+/// Value of each dimension of a spec, in the same order.
+using Config = std::vector<double>;
+
+/**
+ * Parses a spec of "name=values" entries separated by semicolons or
+ * newlines. Values are either a comma-separated list, like
+ * "population_size=100,500", or a "min:max" range for random search, like
+ * "crossover_prob=0.5:0.95". Booleans are given as 0 and 1, or false and true.
+ * Names: population_size, tournament_size, max_height, crossover_prob,
+ * elitism, num_generations, tarpeian_prob and parsimony_coefficient.
+ */
+Spec parseSpec(const std::string &text);
+
+/// All the combinations of the choices of the spec, which can't have ranges.
+std::vector<Config> grid(const Spec &spec);
+
+/**
+ * Samples numConfigs configs, taking each value uniformly from the choices or
+ * the range of its dimension. Integer hyperparameters get integer values.
+ */
+std::vector<Config> randomSearch(const Spec &spec, size_t numConfigs,
+                                 repr::RNG &rng);
+
+/// "name=value" pairs of the config, separated by spaces.
+std::string str(const Spec &spec, const Config &config);
+
+/**
+ * Base params with the values of the config, saving the results to
+ * outputFile. The population size is adjusted like in repr::Params().
+ */
+repr::Params configParams(const repr::Params &base, const Spec &spec,
+                          const Config &config, const std::string &outputFile);
+
+/// Statistics of all the instances of a config.
+struct Result {
+  stats::Aggregator train;
+  stats::Aggregator test;
+
+  /// Total wall time of the instances, in seconds.
+  double runSeconds = 0;
+};
+
+/**
+ * Runs all the instances of all the params on a pool of threads, sharing the
+ * datasets. Each run is a single instance, so configs with many instances
+ * are split among the threads.
+ * Runs are scheduled instance by instance, so all configs advance at the same
+ * pace, and the threads are divided evenly among the concurrent runs: each
+ * one gets numThreads / numRuns OpenMP threads, at least threadsPerRun.
+ * Instance i of each config is seeded with params.seed and i, so results
+ * don't depend on the scheduling.
+ * @param numThreads Number of cores to use, 0 for all of them.
+ * @return The results of each params, in the same order.
+ */
+std::vector<Result> run(const std::vector<repr::Params> &params,
+                        const repr::Dataset &trainDataset,
+                        const repr::Dataset &testDataset, size_t numThreads,
+                        size_t threadsPerRun);
+
+/**
+ * Logs the configs ranked by their mean final test fitness, and saves the
+ * same table as a CSV file, unless filename is empty.
+ * @param outputFiles Results file of each config.
+ */
+void summarize(const Spec &spec, const std::vector<Config> &configs,
+               const std::vector<std::string> &outputFiles,
+               const std::vector<Result> &results,
+               const std::string &filename);
+
+} // namespace sweep
+
+#endif // !COMPNAT_TP1_SWEEP_HPP
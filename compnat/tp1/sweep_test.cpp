@@ -0,0 +1,167 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sweep.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "parser.hpp"
+#include "primitives.hpp"
+
+namespace {
+using testing::ElementsAre;
+
+TEST(SweepTest, ParsesSpecs) {
+  const auto &spec = sweep::parseSpec(
+      "population_size=100, 200;elitism=true,false\n"
+      "  crossover_prob = 0.5:0.95 ;\n");
+  ASSERT_EQ((size_t)3, spec.size());
+  EXPECT_EQ("population_size", spec[0].name);
+  EXPECT_THAT(spec[0].values.choices, ElementsAre(100, 200));
+  EXPECT_EQ("elitism", spec[1].name);
+  EXPECT_THAT(spec[1].values.choices, ElementsAre(1, 0));
+  EXPECT_EQ("crossover_prob", spec[2].name);
+  EXPECT_TRUE(spec[2].values.choices.empty());
+  EXPECT_DOUBLE_EQ(0.5, spec[2].values.min);
+  EXPECT_DOUBLE_EQ(0.95, spec[2].values.max);
+
+  EXPECT_TRUE(sweep::parseSpec("").empty());
+  EXPECT_DEATH(sweep::parseSpec("mutation_prob=0.1"),
+               "Unknown sweep hyperparameter");
+  EXPECT_DEATH(sweep::parseSpec("max_height=5;max_height=7"),
+               "Repeated sweep hyperparameter");
+}
+
+TEST(SweepTest, GridHasAllCombinations) {
+  const auto &spec =
+      sweep::parseSpec("population_size=100,200,300;elitism=0,1");
+  const auto &configs = sweep::grid(spec);
+  ASSERT_EQ((size_t)6, configs.size());
+  EXPECT_THAT(configs[0], ElementsAre(100, 0));
+  EXPECT_THAT(configs[1], ElementsAre(100, 1));
+  EXPECT_THAT(configs[5], ElementsAre(300, 1));
+  EXPECT_EQ("population_size=300 elitism=1", sweep::str(spec, configs[5]));
+
+  EXPECT_EQ((size_t)1, sweep::grid({}).size());
+  EXPECT_DEATH(sweep::grid(sweep::parseSpec("crossover_prob=0.5:0.9")),
+               "can't sweep the range");
+}
+
+TEST(SweepTest, RandomSearchSamplesTheSpec) {
+  const auto &spec = sweep::parseSpec(
+      "tournament_size=2:9;crossover_prob=0.5:0.9;max_height=5,7");
+  repr::RNG rng(0);
+  const auto &configs = sweep::randomSearch(spec, 100, rng);
+  ASSERT_EQ((size_t)100, configs.size());
+  for (const auto &config : configs) {
+    ASSERT_EQ((size_t)3, config.size());
+    EXPECT_LE(2, config[0]);
+    EXPECT_GE(9, config[0]);
+    EXPECT_EQ(std::round(config[0]), config[0]);
+    EXPECT_LE(0.5, config[1]);
+    EXPECT_GE(0.9, config[1]);
+    EXPECT_TRUE(config[2] == 5 || config[2] == 7);
+  }
+}
+
+TEST(SweepTest, ConfigParamsAdjustThePopulation) {
+  const auto &spec = sweep::parseSpec(
+      "population_size=100;max_height=5;elitism=1;tarpeian_prob=0.25");
+  const repr::Params base( // Keep formatting
+      "", 1, 2, 3, 60, 5, 7, 0.9, false, false,
+      {
+          primitives::sumFn,
+          primitives::subFn,
+          primitives::multFn,
+          primitives::divFn,
+      },
+      {
+          primitives::constTerm,
+          primitives::makeVarTerm(0),
+      });
+  const auto &params =
+      sweep::configParams(base, spec, {101, 5, 1, 0.25}, "config-0.cnat");
+  EXPECT_EQ("config-0.cnat", params.outputFile);
+  EXPECT_EQ((size_t)104, params.populationSize);
+  EXPECT_EQ((size_t)5, params.maxHeight);
+  EXPECT_TRUE(params.elitism);
+  EXPECT_DOUBLE_EQ(0.25, params.bloat.tarpeianProb);
+  EXPECT_EQ((size_t)2, params.numInstances);
+  EXPECT_EQ((size_t)3, params.numGenerations);
+}
+
+TEST(SweepTest, RunsAllInstancesOfAllConfigs) {
+  const auto &trainDataset =
+      parser::loadDataset("compnat/tp1/datasets/keijzer-7-train.csv");
+  const auto &testDataset =
+      parser::loadDataset("compnat/tp1/datasets/keijzer-7-test.csv");
+  const auto &spec = sweep::parseSpec("tournament_size=2,5;elitism=0,1");
+  const auto &configs = sweep::grid(spec);
+  repr::Params base( // Keep formatting
+      "", 1, 3, 3, 60, 5, 7, 0.9, false, false,
+      {
+          primitives::sumFn,
+          primitives::subFn,
+          primitives::multFn,
+          primitives::divFn,
+      },
+      {
+          primitives::constTerm,
+          primitives::makeVarTerm(0),
+      });
+  base.statsLevel = repr::StatsLevel::None;
+  std::vector<repr::Params> params;
+  for (const auto &config : configs) {
+    params.push_back(sweep::configParams(base, spec, config, ""));
+  }
+
+  // Each instance has its own seed, so the results don't depend on the
+  // number of threads.
+  const auto &serial = sweep::run(params, trainDataset, testDataset, 1, 1);
+  const auto &parallel = sweep::run(params, trainDataset, testDataset, 4, 1);
+  ASSERT_EQ(configs.size(), serial.size());
+  ASSERT_EQ(configs.size(), parallel.size());
+  for (size_t i = 0; i < configs.size(); ++i) {
+    EXPECT_EQ((size_t)3, serial[i].test.finalStats().count());
+    EXPECT_EQ((size_t)3, serial[i].train.generationsRun().count());
+    EXPECT_LT(0, serial[i].runSeconds);
+    EXPECT_DOUBLE_EQ(serial[i].test.finalStats().bestFitness.mean(),
+                     parallel[i].test.finalStats().bestFitness.mean());
+  }
+
+  const std::string filename = testing::TempDir() + "sweep_summary.csv";
+  sweep::summarize(spec, configs, {"0.cnat", "1.cnat", "2.cnat", "3.cnat"},
+                   serial, filename);
+  std::ifstream in(filename);
+  std::string line;
+  ASSERT_TRUE(std::getline(in, line));
+  EXPECT_EQ("rank,config,tournament_size,elitism,testFitness,"
+            "testFitnessStddev,testSize,generationsRun,runSeconds,outputFile",
+            line);
+  size_t numLines = 0;
+  while (std::getline(in, line)) {
+    ++numLines;
+  }
+  EXPECT_EQ(configs.size(), numLines);
+}
+
+} // namespace
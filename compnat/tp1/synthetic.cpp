@@ -0,0 +1,138 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "synthetic.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+
+#include "generators.hpp"
+#include "primitives.hpp"
+#include "program.hpp"
+#include "serializer.hpp"
+
+namespace {
+/// Number of rows generated from each seed.
+const size_t BlockRows_ = 1 << 16;
+
+/// Number of inputs used by the expression.
+size_t numInputs_(const repr::Node &expression) {
+  size_t numInputs = 0;
+  if (expression.op() == repr::Op::Var) {
+    numInputs = expression.var() + 1;
+  }
+  for (size_t i = 0; i < expression.numChildren(); ++i) {
+    numInputs = std::max(numInputs, numInputs_(expression.child(i)));
+  }
+  return numInputs;
+}
+
+synthetic::Target makeTarget_(const std::string &expression, double minInput,
+                              double maxInput) {
+  synthetic::Target target;
+  target.expression = serializer::parse(expression);
+  target.numInputs = numInputs_(target.expression);
+  target.minInput = minInput;
+  target.maxInput = maxInput;
+  return target;
+}
+
+} // namespace
+
+namespace synthetic {
+
+Target target(const std::string &name) {
+  static const std::map<std::string, Target> problems = {
+      {"keijzer-7", makeTarget_("(log2(x0) * 0.6931471805599453)", 1, 100)},
+      {"keijzer-10", makeTarget_("pow(x0, x1)", 0, 1)},
+  };
+
+  const auto it = problems.find(name);
+  return it != problems.end() ? it->second : makeTarget_(name, 0, 1);
+}
+
+Target randomTarget(repr::RNG &rng, size_t numInputs, size_t maxHeight,
+                    const std::vector<repr::PrimitiveFn> &functions) {
+  CHECK(numInputs) << "Random targets need at least one input";
+  std::vector<repr::PrimitiveFn> terminals = {primitives::constTerm};
+  for (size_t i = 0; i < numInputs; ++i) {
+    terminals.push_back(primitives::makeVarTerm(i));
+  }
+
+  // Constant targets can't be learned from the inputs.
+  Target target;
+  do {
+    target.expression = generators::grow(rng, maxHeight, functions, terminals);
+  } while (!numInputs_(target.expression));
+  target.numInputs = numInputs;
+  return target;
+}
+
+repr::Dataset generate(const Target &target, const Spec &spec) {
+  CHECK(spec.numInputs >= target.numInputs)
+      << "The target uses " << target.numInputs << " inputs, but the dataset "
+      << "has " << spec.numInputs;
+  CHECK(spec.numInputs) << "Datasets need at least one input";
+  CHECK(target.minInput <= target.maxInput)
+      << "Invalid input range [" << target.minInput << ", "
+      << target.maxInput << ")";
+
+  repr::Dataset dataset(spec.numRows, spec.numInputs);
+  const program::Program program(target.expression);
+  const size_t numBlocks = (spec.numRows + BlockRows_ - 1) / BlockRows_;
+  size_t numNonFinite = 0;
+
+#pragma omp parallel for schedule(dynamic) reduction(+ : numNonFinite)
+  for (size_t block = 0; block < numBlocks; ++block) {
+    std::seed_seq seed{spec.seed, (unsigned)(block >> 32), (unsigned)block};
+    repr::RNG rng(seed);
+    std::uniform_real_distribution<double> input(target.minInput,
+                                                 target.maxInput);
+    std::normal_distribution<double> noise(0, spec.noise);
+
+    // The values of each row are drawn together, so the rows don't depend on
+    // the size of the block.
+    const size_t begin = block * BlockRows_;
+    const size_t end = std::min(spec.numRows, begin + BlockRows_);
+    std::vector<repr::T> noises(end - begin);
+    for (size_t row = begin; row < end; ++row) {
+      for (size_t var = 0; var < spec.numInputs; ++var) {
+        dataset.mutableColumn(var)[row] = input(rng);
+      }
+      noises[row - begin] = spec.noise > 0 ? noise(rng) : 0;
+    }
+
+    repr::T *outputs = dataset.mutableColumn(spec.numInputs);
+    program.eval(dataset, begin, end, outputs + begin);
+    for (size_t row = begin; row < end; ++row) {
+      outputs[row] += noises[row - begin];
+      numNonFinite += !std::isfinite(outputs[row]);
+    }
+  }
+
+  CHECK(!numNonFinite) << numNonFinite << " of " << spec.numRows
+                       << " outputs of " << target.expression.str()
+                       << " aren't finite";
+  dataset.summarize();
+  return dataset;
+}
+
+} // namespace synthetic
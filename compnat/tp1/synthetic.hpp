@@ -0,0 +1,84 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPNAT_TP1_SYNTHETIC_HPP
+#define COMPNAT_TP1_SYNTHETIC_HPP
+
+#include <string>
+#include <vector>
+
+#include "representation.hpp"
+
+/**
+ * Synthetic regression datasets of any size, with the outputs given by a
+ * ground-truth expression. Used for scaling tests, as the bundled datasets are
+ * small enough to fit in the caches.
+ */
+namespace synthetic {
+
+/// Ground-truth expression of a dataset.
+struct Target {
+  repr::Node expression;
+
+  /// Number of inputs the expression uses.
+  size_t numInputs = 0;
+
+  /// Range the inputs are sampled from, [minInput, maxInput).
+  double minInput = 0;
+  double maxInput = 1;
+};
+
+/**
+ * Target of a named problem: keijzer-7 (ln(x0), with x0 in [1, 100)) and
+ * keijzer-10 (x0^x1, with both in [0, 1)), the problems of the bundled
+ * datasets. Any other name is parsed as an expression, like
+ * "((x0 * x1) + 2)", whose inputs are in [0, 1).
+ */
+Target target(const std::string &name);
+
+/**
+ * Random target created with generators::grow(), which only uses the given
+ * functions, constants and the first numInputs inputs. Trees without inputs
+ * are discarded.
+ */
+Target randomTarget(repr::RNG &rng, size_t numInputs, size_t maxHeight,
+                    const std::vector<repr::PrimitiveFn> &functions);
+
+/// Shape of a synthetic dataset.
+struct Spec {
+  size_t numRows = 0;
+
+  /// Number of inputs, at least the number the target uses. The extra inputs
+  /// are unrelated to the outputs.
+  size_t numInputs = 0;
+
+  /// Standard deviation of the Gaussian noise added to the outputs.
+  double noise = 0;
+
+  unsigned seed = 0;
+};
+
+/**
+ * Generates the summarized dataset, sampling the inputs uniformly from the
+ * range of the target. Blocks of rows are generated in parallel, each with
+ * its own seed, so the dataset only depends on the spec and the target.
+ * Aborts if any output isn't finite.
+ */
+repr::Dataset generate(const Target &target, const Spec &spec);
+
+} // namespace synthetic
+
+#endif // !COMPNAT_TP1_SYNTHETIC_HPP
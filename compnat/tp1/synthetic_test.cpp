@@ -0,0 +1,108 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "synthetic.hpp"
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "primitives.hpp"
+#include "statistics.hpp"
+
+namespace {
+
+synthetic::Spec spec(size_t numRows, size_t numInputs, double noise = 0) {
+  synthetic::Spec spec;
+  spec.numRows = numRows;
+  spec.numInputs = numInputs;
+  spec.noise = noise;
+  spec.seed = 3;
+  return spec;
+}
+
+TEST(SyntheticTest, EvaluatesTheTarget) {
+  const auto &target = synthetic::target("keijzer-10");
+  ASSERT_EQ((size_t)2, target.numInputs);
+
+  const auto &dataset = synthetic::generate(target, spec(1000, 3));
+  ASSERT_EQ((size_t)1000, dataset.size());
+  ASSERT_EQ((size_t)3, dataset.numInputs());
+  ASSERT_TRUE(dataset.summarized());
+  for (size_t i = 0; i < dataset.size(); ++i) {
+    EXPECT_LE(0, dataset.input(2)[i]);
+    EXPECT_GT(1, dataset.input(2)[i]);
+    EXPECT_NEAR(std::pow(dataset.input(0)[i], dataset.input(1)[i]),
+                dataset.expected()[i], 1e-5);
+  }
+  EXPECT_NEAR(0, stats::fitness(target.expression, dataset), 1e-5);
+
+  const auto &keijzer7 = synthetic::target("keijzer-7");
+  const auto &logs = synthetic::generate(keijzer7, spec(100, 1));
+  EXPECT_LE(1, logs.summary(0).min);
+  EXPECT_NEAR(std::log(logs.input(0)[0]), logs.expected()[0], 1e-5);
+}
+
+TEST(SyntheticTest, ParsesExpressions) {
+  const auto &target = synthetic::target("((x0 * x3) + 2)");
+  EXPECT_EQ((size_t)4, target.numInputs);
+  EXPECT_EQ("((x0 * x3) + 2)", target.expression.str());
+}
+
+TEST(SyntheticTest, DependsOnlyOnTheSeed) {
+  const auto &target = synthetic::target("((x0 * x1) + 2)");
+
+  // More rows than a block, which have their own seeds.
+  const auto &small = synthetic::generate(target, spec(70000, 2, 0.5));
+  const auto &big = synthetic::generate(target, spec(150000, 2, 0.5));
+  for (size_t i = 0; i < small.size(); ++i) {
+    ASSERT_EQ(small.input(0)[i], big.input(0)[i]) << i;
+    ASSERT_EQ(small.expected()[i], big.expected()[i]) << i;
+  }
+
+  auto otherSpec = spec(70000, 2, 0.5);
+  otherSpec.seed = 4;
+  const auto &other = synthetic::generate(target, otherSpec);
+  EXPECT_NE(small.input(0)[0], other.input(0)[0]);
+}
+
+TEST(SyntheticTest, AddsNoise) {
+  const auto &target = synthetic::target("x0");
+  const auto &dataset = synthetic::generate(target, spec(100000, 1, 0.5));
+  double sum = 0, sumSquares = 0;
+  for (size_t i = 0; i < dataset.size(); ++i) {
+    const double error = dataset.expected()[i] - dataset.input(0)[i];
+    sum += error;
+    sumSquares += error * error;
+  }
+  EXPECT_NEAR(0, sum / dataset.size(), 0.01);
+  EXPECT_NEAR(0.5, std::sqrt(sumSquares / dataset.size()), 0.01);
+}
+
+TEST(SyntheticTest, RandomTargetsUseTheInputs) {
+  repr::RNG rng(0);
+  for (size_t i = 0; i < 20; ++i) {
+    const auto &target = synthetic::randomTarget(
+        rng, 3, 4, {primitives::sumFn, primitives::multFn});
+    EXPECT_EQ((size_t)3, target.numInputs);
+    EXPECT_NE(std::string::npos, target.expression.str().find('x'));
+
+    const auto &dataset = synthetic::generate(target, spec(100, 3));
+    EXPECT_TRUE(std::isfinite(dataset.summary(3).mean));
+  }
+}
+
+} // namespace
@@ -14,18 +14,35 @@
  * limitations under the License.
  */
 
+#include <chrono>
 #include <random>
 
 #include "glog/logging.h"
 #include <gflags/gflags.h>
 
+#include "compnat/common/allocations.hpp"
+#include "compnat/common/counters.hpp"
+#include "compnat/common/numa.hpp"
+#include "compnat/common/trace.hpp"
+#include "kfold.hpp"
 #include "parser.hpp"
 #include "primitives.hpp"
 #include "representation.hpp"
 #include "simulation.hpp"
+#include "statistics.hpp"
+#include "stream.hpp"
 
-DEFINE_string(dataset_train, "", "File containing the train dataset.");
-DEFINE_string(dataset_test, "", "File containing the test dataset.");
+DEFINE_string(dataset_train, "",
+              "File containing the train dataset (CSV or '.cnatds').");
+DEFINE_string(dataset_test, "",
+              "File containing the test dataset (CSV or '.cnatds').");
+DEFINE_bool(verify_dataset_checksum, true,
+            "Verify the checksum of binary ('.cnatds') datasets.");
+DEFINE_bool(stream_datasets, false,
+            "Stream the datasets from disk in chunks instead of loading them "
+            "in memory. Allows datasets bigger than the memory.");
+DEFINE_int32(stream_memory_mb, 256,
+             "Maximum memory in MB used by each streamed dataset.");
 DEFINE_string(output_file, "",
               "Output file for the execution data. "
               "Extension should be '.cnat'.");
@@ -35,10 +52,120 @@ DEFINE_int32(num_generations, 50, "Number of generations to run.");
 DEFINE_int32(population_size, 100, "Size of the population.");
 DEFINE_int32(tournament_size, 7, "Size of the tournament.");
 DEFINE_int32(max_height, 7, "Maximum tree height.");
+DEFINE_string(functions, "sum,sub,mult,div",
+              "Comma-separated functions of the individuals. Available: sum, "
+              "sub, mult, div, log, exp, sin, cos, sqrt and pow.");
 DEFINE_double(crossover_prob, 0.9,
               "Crossover probability. Will use mutation otherwise.");
 DEFINE_bool(elitism, false, "Whether to use elitism or not.");
 DEFINE_bool(always_test, false, "Run test dataset on all generations.");
+DEFINE_bool(simplify_genotype, false,
+            "Replace the individuals by their simplified version (constant "
+            "folding, identity elimination) after each evaluation.");
+DEFINE_double(tarpeian_prob, 0,
+              "Bloat control: probability of rejecting children bigger than "
+              "the average size of the previous generation (0 to disable).");
+DEFINE_double(parsimony_coefficient, 0,
+              "Bloat control: selection uses fitness + coefficient * size (0 "
+              "to disable).");
+DEFINE_uint64(node_budget, 0,
+              "Bloat control: maximum total number of nodes of a generation "
+              "(0 for unlimited).");
+DEFINE_uint64(tune_elites, 0,
+              "Number of best individuals of each generation that have their "
+              "constants tuned with Levenberg-Marquardt (0 to disable). "
+              "Requires the datasets in memory.");
+DEFINE_uint64(tune_steps, 5,
+              "Levenberg-Marquardt steps for each tuned individual.");
+DEFINE_double(target_fitness, 0,
+              "Train fitness that counts as solving the problem. Reports the "
+              "number of evaluations needed to reach it (0 to disable).");
+DEFINE_double(time_budget, 0,
+              "Seconds all instances may run for. The running instance stops "
+              "when it runs out and the remaining ones are skipped (0 to "
+              "disable).");
+DEFINE_double(instance_time_budget, 0,
+              "Seconds each instance may run for (0 to disable).");
+DEFINE_uint64(stagnation_generations, 0,
+              "Stop instances whose best train fitness didn't improve by more "
+              "than --stagnation_epsilon in this many generations (0 to "
+              "disable).");
+DEFINE_double(stagnation_epsilon, 0,
+              "Minimum decrease of the best train fitness that counts as an "
+              "improvement for --stagnation_generations.");
+DEFINE_string(stats_level, "full",
+              "Statistics of each generation: none (only the final ones), "
+              "summary (fitness and size of the best, worst and average "
+              "individuals, only the best is scored on the test dataset) or "
+              "full.");
+DEFINE_uint64(kfold, 0,
+              "Cross-validate with this many folds of the train dataset, "
+              "which run concurrently. The test dataset is ignored (0 to "
+              "disable).");
+DEFINE_uint64(kfold_threads_per_run, 1,
+              "Minimum number of threads of each instance of a fold with "
+              "--kfold.");
+DEFINE_bool(numa_replicate, false,
+            "Replicate the datasets in huge page backed memory of each NUMA "
+            "node and pin the OpenMP threads to the nodes, so that each "
+            "thread reads its local replica.");
+DEFINE_bool(perf_counters, false,
+            "Count cycles, instructions, cache misses, branch misses and "
+            "stalled cycles of each phase with Linux perf_event_open. Only "
+            "times are measured if the counters are unavailable.");
+DEFINE_string(trace_file, "",
+              "If set, writes a trace of the generations, phases and parallel "
+              "tasks of each thread to this file, in the trace event JSON "
+              "format of chrome://tracing and Perfetto.");
+DEFINE_bool(count_allocations, false,
+            "Count the heap allocations, allocated bytes and peak heap size "
+            "of each phase of each generation.");
+
+namespace {
+repr::Params buildParams_(size_t numInputs) {
+  std::vector<repr::PrimitiveFn> functions;
+  for (const auto &name : parser::splitLine(FLAGS_functions, ',')) {
+    functions.push_back(primitives::function(name));
+  }
+
+  // Add the correct number of variable terminals.
+  std::vector<repr::PrimitiveFn> terminals;
+  terminals.push_back(primitives::constTerm);
+  for (size_t i = 0; i < numInputs; ++i) {
+    terminals.push_back(primitives::makeVarTerm(i));
+  }
+
+  repr::BloatParams bloat;
+  bloat.tarpeianProb = FLAGS_tarpeian_prob;
+  bloat.parsimonyCoefficient = FLAGS_parsimony_coefficient;
+  bloat.nodeBudget = FLAGS_node_budget;
+
+  repr::TuningParams tuning;
+  tuning.numElites = FLAGS_tune_elites;
+  tuning.numSteps = FLAGS_tune_steps;
+
+  repr::StoppingParams stopping;
+  stopping.timeBudget = FLAGS_time_budget;
+  stopping.instanceTimeBudget = FLAGS_instance_time_budget;
+  stopping.stagnationGenerations = FLAGS_stagnation_generations;
+  stopping.stagnationEpsilon = FLAGS_stagnation_epsilon;
+
+  return repr::Params(FLAGS_output_file, FLAGS_seed, FLAGS_num_instances,
+                      FLAGS_num_generations, FLAGS_population_size,
+                      FLAGS_tournament_size, FLAGS_max_height,
+                      FLAGS_crossover_prob, FLAGS_elitism, FLAGS_always_test,
+                      functions, terminals, FLAGS_simplify_genotype, bloat,
+                      tuning, FLAGS_target_fitness, stopping,
+                      repr::parseStatsLevel(FLAGS_stats_level));
+}
+
+void writeTrace_() {
+  if (!FLAGS_trace_file.empty()) {
+    trace::write(FLAGS_trace_file);
+  }
+}
+
+} // namespace
 
 int main(int argc, char **argv) {
   gflags::ParseCommandLineFlags(&argc, &argv, true);
@@ -49,34 +176,82 @@ int main(int argc, char **argv) {
     std::random_device rd;
     FLAGS_seed = rd();
   }
+  if (FLAGS_perf_counters) {
+    counters::enable();
+  }
+  if (!FLAGS_trace_file.empty()) {
+    trace::enable();
+  }
+  if (FLAGS_count_allocations) {
+    allocations::enable();
+  }
 
-  const auto &trainDataset = parser::loadDataset(FLAGS_dataset_train);
-  const auto &testDataset = parser::loadDataset(FLAGS_dataset_test);
+  if (FLAGS_stream_datasets) {
+    CHECK(FLAGS_kfold == 0)
+        << "--kfold requires the datasets in memory, not streamed";
+    CHECK(!FLAGS_numa_replicate)
+        << "--numa_replicate requires the datasets in memory, not streamed";
+    const size_t maxMemory = (size_t)FLAGS_stream_memory_mb << 20;
+    stream::DatasetStream trainStream(FLAGS_dataset_train, maxMemory,
+                                      FLAGS_verify_dataset_checksum);
+    stream::DatasetStream testStream(FLAGS_dataset_test, maxMemory,
+                                     FLAGS_verify_dataset_checksum);
+    const auto &params = buildParams_(trainStream.numInputs());
 
-  const std::vector<repr::PrimitiveFn> functions = {
-      primitives::sumFn,
-      primitives::subFn,
-      primitives::multFn,
-      primitives::divFn,
-  };
+    auto[trainAggregator, testAggregator] =
+        simulation::simulate(params, trainStream, testStream);
+    stats::saveResults(params, trainAggregator, testAggregator);
+    counters::logSummary();
+    writeTrace_();
+    return 0;
+  }
 
-  // Add the correct number of variable terminals.
-  std::vector<repr::PrimitiveFn> terminals;
-  terminals.push_back(primitives::constTerm);
-  const auto &datasetInput = trainDataset[0].first;
-  for (size_t i = 0; i < datasetInput.size(); ++i) {
-    terminals.push_back(primitives::makeVarTerm(i));
+  if (FLAGS_kfold != 0) {
+    CHECK(!FLAGS_count_allocations)
+        << "--count_allocations can't count the folds that run concurrently";
+    CHECK(!FLAGS_numa_replicate)
+        << "--numa_replicate doesn't replicate the folds of --kfold";
+    const auto &dataset =
+        parser::loadDataset(FLAGS_dataset_train, FLAGS_verify_dataset_checksum);
+    const auto &params = buildParams_(dataset.numInputs());
+    const auto &folds = kfold::split(dataset, FLAGS_kfold, params.seed);
+
+    const auto &foldStats =
+        kfold::run(params, folds, 0, FLAGS_kfold_threads_per_run);
+    stats::Aggregator trainAggregator, testAggregator;
+    for (const auto &fold : foldStats) {
+      trainAggregator.merge(fold.train);
+      testAggregator.merge(fold.test);
+    }
+    stats::saveResults(params, trainAggregator, testAggregator, foldStats);
+    counters::logSummary();
+    writeTrace_();
+    return 0;
   }
 
-  repr::Params params(FLAGS_output_file, FLAGS_seed, FLAGS_num_instances,
-                      FLAGS_num_generations, FLAGS_population_size,
-                      FLAGS_tournament_size, FLAGS_max_height,
-                      FLAGS_crossover_prob, FLAGS_elitism, FLAGS_always_test,
-                      functions, terminals);
+  const auto loadStart = std::chrono::steady_clock::now();
+  auto trainDataset =
+      parser::loadDataset(FLAGS_dataset_train, FLAGS_verify_dataset_checksum);
+  auto testDataset =
+      parser::loadDataset(FLAGS_dataset_test, FLAGS_verify_dataset_checksum);
+  if (FLAGS_numa_replicate) {
+    numa::pinOpenMPThreads();
+    trainDataset = trainDataset.replicate();
+    testDataset = testDataset.replicate();
+  }
+  const std::chrono::duration<double, std::milli> loadTime =
+      std::chrono::steady_clock::now() - loadStart;
+  LOG(INFO) << "Datasets loaded in " << loadTime.count() << " ms";
 
-  auto[allTrainStats, allTestStats] =
+  const auto &params = buildParams_(trainDataset.numInputs());
+  auto[trainAggregator, testAggregator] =
       simulation::simulate(params, trainDataset, testDataset);
-  saveResults(params, allTrainStats, allTestStats);
+  stats::saveResults(params, trainAggregator, testAggregator);
+  counters::logSummary();
+  if (FLAGS_numa_replicate || numa::numNodes() > 1) {
+    numa::logSummary();
+  }
+  writeTrace_();
 
   return 0;
 }
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <mutex>
+#include <thread>
+
+#include <pthread.h>
+
+#include "glog/logging.h"
+#include <gflags/gflags.h>
+
+#include "parser.hpp"
+#include "serve.hpp"
+
+DEFINE_string(socket, "/tmp/tp1.sock", "Unix domain socket to listen on.");
+DEFINE_string(models, "",
+              "Comma-separated files with the served models: tp1 results "
+              "('.cnat'), for their best individual, or text files with an "
+              "expression per line. Requests select models by their index.");
+DEFINE_int64(batch_window_us, 200,
+             "Microseconds a micro-batch waits for more requests after its "
+             "first one.");
+DEFINE_uint64(max_batch_rows, 1 << 16,
+              "Rows that close a micro-batch before its window.");
+DEFINE_double(report_seconds, 10,
+              "Seconds between the reports of the throughput and latency (0 "
+              "to only report on exit).");
+
+namespace {
+void report_(const serve::BatcherCounters &counters,
+             const serve::BatcherCounters &last, double seconds) {
+  const size_t numBatches = counters.numBatches - last.numBatches;
+  const size_t numRows = counters.numRows - last.numRows;
+  LOG(INFO) << (counters.numRequests - last.numRequests) / seconds
+            << " requests/s, " << numRows / seconds << " rows/s, "
+            << (numBatches ? (double)numRows / numBatches : 0)
+            << " rows/batch, " << counters.numErrors - last.numErrors
+            << " errors | latency since start: p50 " << counters.p50Micros
+            << " us, p99 " << counters.p99Micros << " us";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  CHECK(!FLAGS_models.empty()) << "--models is required.";
+
+  // Only the signal thread receives SIGINT and SIGTERM, inherited by the
+  // other threads.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  const auto &models = serve::loadModels(parser::splitLine(FLAGS_models, ','));
+  CHECK(!models.empty()) << "No models in " << FLAGS_models;
+  for (size_t i = 0; i < models.size(); ++i) {
+    LOG(INFO) << "Model " << i << ": " << models[i].individual.str() << " ("
+              << models[i].numInputs << " inputs, " << models[i].name << ")";
+  }
+
+  serve::Batcher batcher(models,
+                         std::chrono::microseconds(FLAGS_batch_window_us),
+                         FLAGS_max_batch_rows);
+  serve::Server server(FLAGS_socket, batcher);
+
+  std::thread signalThread([&]() {
+    int signal;
+    sigwait(&signals, &signal);
+    LOG(INFO) << "Stopping on signal " << signal;
+    server.stop();
+  });
+
+  std::mutex mutex;
+  std::condition_variable stopped;
+  bool stopping = false;
+  const auto start = std::chrono::steady_clock::now();
+  std::thread reportThread([&]() {
+    if (FLAGS_report_seconds <= 0) {
+      return;
+    }
+    const std::chrono::duration<double> period(FLAGS_report_seconds);
+    serve::BatcherCounters last;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopped.wait_for(lock, period, [&]() { return stopping; })) {
+      const auto &counters = batcher.counters();
+      report_(counters, last, period.count());
+      last = counters;
+    }
+  });
+
+  server.run();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  stopped.notify_one();
+  reportThread.join();
+  signalThread.join();
+
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  const auto &counters = batcher.counters();
+  LOG(INFO) << "Served " << counters.numRequests << " requests ("
+            << counters.numRows << " rows) in " << counters.numBatches
+            << " batches";
+  report_(counters, serve::BatcherCounters(), elapsed.count());
+
+  return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "glog/logging.h"
+#include <gflags/gflags.h>
+
+#include "serve.hpp"
+
+DEFINE_string(socket, "/tmp/tp1.sock", "Unix domain socket of tp1_serve.");
+DEFINE_uint64(model, 0, "Index of the model to evaluate.");
+DEFINE_uint64(num_inputs, 1,
+              "Number of inputs of each row, at least the number the model "
+              "uses.");
+DEFINE_uint64(num_clients, 4,
+              "Concurrent clients, each with its own connection and thread.");
+DEFINE_uint64(num_requests, 10000, "Requests sent by each client.");
+DEFINE_uint64(rows_per_request, 1, "Rows of each request.");
+DEFINE_int32(seed, 0, "Seed of the random inputs, uniform in [0, 1).");
+
+int main(int argc, char **argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  CHECK(FLAGS_num_inputs) << "--num_inputs must be positive.";
+
+  // Each client waits for the response of a request before sending the next.
+  serve::LatencyHistogram latencies;
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < FLAGS_num_clients; ++i) {
+    threads.emplace_back([&, i]() {
+      serve::Client client(FLAGS_socket);
+      std::seed_seq seed{(unsigned)FLAGS_seed, (unsigned)i};
+      repr::RNG rng(seed);
+      std::uniform_real_distribution<double> distr(0, 1);
+      std::vector<double> inputs(FLAGS_rows_per_request * FLAGS_num_inputs);
+      std::vector<double> outputs;
+
+      for (size_t request = 0; request < FLAGS_num_requests; ++request) {
+        for (auto &input : inputs) {
+          input = distr(rng);
+        }
+
+        const auto requestStart = std::chrono::steady_clock::now();
+        const auto status =
+            client.predict(FLAGS_model, FLAGS_num_inputs, inputs, outputs);
+        const std::chrono::duration<double, std::micro> latency =
+            std::chrono::steady_clock::now() - requestStart;
+        CHECK(status == serve::Status::Ok)
+            << "Request failed: " << serve::statusName(status);
+        latencies.add(latency.count());
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  const size_t numRequests = FLAGS_num_clients * FLAGS_num_requests;
+  const size_t numRows = numRequests * FLAGS_rows_per_request;
+  LOG(INFO) << numRequests << " requests (" << numRows << " rows) in "
+            << elapsed.count() << " s: " << numRequests / elapsed.count()
+            << " requests/s, " << numRows / elapsed.count() << " rows/s";
+  LOG(INFO) << "Latency: p50 " << latencies.percentile(0.5) << " us, p99 "
+            << latencies.percentile(0.99) << " us";
+
+  return 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glog/logging.h"
+#include <gflags/gflags.h>
+
+#include "parser.hpp"
+#include "primitives.hpp"
+#include "representation.hpp"
+#include "statistics.hpp"
+#include "sweep.hpp"
+#include "utils.hpp"
+
+DEFINE_string(dataset_train, "",
+              "File containing the train dataset (CSV or '.cnatds').");
+DEFINE_string(dataset_test, "",
+              "File containing the test dataset (CSV or '.cnatds').");
+DEFINE_bool(verify_dataset_checksum, true,
+            "Verify the checksum of binary ('.cnatds') datasets.");
+DEFINE_string(output_dir, ".",
+              "Existing directory that receives the results of each config "
+              "('config-<n>.cnat') and the summary ('summary.csv').");
+DEFINE_string(spec, "",
+              "Hyperparameters to sweep, as 'name=values' entries separated "
+              "by semicolons or newlines. Values are a comma-separated list "
+              "or, for random search, a 'min:max' range. Names: "
+              "population_size, tournament_size, max_height, crossover_prob, "
+              "elitism, num_generations, tarpeian_prob and "
+              "parsimony_coefficient.");
+DEFINE_int32(num_random_configs, 0,
+             "Number of configs sampled from the spec by random search (0 "
+             "for grid search over all the combinations).");
+DEFINE_int32(num_threads, 0, "Number of threads to use (0 for all cores).");
+DEFINE_int32(threads_per_run, 1,
+             "Minimum number of OpenMP threads used by each run. Fewer runs "
+             "execute at a time with more threads each.");
+DEFINE_int32(seed, -1, "Initial seed (-1 to select at random).");
+DEFINE_int32(num_instances, 30, "Number of instances of each config.");
+
+// Values of the hyperparameters that aren't swept.
+DEFINE_int32(num_generations, 50, "Number of generations to run.");
+DEFINE_int32(population_size, 100, "Size of the population.");
+DEFINE_int32(tournament_size, 7, "Size of the tournament.");
+DEFINE_int32(max_height, 7, "Maximum tree height.");
+DEFINE_string(functions, "sum,sub,mult,div",
+              "Comma-separated functions of the individuals. Available: sum, "
+              "sub, mult, div, log, exp, sin, cos, sqrt and pow.");
+DEFINE_double(crossover_prob, 0.9,
+              "Crossover probability. Will use mutation otherwise.");
+DEFINE_bool(elitism, false, "Whether to use elitism or not.");
+DEFINE_string(stats_level, "none",
+              "Statistics of each generation: none (only the final ones), "
+              "summary or full, see tp1.");
+
+namespace {
+repr::Params baseParams_(size_t numInputs) {
+  std::vector<repr::PrimitiveFn> functions;
+  for (const auto &name : parser::splitLine(FLAGS_functions, ',')) {
+    functions.push_back(primitives::function(name));
+  }
+
+  std::vector<repr::PrimitiveFn> terminals;
+  terminals.push_back(primitives::constTerm);
+  for (size_t i = 0; i < numInputs; ++i) {
+    terminals.push_back(primitives::makeVarTerm(i));
+  }
+
+  return repr::Params(
+      "", FLAGS_seed, FLAGS_num_instances, FLAGS_num_generations,
+      FLAGS_population_size, FLAGS_tournament_size, FLAGS_max_height,
+      FLAGS_crossover_prob, FLAGS_elitism, false, functions, terminals, false,
+      repr::BloatParams(), repr::TuningParams(), 0, repr::StoppingParams(),
+      repr::parseStatsLevel(FLAGS_stats_level));
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+
+  if (FLAGS_seed == -1) {
+    std::random_device rd;
+    FLAGS_seed = rd();
+  }
+
+  // Loaded once for all the runs.
+  const auto &trainDataset =
+      parser::loadDataset(FLAGS_dataset_train, FLAGS_verify_dataset_checksum);
+  const auto &testDataset =
+      parser::loadDataset(FLAGS_dataset_test, FLAGS_verify_dataset_checksum);
+  const auto &base = baseParams_(trainDataset.numInputs());
+
+  const auto &spec = sweep::parseSpec(FLAGS_spec);
+  repr::RNG rng(FLAGS_seed);
+  const auto &configs =
+      FLAGS_num_random_configs > 0
+          ? sweep::randomSearch(spec, FLAGS_num_random_configs, rng)
+          : sweep::grid(spec);
+
+  std::vector<repr::Params> params;
+  std::vector<std::string> outputFiles;
+  for (size_t i = 0; i < configs.size(); ++i) {
+    LOG(INFO) << "Config " << i << ": " << sweep::str(spec, configs[i]);
+    outputFiles.push_back(
+        utils::strCat(FLAGS_output_dir, "/config-", i, ".cnat"));
+    params.push_back(
+        sweep::configParams(base, spec, configs[i], outputFiles.back()));
+  }
+
+  const auto &results = sweep::run(params, trainDataset, testDataset,
+                                   FLAGS_num_threads, FLAGS_threads_per_run);
+  for (size_t i = 0; i < results.size(); ++i) {
+    stats::saveResults(params[i], results[i].train, results[i].test);
+  }
+  sweep::summarize(spec, configs, outputFiles, results,
+                   utils::strCat(FLAGS_output_dir, "/summary.csv"));
+
+  return 0;
+}
@@ -0,0 +1,490 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tuning.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include "compnat/common/counters.hpp"
+#include "compnat/common/numa.hpp"
+#include "primitives.hpp"
+#include "program.hpp"
+#include "vecmath.hpp"
+
+namespace tuning {
+namespace {
+using repr::Op;
+
+/// Number of samples evaluated at a time.
+const size_t BlockSize_ = 256;
+
+/// Param of instructions that aren't constants.
+const size_t NoParam_ = std::numeric_limits<size_t>::max();
+
+/// Instruction of the tape. Values are always double, even if repr::T isn't.
+struct Instruction_ {
+  Op op;
+  size_t var;
+
+  /// Instructions of the children.
+  size_t a, b;
+
+  /// Index of the constant of Op::Const instructions.
+  size_t param;
+};
+
+/// Individual in postfix form, with its constants as params.
+struct Tape_ {
+  std::vector<Instruction_> code;
+  std::vector<repr::Node *> constants;
+};
+
+/// Appends the node to the tape. Returns false if it can't be tuned.
+bool record_(repr::Node &node, Tape_ &tape) {
+  Instruction_ instr{node.op(), node.var(), 0, 0, NoParam_};
+  switch (node.op()) {
+  case Op::Custom:
+    return false;
+  case Op::Const:
+    instr.param = tape.constants.size();
+    tape.constants.push_back(&node);
+    break;
+  case Op::Var:
+    break;
+  default:
+    for (size_t i = 0; i < node.numChildren(); ++i) {
+      if (!record_(node.mutableChild(i), tape)) {
+        return false;
+      }
+      (i ? instr.b : instr.a) = tape.code.size() - 1;
+    }
+  }
+
+  tape.code.push_back(instr);
+  return true;
+}
+
+/// Squared error and normal equations (J^T J and J^T r) of the residuals.
+struct Normal_ {
+  double squaredError;
+  std::vector<double> jtj;
+  std::vector<double> jtr;
+};
+
+/// Evaluates the tape and its Jacobian over blocks of samples.
+class Differentiator_ {
+public:
+  explicit Differentiator_(const Tape_ &tape)
+      : code_(tape.code), numParams_(tape.constants.size()),
+        values_(code_.size() * BlockSize_),
+        adjoints_(code_.size() * BlockSize_),
+        jacobian_(numParams_ * BlockSize_) {}
+
+  /**
+   * Evaluates the tape over the dataset with the given params.
+   * @return If all outputs are finite. Otherwise, normal isn't valid.
+   */
+  bool eval(const repr::Dataset &dataset, const std::vector<double> &params,
+            Normal_ &normal) {
+    const size_t k = numParams_;
+    normal.squaredError = 0;
+    normal.jtj.assign(k * k, 0);
+    normal.jtr.assign(k, 0);
+
+    const repr::T *expected = dataset.expected();
+    for (size_t begin = 0; begin < dataset.size(); begin += BlockSize_) {
+      const size_t n = std::min(BlockSize_, dataset.size() - begin);
+      forward_(dataset, params, begin, n);
+      reverse_(n);
+
+      const double *out = value_(code_.size() - 1);
+      for (size_t r = 0; r < n; ++r) {
+        const double residual = out[r] - expected[begin + r];
+        if (!std::isfinite(residual)) {
+          return false;
+        }
+
+        normal.squaredError += residual * residual;
+        for (size_t p = 0; p < k; ++p) {
+          const double jp = jacobian_[p * BlockSize_ + r];
+          normal.jtr[p] += jp * residual;
+          for (size_t q = p; q < k; ++q) {
+            normal.jtj[p * k + q] += jp * jacobian_[q * BlockSize_ + r];
+          }
+        }
+      }
+    }
+
+    for (size_t p = 0; p < k; ++p) {
+      for (size_t q = 0; q < p; ++q) {
+        normal.jtj[p * k + q] = normal.jtj[q * k + p];
+      }
+    }
+    return std::isfinite(normal.squaredError);
+  }
+
+private:
+  double *value_(size_t i) { return &values_[i * BlockSize_]; }
+  double *adjoint_(size_t i) { return &adjoints_[i * BlockSize_]; }
+
+  void forward_(const repr::Dataset &dataset, const std::vector<double> &params,
+                size_t begin, size_t n) {
+    const double eps = std::numeric_limits<repr::T>::epsilon();
+    for (size_t i = 0; i < code_.size(); ++i) {
+      const auto &instr = code_[i];
+      double *out = value_(i);
+      const double *a = value_(instr.a);
+      const double *b = value_(instr.b);
+      switch (instr.op) {
+      case Op::Const:
+        std::fill_n(out, n, params[instr.param]);
+        break;
+      case Op::Var:
+        std::copy_n(dataset.input(instr.var) + begin, n, out);
+        break;
+      case Op::Sum:
+        for (size_t r = 0; r < n; ++r) {
+          out[r] = a[r] + b[r];
+        }
+        break;
+      case Op::Sub:
+        for (size_t r = 0; r < n; ++r) {
+          out[r] = a[r] - b[r];
+        }
+        break;
+      case Op::Mult:
+        for (size_t r = 0; r < n; ++r) {
+          out[r] = a[r] * b[r];
+        }
+        break;
+      case Op::Div: // Same as utils::safeDiv().
+        for (size_t r = 0; r < n; ++r) {
+          out[r] = std::abs(b[r]) <= eps ? 0 : a[r] / b[r];
+        }
+        break;
+      case Op::Log:
+        for (size_t r = 0; r < n; ++r) {
+          out[r] = std::log2(a[r]);
+        }
+        break;
+      case Op::Exp: // Same as primitives::protectedExp().
+#pragma omp simd
+        for (size_t r = 0; r < n; ++r) {
+          out[r] = vecmath::exp(primitives::clampExpArg(a[r]));
+        }
+        break;
+      case Op::Sin:
+#pragma omp simd
+        for (size_t r = 0; r < n; ++r) {
+          out[r] = vecmath::sin(a[r]);
+        }
+        break;
+      case Op::Cos:
+#pragma omp simd
+        for (size_t r = 0; r < n; ++r) {
+          out[r] = vecmath::cos(a[r]);
+        }
+        break;
+      case Op::Sqrt:
+#pragma omp simd
+        for (size_t r = 0; r < n; ++r) {
+          out[r] = std::sqrt(std::abs(a[r]));
+        }
+        break;
+      case Op::Pow: // Same as primitives::protectedPow().
+#pragma omp simd
+        for (size_t r = 0; r < n; ++r) {
+          const double abs = std::abs(a[r]);
+          const double value = vecmath::exp(
+              primitives::clampExpArg(b[r] * vecmath::log(abs)));
+          out[r] = abs <= eps ? 0 : value;
+        }
+        break;
+      case Op::Custom:
+        break;
+      }
+    }
+  }
+
+  /// Finds the derivative of each output with respect to each param.
+  void reverse_(size_t n) {
+    const double eps = std::numeric_limits<repr::T>::epsilon();
+    std::fill(adjoints_.begin(), adjoints_.end(), 0);
+    std::fill(jacobian_.begin(), jacobian_.end(), 0);
+    std::fill_n(adjoint_(code_.size() - 1), n, 1);
+
+    for (size_t i = code_.size(); i-- > 0;) {
+      const auto &instr = code_[i];
+      const double *g = adjoint_(i);
+      const double *a = value_(instr.a);
+      const double *b = value_(instr.b);
+      double *ga = adjoint_(instr.a);
+      double *gb = adjoint_(instr.b);
+      switch (instr.op) {
+      case Op::Const: {
+        double *j = &jacobian_[instr.param * BlockSize_];
+        for (size_t r = 0; r < n; ++r) {
+          j[r] += g[r];
+        }
+        break;
+      }
+      case Op::Sum:
+        for (size_t r = 0; r < n; ++r) {
+          ga[r] += g[r];
+          gb[r] += g[r];
+        }
+        break;
+      case Op::Sub:
+        for (size_t r = 0; r < n; ++r) {
+          ga[r] += g[r];
+          gb[r] -= g[r];
+        }
+        break;
+      case Op::Mult:
+        for (size_t r = 0; r < n; ++r) {
+          ga[r] += g[r] * b[r];
+          gb[r] += g[r] * a[r];
+        }
+        break;
+      case Op::Div:
+        for (size_t r = 0; r < n; ++r) {
+          if (std::abs(b[r]) > eps) {
+            ga[r] += g[r] / b[r];
+            gb[r] -= g[r] * a[r] / (b[r] * b[r]);
+          }
+        }
+        break;
+      case Op::Log:
+        for (size_t r = 0; r < n; ++r) {
+          ga[r] += g[r] / (a[r] * M_LN2);
+        }
+        break;
+      case Op::Exp: {
+        // Clamped arguments don't change the output.
+        const double *out = value_(i);
+        for (size_t r = 0; r < n; ++r) {
+          if (a[r] == primitives::clampExpArg(a[r])) {
+            ga[r] += g[r] * out[r];
+          }
+        }
+        break;
+      }
+      case Op::Sin:
+        for (size_t r = 0; r < n; ++r) {
+          ga[r] += g[r] * vecmath::cos(a[r]);
+        }
+        break;
+      case Op::Cos:
+        for (size_t r = 0; r < n; ++r) {
+          ga[r] -= g[r] * vecmath::sin(a[r]);
+        }
+        break;
+      case Op::Sqrt: {
+        const double *out = value_(i);
+        for (size_t r = 0; r < n; ++r) {
+          if (out[r] > 0) {
+            ga[r] += g[r] * (a[r] < 0 ? -0.5 : 0.5) / out[r];
+          }
+        }
+        break;
+      }
+      case Op::Pow: {
+        // d/da |a|^b = b |a|^b / a and d/db |a|^b = |a|^b log(|a|).
+        const double *out = value_(i);
+        for (size_t r = 0; r < n; ++r) {
+          const double log = vecmath::log(std::abs(a[r]));
+          const double exponent = b[r] * log;
+          if (std::abs(a[r]) > eps &&
+              exponent == primitives::clampExpArg(exponent)) {
+            ga[r] += g[r] * b[r] * out[r] / a[r];
+            gb[r] += g[r] * out[r] * log;
+          }
+        }
+        break;
+      }
+      default:
+        break;
+      }
+    }
+  }
+
+  const std::vector<Instruction_> &code_;
+  size_t numParams_;
+  std::vector<double> values_;
+  std::vector<double> adjoints_;
+  std::vector<double> jacobian_;
+};
+
+/**
+ * Solves a x = b in place of b by Gaussian elimination with partial pivoting.
+ * @return False if a is singular.
+ */
+bool solve_(std::vector<double> &a, std::vector<double> &b, size_t k) {
+  for (size_t col = 0; col < k; ++col) {
+    size_t pivot = col;
+    for (size_t row = col + 1; row < k; ++row) {
+      if (std::abs(a[row * k + col]) > std::abs(a[pivot * k + col])) {
+        pivot = row;
+      }
+    }
+    if (!(std::abs(a[pivot * k + col]) > 1e-300)) {
+      return false;
+    }
+    if (pivot != col) {
+      std::swap_ranges(&a[col * k], &a[col * k] + k, &a[pivot * k]);
+      std::swap(b[col], b[pivot]);
+    }
+
+    for (size_t row = col + 1; row < k; ++row) {
+      const double factor = a[row * k + col] / a[col * k + col];
+      for (size_t i = col; i < k; ++i) {
+        a[row * k + i] -= factor * a[col * k + i];
+      }
+      b[row] -= factor * b[col];
+    }
+  }
+
+  for (size_t col = k; col-- > 0;) {
+    for (size_t i = col + 1; i < k; ++i) {
+      b[col] -= a[col * k + i] * b[i];
+    }
+    b[col] /= a[col * k + col];
+  }
+  return std::all_of(b.begin(), b.end(),
+                     [](double x) { return std::isfinite(x); });
+}
+
+/// Replaces the constants of the tape by the given values.
+void assign_(const Tape_ &tape, const std::vector<double> &params) {
+  for (size_t p = 0; p < params.size(); ++p) {
+    *tape.constants[p] = repr::Node(primitives::constant(params[p]));
+  }
+}
+
+} // namespace
+
+size_t tune(repr::Node &individual, const repr::Dataset &dataset,
+            size_t numSteps, double &fitness) {
+  Tape_ tape;
+  if (!numSteps || !dataset.size() || !record_(individual, tape) ||
+      tape.constants.empty() || tape.constants.size() > MaxConstants) {
+    return 0;
+  }
+
+  const size_t k = tape.constants.size();
+  std::vector<double> initial(k);
+  for (size_t p = 0; p < k; ++p) {
+    initial[p] = tape.constants[p]->value();
+  }
+
+  Differentiator_ differentiator(tape);
+  Normal_ current, candidate;
+  size_t numEvaluations = 1;
+  if (!differentiator.eval(dataset, initial, current)) {
+    return numEvaluations;
+  }
+
+  auto params = initial;
+  std::vector<double> a, delta, next(k);
+  double lambda = 1e-3;
+  bool improved = false;
+  for (size_t step = 0; step < numSteps; ++step) {
+    a = current.jtj;
+    delta = current.jtr;
+    for (size_t p = 0; p < k; ++p) {
+      a[p * k + p] += lambda * a[p * k + p] + 1e-12;
+      delta[p] = -delta[p];
+    }
+    if (!solve_(a, delta, k)) {
+      lambda *= 10;
+      continue;
+    }
+
+    for (size_t p = 0; p < k; ++p) {
+      next[p] = params[p] + delta[p];
+    }
+    ++numEvaluations;
+    if (differentiator.eval(dataset, next, candidate) &&
+        candidate.squaredError < current.squaredError) {
+      params.swap(next);
+      std::swap(current, candidate);
+      lambda = std::max(lambda / 10, 1e-12);
+      improved = true;
+    } else {
+      lambda *= 10;
+    }
+  }
+
+  if (!improved) {
+    return numEvaluations;
+  }
+
+  // The tape is evaluated in double precision, so the fitness is checked with
+  // the same evaluation used by the rest of the program.
+  assign_(tape, params);
+  ++numEvaluations;
+  const double tunedFitness = std::sqrt(
+      program::Program(individual).squaredError(dataset) / dataset.size());
+  if (tunedFitness < fitness) {
+    fitness = tunedFitness;
+  } else {
+    assign_(tape, initial);
+  }
+  return numEvaluations;
+}
+
+size_t tuneElites(const repr::Params &params,
+                  std::vector<repr::Node> &population,
+                  std::vector<double> &fitnesses,
+                  const repr::Dataset &dataset) {
+  const size_t numElites =
+      std::min(params.tuning.numElites, population.size());
+  if (!numElites) {
+    return 0;
+  }
+
+  // NaN fitnesses are the worst.
+  const auto &key = [&](size_t i) {
+    return std::isnan(fitnesses[i]) ? std::numeric_limits<double>::infinity()
+                                    : fitnesses[i];
+  };
+  std::vector<size_t> elites(population.size());
+  std::iota(elites.begin(), elites.end(), 0);
+  std::partial_sort(elites.begin(), elites.begin() + numElites, elites.end(),
+                    [&](size_t a, size_t b) { return key(a) < key(b); });
+
+  size_t numEvaluations = 0;
+#pragma omp parallel reduction(+ : numEvaluations)
+  {
+    counters::Region region("tuning");
+    const int node = numa::currentNode();
+    const auto &local = dataset.replica(node);
+#pragma omp for
+    for (size_t i = 0; i < numElites; ++i) {
+      const size_t elite = elites[i];
+      numEvaluations += tune(population[elite], local, params.tuning.numSteps,
+                             fitnesses[elite]);
+    }
+    numa::recordAccess(node, local.node(),
+                       numEvaluations * local.sizeInBytes());
+  }
+  return numEvaluations;
+}
+
+} // namespace tuning
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPNAT_TP1_TUNING_HPP
+#define COMPNAT_TP1_TUNING_HPP
+
+#include <vector>
+
+#include "representation.hpp"
+
+namespace tuning {
+
+/// Maximum number of constants of the individuals that are tuned.
+constexpr size_t MaxConstants = 32;
+
+/**
+ * Tunes the constants of the individual to minimize its squared error on the
+ * dataset, with Levenberg-Marquardt steps.
+ * The Jacobian of the outputs with respect to the constants is computed with
+ * a forward and a reverse pass over blocks of samples of the dataset columns.
+ * The individual is only changed if its fitness improves. Individuals with
+ * Op::Custom nodes, without constants or with more than MaxConstants
+ * constants are not tuned.
+ * @param numSteps Number of Levenberg-Marquardt steps.
+ * @param fitness Fitness (RMSE) of the individual, updated if it improves.
+ * @return Number of evaluations of the individual over the dataset, each
+ *   including the forward and the reverse pass.
+ */
+size_t tune(repr::Node &individual, const repr::Dataset &dataset,
+            size_t numSteps, double &fitness);
+
+/**
+ * Tunes the params.tuning.numElites best individuals of the population in
+ * parallel, updating their fitness.
+ * @return Total number of evaluations, see tune().
+ */
+size_t tuneElites(const repr::Params &params,
+                  std::vector<repr::Node> &population,
+                  std::vector<double> &fitnesses,
+                  const repr::Dataset &dataset);
+
+} // namespace tuning
+
+#endif // !COMPNAT_TP1_TUNING_HPP
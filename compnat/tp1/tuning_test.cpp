@@ -0,0 +1,133 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tuning.hpp"
+
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "primitives.hpp"
+#include "serializer.hpp"
+#include "statistics.hpp"
+
+namespace {
+using repr::Node;
+
+/// Dataset of y = 3 * x0 + 2.
+repr::Dataset linearDataset() {
+  return {{{-2, 1}, -4}, {{-1, 0}, -1}, {{0, 4}, 2},
+          {{1, 2}, 5},   {{2, 3}, 8},   {{5, 1}, 17}};
+}
+
+TEST(TuningTest, FitsLinearConstants) {
+  const auto &dataset = linearDataset();
+  auto individual = serializer::parse("((0.5 * x0) + 0.1)");
+  double fitness = stats::fitness(individual, dataset);
+
+  EXPECT_EQ((size_t)4, tuning::tune(individual, dataset, 2, fitness));
+  EXPECT_NEAR(0, fitness, 1e-5);
+  EXPECT_NEAR(3, individual.child(0).child(0).value(), 1e-5);
+  EXPECT_NEAR(2, individual.child(1).value(), 1e-5);
+  EXPECT_DOUBLE_EQ(stats::fitness(individual, dataset), fitness);
+}
+
+TEST(TuningTest, DifferentiatesAllOperations) {
+  // y = log2(x0 + 3) / 2 - x1 * 0.25.
+  repr::Dataset target(1000, 2);
+  for (size_t i = 0; i < target.size(); ++i) {
+    const repr::T x0 = i * 0.01, x1 = std::sin(i);
+    target.mutableColumn(0)[i] = x0;
+    target.mutableColumn(1)[i] = x1;
+    target.mutableColumn(2)[i] = std::log2(x0 + 3) / 2 - x1 * 0.25;
+  }
+  target.summarize();
+
+  auto individual =
+      serializer::parse("((log2((x0 + 2)) / 1.5) - (x1 * 0.5))");
+  const double initialFitness = stats::fitness(individual, target);
+  double fitness = initialFitness;
+  tuning::tune(individual, target, 10, fitness);
+  EXPECT_LT(fitness, initialFitness * 1e-3) << individual.str();
+}
+
+TEST(TuningTest, DifferentiatesTranscendentalOperations) {
+  // y = exp(x0 * 0.5) + sin(x1 * 2) * cos(x0) - sqrt(x0 * 2) + pow(x0, 1.5).
+  repr::Dataset target(1000, 2);
+  for (size_t i = 0; i < target.size(); ++i) {
+    const repr::T x0 = i * 0.002 + 0.5, x1 = std::sin(i);
+    target.mutableColumn(0)[i] = x0;
+    target.mutableColumn(1)[i] = x1;
+    target.mutableColumn(2)[i] = std::exp(x0 * 0.5) +
+                                 std::sin(x1 * 2) * std::cos(x0) -
+                                 std::sqrt(x0 * 2) + std::pow(x0, 1.5);
+  }
+  target.summarize();
+
+  auto individual = serializer::parse(
+      "(((exp((x0 * 0.4)) + (sin((x1 * 1.8)) * cos(x0))) - sqrt((x0 * 2.5))) "
+      "+ pow(x0, 1.4))");
+  const double initialFitness = stats::fitness(individual, target);
+  double fitness = initialFitness;
+  tuning::tune(individual, target, 10, fitness);
+  EXPECT_LT(fitness, initialFitness * 1e-3) << individual.str();
+}
+
+TEST(TuningTest, SkipsIndividualsWithoutConstants) {
+  const auto &dataset = linearDataset();
+  auto individual = serializer::parse("(x0 + x1)");
+  double fitness = stats::fitness(individual, dataset);
+  EXPECT_EQ((size_t)0, tuning::tune(individual, dataset, 5, fitness));
+  EXPECT_EQ("(x0 + x1)", individual.str());
+}
+
+TEST(TuningTest, NeverWorsensIndividuals) {
+  const auto &dataset = linearDataset();
+
+  // Already optimal.
+  auto individual = serializer::parse("((3 * x0) + 2)");
+  double fitness = stats::fitness(individual, dataset);
+  tuning::tune(individual, dataset, 5, fitness);
+  EXPECT_EQ("((3 * x0) + 2)", individual.str());
+
+  // Non-finite outputs can't be tuned.
+  individual = serializer::parse("log2((x0 * 0.5))");
+  fitness = stats::fitness(individual, dataset);
+  EXPECT_EQ((size_t)1, tuning::tune(individual, dataset, 5, fitness));
+  EXPECT_EQ("log2((x0 * 0.5))", individual.str());
+}
+
+TEST(TuningTest, TunesOnlyElites) {
+  const auto &dataset = linearDataset();
+  std::vector<Node> population = {serializer::parse("((2 * x0) + 1)"),
+                                  serializer::parse("(x1 * 0.5)"),
+                                  serializer::parse("((0.5 * x0) + 3)")};
+  auto fitnesses = stats::fitness(population, dataset);
+
+  repr::TuningParams tuning;
+  tuning.numElites = 1;
+  const repr::Params params("", 0, 0, 0, 2, 0, 3, 0.8, false, false, {}, {},
+                            false, repr::BloatParams(), tuning);
+  EXPECT_LT((size_t)0,
+            tuning::tuneElites(params, population, fitnesses, dataset));
+  EXPECT_NEAR(0, fitnesses[0], 1e-5);
+  EXPECT_EQ("(x1 * 0.5)", population[1].str());
+  EXPECT_EQ("((0.5 * x0) + 3)", population[2].str());
+  EXPECT_EQ(stats::fitness(population, dataset), fitnesses);
+}
+
+} // namespace
@@ -17,6 +17,7 @@
 #ifndef COMPNAT_TP1_UTILS_HPP
 #define COMPNAT_TP1_UTILS_HPP
 
+#include <chrono>
 #include <cmath>
 #include <limits>
 #include <sstream>
@@ -33,6 +34,32 @@ template <typename T> T safeDiv(const T &a, const T &b, const T &def = 0) {
   return a / b;
 }
 
+/// Combines value into the hash seed.
+inline void hashCombine(size_t &seed, size_t value) {
+  seed ^= value + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2);
+}
+
+/// Milliseconds elapsed since start.
+inline double elapsedMs(std::chrono::steady_clock::time_point start) {
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+/// Adds the milliseconds elapsed during its lifetime to a counter.
+class ScopedTimer {
+public:
+  explicit ScopedTimer(double &ms)
+      : ms_(ms), start_(std::chrono::steady_clock::now()) {}
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+  ~ScopedTimer() { ms_ += elapsedMs(start_); }
+
+private:
+  double &ms_;
+  std::chrono::steady_clock::time_point start_;
+};
+
 template <typename T> void strCatter_(std::stringstream &ss, const T &t) {
   ss << t;
 }
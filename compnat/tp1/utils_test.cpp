@@ -16,10 +16,14 @@
 
 #include "utils.hpp"
 
+#include <chrono>
+#include <thread>
+
 #include <gtest/gtest.h>
 
 namespace {
 using utils::paddedStrCat;
+using utils::ScopedTimer;
 using utils::safeDiv;
 using utils::strCat;
 using utils::strSplit;
@@ -54,4 +58,14 @@ TEST(StrSplitTest, WorksCorrectly) {
   EXPECT_EQ(42, i);
 }
 
+TEST(ScopedTimerTest, AccumulatesElapsedTime) {
+  double ms = 1000;
+  {
+    ScopedTimer timer(ms);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  EXPECT_LE(1020, ms);
+  EXPECT_GT(2000, ms);
+}
+
 } // namespace
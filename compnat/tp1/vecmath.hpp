@@ -0,0 +1,179 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPNAT_TP1_VECMATH_HPP
+#define COMPNAT_TP1_VECMATH_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+/**
+ * Branch-free polynomial implementations of transcendental functions.
+ * They only use arithmetic, comparisons, selects and 64 bit integer shifts, so
+ * loops calling them over arrays are vectorized by the compiler, unlike calls
+ * to libm. The results are within a few ulps of libm.
+ * GCC only turns the selects into vector blends with -fno-trapping-math.
+ */
+namespace vecmath {
+
+/// Arguments of exp() are clamped to [MinExpArg, MaxExpArg].
+constexpr double MinExpArg = -708;
+constexpr double MaxExpArg = 709;
+
+/// Arguments of sin() and cos() with a bigger magnitude give NaN.
+constexpr double MaxTrigArg = 1125899906842624.0; // 2^50.
+
+namespace detail {
+
+inline double fromBits(uint64_t bits) {
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+inline uint64_t toBits(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+/// Adding and subtracting it rounds doubles with |x| < 2^51 to integers.
+constexpr double RoundMagic = 6755399441055744.0; // 1.5 * 2^52.
+
+constexpr double Ln2Hi = 6.93147180369123816490e-01;
+constexpr double Ln2Lo = 1.90821492927058770002e-10;
+constexpr double Log2e = 1.44269504088896338700e+00;
+
+constexpr double TwoOverPi = 6.36619772367581382433e-01;
+constexpr double PiOver2_1 = 1.57079632673412561417e+00;
+constexpr double PiOver2_2 = 6.07710050630396597660e-11;
+constexpr double PiOver2_3 = 2.02226624871116645580e-21;
+
+/// Rounds to the nearest integer. Valid for |x| < 2^51.
+inline double round(double x) { return (x + RoundMagic) - RoundMagic; }
+
+/// sin(x) or cos(x) depending on the quadrant of the reduced argument.
+inline double sinQuadrant(double x, double shift) {
+  const double q = round(x * TwoOverPi);
+  const double r = ((x - q * PiOver2_1) - q * PiOver2_2) - q * PiOver2_3;
+  const double z = r * r;
+
+  // Polynomials of fdlibm's __kernel_sin and __kernel_cos, |r| <= pi / 4.
+  const double s =
+      r + r * z * (-1.66666666666666324348e-01 +
+                   z * (8.33333333332248946124e-03 +
+                        z * (-1.98412698298579493134e-04 +
+                             z * (2.75573137070700676789e-06 +
+                                  z * (-2.50507602534068634195e-08 +
+                                       z * 1.58969099521155010221e-10)))));
+  const double c =
+      1 - 0.5 * z +
+      z * z * (4.16666666666666019037e-02 +
+               z * (-1.38888888888741095749e-03 +
+                    z * (2.48015872894767294178e-05 +
+                         z * (-2.75573143513906633035e-07 +
+                              z * (2.08757232129817482790e-09 +
+                                   z * -1.13596475577881948265e-11)))));
+
+  // Quadrant in [0, 4). floor(n / 4) is round(n / 4 - 0.375), as n is
+  // an integer.
+  const double n = q + shift;
+  const double quadrant = n - 4 * round(n * 0.25 - 0.375);
+  const double value = quadrant == 1 || quadrant == 3 ? c : s;
+  const double result = quadrant >= 2 ? -value : value;
+  return x >= -MaxTrigArg && x <= MaxTrigArg
+             ? result
+             : std::numeric_limits<double>::quiet_NaN();
+}
+
+} // namespace detail
+
+/// e^x, with x clamped to [MinExpArg, MaxExpArg]. NaN gives NaN.
+inline double exp(double x) {
+  x = x < MinExpArg ? MinExpArg : x;
+  x = x > MaxExpArg ? MaxExpArg : x;
+
+  // x = k ln(2) + r, with |r| <= ln(2) / 2. k is in the low bits of t.
+  const double t = x * detail::Log2e + detail::RoundMagic;
+  const double k = t - detail::RoundMagic;
+  const uint64_t ki = detail::toBits(t) - detail::toBits(detail::RoundMagic);
+  const double r = (x - k * detail::Ln2Hi) - k * detail::Ln2Lo;
+
+  // Taylor series up to r^13 / 13!.
+  double p = 1.0 / 6227020800;
+  p = p * r + 1.0 / 479001600;
+  p = p * r + 1.0 / 39916800;
+  p = p * r + 1.0 / 3628800;
+  p = p * r + 1.0 / 362880;
+  p = p * r + 1.0 / 40320;
+  p = p * r + 1.0 / 5040;
+  p = p * r + 1.0 / 720;
+  p = p * r + 1.0 / 120;
+  p = p * r + 1.0 / 24;
+  p = p * r + 1.0 / 6;
+  p = p * r + 0.5;
+  p = p * r + 1;
+  p = p * r + 1;
+
+  // 2^k, built directly in the exponent bits.
+  return p * detail::fromBits((ki + 1023) << 52);
+}
+
+/// Natural logarithm of a normal or infinite x > 0. Gives NaN if x <= 0.
+inline double log(double x) {
+  // x = 2^e m, with m in [sqrt(0.5), sqrt(2)).
+  const uint64_t sqrtHalf = 0x3fe6a09e667f3bcd;
+  const uint64_t bits = detail::toBits(x) - sqrtHalf;
+  const double m = detail::fromBits((bits & ((1ull << 52) - 1)) + sqrtHalf);
+
+  // The exponent is the sign-extended top 12 bits, converted to double
+  // through the mantissa of 2^52.
+  const double two52 = 4503599627370496.0;
+  const double unsignedE =
+      detail::fromBits((bits >> 52) | 0x4330000000000000) - two52;
+  const double e = unsignedE >= 2048 ? unsignedE - 4096 : unsignedE;
+
+  // log(m) = 2 atanh(s), with s = (m - 1) / (m + 1) and |s| < 0.172.
+  const double s = (m - 1) / (m + 1);
+  const double z = s * s;
+  double p = 1.0 / 21;
+  p = p * z + 1.0 / 19;
+  p = p * z + 1.0 / 17;
+  p = p * z + 1.0 / 15;
+  p = p * z + 1.0 / 13;
+  p = p * z + 1.0 / 11;
+  p = p * z + 1.0 / 9;
+  p = p * z + 1.0 / 7;
+  p = p * z + 1.0 / 5;
+  p = p * z + 1.0 / 3;
+  p = p * z + 1;
+
+  const double result = e * detail::Ln2Hi + (2 * s * p + e * detail::Ln2Lo);
+  const double infinity = std::numeric_limits<double>::infinity();
+  const double finiteResult = x == infinity ? infinity : result;
+  return x > 0 ? finiteResult : std::numeric_limits<double>::quiet_NaN();
+}
+
+/// Sine of x. Accurate for |x| < 2^20 pi / 2, NaN if |x| > MaxTrigArg.
+inline double sin(double x) { return detail::sinQuadrant(x, 0); }
+
+/// Cosine of x. Accurate for |x| < 2^20 pi / 2, NaN if |x| > MaxTrigArg.
+inline double cos(double x) { return detail::sinQuadrant(x, 1); }
+
+} // namespace vecmath
+
+#endif // !COMPNAT_TP1_VECMATH_HPP
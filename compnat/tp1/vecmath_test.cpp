@@ -0,0 +1,88 @@
+/*
+ * Copyright 2017 Renato Utsch
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vecmath.hpp"
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include <gtest/gtest.h>
+
+namespace {
+const double Epsilon = std::numeric_limits<double>::epsilon();
+const double Infinity = std::numeric_limits<double>::infinity();
+const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+TEST(VecmathTest, ExpMatchesLibm) {
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<double> distr(vecmath::MinExpArg,
+                                               vecmath::MaxExpArg);
+  for (int i = 0; i < 100000; ++i) {
+    const double x = distr(rng);
+    EXPECT_NEAR(1, vecmath::exp(x) / std::exp(x), 4 * Epsilon) << x;
+  }
+  EXPECT_EQ(1, vecmath::exp(0));
+  EXPECT_DOUBLE_EQ(M_E, vecmath::exp(1));
+}
+
+TEST(VecmathTest, ExpClampsArguments) {
+  EXPECT_EQ(vecmath::exp(vecmath::MaxExpArg), vecmath::exp(1e6));
+  EXPECT_EQ(vecmath::exp(vecmath::MaxExpArg), vecmath::exp(Infinity));
+  EXPECT_EQ(vecmath::exp(vecmath::MinExpArg), vecmath::exp(-Infinity));
+  EXPECT_TRUE(std::isfinite(vecmath::exp(1e6)));
+  EXPECT_LT(0, vecmath::exp(-1e6));
+  EXPECT_TRUE(std::isnan(vecmath::exp(NaN)));
+}
+
+TEST(VecmathTest, LogMatchesLibm) {
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<double> distr(-300, 300);
+  for (int i = 0; i < 100000; ++i) {
+    const double x = std::pow(10, distr(rng));
+    EXPECT_NEAR(std::log(x), vecmath::log(x),
+                4 * Epsilon * std::max(1.0, std::abs(std::log(x))))
+        << x;
+  }
+  EXPECT_EQ(0, vecmath::log(1));
+  EXPECT_EQ(Infinity, vecmath::log(Infinity));
+  EXPECT_TRUE(std::isnan(vecmath::log(0)));
+  EXPECT_TRUE(std::isnan(vecmath::log(-1)));
+  EXPECT_TRUE(std::isnan(vecmath::log(NaN)));
+}
+
+TEST(VecmathTest, TrigonometricMatchesLibm) {
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<double> distr(-1e5, 1e5);
+  for (int i = 0; i < 100000; ++i) {
+    const double x = distr(rng);
+    EXPECT_NEAR(std::sin(x), vecmath::sin(x), 4 * Epsilon) << x;
+    EXPECT_NEAR(std::cos(x), vecmath::cos(x), 4 * Epsilon) << x;
+  }
+  EXPECT_EQ(0, vecmath::sin(0));
+  EXPECT_EQ(1, vecmath::cos(0));
+  EXPECT_DOUBLE_EQ(1, vecmath::sin(M_PI / 2));
+  EXPECT_DOUBLE_EQ(-1, vecmath::cos(M_PI));
+}
+
+TEST(VecmathTest, TrigonometricOfHugeArgumentsIsNaN) {
+  EXPECT_TRUE(std::isnan(vecmath::sin(2 * vecmath::MaxTrigArg)));
+  EXPECT_TRUE(std::isnan(vecmath::cos(-Infinity)));
+  EXPECT_TRUE(std::isnan(vecmath::sin(NaN)));
+  EXPECT_FALSE(std::isnan(vecmath::cos(vecmath::MaxTrigArg)));
+}
+
+} // namespace
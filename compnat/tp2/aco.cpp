@@ -21,12 +21,15 @@
 #include <limits>
 #include <numeric>
 #include <set>
+#include <tuple>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include <glog/logging.h>
 
+#include "compnat/common/counters.hpp"
+#include "compnat/common/trace.hpp"
 #include "gap.hpp"
 
 namespace tp2 {
@@ -37,26 +40,6 @@ const float TMin = 0.001f;
 const float TMax = 0.999f;
 const float StagnationThreshold = 0.5f;
 
-/**
- * Returns vector from client to distances to that client.
- */
-std::vector<std::vector<float>> calcDistances_(const Dataset &dataset) {
-  std::vector<std::vector<float>> distances(dataset.numPoints());
-  std::generate(distances.begin(), distances.end(), [&]() {
-    return std::vector<float>(dataset.numPoints(), 0.0f);
-  });
-
-  for (size_t i = 0; i < dataset.numPoints(); ++i) {
-    for (size_t j = i + 1; j < dataset.numPoints(); ++j) {
-      distances[i][j] =
-          glm::distance(dataset.point(i).position, dataset.point(j).position);
-      distances[j][i] = distances[i][j];
-    }
-  }
-
-  return distances;
-}
-
 size_t selectPoint_(RNG &rng, const std::set<size_t> &unselected,
                     const std::vector<float> &pheromones) {
   const float sum =
@@ -156,12 +139,11 @@ void stagnationControl_(std::vector<float> &pheromones, size_t numPoints,
 
 } // namespace
 
-Result aco(RNG &rng, const Dataset &dataset, int numIterations, int numAnts,
-           float decay) {
+Result aco(RNG &rng, const Dataset &dataset, const Distances &distances,
+           int numIterations, int numAnts, float decay) {
   CHECK(numIterations > 0);
   CHECK(numAnts > 0);
 
-  const auto &distances = calcDistances_(dataset);
   std::vector<float> pheromones(dataset.numPoints(), TInitial);
 
   std::vector<float> globalBests(numIterations);
@@ -169,11 +151,21 @@ Result aco(RNG &rng, const Dataset &dataset, int numIterations, int numAnts,
   std::vector<float> localWorsts(numIterations);
   Solution globalBest;
   for (int i = 0; i < numIterations; ++i) {
+    trace::Span iterationSpan("iteration", i);
     std::vector<Solution> solutions;
     for (int j = 0; j < numAnts; ++j) {
-      auto[clients, medians] = selectMedians_(
-          rng, pheromones, dataset.numMedians(), dataset.numPoints());
-      const float distance = gap(dataset, clients, medians, distances);
+      std::vector<size_t> clients, medians;
+      {
+        counters::Region region("selectMedians");
+        std::tie(clients, medians) = selectMedians_(
+            rng, pheromones, dataset.numMedians(), dataset.numPoints());
+      }
+
+      float distance;
+      {
+        counters::Region region("gap");
+        distance = gap(dataset, clients, medians, distances);
+      }
       solutions.emplace_back(distance, std::move(medians));
     }
 
@@ -186,6 +178,7 @@ Result aco(RNG &rng, const Dataset &dataset, int numIterations, int numAnts,
               << "\t| localBest: " << localBest.distance
               << "\t| localWorst: " << localWorst.distance;
 
+    trace::Span span("updatePheromones");
     updatePheromones_(pheromones, decay, globalBest, localBest, localWorst);
     stagnationControl_(pheromones, dataset.numPoints(), dataset.numMedians());
     globalBests[i] = globalBest.distance;
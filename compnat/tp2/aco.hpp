@@ -53,8 +53,8 @@ struct Result {
         localWorsts(localWorsts) {}
 };
 
-Result aco(RNG &rng, const Dataset &dataset, int numIterations, int numAnts,
-           float decay);
+Result aco(RNG &rng, const Dataset &dataset, const Distances &distances,
+           int numIterations, int numAnts, float decay);
 
 } // namespace tp2
 
@@ -52,8 +52,31 @@ class Results(object):
             return self._tab.VectorLen(o)
         return 0
 
-def ResultsStart(builder): builder.StartObject(2)
+# /// Performance counters of each region, if enabled with --perf_counters.
+    # Results
+    def Counters(self, j):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(8))
+        if o != 0:
+            x = self._tab.Vector(o)
+            x += flatbuffers.number_types.UOffsetTFlags.py_type(j) * 4
+            x = self._tab.Indirect(x)
+            from .CounterRegion import CounterRegion
+            obj = CounterRegion()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+    # Results
+    def CountersLength(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(8))
+        if o != 0:
+            return self._tab.VectorLen(o)
+        return 0
+
+def ResultsStart(builder): builder.StartObject(3)
 def ResultsAddParams(builder, params): builder.PrependUOffsetTRelativeSlot(0, flatbuffers.number_types.UOffsetTFlags.py_type(params), 0)
 def ResultsAddIterations(builder, iterations): builder.PrependUOffsetTRelativeSlot(1, flatbuffers.number_types.UOffsetTFlags.py_type(iterations), 0)
 def ResultsStartIterationsVector(builder, numElems): return builder.StartVector(4, numElems, 4)
+def ResultsAddCounters(builder, counters): builder.PrependUOffsetTRelativeSlot(2, flatbuffers.number_types.UOffsetTFlags.py_type(counters), 0)
+def ResultsStartCountersVector(builder, numElems): return builder.StartVector(4, numElems, 4)
 def ResultsEnd(builder): return builder.EndObject()
@@ -31,14 +31,14 @@ std::vector<std::pair<size_t, std::vector<size_t>>>
 buildSortedClientMedians_(const Dataset &dataset,
                           const std::vector<size_t> &clients,
                           const std::vector<size_t> &medians,
-                          const std::vector<std::vector<float>> &distances) {
+                          const Distances &distances) {
   // Vector of client (in same order as clients vector) to ordered medians.
   std::vector<std::pair<size_t, std::vector<size_t>>> sortedClientMedians;
   for (size_t client : clients) {
     std::vector<size_t> clientMedians = medians;
     std::sort(clientMedians.begin(), clientMedians.end(),
               [&](size_t a, size_t b) {
-                return distances[client][a] < distances[client][b];
+                return distances(client, a) < distances(client, b);
               });
 
     sortedClientMedians.emplace_back(client, std::move(clientMedians));
@@ -62,7 +62,7 @@ buildSortedClientMedians_(const Dataset &dataset,
 
 float gap(const Dataset &dataset, const std::vector<size_t> &clients,
           const std::vector<size_t> &medians,
-          const std::vector<std::vector<float>> &distances) {
+          const Distances &distances) {
   const auto sortedClientMedians =
       buildSortedClientMedians_(dataset, clients, medians, distances);
 
@@ -78,7 +78,7 @@ float gap(const Dataset &dataset, const std::vector<size_t> &clients,
     const float demand = dataset.point(client).demand;
     bool foundMedian = false;
     for (size_t median : clientMedians) {
-      const float distance = distances[client][median];
+      const float distance = distances(client, median);
       if (demand <= capacities[median]) {
         capacities[median] -= demand;
         solution += distance;
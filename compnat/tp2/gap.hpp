@@ -29,7 +29,7 @@ namespace tp2 {
  */
 float gap(const Dataset &dataset, const std::vector<size_t> &clients,
           const std::vector<size_t> &medians,
-          const std::vector<std::vector<float>> &distances);
+          const Distances &distances);
 
 } // namespace tp2
 
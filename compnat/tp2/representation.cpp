@@ -21,6 +21,8 @@
 
 #include <glog/logging.h>
 
+#include "compnat/common/numa.hpp"
+
 namespace tp2 {
 namespace {} // namespace
 
@@ -39,4 +41,19 @@ void Dataset::parseInputFile_(const char *filename) {
   }
 }
 
+Distances::Distances(const Dataset &dataset, int node)
+    : numPoints_(dataset.numPoints()),
+      node_(node >= 0 ? node : numa::currentNode()),
+      storage_(numa::allocate(numPoints_ * numPoints_ * sizeof(float), node_)),
+      data_(static_cast<float *>(storage_.get())) {
+  for (size_t i = 0; i < numPoints_; ++i) {
+    data_[i * numPoints_ + i] = 0.0f;
+    for (size_t j = i + 1; j < numPoints_; ++j) {
+      data_[i * numPoints_ + j] =
+          glm::distance(dataset.point(i).position, dataset.point(j).position);
+      data_[j * numPoints_ + i] = data_[i * numPoints_ + j];
+    }
+  }
+}
+
 } // namespace tp2
@@ -17,6 +17,7 @@
 #ifndef COMPNAT_TP2_REPRESENTATION_HPP
 #define COMPNAT_TP2_REPRESENTATION_HPP
 
+#include <memory>
 #include <random>
 #include <vector>
 
@@ -69,6 +70,34 @@ private:
   size_t numMedians_;
 };
 
+/**
+ * Distances between all pairs of points of a dataset, in a single block of
+ * memory of a NUMA node.
+ */
+class Distances {
+public:
+  /**
+   * Computes the distances between the points of the dataset.
+   * @param node NUMA node of the memory, or -1 for the node of the calling
+   *   thread.
+   */
+  Distances(const Dataset &dataset, int node = -1);
+
+  /// Distance between the points i and j.
+  float operator()(size_t i, size_t j) const {
+    return data_[i * numPoints_ + j];
+  }
+
+  /// NUMA node of the memory of the distances.
+  int node() const { return node_; }
+
+private:
+  size_t numPoints_;
+  int node_;
+  std::shared_ptr<void> storage_;
+  float *data_;
+};
+
 } // namespace tp2
 
 #endif // !COMPNAT_TP2_REPRESENTATION_HPP
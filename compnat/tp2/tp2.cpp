@@ -21,6 +21,9 @@
 #include <glog/logging.h>
 
 #include "aco.hpp"
+#include "compnat/common/counters.hpp"
+#include "compnat/common/numa.hpp"
+#include "compnat/common/trace.hpp"
 #include "compnat/tp2/results/results_generated.h"
 #include "representation.hpp"
 
@@ -31,6 +34,18 @@ DEFINE_int32(num_ants, -1, "Number of ants (-1 for n - p).");
 DEFINE_int32(num_executions, 30, "Number of executions.");
 DEFINE_int32(num_iterations, 50, "Number of iterations of the algorithm.");
 DEFINE_double(decay, 0.01f, "Pheromone decay rate.");
+DEFINE_bool(numa_replicate, false,
+            "Replicate the distance matrix in huge page backed memory of each "
+            "NUMA node and pin the OpenMP threads to the nodes, so that each "
+            "execution reads its local replica.");
+DEFINE_bool(perf_counters, false,
+            "Count cycles, instructions, cache misses, branch misses and "
+            "stalled cycles of each phase with Linux perf_event_open. Only "
+            "times are measured if the counters are unavailable.");
+DEFINE_string(trace_file, "",
+              "If set, writes a trace of the executions, iterations and "
+              "phases of each thread to this file, in the trace event JSON "
+              "format of chrome://tracing and Perfetto.");
 
 namespace {
 /**
@@ -104,6 +119,28 @@ buildIterations_(flatbuffers::FlatBufferBuilder &builder,
   return builder.CreateVector(iterations);
 }
 
+flatbuffers::Offset<
+    flatbuffers::Vector<flatbuffers::Offset<tp2::results::CounterRegion>>>
+buildCounters_(flatbuffers::FlatBufferBuilder &builder) {
+  std::vector<flatbuffers::Offset<tp2::results::CounterRegion>> regions;
+  for (const auto & [ name, counts ] : counters::regions()) {
+    auto regionName = builder.CreateString(name);
+
+    tp2::results::CounterRegionBuilder regionBuilder(builder);
+    regionBuilder.add_name(regionName);
+    regionBuilder.add_numCalls(counts.numCalls);
+    regionBuilder.add_time(counts.time);
+    regionBuilder.add_cycles(counts.events[counters::Cycles]);
+    regionBuilder.add_instructions(counts.events[counters::Instructions]);
+    regionBuilder.add_cacheMisses(counts.events[counters::CacheMisses]);
+    regionBuilder.add_branchMisses(counts.events[counters::BranchMisses]);
+    regionBuilder.add_stalledCycles(counts.events[counters::StalledCycles]);
+    regions.push_back(regionBuilder.Finish());
+  }
+
+  return builder.CreateVector(regions);
+}
+
 void buildAndWriteResults_(const std::string &outputFile,
                            const std::vector<tp2::Result> &results,
                            int numAnts) {
@@ -111,10 +148,12 @@ void buildAndWriteResults_(const std::string &outputFile,
 
   auto params = buildParams_(builder, numAnts);
   auto iterations = buildIterations_(builder, results);
+  auto resultsCounters = buildCounters_(builder);
 
   tp2::results::ResultsBuilder resultsBuilder(builder);
   resultsBuilder.add_params(params);
   resultsBuilder.add_iterations(iterations);
+  resultsBuilder.add_counters(resultsCounters);
   builder.Finish(resultsBuilder.Finish());
 
   saveToFile_(outputFile, builder.GetBufferPointer(), builder.GetSize());
@@ -126,6 +165,12 @@ int main(int argc, char **argv) {
   gflags::ParseCommandLineFlags(&argc, &argv, true);
   google::InitGoogleLogging(argv[0]);
   google::InstallFailureSignalHandler();
+  if (FLAGS_perf_counters) {
+    counters::enable();
+  }
+  if (!FLAGS_trace_file.empty()) {
+    trace::enable();
+  }
 
   const auto seeds = generateSeeds_(FLAGS_seed, FLAGS_num_executions);
   const auto dataset = tp2::Dataset(FLAGS_dataset.c_str());
@@ -135,12 +180,36 @@ int main(int argc, char **argv) {
     numAnts = dataset.numPoints() - dataset.numMedians();
   }
 
+  // The distances are shared by all executions, with a replica per node if
+  // requested.
+  std::vector<tp2::Distances> distances;
+  if (FLAGS_numa_replicate) {
+    numa::pinOpenMPThreads();
+    for (size_t node = 0; node < numa::numNodes(); ++node) {
+      distances.emplace_back(dataset, node);
+    }
+  } else {
+    distances.emplace_back(dataset);
+  }
+
+  // Each ant reads the distances from its clients to all medians.
+  const uint64_t antBytes = (uint64_t)dataset.numMedians() *
+                            (dataset.numPoints() - dataset.numMedians()) *
+                            sizeof(float);
+
   std::vector<tp2::Result> results(FLAGS_num_executions);
 #pragma omp parallel for
   for (int i = 0; i < FLAGS_num_executions; ++i) {
     LOG(INFO) << "Execution " << i;
     tp2::RNG rng(seeds[i]);
-    results[i] = aco(rng, dataset, FLAGS_num_iterations, numAnts, FLAGS_decay);
+    trace::Span span("execution", i);
+    counters::Region region("aco");
+    const int node = numa::currentNode();
+    const auto &local = distances[node % distances.size()];
+    results[i] = aco(rng, dataset, local, FLAGS_num_iterations, numAnts,
+                     FLAGS_decay);
+    numa::recordAccess(node, local.node(),
+                       antBytes * FLAGS_num_iterations * numAnts);
     LOG(INFO) << "";
   }
 
@@ -158,6 +227,13 @@ int main(int argc, char **argv) {
   LOG(INFO) << "Mean global best: " << mean;
 
   buildAndWriteResults_(FLAGS_output_file, results, numAnts);
+  counters::logSummary();
+  if (FLAGS_numa_replicate || numa::numNodes() > 1) {
+    numa::logSummary();
+  }
+  if (!FLAGS_trace_file.empty()) {
+    trace::write(FLAGS_trace_file);
+  }
 
   return 0;
 }